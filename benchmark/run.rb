@@ -54,29 +54,64 @@ module GraphQLBenchmark
         x.report("validate (visibility profile) - big query") { profile_schemas[1].validate(BIG_QUERY, context: ctx) }
         x.report("validate (visibility profile) - fields will merge") { profile_schemas[2].validate(FIELDS_WILL_MERGE_QUERY, context: ctx) }
       when "scan"
-        require "graphql/c_parser"
-        x.report("scan c - introspection") { GraphQL.scan_with_c(QUERY_STRING) }
-        x.report("scan - introspection") { GraphQL.scan_with_ruby(QUERY_STRING) }
-        x.report("scan c - fragments") { GraphQL.scan_with_c(ABSTRACT_FRAGMENTS_2_QUERY_STRING) }
-        x.report("scan - fragments") { GraphQL.scan_with_ruby(ABSTRACT_FRAGMENTS_2_QUERY_STRING) }
-        x.report("scan c - big query") { GraphQL.scan_with_c(BIG_QUERY_STRING) }
-        x.report("scan - big query") { GraphQL.scan_with_ruby(BIG_QUERY_STRING) }
+        scan_reports.each { |label, block| x.report(label, &block) }
       when "parse"
         # Uncomment this to use the C parser:
         # require "graphql/c_parser"
         x.report("parse - introspection") { GraphQL.parse(QUERY_STRING) }
         x.report("parse - fragments") { GraphQL.parse(ABSTRACT_FRAGMENTS_2_QUERY_STRING) }
         x.report("parse - big query") { GraphQL.parse(BIG_QUERY_STRING) }
+        if GraphQL.default_parser.respond_to?(:new_document_cache)
+          document_cache = GraphQL.default_parser.new_document_cache(10)
+          x.report("parse - big query (cached)") { document_cache.parse(BIG_QUERY_STRING) }
+        end
       else
         raise("Unexpected task #{task}")
       end
     end
+
+    if task == "scan"
+      report_allocations(scan_reports)
+    end
+  end
+
+  def self.scan_reports
+    require "graphql/c_parser"
+    {
+      "scan c - introspection" => -> { GraphQL.scan_with_c(QUERY_STRING) },
+      "scan - introspection" => -> { GraphQL.scan_with_ruby(QUERY_STRING) },
+      "scan c (native buffer) - introspection" => -> { GraphQL::CParser::Lexer.tokenize_to_buffer(QUERY_STRING) },
+      "scan c - fragments" => -> { GraphQL.scan_with_c(ABSTRACT_FRAGMENTS_2_QUERY_STRING) },
+      "scan - fragments" => -> { GraphQL.scan_with_ruby(ABSTRACT_FRAGMENTS_2_QUERY_STRING) },
+      "scan c (native buffer) - fragments" => -> { GraphQL::CParser::Lexer.tokenize_to_buffer(ABSTRACT_FRAGMENTS_2_QUERY_STRING) },
+      "scan c - big query" => -> { GraphQL.scan_with_c(BIG_QUERY_STRING) },
+      "scan - big query" => -> { GraphQL.scan_with_ruby(BIG_QUERY_STRING) },
+      "scan c (native buffer) - big query" => -> { GraphQL::CParser::Lexer.tokenize_to_buffer(BIG_QUERY_STRING) },
+    }
+  end
+
+  # Print the number of objects allocated by one call to each block
+  def self.report_allocations(reports)
+    puts "\nAllocations:"
+    reports.each do |label, block|
+      block.call # warm up
+      before = GC.stat(:total_allocated_objects)
+      block.call
+      allocated = GC.stat(:total_allocated_objects) - before
+      puts "  #{label.ljust(40)} #{allocated} objects"
+    end
   end
 
   def self.profile_parse
     # To profile the C parser instead:
     # require "graphql/c_parser"
 
+    report_allocations(
+      "parse - big query" => -> { GraphQL.parse(BIG_QUERY_STRING) },
+      "parse - introspection" => -> { GraphQL.parse(QUERY_STRING) },
+      "parse - fragments" => -> { GraphQL.parse(ABSTRACT_FRAGMENTS_2_QUERY_STRING) },
+    )
+
     report = MemoryProfiler.report do
       GraphQL.parse(BIG_QUERY_STRING)
       GraphQL.parse(QUERY_STRING)
@@ -85,6 +120,214 @@ module GraphQLBenchmark
     report.pretty_print
   end
 
+  # Report the C parser's cost per token, to measure overhead in the `yylex` loop
+  def self.profile_c_parse_per_token
+    require "graphql/c_parser"
+    big_schema_string = File.read(File.join(BENCHMARK_PATH, "big_schema.graphql"))
+    {
+      "c parse - introspection" => QUERY_STRING,
+      "c parse - big query" => BIG_QUERY_STRING,
+      "c parse - big schema" => big_schema_string,
+    }.each do |label, query_string|
+      tokens_count = GraphQL::CParser::Lexer.tokenize_to_buffer(query_string).length
+      iterations = 1_000_000 / tokens_count + 1
+      GraphQL::CParser.parse(query_string) # warm up
+      started_at = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond)
+      iterations.times { GraphQL::CParser.parse(query_string) }
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond) - started_at
+      puts "#{label.ljust(30)} #{tokens_count} tokens, #{(elapsed.to_f / (iterations * tokens_count)).round(1)}ns/token"
+    end
+  end
+
+  # Report the C lexer's throughput for each kind of input and each scan kernel this CPU supports
+  def self.profile_c_lexer_throughput
+    require "graphql/c_parser"
+    fields = Array.new(2000) { |i| "field#{i}(arg: #{i})" }
+    inputs = {
+      "indented whitespace" => "{\n#{fields.map { |f| "#{" " * 40}#{f},#{" " * 20}\n" }.join}}",
+      "comments" => "{\n#{fields.map { |f| "  # #{"A comment about #{f}. " * 4}\n  #{f}\n" }.join}}",
+      "strings" => "{\n#{fields.map { |f| "  #{f.sub(/\d+\)/, "\"#{"a plain string argument " * 4}\")")}\n" }.join}}",
+      "minified" => "{#{fields.join(" ")}}",
+      "big query" => BIG_QUERY_STRING,
+    }
+    original_kernel = GraphQL::CParser::Lexer.scan_kernel
+    GraphQL::CParser::Lexer.available_scan_kernels.each do |kernel|
+      GraphQL::CParser::Lexer.scan_kernel = kernel
+      inputs.each do |label, input|
+        iterations = 50_000_000 / input.bytesize + 1
+        GraphQL::CParser::Lexer.tokenize_to_buffer(input) # warm up
+        started_at = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        iterations.times { GraphQL::CParser::Lexer.tokenize_to_buffer(input) }
+        elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started_at
+        puts "#{kernel.ljust(7)} #{label.ljust(20)} #{(input.bytesize * iterations / elapsed / 1_000_000).round(1)}MB/s"
+      end
+    end
+  ensure
+    GraphQL::CParser::Lexer.scan_kernel = original_kernel
+  end
+
+  # Count how far another thread gets while a multi-megabyte document is parsed, with and without the GVL
+  def self.profile_c_parse_release_gvl
+    require "graphql/c_parser"
+    big_schema_string = File.read(File.join(BENCHMARK_PATH, "big_schema.graphql"))
+    document_string = (big_schema_string * 20).freeze
+    ticks = 0
+    counter = Thread.new { loop { ticks += 1 } }
+    sleep 0.1
+    [false, true, false, true].each do |release_gvl|
+      GC.start
+      ticks_before = ticks
+      started_at = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+      GraphQL::CParser.parse(document_string, release_gvl: release_gvl)
+      elapsed = Process.clock_gettime(Process::CLOCK_MONOTONIC) - started_at
+      puts "release_gvl: #{release_gvl.to_s.ljust(5)} #{(document_string.bytesize / 1_000_000.0).round(1)}MB in #{(elapsed * 1000).round}ms, other thread counted to #{ticks - ticks_before}"
+    end
+  ensure
+    counter&.kill
+  end
+
+  def self.profile_c_parse_many
+    require "graphql/c_parser"
+    query_strs = 64.times.map { |i| BIG_QUERY_STRING + "\n# #{i}" }
+    Benchmark.ips do |x|
+      x.report("parse x #{query_strs.size}") { query_strs.each { |str| GraphQL::CParser.parse(str) } }
+      [1, 2, 4, Etc.nprocessors].uniq.each do |threads|
+        x.report("parse_many(threads: #{threads})") { GraphQL::CParser.parse_many(query_strs, threads: threads) }
+      end
+      x.compare!
+    end
+  end
+
+  # `GraphQL::Language::Cache` stores documents with `GraphQL::CParser::BinaryAST` when it's loaded, instead of `Marshal`
+  def self.profile_binary_ast_load
+    require "graphql/c_parser"
+    require "tempfile"
+    big_schema_string = File.read(File.join(BENCHMARK_PATH, "big_schema.graphql"))
+    document = GraphQL::CParser.parse(big_schema_string)
+    marshal_data = Marshal.dump(document)
+    binary_data = GraphQL::CParser::BinaryAST.dump(document)
+    puts "Marshal: #{marshal_data.bytesize} bytes, BinaryAST: #{binary_data.bytesize} bytes"
+    Tempfile.create("binary_ast") do |file|
+      file.binmode
+      file.write(binary_data)
+      file.close
+      Benchmark.ips do |x|
+        x.report("parse") { GraphQL::CParser.parse(big_schema_string) }
+        x.report("Marshal.load") { Marshal.load(marshal_data) }
+        x.report("BinaryAST.load") { GraphQL::CParser::BinaryAST.load(binary_data) }
+        x.report("BinaryAST.load_file") { GraphQL::CParser::BinaryAST.load_file(file.path) }
+        x.compare!
+      end
+    end
+  end
+
+  # Rejected requests should be cheap, even when they're big: scanners send lots of them
+  def self.profile_c_parse_errors
+    require "graphql/c_parser"
+    big_schema_string = File.read(File.join(BENCHMARK_PATH, "big_schema.graphql"))
+    padding = " " * 1_000_000
+    rejections = {
+      "syntax error, small" => ["{ f(a: ) }", nil],
+      "syntax error, 1MB padding" => ["{ f(a: ) }" + padding, nil],
+      "syntax error after a big document" => [big_schema_string + " }", nil],
+      "too many tokens, big schema" => [big_schema_string, 100],
+      "too many tokens, padded" => ["{ a b c d e f }" + padding, 3],
+      "bad unicode, 1MB padding" => ["{ f(a: \"\\uD800\") }" + padding, nil],
+    }
+    Benchmark.ips do |x|
+      rejections.each do |name, (query_str, max_tokens)|
+        x.report(name) do
+          GraphQL::CParser.parse(query_str, max_tokens: max_tokens)
+          raise "Expected #{name.inspect} to be rejected"
+        rescue GraphQL::ParseError
+          nil
+        end
+      end
+    end
+  end
+
+  def self.profile_c_print
+    require "graphql/c_parser"
+    ruby_printer = Class.new(GraphQL::Language::Printer) do
+      # Overriding a `print_` method opts out of `GraphQL::CParser::Printer`
+      def print_string(str)
+        super
+      end
+    end
+    big_schema_document = GraphQL.parse(File.read(File.join(BENCHMARK_PATH, "big_schema.graphql")))
+    Benchmark.ips do |x|
+      x.report("print - big query (Ruby)") { ruby_printer.new.print(BIG_QUERY) }
+      x.report("print - big query (C)") { GraphQL::Language::Printer.new.print(BIG_QUERY) }
+      x.report("print - big schema (Ruby)") { ruby_printer.new.print(big_schema_document) }
+      x.report("print - big schema (C)") { GraphQL::Language::Printer.new.print(big_schema_document) }
+      x.report("print - big query, truncated (Ruby)") { ruby_printer.new.print(BIG_QUERY, truncate_size: 1000) }
+      x.report("print - big query, truncated (C)") { GraphQL::Language::Printer.new.print(BIG_QUERY, truncate_size: 1000) }
+      x.compare!
+    end
+  end
+
+  def self.profile_c_minify
+    require "graphql/c_parser"
+    Benchmark.ips do |x|
+      x.report("parse and print - big query") { GraphQL.parse(BIG_QUERY_STRING).to_query_string }
+      x.report("minify - big query") { GraphQL::CParser.minify(BIG_QUERY_STRING) }
+      x.compare!
+    end
+  end
+
+  def self.profile_c_sanitize
+    require "graphql/c_parser"
+    ruby_sanitized_printer = Class.new(GraphQL::Language::SanitizedPrinter) do
+      # Overriding this opts out of `GraphQL::CParser::Printer.sanitize`
+      def coerce_argument_value_to_list?(type, value)
+        super
+      end
+    end
+    # Some value for each of big_query.graphql's variables, so that they're inlined
+    sample_value = ->(type) {
+      case type.kind.name
+      when "NON_NULL" then sample_value.(type.of_type)
+      when "LIST" then [sample_value.(type.of_type)]
+      when "ENUM" then type.values.each_value.first.graphql_name
+      when "INPUT_OBJECT" then type.arguments.each_value.select { |a| a.type.non_null? }.to_h { |a| [a.graphql_name, sample_value.(a.type)] }
+      else 10
+      end
+    }
+    variables = BIG_QUERY.definitions.first.variables.to_h do |variable|
+      [variable.name, sample_value.(BIG_SCHEMA.type_from_ast(variable.type))]
+    end
+    query = GraphQL::Query.new(BIG_SCHEMA, document: BIG_QUERY, variables: variables)
+    Benchmark.ips do |x|
+      x.report("sanitize - big query (Ruby)") { ruby_sanitized_printer.new(query).sanitized_query_string }
+      x.report("sanitize - big query (C)") { GraphQL::Language::SanitizedPrinter.new(query).sanitized_query_string }
+      x.compare!
+    end
+  end
+
+  def self.profile_c_nesting
+    require "graphql/c_parser"
+    nested_strings = ->(depth) {
+      {
+        "lists" => "{ f(a: #{"[" * depth}1#{"]" * depth}) }",
+        "objects" => "{ f(a: #{"{a: " * depth}1#{"}" * depth}) }",
+        "selections" => "{ #{"a { " * depth}b#{" }" * depth} }",
+      }
+    }
+    # Each one is parsed on this thread, since documents over `release_gvl_threshold` would be parsed on another one
+    Benchmark.ips do |x|
+      nested_strings.(100).each do |name, str|
+        x.report("nested #{name} - depth 100") { GraphQL::CParser.parse(str, release_gvl: false) }
+      end
+      nested_strings.(100_000).each do |name, str|
+        x.report("nested #{name} - depth 100,000 (rejected)") do
+          GraphQL::CParser.parse(str, release_gvl: false)
+        rescue GraphQL::ParseError
+          nil
+        end
+      end
+    end
+  end
+
   def self.validate_memory
     FIELDS_WILL_MERGE_SCHEMA.validate(FIELDS_WILL_MERGE_QUERY)
 
@@ -160,12 +403,42 @@ module GraphQLBenchmark
     end
   end
 
+  # Like SDL generated from a documented schema: every type, field, argument and enum value has a multi-line description
+  def self.build_description_heavy_sdl
+    description = ->(indent, name) {
+      "#{indent}\"\"\"\n#{indent}#{name} does something useful.\n\n#{indent}  It's described in detail,\n#{indent}  over a few indented lines.\n#{indent}\"\"\"\n"
+    }
+    sdl = "".dup
+    200.times do |n|
+      sdl << description.("", "Object#{n}")
+      sdl << "type Object#{n} {\n"
+      20.times do |n2|
+        sdl << description.("  ", "field#{n2}")
+        sdl << "  field#{n2}(\n#{description.("    ", "arg")}    arg: String\n  ): String\n"
+      end
+      sdl << "}\n\n"
+      sdl << description.("", "Enum#{n}")
+      sdl << "enum Enum#{n} {\n"
+      10.times do |n2|
+        sdl << description.("  ", "VALUE_#{n2}")
+        sdl << "  VALUE_#{n2}\n"
+      end
+      sdl << "}\n\n"
+    end
+    sdl << "type Query {\n#{200.times.map { |n| "  object#{n}: Object#{n}\n" }.join}}\n"
+    sdl
+  end
+
   def self.profile_boot
+    description_heavy_sdl = build_description_heavy_sdl
     Benchmark.ips do |x|
       x.config(time: 10)
       x.report("Booting large schema") {
         build_large_schema
       }
+      x.report("Booting description-heavy schema from SDL") {
+        GraphQL::Schema.from_definition(description_heavy_sdl)
+      }
     end
 
     result = StackProf.run(mode: :wall, interval: 1) do
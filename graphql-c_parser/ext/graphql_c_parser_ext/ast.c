@@ -0,0 +1,689 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ast.h"
+#include "lexer.h"
+
+#define NODE_LAYOUT_MAX_IVARS 16
+#define ARENA_MIN_BLOCK_SIZE 4096
+#define ARENA_MAX_BLOCK_SIZE (1024 * 1024)
+// INT tokens with this many digits or fewer fit in a `long`
+#define MAX_LONG_INT_DIGITS 18
+// FLOAT tokens shorter than this are copied to the stack for `rb_cstr_to_dbl`
+#define MAX_STACK_FLOAT_LENGTH 64
+
+// How to build a node without calling `.from_a`: the instance variables that
+// the node class's `initialize` assigns, in order, so that nodes made here
+// have the same object shape as nodes made in Ruby. See `initialize_node_layout`.
+typedef struct NodeLayout {
+  VALUE node_class;
+  VALUE lazy_class; // See `GraphQL::CParser::LazyNodes`
+  int ivars_count;
+  ID ivars[NODE_LAYOUT_MAX_IVARS];
+  // The position of each ivar's value in `.from_a`'s arguments, or one of the `LAYOUT_` values below
+  int arg_indexes[NODE_LAYOUT_MAX_IVARS];
+  int freeze_value[NODE_LAYOUT_MAX_IVARS];
+  int intern_value[NODE_LAYOUT_MAX_IVARS];
+  // Lists of children which lazy nodes make when they're first read
+  int lazy_value[NODE_LAYOUT_MAX_IVARS];
+  int has_definition_pos;
+} NodeLayout;
+
+#define LAYOUT_NIL -1
+#define LAYOUT_POS -2 // The node's byte offset
+#define LAYOUT_SOURCE -3 // The document, which finds lines and columns for `AbstractNode#line` and `#col`
+#define LAYOUT_LINE -4 // Only for shareable documents, which don't keep the source
+#define LAYOUT_COL -5
+
+static NodeLayout node_layouts[AST_NODE_TYPES_COUNT];
+static VALUE GraphQL_Language_Nodes_NONE;
+static VALUE GraphQL_CParser_Document;
+static ID id_c_document;
+static ID id_c_node_id;
+static ID id_comment;
+static ID id_line;
+static ID id_col;
+static ID id_pos;
+static ID id_definition_pos;
+static ID id_definition_line;
+static ID id_source;
+static ID id_children;
+static ID id_scalars;
+static ID id_parse_stats;
+
+static void document_mark(void *ptr) {
+  GraphQLDocument *doc = ptr;
+  rb_gc_mark(doc->source);
+  rb_gc_mark(doc->filename);
+  rb_gc_mark(doc->seed_atoms);
+  atom_table_mark(&doc->atoms);
+  for (long i = 0; i < doc->objects_count; i++) {
+    rb_gc_mark(doc->objects[i]);
+  }
+}
+
+// Like `realloc`, but like `xrealloc` when it fails
+static void *document_realloc(GraphQLDocument *doc, void *ptr, size_t size) {
+  void *new_ptr = realloc(ptr, size);
+  if (new_ptr == NULL) {
+    if (doc->without_gvl) {
+      // The same as Ruby's allocator on a thread without the GVL
+      fprintf(stderr, "[FATAL] failed to allocate memory\n");
+      exit(EXIT_FAILURE);
+    }
+    rb_memerror();
+  }
+  return new_ptr;
+}
+
+static size_t document_malloc_size(GraphQLDocument *doc) {
+  return doc->arena_size + doc->nodes_capacity * sizeof(GraphQLAstNode *);
+}
+
+// Tell GC how much memory the arena holds, like `xmalloc` would have. Called with the GVL, after parsing.
+void document_report_memory(GraphQLDocument *doc) {
+  size_t size = document_malloc_size(doc);
+  rb_gc_adjust_memory_usage((ssize_t)size - (ssize_t)doc->reported_size);
+  doc->reported_size = size;
+}
+
+void free_document_arena(GraphQLDocument *doc) {
+  GraphQLArenaBlock *block = doc->blocks;
+  while (block) {
+    GraphQLArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  if (doc->reported_size > 0) {
+    rb_gc_adjust_memory_usage(-(ssize_t)doc->reported_size);
+    doc->reported_size = 0;
+  }
+  doc->blocks = NULL;
+  doc->arena_size = 0;
+  xfree(doc->objects);
+  doc->objects = NULL;
+  doc->objects_count = 0;
+  doc->objects_capacity = 0;
+  atom_table_free(&doc->atoms);
+  free(doc->nodes);
+  doc->nodes = NULL;
+  doc->nodes_count = 0;
+  doc->nodes_capacity = 0;
+  doc->root = AST_NIL;
+}
+
+static void document_free(void *ptr) {
+  GraphQLDocument *doc = ptr;
+  free_document_arena(doc);
+  xfree(doc->line_ends);
+  xfree(doc);
+}
+
+static size_t document_memsize(const void *ptr) {
+  const GraphQLDocument *doc = ptr;
+  return sizeof(GraphQLDocument) +
+    doc->arena_size +
+    doc->objects_capacity * sizeof(VALUE) +
+    doc->nodes_capacity * sizeof(GraphQLAstNode *) +
+    doc->line_ends_count * sizeof(long) +
+    atom_table_memsize(&doc->atoms);
+}
+
+static const rb_data_type_t document_data_type = {
+  "GraphQL::CParser::Document",
+  { document_mark, document_free, document_memsize, },
+  // Frozen documents are only read, see `document_freeze`
+  0, 0, RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+// `atoms` is true to share identifiers in this document, an `AtomTable` to also share them with other documents, or false
+VALUE document_new(VALUE source, VALUE filename, int intern_identifiers, VALUE atoms) {
+  GraphQLDocument *doc;
+  VALUE document = TypedData_Make_Struct(GraphQL_CParser_Document, GraphQLDocument, &document_data_type, doc);
+  doc->self = document;
+  doc->source = source;
+  doc->filename = filename;
+  doc->intern_identifiers = intern_identifiers;
+  // Interned identifiers are already shared
+  doc->use_atoms = !intern_identifiers && RTEST(atoms);
+  doc->seed_atoms = atoms == Qtrue ? Qnil : atoms;
+  if (RTEST(doc->seed_atoms)) {
+    get_atom_table(doc->seed_atoms); // Raise a TypeError early
+  }
+  doc->root = AST_NIL;
+  return document;
+}
+
+GraphQLDocument *get_document(VALUE document) {
+  GraphQLDocument *doc;
+  TypedData_Get_Struct(document, GraphQLDocument, &document_data_type, doc);
+  return doc;
+}
+
+static void *arena_alloc(GraphQLDocument *doc, size_t size) {
+  // Keep allocations pointer-aligned
+  size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  GraphQLArenaBlock *block = doc->blocks;
+  if (block == NULL || block->size - block->used < size) {
+    // Each block is twice as big as the last one, up to a limit
+    size_t block_size = block ? block->size * 2 : ARENA_MIN_BLOCK_SIZE;
+    if (block_size > ARENA_MAX_BLOCK_SIZE) {
+      block_size = ARENA_MAX_BLOCK_SIZE;
+    }
+    if (block_size < size) {
+      block_size = size;
+    }
+    GraphQLArenaBlock *new_block = document_realloc(doc, NULL, sizeof(GraphQLArenaBlock) + block_size);
+    new_block->next = block;
+    new_block->size = block_size;
+    new_block->used = 0;
+    doc->blocks = new_block;
+    doc->arena_size += sizeof(GraphQLArenaBlock) + block_size;
+    block = new_block;
+  }
+  void *ptr = block->data + block->used;
+  block->used += size;
+  return ptr;
+}
+
+GraphQLAstNode *ast_node_new(GraphQLDocument *doc, int node_type, long pos, int values_count, ...) {
+  GraphQLAstNode *node = arena_alloc(doc, sizeof(GraphQLAstNode) + values_count * sizeof(GraphQLAstValue));
+  node->node_type = node_type;
+  node->pos = pos;
+  node->values_count = values_count;
+  va_list values;
+  va_start(values, values_count);
+  for (int i = 0; i < values_count; i++) {
+    node->values[i] = va_arg(values, GraphQLAstValue);
+  }
+  va_end(values);
+
+  if (doc->nodes_count == doc->nodes_capacity) {
+    doc->nodes_capacity = doc->nodes_capacity == 0 ? 64 : doc->nodes_capacity * 2;
+    doc->nodes = document_realloc(doc, doc->nodes, doc->nodes_capacity * sizeof(GraphQLAstNode *));
+  }
+  node->id = (int)doc->nodes_count;
+  doc->nodes[doc->nodes_count] = node;
+  doc->nodes_count++;
+  return node;
+}
+
+GraphQLAstValue ast_list_new(GraphQLDocument *doc) {
+  GraphQLAstList *list = arena_alloc(doc, sizeof(GraphQLAstList));
+  list->length = 0;
+  list->first = NULL;
+  list->last = NULL;
+  GraphQLAstValue value = AST_VALUE(AST_VALUE_LIST);
+  value.as.list = list;
+  return value;
+}
+
+void ast_list_push(GraphQLDocument *doc, GraphQLAstValue list, GraphQLAstValue value) {
+  GraphQLAstListItem *item = arena_alloc(doc, sizeof(GraphQLAstListItem));
+  item->value = value;
+  item->next = NULL;
+  if (list.as.list->last) {
+    list.as.list->last->next = item;
+  } else {
+    list.as.list->first = item;
+  }
+  list.as.list->last = item;
+  list.as.list->length++;
+}
+
+GraphQLAstValue ast_object_value(GraphQLDocument *doc, VALUE object) {
+  if (!RB_SPECIAL_CONST_P(object)) {
+    if (doc->objects_count == doc->objects_capacity) {
+      doc->objects_capacity = doc->objects_capacity == 0 ? 16 : doc->objects_capacity * 2;
+      REALLOC_N(doc->objects, VALUE, doc->objects_capacity);
+    }
+    doc->objects[doc->objects_count] = object;
+    doc->objects_count++;
+  }
+  GraphQLAstValue value = AST_VALUE(AST_VALUE_OBJECT);
+  value.as.object = object;
+  return value;
+}
+
+// For objects which are marked elsewhere, like frozen constants. Unlike `ast_object_value`,
+// this doesn't change the document's `objects`, which GC may be marking while the parser runs without the GVL.
+GraphQLAstValue ast_static_value(VALUE object) {
+  GraphQLAstValue value = AST_VALUE(AST_VALUE_OBJECT);
+  value.as.object = object;
+  return value;
+}
+
+// `token_value` is the unescaped content of STRING tokens; other tokens are read from the source when needed.
+GraphQLAstValue ast_token_value(GraphQLDocument *doc, int token_type, long offset, long length, VALUE token_value) {
+  if (token_value != Qnil) {
+    return ast_object_value(doc, token_value);
+  }
+  GraphQLAstValue value = AST_VALUE(AST_VALUE_TOKEN);
+  value.token_type = token_type;
+  value.as.span.offset = offset;
+  value.as.span.length = length;
+  return value;
+}
+
+// INT and FLOAT values are converted when the node is made
+GraphQLAstValue ast_number_value(GraphQLDocument *doc, int value_type, int token_type, long offset, long length) {
+  GraphQLAstValue value = ast_token_value(doc, token_type, offset, length, Qnil);
+  value.type = value_type;
+  return value;
+}
+
+// A token's comment, or nil if it doesn't have one
+GraphQLAstValue ast_comment_value(long offset, long length) {
+  if (length == 0) {
+    return AST_NIL;
+  }
+  GraphQLAstValue value = AST_VALUE(AST_VALUE_COMMENT);
+  value.as.span.offset = offset;
+  value.as.span.length = length;
+  return value;
+}
+
+// Like `String#to_i`, but read straight from the source string.
+// The lexer only makes INT tokens from `-?(0|[1-9][0-9]*)`.
+static VALUE int_value(const char *str, long length) {
+  const char *p = str;
+  const char *pe = str + length;
+  int negative = 0;
+  if (p < pe && *p == '-') {
+    negative = 1;
+    p++;
+  }
+  if (pe - p > MAX_LONG_INT_DIGITS) {
+    return rb_str_to_inum(rb_str_new(str, length), 10, FALSE);
+  }
+  long value = 0;
+  for (; p < pe; p++) {
+    value = value * 10 + (*p - '0');
+  }
+  return LONG2NUM(negative ? -value : value);
+}
+
+// Like `String#to_f`, but read straight from the source string
+static VALUE float_value(const char *str, long length) {
+  if (length >= MAX_STACK_FLOAT_LENGTH) {
+    return DBL2NUM(rb_str_to_dbl(rb_str_new(str, length), FALSE));
+  }
+  char buffer[MAX_STACK_FLOAT_LENGTH];
+  memcpy(buffer, str, length);
+  buffer[length] = '\0';
+  return DBL2NUM(rb_cstr_to_dbl(buffer, FALSE));
+}
+
+static VALUE identifier_atom(GraphQLDocument *doc, const char *ptr, long length) {
+  st_index_t hash = rb_memhash(ptr, length);
+  if (RTEST(doc->seed_atoms)) {
+    VALUE seed = atom_table_lookup(get_atom_table(doc->seed_atoms), ptr, length, hash);
+    if (seed) {
+      return seed;
+    }
+  }
+  return atom_table_fetch(&doc->atoms, ptr, length, hash);
+}
+
+static VALUE materialize_node(GraphQLDocument *doc, GraphQLAstNode *node, int lazy);
+
+// Strings and lists in shareable documents are frozen as they're made. Everything else in them is already frozen.
+static inline VALUE shareable_value(GraphQLDocument *doc, VALUE value) {
+  return doc->shareable ? rb_obj_freeze(value) : value;
+}
+
+static VALUE materialize_value(GraphQLDocument *doc, GraphQLAstValue *value, int lazy) {
+  switch (value->type) {
+    case AST_VALUE_TRUE:
+      return Qtrue;
+    case AST_VALUE_FALSE:
+      return Qfalse;
+    case AST_VALUE_TOKEN: {
+      if (doc->use_atoms && token_is_identifier(value->token_type)) {
+        return identifier_atom(doc, RSTRING_PTR(doc->source) + value->as.span.offset, value->as.span.length);
+      }
+      GraphQLToken token = { value->token_type, 0, 0, value->as.span.offset, value->as.span.length, Qnil };
+      return shareable_value(doc, token_content(doc->source, doc->intern_identifiers, &token));
+    }
+    case AST_VALUE_INT:
+      return int_value(RSTRING_PTR(doc->source) + value->as.span.offset, value->as.span.length);
+    case AST_VALUE_FLOAT:
+      return float_value(RSTRING_PTR(doc->source) + value->as.span.offset, value->as.span.length);
+    case AST_VALUE_OBJECT:
+      return shareable_value(doc, value->as.object);
+    case AST_VALUE_NODE:
+      return materialize_node(doc, value->as.node, lazy);
+    case AST_VALUE_LIST: {
+      VALUE list = rb_ary_new_capa(value->as.list->length);
+      for (GraphQLAstListItem *item = value->as.list->first; item; item = item->next) {
+        rb_ary_push(list, materialize_value(doc, &item->value, lazy));
+      }
+      return shareable_value(doc, list);
+    }
+    case AST_VALUE_NONE:
+      return GraphQL_Language_Nodes_NONE;
+    case AST_VALUE_COMMENT:
+      return shareable_value(doc, comment_content(doc->source, value->as.span.offset, value->as.span.length));
+    default:
+      return Qnil;
+  }
+}
+
+static VALUE materialize_ivar(GraphQLDocument *doc, GraphQLAstNode *node, NodeLayout *layout, int ivar_index, int lazy) {
+  int arg_index = layout->arg_indexes[ivar_index];
+  VALUE ivar_value;
+  switch (arg_index) {
+    case LAYOUT_NIL:
+      return Qnil;
+    case LAYOUT_POS:
+      return LONG2NUM(node->pos);
+    case LAYOUT_SOURCE:
+      return doc->shareable ? Qnil : doc->self;
+    case LAYOUT_LINE:
+      return doc->shareable ? LONG2NUM(document_line_at(doc, node->pos)) : Qnil;
+    case LAYOUT_COL:
+      return doc->shareable ? LONG2NUM(document_column_at(doc, node->pos)) : Qnil;
+    case 0:
+      return doc->filename;
+    default:
+      if (arg_index - 3 >= node->values_count) {
+        return Qnil;
+      }
+      ivar_value = materialize_value(doc, &node->values[arg_index - 3], lazy);
+      if (layout->freeze_value[ivar_index]) {
+        rb_obj_freeze(ivar_value);
+      } else if (layout->intern_value[ivar_index] && RB_TEST(ivar_value)) {
+        ivar_value = rb_str_to_interned_str(ivar_value);
+      }
+      return ivar_value;
+  }
+}
+
+// A frozen Hash for `Document#parse_stats`
+static VALUE parse_stats_hash(GraphQLParseStats *stats) {
+  VALUE hash = rb_hash_new();
+  rb_hash_aset(hash, ID2SYM(rb_intern("max_depth")), LONG2NUM(stats->max_depth));
+  rb_hash_aset(hash, ID2SYM(rb_intern("fields")), LONG2NUM(stats->fields));
+  rb_hash_aset(hash, ID2SYM(rb_intern("aliases")), LONG2NUM(stats->aliases));
+  rb_hash_aset(hash, ID2SYM(rb_intern("directives")), LONG2NUM(stats->directives));
+  rb_hash_aset(hash, ID2SYM(rb_intern("fragment_spreads")), LONG2NUM(stats->fragment_spreads));
+  rb_hash_aset(hash, ID2SYM(rb_intern("max_list_size")), LONG2NUM(stats->max_list_size));
+  return rb_hash_freeze(hash);
+}
+
+static VALUE materialize_node(GraphQLDocument *doc, GraphQLAstNode *node, int lazy) {
+  NodeLayout *layout = &node_layouts[node->node_type];
+  lazy = lazy && RB_TEST(layout->lazy_class);
+  VALUE ast_node = rb_obj_alloc(lazy ? layout->lazy_class : layout->node_class);
+  for (int i = 0; i < layout->ivars_count; i++) {
+    VALUE ivar_value = lazy && layout->lazy_value[i] ? Qnil : materialize_ivar(doc, node, layout, i, lazy);
+    rb_ivar_set(ast_node, layout->ivars[i], ivar_value);
+  }
+  if (node->node_type == AST_Document) {
+    rb_ivar_set(ast_node, id_parse_stats, parse_stats_hash(&doc->stats));
+  }
+  if (lazy) {
+    rb_ivar_set(ast_node, id_c_document, doc->self);
+    rb_ivar_set(ast_node, id_c_node_id, INT2FIX(node->id));
+  } else if (doc->shareable) {
+    // Like `AbstractNode#deep_freeze`, fill in the memoized values, since they can't be assigned later
+    if (layout->has_definition_pos) {
+      rb_ivar_set(ast_node, id_definition_line, LONG2NUM(document_line_at(doc, node->pos)));
+    }
+    rb_obj_freeze(rb_funcall(ast_node, id_children, 0));
+    rb_obj_freeze(rb_funcall(ast_node, id_scalars, 0));
+    rb_obj_freeze(ast_node);
+  }
+  return ast_node;
+}
+
+static void build_line_ends(GraphQLDocument *doc) {
+  const char *str = RSTRING_PTR(doc->source);
+  long length = RSTRING_LEN(doc->source);
+  long capacity = 0;
+  // Only `\n` ends a line, like in `GraphQL::Language::Parser#line_at`, so a `\r` is counted as a column
+  for (const char *p = str; (p = memchr(p, '\n', str + length - p)) != NULL; p++) {
+    if (doc->line_ends_count == capacity) {
+      capacity = capacity == 0 ? 64 : capacity * 2;
+      REALLOC_N(doc->line_ends, long, capacity);
+    }
+    doc->line_ends[doc->line_ends_count] = p - str;
+    doc->line_ends_count++;
+  }
+  doc->has_line_ends = 1;
+}
+
+// The number of line breaks before `pos`
+static long line_ends_before(GraphQLDocument *doc, long pos) {
+  if (!doc->has_line_ends) {
+    build_line_ends(doc);
+  }
+  long low = 0;
+  long high = doc->line_ends_count;
+  while (low < high) {
+    long mid = low + (high - low) / 2;
+    if (doc->line_ends[mid] < pos) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+long document_line_at(GraphQLDocument *doc, long pos) {
+  return line_ends_before(doc, pos) + 1;
+}
+
+// Columns count bytes, like the lexer's
+long document_column_at(GraphQLDocument *doc, long pos) {
+  long line_index = line_ends_before(doc, pos);
+  if (line_index == 0) {
+    return pos + 1;
+  }
+  return pos - doc->line_ends[line_index - 1];
+}
+
+// `document_line_at` and `document_column_at` for one position, like a parse error's.
+// Unless the document's line breaks were already found, only the ones before `pos` are counted,
+// so an error near the start of a big document doesn't read the rest of it.
+void document_position_at(GraphQLDocument *doc, long pos, long *line, long *col) {
+  if (doc->has_line_ends) {
+    *line = document_line_at(doc, pos);
+    *col = document_column_at(doc, pos);
+    return;
+  }
+  const char *str = RSTRING_PTR(doc->source);
+  const char *end = str + (pos < RSTRING_LEN(doc->source) ? pos : RSTRING_LEN(doc->source));
+  const char *p = str;
+  long line_number = 1;
+  long line_start = 0;
+  while ((p = memchr(p, '\n', end - p)) != NULL) {
+    line_number++;
+    p++;
+    line_start = p - str;
+  }
+  *line = line_number;
+  *col = pos - line_start + 1;
+}
+
+// A shareable document is deeply frozen, so that it can be passed to other Ractors. Its nodes aren't lazy
+// and don't refer to this document: their lines and columns are computed while they're made.
+// Nodes read lines and columns from their document, so `Ractor.make_shareable` freezes it too.
+// Its line breaks are found first, since other Ractors may read them at the same time.
+void document_freeze(GraphQLDocument *doc) {
+  if (!doc->has_line_ends) {
+    build_line_ends(doc);
+  }
+}
+
+VALUE materialize_document(GraphQLDocument *doc, int lazy, int shareable) {
+  doc->shareable = shareable;
+  if (shareable && RB_TYPE_P(doc->filename, T_STRING)) {
+    doc->filename = rb_str_new_frozen(doc->filename);
+  }
+  return materialize_value(doc, &doc->root, lazy && !shareable);
+}
+
+// Make a lazy node's lists of children, see `GraphQL::CParser::LazyNodes::LazyNode`
+VALUE materialize_children(GraphQLDocument *doc, VALUE lazy_node, long node_id) {
+  if (node_id < 0 || node_id >= doc->nodes_count) {
+    rb_raise(rb_eArgError, "No node with id %ld in this document", node_id);
+  }
+  GraphQLAstNode *node = doc->nodes[node_id];
+  NodeLayout *layout = &node_layouts[node->node_type];
+  for (int i = 0; i < layout->ivars_count; i++) {
+    if (layout->lazy_value[i]) {
+      rb_ivar_set(lazy_node, layout->ivars[i], materialize_ivar(doc, node, layout, i, 1));
+    }
+  }
+  return lazy_node;
+}
+
+void register_lazy_node_class(VALUE node_class, VALUE lazy_class, VALUE children_ivars) {
+  for (int node_type = 0; node_type < AST_NODE_TYPES_COUNT; node_type++) {
+    NodeLayout *layout = &node_layouts[node_type];
+    if (layout->node_class == node_class) {
+      layout->lazy_class = lazy_class;
+      for (int i = 0; i < layout->ivars_count; i++) {
+        layout->lazy_value[i] = RB_TEST(rb_ary_includes(children_ivars, ID2SYM(layout->ivars[i])));
+      }
+    }
+  }
+}
+
+// Learn a node class's layout by calling `.from_a` with placeholder strings,
+// then checking which ivar each one was assigned to and whether `initialize`
+// froze it (lists of children) or interned it (descriptions).
+// `comment:` is a keyword argument, so the parser passes it after the other arguments.
+// `line` and `col` are left nil, like the Ruby parser does, and computed from `pos` and `source` when they're read
+// (except in shareable documents, see `materialize_document`).
+static void initialize_node_layout(NodeLayout *layout, VALUE node_class) {
+  layout->node_class = node_class;
+  rb_global_variable(&layout->node_class);
+  layout->lazy_class = Qnil;
+  rb_global_variable(&layout->lazy_class);
+  layout->has_definition_pos = 0;
+  VALUE from_a_params = rb_funcall(rb_obj_method(node_class, ID2SYM(rb_intern("from_a"))), rb_intern("parameters"), 0);
+  VALUE args[NODE_LAYOUT_MAX_IVARS];
+  int args_count = 0;
+  for (long i = 0; i < RARRAY_LEN(from_a_params); i++) {
+    if (rb_ary_entry(rb_ary_entry(from_a_params, i), 0) == ID2SYM(rb_intern("req"))) {
+      if (args_count == NODE_LAYOUT_MAX_IVARS) {
+        rb_raise(rb_eRuntimeError, "Too many arguments to build %"PRIsVALUE" in C", node_class);
+      }
+      args[args_count] = rb_sprintf("from_a argument %d", args_count);
+      args_count++;
+    }
+  }
+  VALUE node = rb_funcallv(node_class, rb_intern("from_a"), args_count, args);
+  VALUE ivar_names = rb_obj_instance_variables(node);
+  if (RARRAY_LEN(ivar_names) > NODE_LAYOUT_MAX_IVARS) {
+    rb_raise(rb_eRuntimeError, "Too many instance variables to build %"PRIsVALUE" in C", node_class);
+  }
+  layout->ivars_count = (int)RARRAY_LEN(ivar_names);
+  for (int i = 0; i < layout->ivars_count; i++) {
+    ID ivar = SYM2ID(rb_ary_entry(ivar_names, i));
+    VALUE ivar_value = rb_ivar_get(node, ivar);
+    layout->ivars[i] = ivar;
+    layout->arg_indexes[i] = LAYOUT_NIL;
+    layout->freeze_value[i] = 0;
+    layout->intern_value[i] = 0;
+    layout->lazy_value[i] = 0;
+    if (ivar == id_comment) {
+      layout->arg_indexes[i] = args_count;
+      continue;
+    } else if (ivar == id_pos || ivar == id_definition_pos) {
+      layout->arg_indexes[i] = LAYOUT_POS;
+      layout->has_definition_pos |= ivar == id_definition_pos;
+      continue;
+    } else if (ivar == id_source) {
+      layout->arg_indexes[i] = LAYOUT_SOURCE;
+      continue;
+    } else if (ivar == id_line) {
+      layout->arg_indexes[i] = LAYOUT_LINE;
+      continue;
+    } else if (ivar == id_col) {
+      layout->arg_indexes[i] = LAYOUT_COL;
+      continue;
+    }
+    for (int arg_index = 0; arg_index < args_count; arg_index++) {
+      if (ivar_value == args[arg_index]) {
+        layout->arg_indexes[i] = arg_index;
+        layout->freeze_value[i] = OBJ_FROZEN(ivar_value) ? 1 : 0;
+      } else if (RB_TYPE_P(ivar_value, T_STRING) && rb_str_equal(ivar_value, args[arg_index]) == Qtrue) {
+        layout->arg_indexes[i] = arg_index;
+        layout->intern_value[i] = 1;
+      }
+    }
+  }
+}
+
+void initialize_document_class(VALUE document_class) {
+  GraphQL_CParser_Document = document_class;
+  rb_global_variable(&GraphQL_CParser_Document);
+}
+
+#define INITIALIZE_NODE_LAYOUT(node_class_name) \
+    initialize_node_layout(&node_layouts[AST_##node_class_name], rb_const_get_at(mGraphQLLanguageNodes, rb_intern(#node_class_name)));
+
+void initialize_node_layouts(void) {
+  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
+  VALUE mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
+  VALUE mGraphQLLanguageNodes = rb_const_get_at(mGraphQLLanguage, rb_intern("Nodes"));
+
+  rb_global_variable(&GraphQL_Language_Nodes_NONE);
+  GraphQL_Language_Nodes_NONE = rb_ary_new();
+  rb_ary_freeze(GraphQL_Language_Nodes_NONE);
+
+  id_c_document = rb_intern("@c_document");
+  id_c_node_id = rb_intern("@c_node_id");
+  id_comment = rb_intern("@comment");
+  id_line = rb_intern("@line");
+  id_col = rb_intern("@col");
+  id_pos = rb_intern("@pos");
+  id_definition_pos = rb_intern("@definition_pos");
+  id_definition_line = rb_intern("@definition_line");
+  id_source = rb_intern("@source");
+  id_children = rb_intern("children");
+  id_scalars = rb_intern("scalars");
+  id_parse_stats = rb_intern("@parse_stats");
+
+  INITIALIZE_NODE_LAYOUT(Argument)
+  INITIALIZE_NODE_LAYOUT(Directive)
+  INITIALIZE_NODE_LAYOUT(Document)
+  INITIALIZE_NODE_LAYOUT(Enum)
+  INITIALIZE_NODE_LAYOUT(Field)
+  INITIALIZE_NODE_LAYOUT(FragmentDefinition)
+  INITIALIZE_NODE_LAYOUT(FragmentSpread)
+  INITIALIZE_NODE_LAYOUT(InlineFragment)
+  INITIALIZE_NODE_LAYOUT(InputObject)
+  INITIALIZE_NODE_LAYOUT(ListType)
+  INITIALIZE_NODE_LAYOUT(NonNullType)
+  INITIALIZE_NODE_LAYOUT(NullValue)
+  INITIALIZE_NODE_LAYOUT(OperationDefinition)
+  INITIALIZE_NODE_LAYOUT(TypeName)
+  INITIALIZE_NODE_LAYOUT(VariableDefinition)
+  INITIALIZE_NODE_LAYOUT(VariableIdentifier)
+
+  INITIALIZE_NODE_LAYOUT(ScalarTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(ObjectTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(InterfaceTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(UnionTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(EnumTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(InputObjectTypeDefinition)
+  INITIALIZE_NODE_LAYOUT(EnumValueDefinition)
+  INITIALIZE_NODE_LAYOUT(DirectiveDefinition)
+  INITIALIZE_NODE_LAYOUT(DirectiveLocation)
+  INITIALIZE_NODE_LAYOUT(FieldDefinition)
+  INITIALIZE_NODE_LAYOUT(InputValueDefinition)
+  INITIALIZE_NODE_LAYOUT(SchemaDefinition)
+
+  INITIALIZE_NODE_LAYOUT(ScalarTypeExtension)
+  INITIALIZE_NODE_LAYOUT(ObjectTypeExtension)
+  INITIALIZE_NODE_LAYOUT(InterfaceTypeExtension)
+  INITIALIZE_NODE_LAYOUT(UnionTypeExtension)
+  INITIALIZE_NODE_LAYOUT(EnumTypeExtension)
+  INITIALIZE_NODE_LAYOUT(InputObjectTypeExtension)
+  INITIALIZE_NODE_LAYOUT(SchemaExtension)
+}
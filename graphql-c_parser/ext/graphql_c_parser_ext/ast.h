@@ -0,0 +1,175 @@
+#ifndef Graphql_ast_h
+#define Graphql_ast_h
+#include <ruby.h>
+#include "atoms.h"
+
+// The parser builds a native AST in an arena owned by a `GraphQL::CParser::Document`,
+// then makes `GraphQL::Language::Nodes` from it, all at once or as they're read.
+
+// One for each class in `GraphQL::Language::Nodes` which the parser makes
+typedef enum GraphQLAstNodeType {
+  AST_Argument,
+  AST_Directive,
+  AST_Document,
+  AST_Enum,
+  AST_Field,
+  AST_FragmentDefinition,
+  AST_FragmentSpread,
+  AST_InlineFragment,
+  AST_InputObject,
+  AST_ListType,
+  AST_NonNullType,
+  AST_NullValue,
+  AST_OperationDefinition,
+  AST_TypeName,
+  AST_VariableDefinition,
+  AST_VariableIdentifier,
+  AST_ScalarTypeDefinition,
+  AST_ObjectTypeDefinition,
+  AST_InterfaceTypeDefinition,
+  AST_UnionTypeDefinition,
+  AST_EnumTypeDefinition,
+  AST_InputObjectTypeDefinition,
+  AST_EnumValueDefinition,
+  AST_DirectiveDefinition,
+  AST_DirectiveLocation,
+  AST_FieldDefinition,
+  AST_InputValueDefinition,
+  AST_SchemaDefinition,
+  AST_ScalarTypeExtension,
+  AST_ObjectTypeExtension,
+  AST_InterfaceTypeExtension,
+  AST_UnionTypeExtension,
+  AST_EnumTypeExtension,
+  AST_InputObjectTypeExtension,
+  AST_SchemaExtension,
+  // Not a node class: `query`, `mutation` and `subscription` for a schema definition or extension
+  AST_OperationTypes,
+  AST_NODE_TYPES_COUNT
+} GraphQLAstNodeType;
+
+typedef enum GraphQLAstValueType {
+  AST_VALUE_NIL,
+  AST_VALUE_TRUE,
+  AST_VALUE_FALSE,
+  AST_VALUE_TOKEN, // A name or keyword, read from the source string
+  AST_VALUE_INT,
+  AST_VALUE_FLOAT,
+  AST_VALUE_OBJECT, // A Ruby object, for example an unescaped string
+  AST_VALUE_NODE,
+  AST_VALUE_LIST,
+  AST_VALUE_NONE, // The frozen empty list
+  AST_VALUE_COMMENT // `#` comment lines, read from the source string
+} GraphQLAstValueType;
+
+typedef struct GraphQLAstValue {
+  int type;
+  int token_type; // For tokens, INT and FLOAT
+  union {
+    struct {
+      long offset;
+      long length;
+    } span;
+    VALUE object;
+    struct GraphQLAstNode *node;
+    struct GraphQLAstList *list;
+  } as;
+} GraphQLAstValue;
+
+typedef struct GraphQLAstNode {
+  int node_type;
+  int id; // This node's index in `GraphQLDocument.nodes`
+  long pos; // The byte offset of the node's first token, see `document_line_at`
+  int values_count;
+  GraphQLAstValue values[]; // The arguments to `.from_a` after `filename`, `line` and `col`
+} GraphQLAstNode;
+
+typedef struct GraphQLAstListItem {
+  GraphQLAstValue value;
+  struct GraphQLAstListItem *next;
+} GraphQLAstListItem;
+
+typedef struct GraphQLAstList {
+  long length;
+  GraphQLAstListItem *first;
+  GraphQLAstListItem *last;
+} GraphQLAstList;
+
+typedef struct GraphQLArenaBlock {
+  struct GraphQLArenaBlock *next;
+  size_t size;
+  size_t used;
+  char data[];
+} GraphQLArenaBlock;
+
+// Counted by the parser as rules reduce, for `Document#parse_stats`
+typedef struct GraphQLParseStats {
+  long depth; // The selection sets open right now
+  long max_depth;
+  long fields;
+  long aliases;
+  long directives;
+  long fragment_spreads;
+  long max_list_size;
+} GraphQLParseStats;
+
+typedef struct GraphQLDocument {
+  // The arena and `nodes` come from `malloc`, so that they can grow on threads which don't hold the GVL
+  // or aren't Ruby threads at all. Their size is given to GC by `document_report_memory`.
+  GraphQLArenaBlock *blocks;
+  size_t arena_size;
+  size_t reported_size;
+  int without_gvl; // If set, running out of memory can't raise `NoMemoryError`
+  VALUE self; // The `GraphQL::CParser::Document` which owns this struct
+  VALUE source;
+  VALUE filename;
+  int intern_identifiers;
+  // If `use_atoms` is set, each identifier is made once per document, or taken from `seed_atoms`
+  int use_atoms;
+  GraphQLAtomTable atoms;
+  VALUE seed_atoms; // A `GraphQL::CParser::AtomTable`, or Qnil
+  // Ruby objects referenced by the arena, so that GC doesn't free them
+  VALUE *objects;
+  long objects_count;
+  long objects_capacity;
+  GraphQLAstNode **nodes;
+  long nodes_count;
+  long nodes_capacity;
+  GraphQLAstValue root;
+  // The byte offset of each line break in `source`, made the first time a node's position is read
+  long *line_ends;
+  long line_ends_count;
+  int has_line_ends;
+  int shareable; // See `materialize_document`
+  GraphQLParseStats stats;
+} GraphQLDocument;
+
+#define AST_VALUE(value_type) ((GraphQLAstValue){ .type = value_type })
+#define AST_NIL AST_VALUE(AST_VALUE_NIL)
+#define AST_NONE AST_VALUE(AST_VALUE_NONE)
+#define AST_TRUE AST_VALUE(AST_VALUE_TRUE)
+#define AST_FALSE AST_VALUE(AST_VALUE_FALSE)
+#define AST_NODE_VALUE(ast_node) ((GraphQLAstValue){ .type = AST_VALUE_NODE, .as.node = ast_node })
+
+VALUE document_new(VALUE source, VALUE filename, int intern_identifiers, VALUE atoms);
+GraphQLDocument *get_document(VALUE document);
+GraphQLAstNode *ast_node_new(GraphQLDocument *doc, int node_type, long pos, int values_count, ...);
+GraphQLAstValue ast_list_new(GraphQLDocument *doc);
+void ast_list_push(GraphQLDocument *doc, GraphQLAstValue list, GraphQLAstValue value);
+GraphQLAstValue ast_object_value(GraphQLDocument *doc, VALUE object);
+GraphQLAstValue ast_static_value(VALUE object);
+GraphQLAstValue ast_token_value(GraphQLDocument *doc, int token_type, long offset, long length, VALUE token_value);
+GraphQLAstValue ast_comment_value(long offset, long length);
+GraphQLAstValue ast_number_value(GraphQLDocument *doc, int value_type, int token_type, long offset, long length);
+long document_line_at(GraphQLDocument *doc, long pos);
+long document_column_at(GraphQLDocument *doc, long pos);
+void document_position_at(GraphQLDocument *doc, long pos, long *line, long *col);
+void document_freeze(GraphQLDocument *doc);
+VALUE materialize_document(GraphQLDocument *doc, int lazy, int shareable);
+VALUE materialize_children(GraphQLDocument *doc, VALUE lazy_node, long node_id);
+void register_lazy_node_class(VALUE node_class, VALUE lazy_class, VALUE children_ivars);
+void document_report_memory(GraphQLDocument *doc);
+void free_document_arena(GraphQLDocument *doc);
+void initialize_document_class(VALUE document_class);
+void initialize_node_layouts(void);
+#endif
@@ -0,0 +1,161 @@
+#include "atoms.h"
+#include <ruby/encoding.h>
+
+#define ATOM_TABLE_MIN_CAPACITY 64
+
+static VALUE GraphQL_CParser_AtomTable;
+
+static long atom_table_slot(GraphQLAtomTable *table, const char *ptr, long length, st_index_t hash) {
+  long mask = table->capacity - 1;
+  long slot = (long)(hash & mask);
+  while (table->strings[slot]) {
+    VALUE string = table->strings[slot];
+    if (table->hashes[slot] == hash && RSTRING_LEN(string) == length && memcmp(RSTRING_PTR(string), ptr, length) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+// GC may run during these allocations, so `table` is only changed after them
+static void atom_table_grow(GraphQLAtomTable *table) {
+  GraphQLAtomTable old_table = *table;
+  long capacity = old_table.capacity == 0 ? ATOM_TABLE_MIN_CAPACITY : old_table.capacity * 2;
+  VALUE *strings = ZALLOC_N(VALUE, capacity);
+  st_index_t *hashes = ALLOC_N(st_index_t, capacity);
+  table->strings = strings;
+  table->hashes = hashes;
+  table->capacity = capacity;
+  for (long i = 0; i < old_table.capacity; i++) {
+    if (old_table.strings[i]) {
+      long slot = atom_table_slot(table, RSTRING_PTR(old_table.strings[i]), RSTRING_LEN(old_table.strings[i]), old_table.hashes[i]);
+      table->strings[slot] = old_table.strings[i];
+      table->hashes[slot] = old_table.hashes[i];
+    }
+  }
+  xfree(old_table.strings);
+  xfree(old_table.hashes);
+}
+
+VALUE atom_table_lookup(GraphQLAtomTable *table, const char *ptr, long length, st_index_t hash) {
+  if (table->count == 0) {
+    return 0;
+  }
+  return table->strings[atom_table_slot(table, ptr, length, hash)];
+}
+
+static void atom_table_insert(GraphQLAtomTable *table, VALUE string, st_index_t hash) {
+  // Keep the table at most half full
+  if ((table->count + 1) * 2 > table->capacity) {
+    atom_table_grow(table);
+  }
+  long slot = atom_table_slot(table, RSTRING_PTR(string), RSTRING_LEN(string), hash);
+  if (!table->strings[slot]) {
+    table->strings[slot] = string;
+    table->hashes[slot] = hash;
+    table->count++;
+  }
+}
+
+VALUE atom_table_fetch(GraphQLAtomTable *table, const char *ptr, long length, st_index_t hash) {
+  VALUE string = atom_table_lookup(table, ptr, length, hash);
+  if (!string) {
+    string = rb_obj_freeze(rb_utf8_str_new(ptr, length));
+    atom_table_insert(table, string, hash);
+  }
+  return string;
+}
+
+void atom_table_add(GraphQLAtomTable *table, VALUE string) {
+  atom_table_insert(table, string, rb_memhash(RSTRING_PTR(string), RSTRING_LEN(string)));
+}
+
+void atom_table_mark(GraphQLAtomTable *table) {
+  for (long i = 0; i < table->capacity; i++) {
+    if (table->strings[i]) {
+      rb_gc_mark(table->strings[i]);
+    }
+  }
+}
+
+void atom_table_free(GraphQLAtomTable *table) {
+  xfree(table->strings);
+  xfree(table->hashes);
+  table->strings = NULL;
+  table->hashes = NULL;
+  table->capacity = 0;
+  table->count = 0;
+}
+
+size_t atom_table_memsize(const GraphQLAtomTable *table) {
+  return table->capacity * (sizeof(VALUE) + sizeof(st_index_t));
+}
+
+static void atom_table_object_mark(void *ptr) {
+  atom_table_mark(ptr);
+}
+
+static void atom_table_object_free(void *ptr) {
+  atom_table_free(ptr);
+  xfree(ptr);
+}
+
+static size_t atom_table_object_memsize(const void *ptr) {
+  return sizeof(GraphQLAtomTable) + atom_table_memsize(ptr);
+}
+
+static const rb_data_type_t atom_table_data_type = {
+  "GraphQL::CParser::AtomTable",
+  { atom_table_object_mark, atom_table_object_free, atom_table_object_memsize, },
+  // Tables are frozen once they're initialized, so other Ractors can read them
+  0, 0, RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_FROZEN_SHAREABLE
+};
+
+GraphQLAtomTable *get_atom_table(VALUE atom_table) {
+  GraphQLAtomTable *table;
+  TypedData_Get_Struct(atom_table, GraphQLAtomTable, &atom_table_data_type, table);
+  return table;
+}
+
+static VALUE atom_table_alloc(VALUE klass) {
+  GraphQLAtomTable *table;
+  return TypedData_Make_Struct(klass, GraphQLAtomTable, &atom_table_data_type, table);
+}
+
+// Add frozen, UTF-8 copies of `names`; they're returned for matching identifiers instead of new Strings
+static VALUE atom_table_initialize(VALUE self, VALUE names) {
+  rb_check_frozen(self);
+  GraphQLAtomTable *table = get_atom_table(self);
+  names = rb_Array(names);
+  for (long i = 0; i < RARRAY_LEN(names); i++) {
+    VALUE name = rb_ary_entry(names, i);
+    StringValue(name);
+    if (!(OBJ_FROZEN(name) && rb_enc_get_index(name) == rb_utf8_encindex())) {
+      // GraphQL names are ASCII, so their bytes are the same in UTF-8
+      name = rb_obj_freeze(rb_enc_associate(rb_str_dup(name), rb_utf8_encoding()));
+    }
+    atom_table_add(table, name);
+  }
+  return rb_obj_freeze(self);
+}
+
+static VALUE atom_table_size(VALUE self) {
+  return LONG2NUM(get_atom_table(self)->count);
+}
+
+static VALUE atom_table_aref(VALUE self, VALUE name) {
+  StringValue(name);
+  GraphQLAtomTable *table = get_atom_table(self);
+  VALUE string = atom_table_lookup(table, RSTRING_PTR(name), RSTRING_LEN(name), rb_memhash(RSTRING_PTR(name), RSTRING_LEN(name)));
+  return string ? string : Qnil;
+}
+
+void initialize_atom_table_class(VALUE atom_table_class) {
+  GraphQL_CParser_AtomTable = atom_table_class;
+  rb_global_variable(&GraphQL_CParser_AtomTable);
+  rb_define_alloc_func(atom_table_class, atom_table_alloc);
+  rb_define_method(atom_table_class, "initialize", atom_table_initialize, 1);
+  rb_define_method(atom_table_class, "size", atom_table_size, 0);
+  rb_define_method(atom_table_class, "[]", atom_table_aref, 1);
+}
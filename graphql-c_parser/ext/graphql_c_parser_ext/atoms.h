@@ -0,0 +1,24 @@
+#ifndef Graphql_atoms_h
+#define Graphql_atoms_h
+#include <ruby.h>
+
+// A hash set of frozen Strings, looked up by their bytes, so that each identifier
+// in a document is made once. See `GraphQL::CParser::AtomTable`.
+typedef struct GraphQLAtomTable {
+  VALUE *strings; // Open addressing, 0 for an empty slot
+  st_index_t *hashes;
+  long capacity;
+  long count;
+} GraphQLAtomTable;
+
+// Returns the String with these bytes, or 0 if there isn't one
+VALUE atom_table_lookup(GraphQLAtomTable *table, const char *ptr, long length, st_index_t hash);
+// Returns the String with these bytes, making and adding a frozen one if there isn't one yet
+VALUE atom_table_fetch(GraphQLAtomTable *table, const char *ptr, long length, st_index_t hash);
+void atom_table_add(GraphQLAtomTable *table, VALUE string);
+void atom_table_mark(GraphQLAtomTable *table);
+void atom_table_free(GraphQLAtomTable *table);
+size_t atom_table_memsize(const GraphQLAtomTable *table);
+GraphQLAtomTable *get_atom_table(VALUE atom_table);
+void initialize_atom_table_class(VALUE atom_table_class);
+#endif
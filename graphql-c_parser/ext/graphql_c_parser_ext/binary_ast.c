@@ -0,0 +1,755 @@
+#include "binary_ast.h"
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Sizes of the header and each section's entries, see binary_ast.h
+#define HEADER_SIZE 40
+#define NUMBER_SIZE 8
+#define STRING_ENTRY_SIZE 8
+#define CLASS_ENTRY_SIZE 12
+#define CLASS_IVAR_SIZE 4
+#define NODE_ENTRY_SIZE 8
+#define ARRAY_ENTRY_SIZE 8
+#define VALUE_SIZE 4
+
+#define BINARY_AST_MAX_IVARS 32
+// Lists of values nested deeper than this are left to `Marshal`. (Nodes aren't nested in C: they're written and read in order.)
+#define BINARY_AST_MAX_DEPTH 256
+
+static VALUE GraphQL_Language_Nodes_AbstractNode;
+static VALUE GraphQL_Language_Nodes_NONE;
+static ID id_marshal_dump;
+static ID id_marshal_load;
+
+static uint32_t get_u32(const uint8_t *p) {
+  return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+  return ((uint64_t)get_u32(p)) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+typedef struct BinaryAstBuffer {
+  uint8_t *ptr;
+  size_t length;
+  size_t capacity;
+} BinaryAstBuffer;
+
+// Make room for `size` more bytes and return their offset
+static size_t buffer_reserve(BinaryAstBuffer *buffer, size_t size) {
+  size_t offset = buffer->length;
+  if (offset + size > buffer->capacity) {
+    size_t capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+    while (capacity < offset + size) {
+      capacity *= 2;
+    }
+    REALLOC_N(buffer->ptr, uint8_t, capacity);
+    buffer->capacity = capacity;
+  }
+  buffer->length += size;
+  return offset;
+}
+
+static void buffer_put_u32(BinaryAstBuffer *buffer, size_t offset, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    buffer->ptr[offset + i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+static void buffer_put_u64(BinaryAstBuffer *buffer, size_t offset, uint64_t value) {
+  buffer_put_u32(buffer, offset, (uint32_t)value);
+  buffer_put_u32(buffer, offset + 4, (uint32_t)(value >> 32));
+}
+
+// How to read a class's instance variables from its `marshal_dump`
+typedef struct BinaryAstWriterClass {
+  long arity;
+  int ivars_count;
+  int marshal_indexes[BINARY_AST_MAX_IVARS];
+} BinaryAstWriterClass;
+
+typedef struct BinaryAstWriter {
+  VALUE root;
+  BinaryAstBuffer numbers;
+  BinaryAstBuffer strings;
+  BinaryAstBuffer classes;
+  BinaryAstBuffer class_ivars;
+  BinaryAstBuffer nodes;
+  BinaryAstBuffer arrays;
+  BinaryAstBuffer values;
+  BinaryAstBuffer string_bytes;
+  BinaryAstBuffer class_layouts; // A `BinaryAstWriterClass` for each class
+  // Objects are written once, then referenced by index, so that shared objects are still shared after they're read
+  st_table *string_indexes; // Strings and symbols
+  st_table *array_indexes;
+  st_table *node_indexes;
+  st_table *class_indexes;
+  VALUE node_objects; // Nodes in the order of the node table, written after the root value
+  VALUE keep_alive; // `marshal_dump` results, so that objects in the tables above aren't freed while they're used as keys
+} BinaryAstWriter;
+
+static uint32_t add_number(BinaryAstWriter *writer, uint64_t bits) {
+  size_t offset = buffer_reserve(&writer->numbers, NUMBER_SIZE);
+  buffer_put_u64(&writer->numbers, offset, bits);
+  return (uint32_t)(offset / NUMBER_SIZE);
+}
+
+static uint32_t add_string(BinaryAstWriter *writer, const char *ptr, long length, uint32_t flags) {
+  size_t entry = buffer_reserve(&writer->strings, STRING_ENTRY_SIZE);
+  size_t offset = buffer_reserve(&writer->string_bytes, length);
+  memcpy(writer->string_bytes.ptr + offset, ptr, length);
+  buffer_put_u32(&writer->strings, entry, (uint32_t)offset);
+  buffer_put_u32(&writer->strings, entry + 4, (uint32_t)length << BINARY_AST_FLAGS_BITS | flags);
+  return (uint32_t)(entry / STRING_ENTRY_SIZE);
+}
+
+static uint32_t encoding_flags(VALUE str) {
+  int encindex = rb_enc_get_index(str);
+  if (encindex == rb_utf8_encindex()) {
+    return BINARY_AST_ENCODING_UTF_8;
+  } else if (encindex == rb_ascii8bit_encindex()) {
+    return BINARY_AST_ENCODING_ASCII_8BIT;
+  } else if (encindex == rb_usascii_encindex()) {
+    return BINARY_AST_ENCODING_US_ASCII;
+  }
+  rb_raise(rb_eTypeError, "Can't write a %s string to a binary AST", rb_enc_name(rb_enc_from_index(encindex)));
+}
+
+// `key` is the string itself, or a symbol and `str` is its name
+static uint32_t string_index(BinaryAstWriter *writer, VALUE key, VALUE str) {
+  st_data_t index;
+  if (st_lookup(writer->string_indexes, (st_data_t)key, &index)) {
+    return (uint32_t)index;
+  }
+  uint32_t flags = encoding_flags(str) | (OBJ_FROZEN(key) ? BINARY_AST_FROZEN : 0);
+  index = add_string(writer, RSTRING_PTR(str), RSTRING_LEN(str), flags);
+  st_insert(writer->string_indexes, (st_data_t)key, index);
+  return (uint32_t)index;
+}
+
+static uint32_t node_index(BinaryAstWriter *writer, VALUE node) {
+  st_data_t index;
+  if (!st_lookup(writer->node_indexes, (st_data_t)node, &index)) {
+    index = RARRAY_LEN(writer->node_objects);
+    rb_ary_push(writer->node_objects, node);
+    st_insert(writer->node_indexes, (st_data_t)node, index);
+  }
+  return (uint32_t)index;
+}
+
+static uint32_t array_index(BinaryAstWriter *writer, VALUE array, int depth);
+
+// Write `value` to the value slot at `value_index`, which was already reserved
+static void write_value(BinaryAstWriter *writer, size_t value_index, VALUE value, int depth) {
+  uint32_t tag;
+  uint32_t argument = 0;
+  if (NIL_P(value)) {
+    tag = BINARY_AST_NIL;
+  } else if (value == Qtrue) {
+    tag = BINARY_AST_TRUE;
+  } else if (value == Qfalse) {
+    tag = BINARY_AST_FALSE;
+  } else if (FIXNUM_P(value)) {
+    long number = FIX2LONG(value);
+    if (number >= BINARY_AST_MIN_INT && number <= BINARY_AST_MAX_INT) {
+      tag = BINARY_AST_INT;
+      argument = (uint32_t)number & BINARY_AST_MAX_INDEX;
+    } else {
+      tag = BINARY_AST_INT64;
+      argument = add_number(writer, (uint64_t)(int64_t)number);
+    }
+  } else if (RB_FLOAT_TYPE_P(value)) {
+    double number = RFLOAT_VALUE(value);
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    tag = BINARY_AST_FLOAT;
+    argument = add_number(writer, bits);
+  } else if (RB_TYPE_P(value, T_BIGNUM)) {
+    VALUE digits = rb_big2str(value, 10);
+    tag = BINARY_AST_BIGNUM;
+    argument = add_string(writer, RSTRING_PTR(digits), RSTRING_LEN(digits), BINARY_AST_ENCODING_US_ASCII | BINARY_AST_FROZEN);
+    RB_GC_GUARD(digits);
+  } else if (SYMBOL_P(value)) {
+    tag = BINARY_AST_SYMBOL;
+    argument = string_index(writer, value, rb_sym2str(value));
+  } else if (rb_obj_class(value) == rb_cString) {
+    tag = BINARY_AST_STRING;
+    argument = string_index(writer, value, value);
+  } else if (rb_obj_class(value) == rb_cArray) {
+    if (RARRAY_LEN(value) == 0 && OBJ_FROZEN(value)) {
+      tag = BINARY_AST_NONE;
+    } else {
+      tag = BINARY_AST_ARRAY;
+      argument = array_index(writer, value, depth);
+    }
+  } else if (RTEST(rb_obj_is_kind_of(value, GraphQL_Language_Nodes_AbstractNode))) {
+    tag = BINARY_AST_NODE;
+    argument = node_index(writer, value);
+  } else {
+    rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST", rb_obj_class(value));
+  }
+  buffer_put_u32(&writer->values, value_index * VALUE_SIZE, argument << BINARY_AST_TAG_BITS | tag);
+}
+
+static uint32_t array_index(BinaryAstWriter *writer, VALUE array, int depth) {
+  st_data_t index;
+  if (st_lookup(writer->array_indexes, (st_data_t)array, &index)) {
+    return (uint32_t)index;
+  }
+  if (depth >= BINARY_AST_MAX_DEPTH) {
+    rb_raise(rb_eTypeError, "Can't write arrays nested more than %d deep to a binary AST", BINARY_AST_MAX_DEPTH);
+  }
+  long length = RARRAY_LEN(array);
+  size_t entry = buffer_reserve(&writer->arrays, ARRAY_ENTRY_SIZE);
+  index = entry / ARRAY_ENTRY_SIZE;
+  st_insert(writer->array_indexes, (st_data_t)array, index);
+  size_t first_value = buffer_reserve(&writer->values, VALUE_SIZE * length) / VALUE_SIZE;
+  buffer_put_u32(&writer->arrays, entry, (uint32_t)first_value);
+  buffer_put_u32(&writer->arrays, entry + 4, (uint32_t)length << BINARY_AST_FLAGS_BITS | (OBJ_FROZEN(array) ? BINARY_AST_FROZEN : 0));
+  for (long i = 0; i < length; i++) {
+    write_value(writer, first_value + i, RARRAY_AREF(array, i), depth + 1);
+  }
+  return (uint32_t)index;
+}
+
+// Learn which `marshal_dump` value each of `node_class`'s instance variables gets,
+// by calling `marshal_load` with placeholder objects, then add the class to the class table.
+// (It's like `initialize_node_layout` in ast.c, but with `marshal_load` instead of `.from_a`.)
+static long class_index(BinaryAstWriter *writer, VALUE node_class, VALUE marshal_data) {
+  st_data_t index;
+  if (st_lookup(writer->class_indexes, (st_data_t)node_class, &index)) {
+    return (long)index;
+  }
+  VALUE class_name = rb_mod_name(node_class);
+  if (NIL_P(class_name)) {
+    rb_raise(rb_eTypeError, "Can't write an anonymous class to a binary AST");
+  }
+  BinaryAstWriterClass layout;
+  layout.arity = RARRAY_LEN(marshal_data);
+  if (layout.arity > BINARY_AST_MAX_IVARS) {
+    rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST: `marshal_dump` returned too many values", node_class);
+  }
+  VALUE placeholders = rb_ary_new_capa(layout.arity);
+  for (long i = 0; i < layout.arity; i++) {
+    rb_ary_push(placeholders, rb_obj_alloc(rb_cObject));
+  }
+  VALUE probe = rb_obj_alloc(node_class);
+  rb_funcall(probe, id_marshal_load, 1, rb_ary_dup(placeholders));
+  VALUE ivar_names = rb_obj_instance_variables(probe);
+  if (RARRAY_LEN(ivar_names) > BINARY_AST_MAX_IVARS) {
+    rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST: `marshal_load` assigned too many instance variables", node_class);
+  }
+  layout.ivars_count = (int)RARRAY_LEN(ivar_names);
+  size_t entry = buffer_reserve(&writer->classes, CLASS_ENTRY_SIZE);
+  uint32_t first_ivar = (uint32_t)(writer->class_ivars.length / CLASS_IVAR_SIZE);
+  for (int i = 0; i < layout.ivars_count; i++) {
+    VALUE ivar_name = rb_ary_entry(ivar_names, i);
+    VALUE ivar_value = rb_ivar_get(probe, SYM2ID(ivar_name));
+    layout.marshal_indexes[i] = -1;
+    for (long j = 0; j < layout.arity; j++) {
+      if (RARRAY_AREF(placeholders, j) == ivar_value) {
+        layout.marshal_indexes[i] = (int)j;
+      }
+    }
+    if (layout.marshal_indexes[i] == -1) {
+      rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST: `marshal_load` doesn't assign %"PRIsVALUE" from its argument", node_class, ivar_name);
+    }
+    size_t ivar_entry = buffer_reserve(&writer->class_ivars, CLASS_IVAR_SIZE);
+    buffer_put_u32(&writer->class_ivars, ivar_entry, string_index(writer, ivar_name, rb_sym2str(ivar_name)));
+  }
+  uint32_t name_index = add_string(writer, RSTRING_PTR(class_name), RSTRING_LEN(class_name), encoding_flags(class_name) | BINARY_AST_FROZEN);
+  buffer_put_u32(&writer->classes, entry, name_index);
+  buffer_put_u32(&writer->classes, entry + 4, (uint32_t)layout.ivars_count);
+  buffer_put_u32(&writer->classes, entry + 8, first_ivar);
+  size_t layout_offset = buffer_reserve(&writer->class_layouts, sizeof(BinaryAstWriterClass));
+  memcpy(writer->class_layouts.ptr + layout_offset, &layout, sizeof(BinaryAstWriterClass));
+  index = entry / CLASS_ENTRY_SIZE;
+  st_insert(writer->class_indexes, (st_data_t)node_class, index);
+  RB_GC_GUARD(placeholders);
+  RB_GC_GUARD(probe);
+  return (long)index;
+}
+
+static void write_node(BinaryAstWriter *writer, VALUE node) {
+  VALUE marshal_data = rb_funcall(node, id_marshal_dump, 0);
+  if (!RB_TYPE_P(marshal_data, T_ARRAY)) {
+    rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST: `marshal_dump` didn't return an Array", rb_obj_class(node));
+  }
+  rb_ary_push(writer->keep_alive, marshal_data);
+  long index = class_index(writer, rb_obj_class(node), marshal_data);
+  BinaryAstWriterClass layout;
+  memcpy(&layout, writer->class_layouts.ptr + index * sizeof(BinaryAstWriterClass), sizeof(BinaryAstWriterClass));
+  if (RARRAY_LEN(marshal_data) != layout.arity) {
+    rb_raise(rb_eTypeError, "Can't write %"PRIsVALUE" to a binary AST: `marshal_dump` returned a different number of values", rb_obj_class(node));
+  }
+  size_t entry = buffer_reserve(&writer->nodes, NODE_ENTRY_SIZE);
+  size_t first_value = buffer_reserve(&writer->values, VALUE_SIZE * layout.ivars_count) / VALUE_SIZE;
+  buffer_put_u32(&writer->nodes, entry, (uint32_t)index);
+  buffer_put_u32(&writer->nodes, entry + 4, (uint32_t)first_value);
+  for (int i = 0; i < layout.ivars_count; i++) {
+    write_value(writer, first_value + i, RARRAY_AREF(marshal_data, layout.marshal_indexes[i]), 0);
+  }
+}
+
+static VALUE binary_ast_write(VALUE arg) {
+  BinaryAstWriter *writer = (BinaryAstWriter *)arg;
+  // The root value is the first value
+  buffer_reserve(&writer->values, VALUE_SIZE);
+  write_value(writer, 0, writer->root, 0);
+  // Nodes are added to `writer->node_objects` when they're first referenced, so this visits each of them once
+  for (long i = 0; i < RARRAY_LEN(writer->node_objects); i++) {
+    write_node(writer, RARRAY_AREF(writer->node_objects, i));
+  }
+
+  BinaryAstBuffer *sections[] = {
+    &writer->numbers, &writer->strings, &writer->classes, &writer->class_ivars,
+    &writer->nodes, &writer->arrays, &writer->values, &writer->string_bytes
+  };
+  size_t entry_sizes[] = {
+    NUMBER_SIZE, STRING_ENTRY_SIZE, CLASS_ENTRY_SIZE, CLASS_IVAR_SIZE,
+    NODE_ENTRY_SIZE, ARRAY_ENTRY_SIZE, VALUE_SIZE, 1
+  };
+  size_t sections_count = sizeof(sections) / sizeof(sections[0]);
+  size_t total_size = HEADER_SIZE;
+  for (size_t i = 0; i < sections_count; i++) {
+    if (sections[i]->length / entry_sizes[i] > BINARY_AST_MAX_INDEX) {
+      rb_raise(rb_eTypeError, "Can't write this document to a binary AST: it's too big");
+    }
+    total_size += sections[i]->length;
+  }
+
+  VALUE result = rb_str_new(NULL, total_size);
+  BinaryAstBuffer header = { (uint8_t *)RSTRING_PTR(result), 0, total_size };
+  memcpy(header.ptr, BINARY_AST_MAGIC, 4);
+  buffer_put_u32(&header, 4, BINARY_AST_VERSION);
+  size_t offset = HEADER_SIZE;
+  for (size_t i = 0; i < sections_count; i++) {
+    buffer_put_u32(&header, 8 + 4 * i, (uint32_t)(sections[i]->length / entry_sizes[i]));
+    if (sections[i]->length > 0) {
+      memcpy(header.ptr + offset, sections[i]->ptr, sections[i]->length);
+    }
+    offset += sections[i]->length;
+  }
+  return result;
+}
+
+static VALUE binary_ast_writer_free(VALUE arg) {
+  BinaryAstWriter *writer = (BinaryAstWriter *)arg;
+  xfree(writer->numbers.ptr);
+  xfree(writer->strings.ptr);
+  xfree(writer->classes.ptr);
+  xfree(writer->class_ivars.ptr);
+  xfree(writer->nodes.ptr);
+  xfree(writer->arrays.ptr);
+  xfree(writer->values.ptr);
+  xfree(writer->string_bytes.ptr);
+  xfree(writer->class_layouts.ptr);
+  st_free_table(writer->string_indexes);
+  st_free_table(writer->array_indexes);
+  st_free_table(writer->node_indexes);
+  st_free_table(writer->class_indexes);
+  return Qnil;
+}
+
+// Nodes are written with their `marshal_dump`. Other objects may be `nil`, booleans, numbers,
+// symbols, strings (UTF-8, US-ASCII or binary) and arrays of those. For anything else, this raises `TypeError`.
+static VALUE binary_ast_dump(VALUE self, VALUE root) {
+  BinaryAstWriter writer;
+  memset(&writer, 0, sizeof(writer));
+  writer.root = root;
+  writer.node_objects = rb_ary_new();
+  writer.keep_alive = rb_ary_new();
+  writer.string_indexes = st_init_numtable();
+  writer.array_indexes = st_init_numtable();
+  writer.node_indexes = st_init_numtable();
+  writer.class_indexes = st_init_numtable();
+  VALUE result = rb_ensure(binary_ast_write, (VALUE)&writer, binary_ast_writer_free, (VALUE)&writer);
+  RB_GC_GUARD(writer.root);
+  RB_GC_GUARD(writer.node_objects);
+  RB_GC_GUARD(writer.keep_alive);
+  return result;
+}
+
+typedef struct BinaryAstReader {
+  const uint8_t *data;
+  size_t size;
+  uint32_t numbers_count;
+  uint32_t strings_count;
+  uint32_t classes_count;
+  uint32_t class_ivars_count;
+  uint32_t nodes_count;
+  uint32_t arrays_count;
+  uint32_t values_count;
+  uint32_t string_bytes_size;
+  const uint8_t *numbers;
+  const uint8_t *strings;
+  const uint8_t *classes;
+  const uint8_t *class_ivars;
+  const uint8_t *nodes;
+  const uint8_t *arrays;
+  const uint8_t *values;
+  const uint8_t *string_bytes;
+  ID *class_ivar_ids;
+  // Each of these has an entry for each index, `nil` until it's read
+  VALUE node_classes;
+  VALUE loaded_strings;
+  VALUE loaded_arrays;
+  VALUE loaded_nodes;
+} BinaryAstReader;
+
+NORETURN(static void raise_invalid(const char *reason));
+
+static void raise_invalid(const char *reason) {
+  rb_raise(rb_eArgError, "Invalid binary AST: %s", reason);
+}
+
+static void read_header(BinaryAstReader *reader) {
+  if (reader->size < HEADER_SIZE || memcmp(reader->data, BINARY_AST_MAGIC, 4) != 0) {
+    raise_invalid("it doesn't start with " BINARY_AST_MAGIC);
+  }
+  if (get_u32(reader->data + 4) != BINARY_AST_VERSION) {
+    raise_invalid("it was written by a different version of graphql-c_parser");
+  }
+  reader->numbers_count = get_u32(reader->data + 8);
+  reader->strings_count = get_u32(reader->data + 12);
+  reader->classes_count = get_u32(reader->data + 16);
+  reader->class_ivars_count = get_u32(reader->data + 20);
+  reader->nodes_count = get_u32(reader->data + 24);
+  reader->arrays_count = get_u32(reader->data + 28);
+  reader->values_count = get_u32(reader->data + 32);
+  reader->string_bytes_size = get_u32(reader->data + 36);
+
+  uint64_t offsets[8];
+  uint64_t offset = HEADER_SIZE;
+  offsets[0] = offset; offset += (uint64_t)reader->numbers_count * NUMBER_SIZE;
+  offsets[1] = offset; offset += (uint64_t)reader->strings_count * STRING_ENTRY_SIZE;
+  offsets[2] = offset; offset += (uint64_t)reader->classes_count * CLASS_ENTRY_SIZE;
+  offsets[3] = offset; offset += (uint64_t)reader->class_ivars_count * CLASS_IVAR_SIZE;
+  offsets[4] = offset; offset += (uint64_t)reader->nodes_count * NODE_ENTRY_SIZE;
+  offsets[5] = offset; offset += (uint64_t)reader->arrays_count * ARRAY_ENTRY_SIZE;
+  offsets[6] = offset; offset += (uint64_t)reader->values_count * VALUE_SIZE;
+  offsets[7] = offset; offset += reader->string_bytes_size;
+  if (offset != reader->size) {
+    raise_invalid("its size doesn't match its header");
+  }
+  if (reader->values_count == 0) {
+    raise_invalid("it doesn't have a root value");
+  }
+  reader->numbers = reader->data + offsets[0];
+  reader->strings = reader->data + offsets[1];
+  reader->classes = reader->data + offsets[2];
+  reader->class_ivars = reader->data + offsets[3];
+  reader->nodes = reader->data + offsets[4];
+  reader->arrays = reader->data + offsets[5];
+  reader->values = reader->data + offsets[6];
+  reader->string_bytes = reader->data + offsets[7];
+}
+
+static rb_encoding *read_string(BinaryAstReader *reader, uint32_t index, const char **ptr, long *length, uint32_t *flags) {
+  if (index >= reader->strings_count) {
+    raise_invalid("a string index is out of range");
+  }
+  const uint8_t *entry = reader->strings + (size_t)index * STRING_ENTRY_SIZE;
+  uint32_t offset = get_u32(entry);
+  uint32_t string_length = get_u32(entry + 4) >> BINARY_AST_FLAGS_BITS;
+  *flags = get_u32(entry + 4);
+  if ((uint64_t)offset + string_length > reader->string_bytes_size) {
+    raise_invalid("a string is out of range");
+  }
+  *ptr = (const char *)reader->string_bytes + offset;
+  *length = (long)string_length;
+  switch (*flags & BINARY_AST_ENCODING_MASK) {
+    case BINARY_AST_ENCODING_UTF_8:
+      return rb_utf8_encoding();
+    case BINARY_AST_ENCODING_ASCII_8BIT:
+      return rb_ascii8bit_encoding();
+    case BINARY_AST_ENCODING_US_ASCII:
+      return rb_usascii_encoding();
+    default:
+      raise_invalid("a string has an unknown encoding");
+  }
+}
+
+// `rb_intern3` raises `EncodingError` for names which aren't valid in their encoding
+static ID read_name(BinaryAstReader *reader, uint32_t index) {
+  const char *ptr;
+  long length;
+  uint32_t flags;
+  rb_encoding *enc = read_string(reader, index, &ptr, &length, &flags);
+  if (rb_enc_str_coderange(rb_enc_str_new(ptr, length, enc)) == ENC_CODERANGE_BROKEN) {
+    raise_invalid("a name isn't valid in its encoding");
+  }
+  return rb_intern3(ptr, length, enc);
+}
+
+// Each class is looked up once, and must be a node class
+static void read_classes(BinaryAstReader *reader) {
+  const char *ptr;
+  long length;
+  uint32_t flags;
+  for (uint32_t i = 0; i < reader->classes_count; i++) {
+    const uint8_t *entry = reader->classes + (size_t)i * CLASS_ENTRY_SIZE;
+    read_string(reader, get_u32(entry), &ptr, &length, &flags);
+    VALUE node_class = rb_path_to_class(rb_str_new(ptr, length));
+    if (!RTEST(rb_class_inherited_p(node_class, GraphQL_Language_Nodes_AbstractNode))) {
+      rb_raise(rb_eArgError, "Invalid binary AST: %"PRIsVALUE" isn't a subclass of GraphQL::Language::Nodes::AbstractNode", node_class);
+    }
+    if ((uint64_t)get_u32(entry + 8) + get_u32(entry + 4) > reader->class_ivars_count) {
+      raise_invalid("a class's instance variables are out of range");
+    }
+    rb_ary_store(reader->node_classes, i, node_class);
+  }
+  reader->class_ivar_ids = ALLOC_N(ID, reader->class_ivars_count);
+  for (uint32_t i = 0; i < reader->class_ivars_count; i++) {
+    ID ivar_id = read_name(reader, get_u32(reader->class_ivars + (size_t)i * CLASS_IVAR_SIZE));
+    VALUE ivar_name = rb_id2str(ivar_id);
+    if (RSTRING_LEN(ivar_name) < 2 || RSTRING_PTR(ivar_name)[0] != '@' || RSTRING_PTR(ivar_name)[1] == '@') {
+      raise_invalid("an instance variable name is invalid");
+    }
+    reader->class_ivar_ids[i] = ivar_id;
+  }
+}
+
+static VALUE read_node(BinaryAstReader *reader, uint32_t index) {
+  if (index >= reader->nodes_count) {
+    raise_invalid("a node index is out of range");
+  }
+  VALUE node = RARRAY_AREF(reader->loaded_nodes, index);
+  if (NIL_P(node)) {
+    uint32_t node_class_index = get_u32(reader->nodes + (size_t)index * NODE_ENTRY_SIZE);
+    if (node_class_index >= reader->classes_count) {
+      raise_invalid("a class index is out of range");
+    }
+    // Its instance variables are assigned when the node table gets to it
+    node = rb_obj_alloc(RARRAY_AREF(reader->node_classes, node_class_index));
+    rb_ary_store(reader->loaded_nodes, index, node);
+  }
+  return node;
+}
+
+static VALUE read_value(BinaryAstReader *reader, uint64_t value_index, int depth);
+
+static VALUE read_array(BinaryAstReader *reader, uint32_t index, int depth) {
+  if (index >= reader->arrays_count) {
+    raise_invalid("an array index is out of range");
+  }
+  VALUE array = RARRAY_AREF(reader->loaded_arrays, index);
+  if (!NIL_P(array)) {
+    return array;
+  }
+  if (depth >= BINARY_AST_MAX_DEPTH) {
+    raise_invalid("arrays are nested too deeply");
+  }
+  const uint8_t *entry = reader->arrays + (size_t)index * ARRAY_ENTRY_SIZE;
+  uint32_t first_value = get_u32(entry);
+  uint32_t length = get_u32(entry + 4) >> BINARY_AST_FLAGS_BITS;
+  if ((uint64_t)first_value + length > reader->values_count) {
+    raise_invalid("an array's values are out of range");
+  }
+  array = rb_ary_new_capa(length);
+  rb_ary_store(reader->loaded_arrays, index, array);
+  for (uint32_t i = 0; i < length; i++) {
+    rb_ary_push(array, read_value(reader, (uint64_t)first_value + i, depth + 1));
+  }
+  if (get_u32(entry + 4) & BINARY_AST_FROZEN) {
+    rb_ary_freeze(array);
+  }
+  return array;
+}
+
+static VALUE read_value(BinaryAstReader *reader, uint64_t value_index, int depth) {
+  if (value_index >= reader->values_count) {
+    raise_invalid("a value index is out of range");
+  }
+  uint32_t value = get_u32(reader->values + value_index * VALUE_SIZE);
+  uint32_t tag = value & ((1 << BINARY_AST_TAG_BITS) - 1);
+  uint32_t argument = value >> BINARY_AST_TAG_BITS;
+  const char *ptr;
+  long length;
+  uint32_t flags;
+  switch (tag) {
+    case BINARY_AST_NIL:
+      return Qnil;
+    case BINARY_AST_TRUE:
+      return Qtrue;
+    case BINARY_AST_FALSE:
+      return Qfalse;
+    case BINARY_AST_INT:
+      // Sign-extend it
+      return LONG2FIX(argument > BINARY_AST_MAX_INT ? (long)argument - BINARY_AST_MAX_INDEX - 1 : (long)argument);
+    case BINARY_AST_INT64:
+    case BINARY_AST_FLOAT: {
+      if (argument >= reader->numbers_count) {
+        raise_invalid("a number index is out of range");
+      }
+      uint64_t bits = get_u64(reader->numbers + (size_t)argument * NUMBER_SIZE);
+      if (tag == BINARY_AST_INT64) {
+        return LL2NUM((int64_t)bits);
+      }
+      double number;
+      memcpy(&number, &bits, sizeof(number));
+      return DBL2NUM(number);
+    }
+    case BINARY_AST_BIGNUM:
+      read_string(reader, argument, &ptr, &length, &flags);
+      return rb_str_to_inum(rb_str_new(ptr, length), 10, TRUE);
+    case BINARY_AST_STRING: {
+      rb_encoding *enc = read_string(reader, argument, &ptr, &length, &flags);
+      VALUE str = RARRAY_AREF(reader->loaded_strings, argument);
+      if (NIL_P(str)) {
+        str = (flags & BINARY_AST_FROZEN) ? rb_enc_interned_str(ptr, length, enc) : rb_enc_str_new(ptr, length, enc);
+        rb_ary_store(reader->loaded_strings, argument, str);
+      }
+      return str;
+    }
+    case BINARY_AST_SYMBOL:
+      return ID2SYM(read_name(reader, argument));
+    case BINARY_AST_ARRAY:
+      return read_array(reader, argument, depth);
+    case BINARY_AST_NONE:
+      return GraphQL_Language_Nodes_NONE;
+    case BINARY_AST_NODE:
+      return read_node(reader, argument);
+    default:
+      raise_invalid("a value has an unknown tag");
+  }
+}
+
+// Read the root value, then go through the node table once, assigning each node's instance variables.
+// Nodes are made with `rb_obj_alloc` and `rb_ivar_set`, without calling any Ruby methods.
+static VALUE binary_ast_read(VALUE arg) {
+  BinaryAstReader *reader = (BinaryAstReader *)arg;
+  read_header(reader);
+  reader->node_classes = rb_ary_new_capa(reader->classes_count);
+  rb_ary_resize(reader->node_classes, reader->classes_count);
+  reader->loaded_strings = rb_ary_new_capa(reader->strings_count);
+  rb_ary_resize(reader->loaded_strings, reader->strings_count);
+  reader->loaded_arrays = rb_ary_new_capa(reader->arrays_count);
+  rb_ary_resize(reader->loaded_arrays, reader->arrays_count);
+  reader->loaded_nodes = rb_ary_new_capa(reader->nodes_count);
+  rb_ary_resize(reader->loaded_nodes, reader->nodes_count);
+  read_classes(reader);
+
+  VALUE root = read_value(reader, 0, 0);
+  for (uint32_t i = 0; i < reader->nodes_count; i++) {
+    VALUE node = read_node(reader, i);
+    const uint8_t *entry = reader->nodes + (size_t)i * NODE_ENTRY_SIZE;
+    const uint8_t *class_entry = reader->classes + (size_t)get_u32(entry) * CLASS_ENTRY_SIZE;
+    uint32_t first_value = get_u32(entry + 4);
+    uint32_t ivars_count = get_u32(class_entry + 4);
+    ID *ivar_ids = reader->class_ivar_ids + get_u32(class_entry + 8);
+    if ((uint64_t)first_value + ivars_count > reader->values_count) {
+      raise_invalid("a node's values are out of range");
+    }
+    for (uint32_t j = 0; j < ivars_count; j++) {
+      rb_ivar_set(node, ivar_ids[j], read_value(reader, (uint64_t)first_value + j, 0));
+    }
+  }
+  return root;
+}
+
+static VALUE binary_ast_reader_free(VALUE arg) {
+  BinaryAstReader *reader = (BinaryAstReader *)arg;
+  xfree(reader->class_ivar_ids);
+  return Qnil;
+}
+
+static VALUE binary_ast_load_bytes(const uint8_t *data, size_t size) {
+  BinaryAstReader reader;
+  memset(&reader, 0, sizeof(reader));
+  reader.data = data;
+  reader.size = size;
+  reader.node_classes = Qnil;
+  reader.loaded_strings = Qnil;
+  reader.loaded_arrays = Qnil;
+  reader.loaded_nodes = Qnil;
+  VALUE root = rb_ensure(binary_ast_read, (VALUE)&reader, binary_ast_reader_free, (VALUE)&reader);
+  RB_GC_GUARD(reader.node_classes);
+  RB_GC_GUARD(reader.loaded_strings);
+  RB_GC_GUARD(reader.loaded_arrays);
+  RB_GC_GUARD(reader.loaded_nodes);
+  return root;
+}
+
+static VALUE binary_ast_load(VALUE self, VALUE str) {
+  // A frozen copy shares `str`'s bytes, but they can't be changed while they're read
+  str = rb_str_new_frozen(StringValue(str));
+  VALUE root = binary_ast_load_bytes((const uint8_t *)RSTRING_PTR(str), RSTRING_LEN(str));
+  RB_GC_GUARD(str);
+  return root;
+}
+
+#ifdef HAVE_SYS_MMAN_H
+typedef struct BinaryAstMapping {
+  void *ptr;
+  size_t size;
+} BinaryAstMapping;
+
+static VALUE binary_ast_load_mapping(VALUE arg) {
+  BinaryAstMapping *mapping = (BinaryAstMapping *)arg;
+  return binary_ast_load_bytes(mapping->ptr, mapping->size);
+}
+
+static VALUE binary_ast_unmap(VALUE arg) {
+  BinaryAstMapping *mapping = (BinaryAstMapping *)arg;
+  munmap(mapping->ptr, mapping->size);
+  return Qnil;
+}
+#endif
+
+// The file is mapped into memory and read in place, where mmap is available.
+// It must not be truncated while it's read (`GraphQL::Language::Cache` replaces files with `File.rename`).
+static VALUE binary_ast_load_file(VALUE self, VALUE path) {
+  FilePathValue(path);
+#ifdef HAVE_SYS_MMAN_H
+  int fd = rb_cloexec_open(RSTRING_PTR(path), O_RDONLY, 0);
+  if (fd < 0) {
+    rb_sys_fail_str(path);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    int error = errno;
+    close(fd);
+    errno = error;
+    rb_sys_fail_str(path);
+  }
+  if (file_stat.st_size == 0) {
+    close(fd);
+    raise_invalid("the file is empty");
+  }
+  BinaryAstMapping mapping;
+  mapping.size = (size_t)file_stat.st_size;
+  mapping.ptr = mmap(NULL, mapping.size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int error = errno;
+  close(fd);
+  if (mapping.ptr == MAP_FAILED) {
+    errno = error;
+    rb_sys_fail_str(path);
+  }
+  return rb_ensure(binary_ast_load_mapping, (VALUE)&mapping, binary_ast_unmap, (VALUE)&mapping);
+#else
+  return binary_ast_load(self, rb_funcall(rb_cFile, rb_intern("binread"), 1, path));
+#endif
+}
+
+void initialize_binary_ast_module(VALUE binary_ast_module) {
+  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
+  VALUE mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
+  VALUE mGraphQLLanguageNodes = rb_const_get_at(mGraphQLLanguage, rb_intern("Nodes"));
+  GraphQL_Language_Nodes_AbstractNode = rb_const_get_at(mGraphQLLanguageNodes, rb_intern("AbstractNode"));
+  rb_global_variable(&GraphQL_Language_Nodes_AbstractNode);
+  GraphQL_Language_Nodes_NONE = rb_const_get_at(mGraphQLLanguageNodes, rb_intern("NONE"));
+  rb_global_variable(&GraphQL_Language_Nodes_NONE);
+  id_marshal_dump = rb_intern("marshal_dump");
+  id_marshal_load = rb_intern("marshal_load");
+
+  rb_define_singleton_method(binary_ast_module, "dump", binary_ast_dump, 1);
+  rb_define_singleton_method(binary_ast_module, "load", binary_ast_load, 1);
+  rb_define_singleton_method(binary_ast_module, "load_file", binary_ast_load_file, 1);
+}
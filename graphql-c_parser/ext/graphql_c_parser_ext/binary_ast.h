@@ -0,0 +1,55 @@
+#ifndef Graphql_binary_ast_h
+#define Graphql_binary_ast_h
+#include <ruby.h>
+#include <ruby/encoding.h>
+#include <stdint.h>
+
+// A binary format for `GraphQL::Language::Nodes`, used by `GraphQL::Language::Cache` in place of `Marshal`.
+//
+// Everything is little-endian and found by index, not by pointer, so it can be read in place,
+// for example from an mmap'd file. Each entry is made of 32-bit words. After a 40-byte header
+// (`"GQLB"`, the version, then the number of entries in each section), the sections are:
+//
+// - numbers: 8 bytes each, `int64_t` or `double`
+// - strings: `{ offset, length << 3 | flags }`, where `offset` is from the start of `string bytes`
+// - classes: `{ name (a string), ivars count, first ivar }`
+// - class ivars: a string for each instance variable name, in the order the class's `marshal_load` assigns them
+// - nodes: `{ class, first value }`, with a value for each of its class's ivars
+// - arrays: `{ first value, length << 3 | flags }`
+// - values: `argument << 4 | tag`, see `BinaryAstValueTag`. The first value is the root.
+// - string bytes
+#define BINARY_AST_MAGIC "GQLB"
+#define BINARY_AST_VERSION 1
+
+typedef enum BinaryAstValueTag {
+  BINARY_AST_NIL,
+  BINARY_AST_TRUE,
+  BINARY_AST_FALSE,
+  BINARY_AST_INT, // The argument is a signed, 28-bit integer
+  BINARY_AST_INT64, // A number
+  BINARY_AST_BIGNUM, // A string of decimal digits
+  BINARY_AST_FLOAT, // A number
+  BINARY_AST_STRING,
+  BINARY_AST_SYMBOL, // A string
+  BINARY_AST_ARRAY,
+  BINARY_AST_NONE, // `GraphQL::Language::Nodes::NONE`, for any frozen, empty array
+  BINARY_AST_NODE,
+  BINARY_AST_VALUE_TAGS_COUNT
+} BinaryAstValueTag;
+
+// Flags for strings: their encoding is `flags & BINARY_AST_ENCODING_MASK`
+#define BINARY_AST_ENCODING_UTF_8 0
+#define BINARY_AST_ENCODING_ASCII_8BIT 1
+#define BINARY_AST_ENCODING_US_ASCII 2
+#define BINARY_AST_ENCODING_MASK 3
+// Flags for strings and arrays
+#define BINARY_AST_FROZEN 4
+#define BINARY_AST_FLAGS_BITS 3
+#define BINARY_AST_TAG_BITS 4
+// Indexes and small integers must fit in a value's argument
+#define BINARY_AST_MAX_INDEX ((1 << (32 - BINARY_AST_TAG_BITS)) - 1)
+#define BINARY_AST_MIN_INT (-(1 << (32 - BINARY_AST_TAG_BITS - 1)))
+#define BINARY_AST_MAX_INT ((1 << (32 - BINARY_AST_TAG_BITS - 1)) - 1)
+
+void initialize_binary_ast_module(VALUE binary_ast_module);
+#endif
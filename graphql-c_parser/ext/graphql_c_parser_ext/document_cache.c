@@ -0,0 +1,232 @@
+#include "document_cache.h"
+
+static int entry_compare(st_data_t a, st_data_t b) {
+  GraphQLDocumentCacheEntry *entry_a = (GraphQLDocumentCacheEntry *)a;
+  GraphQLDocumentCacheEntry *entry_b = (GraphQLDocumentCacheEntry *)b;
+  long length = RSTRING_LEN(entry_a->query_string);
+  // st_table wants 0 for a match
+  return !(
+    entry_a->hash == entry_b->hash &&
+    entry_a->max_tokens == entry_b->max_tokens &&
+    entry_a->reject_numbers_followed_by_names == entry_b->reject_numbers_followed_by_names &&
+    RSTRING_LEN(entry_b->query_string) == length &&
+    memcmp(RSTRING_PTR(entry_a->query_string), RSTRING_PTR(entry_b->query_string), length) == 0
+  );
+}
+
+static st_index_t entry_hash(st_data_t a) {
+  return ((GraphQLDocumentCacheEntry *)a)->hash;
+}
+
+static const struct st_hash_type entry_hash_type = { entry_compare, entry_hash };
+
+static st_index_t query_hash(VALUE query_string, long max_tokens, int reject_numbers_followed_by_names) {
+  st_index_t hash = st_hash_uint(rb_memhash(RSTRING_PTR(query_string), RSTRING_LEN(query_string)), (st_index_t)max_tokens);
+  return st_hash_uint(hash, (st_index_t)reject_numbers_followed_by_names);
+}
+
+static long max_tokens_key(VALUE max_tokens) {
+  // -1 indicates that there is no limit, like in the lexer
+  return NIL_P(max_tokens) ? -1 : NUM2LONG(max_tokens);
+}
+
+static void unlink_entry(GraphQLDocumentCache *cache, GraphQLDocumentCacheEntry *entry) {
+  if (entry->newer) {
+    entry->newer->older = entry->older;
+  } else {
+    cache->newest = entry->older;
+  }
+  if (entry->older) {
+    entry->older->newer = entry->newer;
+  } else {
+    cache->oldest = entry->newer;
+  }
+  entry->newer = NULL;
+  entry->older = NULL;
+}
+
+static void link_newest_entry(GraphQLDocumentCache *cache, GraphQLDocumentCacheEntry *entry) {
+  entry->older = cache->newest;
+  entry->newer = NULL;
+  if (cache->newest) {
+    cache->newest->newer = entry;
+  } else {
+    cache->oldest = entry;
+  }
+  cache->newest = entry;
+}
+
+static GraphQLDocumentCacheEntry *find_entry(GraphQLDocumentCache *cache, VALUE query_string, long max_tokens, int reject_numbers_followed_by_names) {
+  GraphQLDocumentCacheEntry key;
+  key.query_string = query_string;
+  key.max_tokens = max_tokens;
+  key.reject_numbers_followed_by_names = reject_numbers_followed_by_names;
+  key.hash = query_hash(query_string, max_tokens, reject_numbers_followed_by_names);
+  st_data_t entry;
+  if (st_lookup(cache->entries, (st_data_t)&key, &entry)) {
+    return (GraphQLDocumentCacheEntry *)entry;
+  }
+  return NULL;
+}
+
+static void delete_entry(GraphQLDocumentCache *cache, GraphQLDocumentCacheEntry *entry) {
+  st_data_t key = (st_data_t)entry;
+  st_delete(cache->entries, &key, NULL);
+  unlink_entry(cache, entry);
+  cache->bytesize -= entry->bytesize;
+  xfree(entry);
+}
+
+static void evict_entries(GraphQLDocumentCache *cache) {
+  while (cache->oldest && ((long)cache->entries->num_entries > cache->max_size || cache->bytesize > cache->max_bytes)) {
+    delete_entry(cache, cache->oldest);
+    cache->evictions++;
+  }
+}
+
+static void document_cache_clear_entries(GraphQLDocumentCache *cache) {
+  while (cache->oldest) {
+    delete_entry(cache, cache->oldest);
+  }
+}
+
+static void document_cache_mark(void *ptr) {
+  GraphQLDocumentCache *cache = ptr;
+  for (GraphQLDocumentCacheEntry *entry = cache->newest; entry; entry = entry->older) {
+    rb_gc_mark(entry->query_string);
+    rb_gc_mark(entry->document);
+  }
+}
+
+static void document_cache_free(void *ptr) {
+  GraphQLDocumentCache *cache = ptr;
+  if (cache->entries) {
+    document_cache_clear_entries(cache);
+    st_free_table(cache->entries);
+  }
+  xfree(cache);
+}
+
+static size_t document_cache_memsize(const void *ptr) {
+  const GraphQLDocumentCache *cache = ptr;
+  size_t size = sizeof(GraphQLDocumentCache);
+  if (cache->entries) {
+    size += st_memsize(cache->entries) + cache->entries->num_entries * sizeof(GraphQLDocumentCacheEntry);
+  }
+  return size;
+}
+
+static const rb_data_type_t document_cache_data_type = {
+  "GraphQL::CParser::DocumentCache",
+  { document_cache_mark, document_cache_free, document_cache_memsize, },
+  0, 0, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static GraphQLDocumentCache *get_document_cache(VALUE self) {
+  GraphQLDocumentCache *cache;
+  TypedData_Get_Struct(self, GraphQLDocumentCache, &document_cache_data_type, cache);
+  if (cache->entries == NULL) {
+    rb_raise(rb_eRuntimeError, "This DocumentCache wasn't initialized");
+  }
+  return cache;
+}
+
+static VALUE document_cache_alloc(VALUE klass) {
+  GraphQLDocumentCache *cache;
+  return TypedData_Make_Struct(klass, GraphQLDocumentCache, &document_cache_data_type, cache);
+}
+
+static VALUE document_cache_c_initialize(VALUE self, VALUE max_size, VALUE max_bytes) {
+  GraphQLDocumentCache *cache;
+  TypedData_Get_Struct(self, GraphQLDocumentCache, &document_cache_data_type, cache);
+  if (cache->entries) {
+    rb_raise(rb_eRuntimeError, "This DocumentCache was already initialized");
+  }
+  cache->max_size = NUM2LONG(max_size);
+  cache->max_bytes = NUM2SIZET(max_bytes);
+  cache->entries = st_init_table(&entry_hash_type);
+  return Qnil;
+}
+
+// Return the cached document for `query_string`, `max_tokens` and `reject_numbers_followed_by_names`, or nil
+static VALUE document_cache_lookup(VALUE self, VALUE query_string, VALUE max_tokens, VALUE reject_numbers_followed_by_names) {
+  StringValue(query_string);
+  long max_tokens_value = max_tokens_key(max_tokens);
+  GraphQLDocumentCache *cache = get_document_cache(self);
+  GraphQLDocumentCacheEntry *entry = find_entry(cache, query_string, max_tokens_value, RTEST(reject_numbers_followed_by_names));
+  if (entry == NULL) {
+    cache->misses++;
+    return Qnil;
+  }
+  cache->hits++;
+  if (entry != cache->newest) {
+    unlink_entry(cache, entry);
+    link_newest_entry(cache, entry);
+  }
+  return entry->document;
+}
+
+// Cache `document` for `query_string`, `max_tokens` and `reject_numbers_followed_by_names`, then evict the least recently used
+// documents until the cache fits in its limits. If another thread cached this string first,
+// its document is kept and returned.
+static VALUE document_cache_store(VALUE self, VALUE query_string, VALUE max_tokens, VALUE reject_numbers_followed_by_names, VALUE document, VALUE bytesize) {
+  StringValue(query_string);
+  long max_tokens_value = max_tokens_key(max_tokens);
+  int reject_numbers_followed_by_names_value = RTEST(reject_numbers_followed_by_names);
+  size_t bytesize_value = NUM2SIZET(bytesize);
+  GraphQLDocumentCache *cache = get_document_cache(self);
+  if (cache->max_size < 1 || bytesize_value > cache->max_bytes) {
+    return document;
+  }
+  GraphQLDocumentCacheEntry *existing_entry = find_entry(cache, query_string, max_tokens_value, reject_numbers_followed_by_names_value);
+  if (existing_entry) {
+    return existing_entry->document;
+  }
+  // The key must not change while it's cached; a frozen string's copy shares its bytes.
+  VALUE frozen_query_string = rb_str_new_frozen(query_string);
+  GraphQLDocumentCacheEntry *entry = ALLOC(GraphQLDocumentCacheEntry);
+  entry->query_string = frozen_query_string;
+  entry->document = document;
+  entry->hash = query_hash(frozen_query_string, max_tokens_value, reject_numbers_followed_by_names_value);
+  entry->max_tokens = max_tokens_value;
+  entry->reject_numbers_followed_by_names = reject_numbers_followed_by_names_value;
+  entry->bytesize = bytesize_value;
+  // Link the entry before inserting it, so that it's marked if GC runs during `st_insert`
+  link_newest_entry(cache, entry);
+  cache->bytesize += bytesize_value;
+  st_insert(cache->entries, (st_data_t)entry, (st_data_t)entry);
+  evict_entries(cache);
+  return document;
+}
+
+static VALUE document_cache_size(VALUE self) {
+  return LONG2NUM((long)get_document_cache(self)->entries->num_entries);
+}
+
+static VALUE document_cache_clear(VALUE self) {
+  document_cache_clear_entries(get_document_cache(self));
+  return self;
+}
+
+static VALUE document_cache_stats(VALUE self) {
+  GraphQLDocumentCache *cache = get_document_cache(self);
+  VALUE stats = rb_hash_new();
+  rb_hash_aset(stats, ID2SYM(rb_intern("size")), LONG2NUM((long)cache->entries->num_entries));
+  rb_hash_aset(stats, ID2SYM(rb_intern("bytesize")), SIZET2NUM(cache->bytesize));
+  rb_hash_aset(stats, ID2SYM(rb_intern("max_size")), LONG2NUM(cache->max_size));
+  rb_hash_aset(stats, ID2SYM(rb_intern("max_bytes")), SIZET2NUM(cache->max_bytes));
+  rb_hash_aset(stats, ID2SYM(rb_intern("hits")), LONG2NUM(cache->hits));
+  rb_hash_aset(stats, ID2SYM(rb_intern("misses")), LONG2NUM(cache->misses));
+  rb_hash_aset(stats, ID2SYM(rb_intern("evictions")), LONG2NUM(cache->evictions));
+  return stats;
+}
+
+void initialize_document_cache_class(VALUE document_cache_class) {
+  rb_define_alloc_func(document_cache_class, document_cache_alloc);
+  rb_define_private_method(document_cache_class, "c_initialize", document_cache_c_initialize, 2);
+  rb_define_private_method(document_cache_class, "c_lookup", document_cache_lookup, 3);
+  rb_define_private_method(document_cache_class, "c_store", document_cache_store, 5);
+  rb_define_method(document_cache_class, "size", document_cache_size, 0);
+  rb_define_method(document_cache_class, "clear", document_cache_clear, 0);
+  rb_define_method(document_cache_class, "stats", document_cache_stats, 0);
+}
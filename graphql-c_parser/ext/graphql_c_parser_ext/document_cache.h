@@ -0,0 +1,35 @@
+#ifndef Graphql_document_cache_h
+#define Graphql_document_cache_h
+#include <ruby.h>
+
+// A cached document, in a list from the most to the least recently used
+typedef struct GraphQLDocumentCacheEntry {
+  VALUE query_string; // A frozen copy of the parsed string
+  VALUE document;
+  st_index_t hash;
+  long max_tokens;
+  int reject_numbers_followed_by_names; // `GraphQL.reject_numbers_followed_by_names` when it was parsed
+  size_t bytesize;
+  struct GraphQLDocumentCacheEntry *newer;
+  struct GraphQLDocumentCacheEntry *older;
+} GraphQLDocumentCacheEntry;
+
+// A least-recently-used cache of frozen documents, looked up by their query strings' bytes,
+// `max_tokens:` and `GraphQL.reject_numbers_followed_by_names`. See `GraphQL::CParser::DocumentCache`.
+//
+// Its methods don't call Ruby code or release the GVL while they change it,
+// so threads can share a cache without a lock.
+typedef struct GraphQLDocumentCache {
+  st_table *entries; // GraphQLDocumentCacheEntry* => GraphQLDocumentCacheEntry*
+  GraphQLDocumentCacheEntry *newest;
+  GraphQLDocumentCacheEntry *oldest;
+  long max_size;
+  size_t max_bytes;
+  size_t bytesize;
+  long hits;
+  long misses;
+  long evictions;
+} GraphQLDocumentCache;
+
+void initialize_document_cache_class(VALUE document_cache_class);
+#endif
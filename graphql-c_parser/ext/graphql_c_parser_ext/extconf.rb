@@ -1,4 +1,9 @@
 # frozen_string_literal: true
 require 'mkmf'
 
+# `GraphQL::CParser.parse_many` uses native threads when they're available
+have_header('pthread.h')
+# `GraphQL::CParser::BinaryAST.load_file` reads files in place when they can be mapped into memory
+have_header('sys/mman.h')
+
 create_makefile 'graphql/graphql_c_parser_ext'
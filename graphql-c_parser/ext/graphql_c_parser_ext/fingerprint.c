@@ -0,0 +1,316 @@
+#include "fingerprint.h"
+#include <string.h>
+
+// A fixed key, so that fingerprints are the same in every process.
+// (Fingerprints are opaque because they're hashes, not because the key is secret.)
+static const uint8_t FINGERPRINT_KEY[16] = {
+  'g', 'r', 'a', 'p', 'h', 'q', 'l', '-', 'r', 'u', 'b', 'y', '-', 'k', 'e', 'y'
+};
+
+// `JSON.generate` raises for documents nested deeper than this, too
+#define FINGERPRINT_MAX_NESTING 100
+
+static ID id_to_s;
+static ID id_to_json;
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND(s) \
+  do { \
+    s->v0 += s->v1; s->v1 = ROTL(s->v1, 13); s->v1 ^= s->v0; s->v0 = ROTL(s->v0, 32); \
+    s->v2 += s->v3; s->v3 = ROTL(s->v3, 16); s->v3 ^= s->v2; \
+    s->v0 += s->v3; s->v3 = ROTL(s->v3, 21); s->v3 ^= s->v0; \
+    s->v2 += s->v1; s->v1 = ROTL(s->v1, 17); s->v1 ^= s->v2; s->v2 = ROTL(s->v2, 32); \
+  } while (0)
+
+static uint64_t read_u64_le(const uint8_t *p) {
+  return ((uint64_t)p[0]) | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+    ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static void write_u64_le(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+static void siphash_block(GraphQLSipHash *state, uint64_t m) {
+  state->v3 ^= m;
+  SIPROUND(state);
+  SIPROUND(state);
+  state->v0 ^= m;
+}
+
+void siphash_init(GraphQLSipHash *state, const uint8_t key[16]) {
+  uint64_t k0 = read_u64_le(key);
+  uint64_t k1 = read_u64_le(key + 8);
+  state->v0 = k0 ^ 0x736f6d6570736575ULL;
+  state->v1 = k1 ^ 0x646f72616e646f6dULL ^ 0xee; // 0xee makes the 128-bit variant
+  state->v2 = k0 ^ 0x6c7967656e657261ULL;
+  state->v3 = k1 ^ 0x7465646279746573ULL;
+  state->tail_length = 0;
+  state->length = 0;
+}
+
+void siphash_update(GraphQLSipHash *state, const char *ptr, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)ptr;
+  state->length += length;
+  if (state->tail_length > 0) {
+    while (length > 0 && state->tail_length < 8) {
+      state->tail[state->tail_length++] = *bytes++;
+      length--;
+    }
+    if (state->tail_length < 8) {
+      return;
+    }
+    siphash_block(state, read_u64_le(state->tail));
+    state->tail_length = 0;
+  }
+  while (length >= 8) {
+    siphash_block(state, read_u64_le(bytes));
+    bytes += 8;
+    length -= 8;
+  }
+  memcpy(state->tail, bytes, length);
+  state->tail_length = length;
+}
+
+void siphash_final(GraphQLSipHash *state, uint8_t out[16]) {
+  uint64_t b = ((uint64_t)state->length) << 56;
+  for (size_t i = 0; i < state->tail_length; i++) {
+    b |= ((uint64_t)state->tail[i]) << (8 * i);
+  }
+  siphash_block(state, b);
+  state->v2 ^= 0xee;
+  for (int i = 0; i < 4; i++) {
+    SIPROUND(state);
+  }
+  write_u64_le(out, state->v0 ^ state->v1 ^ state->v2 ^ state->v3);
+  state->v1 ^= 0xdd;
+  for (int i = 0; i < 4; i++) {
+    SIPROUND(state);
+  }
+  write_u64_le(out + 8, state->v0 ^ state->v1 ^ state->v2 ^ state->v3);
+}
+
+// Like `Base64.urlsafe_encode64`, with padding
+static VALUE encode_fingerprint(const uint8_t digest[16]) {
+  static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  char out[24];
+  int o = 0;
+  for (int i = 0; i < 16; i += 3) {
+    uint32_t n = ((uint32_t)digest[i]) << 16;
+    if (i + 1 < 16) n |= ((uint32_t)digest[i + 1]) << 8;
+    if (i + 2 < 16) n |= digest[i + 2];
+    out[o++] = alphabet[(n >> 18) & 63];
+    out[o++] = alphabet[(n >> 12) & 63];
+    out[o++] = i + 1 < 16 ? alphabet[(n >> 6) & 63] : '=';
+    out[o++] = i + 2 < 16 ? alphabet[n & 63] : '=';
+  }
+  return rb_usascii_str_new(out, sizeof(out));
+}
+
+// Bytes are collected here, so that short pieces of JSON are hashed together
+typedef struct FingerprintSink {
+  GraphQLSipHash hash;
+  char buffer[256];
+  size_t length;
+} FingerprintSink;
+
+static void sink_flush(FingerprintSink *sink) {
+  siphash_update(&sink->hash, sink->buffer, sink->length);
+  sink->length = 0;
+}
+
+static void sink_write(FingerprintSink *sink, const char *ptr, size_t length) {
+  if (sink->length + length > sizeof(sink->buffer)) {
+    sink_flush(sink);
+    if (length >= sizeof(sink->buffer)) {
+      // Hash long strings where they are, without copying them
+      siphash_update(&sink->hash, ptr, length);
+      return;
+    }
+  }
+  memcpy(sink->buffer + sink->length, ptr, length);
+  sink->length += length;
+}
+
+#define sink_write_literal(sink, str) sink_write(sink, str, sizeof(str) - 1)
+
+static void sink_write_string(FingerprintSink *sink, VALUE str) {
+  sink_write(sink, RSTRING_PTR(str), RSTRING_LEN(str));
+  RB_GC_GUARD(str);
+}
+
+// Write `str` as a JSON string, escaped like `JSON.generate` does
+static void write_json_string(FingerprintSink *sink, VALUE str) {
+  static const char hex[] = "0123456789abcdef";
+  const char *ptr = RSTRING_PTR(str);
+  long length = RSTRING_LEN(str);
+  long run_start = 0;
+  sink_write_literal(sink, "\"");
+  for (long i = 0; i < length; i++) {
+    unsigned char c = (unsigned char)ptr[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    sink_write(sink, ptr + run_start, i - run_start);
+    run_start = i + 1;
+    switch (c) {
+      case '"': sink_write_literal(sink, "\\\""); break;
+      case '\\': sink_write_literal(sink, "\\\\"); break;
+      case '\b': sink_write_literal(sink, "\\b"); break;
+      case '\f': sink_write_literal(sink, "\\f"); break;
+      case '\n': sink_write_literal(sink, "\\n"); break;
+      case '\r': sink_write_literal(sink, "\\r"); break;
+      case '\t': sink_write_literal(sink, "\\t"); break;
+      default: {
+        char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+        sink_write(sink, escape, sizeof(escape));
+      }
+    }
+  }
+  sink_write(sink, ptr + run_start, length - run_start);
+  sink_write_literal(sink, "\"");
+  RB_GC_GUARD(str);
+}
+
+static void write_json(FingerprintSink *sink, VALUE value, int depth);
+
+typedef struct WriteHashPairArgs {
+  FingerprintSink *sink;
+  int depth;
+  int first;
+} WriteHashPairArgs;
+
+static int write_json_hash_pair(VALUE key, VALUE value, VALUE data) {
+  WriteHashPairArgs *args = (WriteHashPairArgs *)data;
+  if (args->first) {
+    args->first = 0;
+  } else {
+    sink_write_literal(args->sink, ",");
+  }
+  if (RB_TYPE_P(key, T_STRING)) {
+    write_json_string(args->sink, key);
+  } else if (SYMBOL_P(key)) {
+    write_json_string(args->sink, rb_sym2str(key));
+  } else {
+    write_json_string(args->sink, rb_obj_as_string(key));
+  }
+  sink_write_literal(args->sink, ":");
+  write_json(args->sink, value, args->depth);
+  return ST_CONTINUE;
+}
+
+// Hash the JSON for `value` without making a JSON string.
+// For JSON-like values, it's the same as `JSON.generate(value)`; other objects are hashed by their `#to_json`.
+static void write_json(FingerprintSink *sink, VALUE value, int depth) {
+  switch (TYPE(value)) {
+    case T_NIL:
+      sink_write_literal(sink, "null");
+      break;
+    case T_TRUE:
+      sink_write_literal(sink, "true");
+      break;
+    case T_FALSE:
+      sink_write_literal(sink, "false");
+      break;
+    case T_FIXNUM: {
+      char digits[24];
+      int length = snprintf(digits, sizeof(digits), "%ld", FIX2LONG(value));
+      sink_write(sink, digits, length);
+      break;
+    }
+    case T_BIGNUM:
+      sink_write_string(sink, rb_big2str(value, 10));
+      break;
+    case T_FLOAT:
+      sink_write_string(sink, rb_funcall(value, id_to_s, 0));
+      break;
+    case T_STRING:
+      write_json_string(sink, value);
+      break;
+    case T_SYMBOL:
+      write_json_string(sink, rb_sym2str(value));
+      break;
+    case T_ARRAY:
+      if (depth + 1 > FINGERPRINT_MAX_NESTING) {
+        rb_raise(rb_eArgError, "nesting of %d is too deep", depth + 1);
+      }
+      sink_write_literal(sink, "[");
+      // `#to_json` might change the array, so its length is checked each time
+      for (long i = 0; i < RARRAY_LEN(value); i++) {
+        if (i > 0) {
+          sink_write_literal(sink, ",");
+        }
+        write_json(sink, RARRAY_AREF(value, i), depth + 1);
+      }
+      sink_write_literal(sink, "]");
+      break;
+    case T_HASH: {
+      if (depth + 1 > FINGERPRINT_MAX_NESTING) {
+        rb_raise(rb_eArgError, "nesting of %d is too deep", depth + 1);
+      }
+      WriteHashPairArgs args = { sink, depth + 1, 1 };
+      sink_write_literal(sink, "{");
+      rb_hash_foreach(value, write_json_hash_pair, (VALUE)&args);
+      sink_write_literal(sink, "}");
+      break;
+    }
+    default:
+      if (rb_respond_to(value, id_to_json)) {
+        VALUE json = rb_funcall(value, id_to_json, 0);
+        StringValue(json);
+        sink_write_string(sink, json);
+      } else {
+        write_json_string(sink, rb_obj_as_string(value));
+      }
+  }
+}
+
+// Hash the bytes of `str` where they are, then encode them URL-safe
+static VALUE fingerprint_generate(VALUE self, VALUE str) {
+  StringValue(str);
+  GraphQLSipHash hash;
+  uint8_t digest[16];
+  siphash_init(&hash, FINGERPRINT_KEY);
+  siphash_update(&hash, RSTRING_PTR(str), RSTRING_LEN(str));
+  siphash_final(&hash, digest);
+  RB_GC_GUARD(str);
+  return encode_fingerprint(digest);
+}
+
+// Like `generate(JSON.generate(variables))`, but without the JSON string
+static VALUE fingerprint_generate_for_variables(VALUE self, VALUE variables) {
+  FingerprintSink sink;
+  uint8_t digest[16];
+  siphash_init(&sink.hash, FINGERPRINT_KEY);
+  sink.length = 0;
+  write_json(&sink, variables, 0);
+  sink_flush(&sink);
+  siphash_final(&sink.hash, digest);
+  return encode_fingerprint(digest);
+}
+
+// For testing against the reference vectors
+static VALUE fingerprint_siphash128(VALUE self, VALUE key, VALUE str) {
+  StringValue(key);
+  StringValue(str);
+  if (RSTRING_LEN(key) != 16) {
+    rb_raise(rb_eArgError, "Expected a 16-byte key, got %ld bytes", RSTRING_LEN(key));
+  }
+  GraphQLSipHash hash;
+  uint8_t digest[16];
+  siphash_init(&hash, (const uint8_t *)RSTRING_PTR(key));
+  siphash_update(&hash, RSTRING_PTR(str), RSTRING_LEN(str));
+  siphash_final(&hash, digest);
+  return rb_str_new((const char *)digest, sizeof(digest));
+}
+
+void initialize_fingerprint_module(VALUE fingerprint_module) {
+  id_to_s = rb_intern("to_s");
+  id_to_json = rb_intern("to_json");
+  rb_define_singleton_method(fingerprint_module, "generate", fingerprint_generate, 1);
+  rb_define_singleton_method(fingerprint_module, "generate_for_variables", fingerprint_generate_for_variables, 1);
+  rb_define_singleton_method(fingerprint_module, "siphash128", fingerprint_siphash128, 2);
+}
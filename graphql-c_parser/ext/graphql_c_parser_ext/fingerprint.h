@@ -0,0 +1,19 @@
+#ifndef Graphql_fingerprint_h
+#define Graphql_fingerprint_h
+#include <ruby.h>
+#include <stdint.h>
+
+// SipHash-2-4 with a 128-bit output, which can be given its input a piece at a time
+typedef struct GraphQLSipHash {
+  uint64_t v0, v1, v2, v3;
+  uint8_t tail[8];
+  size_t tail_length;
+  size_t length;
+} GraphQLSipHash;
+
+void siphash_init(GraphQLSipHash *state, const uint8_t key[16]);
+void siphash_update(GraphQLSipHash *state, const char *ptr, size_t length);
+void siphash_final(GraphQLSipHash *state, uint8_t out[16]);
+
+void initialize_fingerprint_module(VALUE fingerprint_module);
+#endif
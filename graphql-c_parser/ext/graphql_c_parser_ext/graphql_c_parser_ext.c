@@ -4,19 +4,249 @@ VALUE GraphQL_CParser_Lexer_tokenize_with_c_internal(VALUE self, VALUE query_str
   return tokenize(query_string, RTEST(fstring_identifiers), RTEST(reject_numbers_followed_by_names), FIX2INT(max_tokens));
 }
 
-VALUE GraphQL_CParser_Parser_c_parse(VALUE self) {
-  yyparse(self, rb_ivar_get(self, rb_intern("@filename")));
+VALUE GraphQL_CParser_Lexer_signature_with_c_internal(VALUE self, VALUE query_string, VALUE reject_numbers_followed_by_names) {
+  return signature(query_string, RTEST(reject_numbers_followed_by_names));
+}
+
+VALUE GraphQL_CParser_Lexer_minify_with_c_internal(VALUE self, VALUE query_string, VALUE reject_numbers_followed_by_names) {
+  return minify(query_string, RTEST(reject_numbers_followed_by_names));
+}
+
+VALUE GraphQL_CParser_Lexer_scan_kernel(VALUE self) {
+  return rb_str_new_cstr(scan_kernels->name);
+}
+
+VALUE GraphQL_CParser_Lexer_set_scan_kernel(VALUE self, VALUE name) {
+  if (!use_scan_kernels(StringValueCStr(name))) {
+    rb_raise(rb_eArgError, "Unsupported scan kernel: %"PRIsVALUE" (available: %"PRIsVALUE")", name, available_scan_kernels());
+  }
+  return name;
+}
+
+VALUE GraphQL_CParser_Lexer_available_scan_kernels(VALUE self) {
+  return available_scan_kernels();
+}
+
+VALUE GraphQL_CParser_TokenBuffer_length(VALUE self) {
+  return LONG2NUM(get_token_buffer(self)->length);
+}
+
+VALUE GraphQL_CParser_TokenBuffer_aref(VALUE self, VALUE index) {
+  GraphQLTokenBuffer *buffer = get_token_buffer(self);
+  long idx = NUM2LONG(index);
+  if (idx < 0) {
+    idx += buffer->length;
+  }
+  if (idx < 0 || idx >= buffer->length) {
+    return Qnil;
+  }
+  return token_to_array(buffer->source, buffer->intern_identifiers, &buffer->tokens[idx]);
+}
+
+VALUE GraphQL_CParser_TokenBuffer_to_a(VALUE self) {
+  GraphQLTokenBuffer *buffer = get_token_buffer(self);
+  VALUE tokens = rb_ary_new_capa(buffer->length);
+  for (long i = 0; i < buffer->length; i++) {
+    rb_ary_push(tokens, token_to_array(buffer->source, buffer->intern_identifiers, &buffer->tokens[i]));
+  }
+  return tokens;
+}
+
+VALUE GraphQL_CParser_Lexer_token_stream_with_c_internal(VALUE self, VALUE query_string, VALUE fstring_identifiers, VALUE reject_numbers_followed_by_names, VALUE max_tokens, VALUE comments) {
+  return token_stream(query_string, RTEST(fstring_identifiers), RTEST(reject_numbers_followed_by_names), FIX2INT(max_tokens), RTEST(comments));
+}
+
+VALUE GraphQL_CParser_TokenStream_current_token(VALUE self) {
+  GraphQLLexer *lexer = get_token_stream(self);
+  if (lexer->token.type == 0) {
+    return Qnil;
+  }
+  return token_to_array(lexer->source, lexer->intern_identifiers, &lexer->token);
+}
+
+VALUE GraphQL_CParser_TokenStream_tokens_count(VALUE self) {
+  return INT2FIX(get_token_stream(self)->tokens_count);
+}
+
+VALUE GraphQL_CParser_TokenStream_signature(VALUE self) {
+  return signature_to_s(get_token_stream(self));
+}
+
+VALUE GraphQL_CParser_Parser_c_initialize(VALUE self, VALUE query_string, VALUE filename, VALUE max_depth, VALUE max_aliases, VALUE max_fields, VALUE max_nesting) {
+  GraphQLParser *state = get_parser(self);
+  state->query_string = query_string;
+  state->filename = filename;
+  state->max_depth = NUM2LONG(max_depth);
+  state->max_aliases = NUM2LONG(max_aliases);
+  state->max_fields = NUM2LONG(max_fields);
+  state->max_nesting = NUM2LONG(max_nesting);
+  return Qnil;
+}
+
+static void start_parse(GraphQLParser *state, VALUE token_stream, VALUE atoms) {
+  state->lexer = get_token_stream(token_stream);
+  state->token_stream = token_stream;
+  state->document = document_new(state->lexer->source, state->filename, state->lexer->intern_identifiers, atoms);
+  state->ast = get_document(state->document);
+}
+
+static VALUE finish_parse(GraphQLParser *state, VALUE lazy, VALUE shareable) {
+  document_report_memory(state->ast);
+  state->result = materialize_document(state->ast, RTEST(lazy), RTEST(shareable));
+  if (!RTEST(lazy)) {
+    // Every node has been made, so the arena isn't needed anymore
+    free_document_arena(state->ast);
+  }
+  state->document = Qnil;
+  state->ast = NULL;
+  return state->result;
+}
+
+VALUE GraphQL_CParser_Parser_c_parse(VALUE self, VALUE token_stream, VALUE lazy, VALUE atoms, VALUE release_gvl, VALUE shareable) {
+  GraphQLParser *state = get_parser(self);
+  start_parse(state, token_stream, atoms);
+  if (RTEST(release_gvl)) {
+    parse_without_gvl(self, state);
+  } else {
+    parse_with_gvl(self, state);
+  }
+  return finish_parse(state, lazy, shareable);
+}
+
+// Lex and parse each parser's document without the GVL, on up to `threads_count` native threads.
+// Then, `#c_finish_parse` raises each one's error or makes its nodes.
+VALUE GraphQL_CParser_Parser_c_parse_many(VALUE self, VALUE parsers, VALUE token_streams, VALUE atoms, VALUE threads_count) {
+  long count = RARRAY_LEN(parsers);
+  if (RARRAY_LEN(token_streams) != count) {
+    rb_raise(rb_eArgError, "Expected one token stream for each parser");
+  }
+  VALUE jobs_buffer;
+  GraphQLParseJob *jobs = ALLOCV_N(GraphQLParseJob, jobs_buffer, count);
+  for (long i = 0; i < count; i++) {
+    jobs[i].parser = RARRAY_AREF(parsers, i);
+    jobs[i].state = get_parser(jobs[i].parser);
+    start_parse(jobs[i].state, RARRAY_AREF(token_streams, i), atoms);
+  }
+  parse_many_without_gvl(jobs, count, NUM2INT(threads_count));
+  ALLOCV_END(jobs_buffer);
+  RB_GC_GUARD(parsers);
+  RB_GC_GUARD(token_streams);
+  return Qnil;
+}
+
+VALUE GraphQL_CParser_Parser_c_finish_parse(VALUE self, VALUE lazy, VALUE shareable) {
+  GraphQLParser *state = get_parser(self);
+  if (state->ast == NULL) {
+    rb_raise(rb_eRuntimeError, "This parser isn't waiting to finish, see `.c_parse_many`");
+  }
+  document_report_memory(state->ast);
+  raise_deferred_parse_error(self, state);
+  return finish_parse(state, lazy, shareable);
+}
+
+VALUE GraphQL_CParser_Parser_query_string(VALUE self) {
+  return get_parser(self)->query_string;
+}
+
+VALUE GraphQL_CParser_Parser_filename(VALUE self) {
+  return get_parser(self)->filename;
+}
+
+VALUE GraphQL_CParser_Parser_token_stream(VALUE self) {
+  return get_parser(self)->token_stream;
+}
+
+VALUE GraphQL_CParser_Document_materialize_children(VALUE self, VALUE lazy_node, VALUE node_id) {
+  return materialize_children(get_document(self), lazy_node, NUM2LONG(node_id));
+}
+
+VALUE GraphQL_CParser_Document_line_at(VALUE self, VALUE pos) {
+  return LONG2NUM(document_line_at(get_document(self), NUM2LONG(pos)));
+}
+
+VALUE GraphQL_CParser_Document_column_at(VALUE self, VALUE pos) {
+  return LONG2NUM(document_column_at(get_document(self), NUM2LONG(pos)));
+}
+
+VALUE GraphQL_CParser_Document_freeze(VALUE self) {
+  document_freeze(get_document(self));
+  return rb_call_super(0, NULL);
+}
+
+VALUE GraphQL_CParser_LazyNodes_register_lazy_node_class(VALUE self, VALUE node_class, VALUE lazy_class, VALUE children_ivars) {
+  register_lazy_node_class(node_class, lazy_class, children_ivars);
   return Qnil;
 }
 
 void Init_graphql_c_parser_ext() {
+  // Parsing only reads process-wide state, so it can run in any Ractor.
+  // Methods which change that state are defined below with `rb_ext_ractor_safe(false)`, so they're only for the main Ractor.
+  rb_ext_ractor_safe(true);
   VALUE GraphQL = rb_define_module("GraphQL");
   VALUE CParser = rb_define_module_under(GraphQL, "CParser");
   VALUE Lexer = rb_define_module_under(CParser, "Lexer");
   rb_define_singleton_method(Lexer, "tokenize_with_c_internal", GraphQL_CParser_Lexer_tokenize_with_c_internal, 4);
+  rb_define_singleton_method(Lexer, "token_stream_with_c_internal", GraphQL_CParser_Lexer_token_stream_with_c_internal, 5);
+  rb_define_singleton_method(Lexer, "signature_with_c_internal", GraphQL_CParser_Lexer_signature_with_c_internal, 2);
+  rb_define_singleton_method(Lexer, "minify_with_c_internal", GraphQL_CParser_Lexer_minify_with_c_internal, 2);
+  rb_define_singleton_method(Lexer, "scan_kernel", GraphQL_CParser_Lexer_scan_kernel, 0);
+  rb_ext_ractor_safe(false);
+  rb_define_singleton_method(Lexer, "scan_kernel=", GraphQL_CParser_Lexer_set_scan_kernel, 1);
+  rb_ext_ractor_safe(true);
+  rb_define_singleton_method(Lexer, "available_scan_kernels", GraphQL_CParser_Lexer_available_scan_kernels, 0);
   setup_static_token_variables();
+  initialize_scan_kernels();
+
+  VALUE TokenBuffer = rb_define_class_under(CParser, "TokenBuffer", rb_cObject);
+  rb_undef_alloc_func(TokenBuffer);
+  rb_define_method(TokenBuffer, "length", GraphQL_CParser_TokenBuffer_length, 0);
+  rb_define_method(TokenBuffer, "[]", GraphQL_CParser_TokenBuffer_aref, 1);
+  rb_define_method(TokenBuffer, "to_a", GraphQL_CParser_TokenBuffer_to_a, 0);
+  initialize_token_buffer_class(TokenBuffer);
+
+  VALUE TokenStream = rb_define_class_under(CParser, "TokenStream", rb_cObject);
+  rb_undef_alloc_func(TokenStream);
+  rb_define_method(TokenStream, "current_token", GraphQL_CParser_TokenStream_current_token, 0);
+  rb_define_method(TokenStream, "tokens_count", GraphQL_CParser_TokenStream_tokens_count, 0);
+  rb_define_method(TokenStream, "signature", GraphQL_CParser_TokenStream_signature, 0);
+  initialize_token_stream_class(TokenStream);
 
   VALUE Parser = rb_define_class_under(CParser, "Parser", rb_cObject);
-  rb_define_method(Parser, "c_parse", GraphQL_CParser_Parser_c_parse, 0);
-  initialize_node_class_variables();
+  initialize_parser_class(Parser);
+  rb_define_private_method(Parser, "c_initialize", GraphQL_CParser_Parser_c_initialize, 6);
+  rb_define_method(Parser, "c_parse", GraphQL_CParser_Parser_c_parse, 5);
+  rb_define_singleton_method(Parser, "c_parse_many", GraphQL_CParser_Parser_c_parse_many, 4);
+  rb_define_method(Parser, "c_finish_parse", GraphQL_CParser_Parser_c_finish_parse, 2);
+  rb_define_method(Parser, "query_string", GraphQL_CParser_Parser_query_string, 0);
+  rb_define_method(Parser, "filename", GraphQL_CParser_Parser_filename, 0);
+  rb_define_method(Parser, "token_stream", GraphQL_CParser_Parser_token_stream, 0);
+
+  VALUE Document = rb_define_class_under(CParser, "Document", rb_cObject);
+  rb_undef_alloc_func(Document);
+  rb_define_method(Document, "materialize_children", GraphQL_CParser_Document_materialize_children, 2);
+  rb_define_method(Document, "line_at", GraphQL_CParser_Document_line_at, 1);
+  rb_define_method(Document, "column_at", GraphQL_CParser_Document_column_at, 1);
+  rb_define_method(Document, "freeze", GraphQL_CParser_Document_freeze, 0);
+  initialize_document_class(Document);
+
+  VALUE AtomTable = rb_define_class_under(CParser, "AtomTable", rb_cObject);
+  initialize_atom_table_class(AtomTable);
+
+  VALUE DocumentCache = rb_define_class_under(CParser, "DocumentCache", rb_cObject);
+  initialize_document_cache_class(DocumentCache);
+
+  VALUE Fingerprint = rb_define_module_under(CParser, "Fingerprint");
+  initialize_fingerprint_module(Fingerprint);
+
+  VALUE BinaryAST = rb_define_module_under(CParser, "BinaryAST");
+  initialize_binary_ast_module(BinaryAST);
+
+  VALUE Printer = rb_define_module_under(CParser, "Printer");
+  initialize_printer_module(Printer);
+
+  VALUE LazyNodes = rb_define_module_under(CParser, "LazyNodes");
+  rb_ext_ractor_safe(false);
+  rb_define_singleton_method(LazyNodes, "register_lazy_node_class", GraphQL_CParser_LazyNodes_register_lazy_node_class, 3);
+  rb_ext_ractor_safe(true);
+  initialize_node_layouts();
 }
@@ -4,5 +4,11 @@
 #include <ruby/encoding.h>
 #include "lexer.h"
 #include "parser.h"
+#include "scan.h"
+#include "atoms.h"
+#include "document_cache.h"
+#include "fingerprint.h"
+#include "binary_ast.h"
+#include "printer.h"
 void Init_graphql_c_parser_ext();
 #endif
@@ -1,6 +1,6 @@
 #line 1 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 
-#line 106 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+#line 109 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 
 
 
@@ -682,11 +682,14 @@ static const int graphql_c_lexer_error = -1;
 static const int graphql_c_lexer_en_main = 21;
 
 
-#line 108 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+#line 111 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 
 
 #include <ruby.h>
 #include <ruby/encoding.h>
+#include "lexer.h"
+#include "scan.h"
+#include <inttypes.h>
 
 #define INIT_STATIC_TOKEN_VARIABLE(token_name) \
 static VALUE GraphQLTokenString##token_name;
@@ -770,220 +773,737 @@ typedef enum TokenType {
 	BAD_UNICODE_ESCAPE
 } TokenType;
 
-typedef struct Meta {
-	int line;
-	int col;
-	char *query_cstr;
-	char *pe;
-	VALUE tokens;
-	int dedup_identifiers;
-	int reject_numbers_followed_by_names;
-	int preceeded_by_number;
-	int max_tokens;
-	int tokens_count;
-} Meta;
-
-#define STATIC_VALUE_TOKEN(token_type, content_str) \
-case token_type: \
-token_sym = ID2SYM(rb_intern(#token_type)); \
-token_content = GraphQLTokenString##token_type; \
-break;
+static VALUE GraphQL_CParser_TokenBuffer;
+static VALUE GraphQL_CParser_TokenStream;
+
+static void token_buffer_mark(void *ptr) {
+	GraphQLTokenBuffer *buffer = ptr;
+	rb_gc_mark(buffer->source);
+	for (long i = 0; i < buffer->length; i++) {
+		rb_gc_mark(buffer->tokens[i].value);
+	}
+}
+
+static void token_buffer_free(void *ptr) {
+	GraphQLTokenBuffer *buffer = ptr;
+	xfree(buffer->tokens);
+	xfree(buffer);
+}
+
+static size_t token_buffer_memsize(const void *ptr) {
+	const GraphQLTokenBuffer *buffer = ptr;
+	return sizeof(GraphQLTokenBuffer) + buffer->capacity * sizeof(GraphQLToken);
+}
+
+static const rb_data_type_t token_buffer_data_type = {
+	"GraphQL::CParser::TokenBuffer",
+	{ token_buffer_mark, token_buffer_free, token_buffer_memsize, },
+	0, 0, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+GraphQLTokenBuffer *get_token_buffer(VALUE token_buffer) {
+	GraphQLTokenBuffer *buffer;
+	TypedData_Get_Struct(token_buffer, GraphQLTokenBuffer, &token_buffer_data_type, buffer);
+	return buffer;
+}
+
+static void push_token(GraphQLTokenBuffer *buffer, GraphQLToken *token) {
+	if (buffer->length == buffer->capacity) {
+		buffer->capacity = buffer->capacity == 0 ? 64 : buffer->capacity * 2;
+		REALLOC_N(buffer->tokens, GraphQLToken, buffer->capacity);
+	}
+	buffer->tokens[buffer->length] = *token;
+	buffer->length++;
+}
+
+static void token_stream_mark(void *ptr) {
+	GraphQLLexer *lexer = ptr;
+	rb_gc_mark(lexer->source);
+	rb_gc_mark(lexer->token.value);
+}
+
+static size_t token_stream_memsize(const void *ptr) {
+	return sizeof(GraphQLLexer);
+}
+
+static const rb_data_type_t token_stream_data_type = {
+	"GraphQL::CParser::TokenStream",
+	{ token_stream_mark, RUBY_TYPED_DEFAULT_FREE, token_stream_memsize, },
+	0, 0, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+GraphQLLexer *get_token_stream(VALUE token_stream) {
+	GraphQLLexer *lexer;
+	TypedData_Get_Struct(token_stream, GraphQLLexer, &token_stream_data_type, lexer);
+	return lexer;
+}
+
+int token_is_identifier(int token_type) {
+	return token_type - 200 == IDENTIFIER;
+}
 
-#define DYNAMIC_VALUE_TOKEN(token_type) \
+#define STATIC_VALUE_TOKEN(token_type) \
 case token_type: \
-token_sym = ID2SYM(rb_intern(#token_type)); \
-token_content = rb_utf8_str_new(ts, te - ts); \
-break;
+return GraphQLTokenString##token_type;
 
-void emit(TokenType tt, char *ts, char *te, Meta *meta) {
-	meta->tokens_count++;
-	// -1 indicates that there is no limit:
-	if (meta->max_tokens > 0 && meta->tokens_count > meta->max_tokens) {
-		VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-		VALUE cParseError = rb_const_get_at(mGraphQL, rb_intern("ParseError"));
-		VALUE exception = rb_funcall(
-		cParseError, rb_intern("new"), 4,
-		rb_str_new_cstr("This query is too large to execute."),
-		LONG2NUM(meta->line),
-		LONG2NUM(meta->col),
-		rb_str_new_cstr(meta->query_cstr)
-		);
-		rb_exc_raise(exception);
+static VALUE string_token_content(const char *ts, long length);
+
+VALUE token_content(VALUE source, int intern_identifiers, GraphQLToken *token) {
+	char *ts = RSTRING_PTR(source) + token->byte_offset;
+	switch((TokenType)(token->type - 200)) {
+		STATIC_VALUE_TOKEN(ON)
+		STATIC_VALUE_TOKEN(FRAGMENT)
+		STATIC_VALUE_TOKEN(QUERY)
+		STATIC_VALUE_TOKEN(MUTATION)
+		STATIC_VALUE_TOKEN(SUBSCRIPTION)
+		STATIC_VALUE_TOKEN(REPEATABLE)
+		STATIC_VALUE_TOKEN(RCURLY)
+		STATIC_VALUE_TOKEN(LCURLY)
+		STATIC_VALUE_TOKEN(RBRACKET)
+		STATIC_VALUE_TOKEN(LBRACKET)
+		STATIC_VALUE_TOKEN(RPAREN)
+		STATIC_VALUE_TOKEN(LPAREN)
+		STATIC_VALUE_TOKEN(COLON)
+		STATIC_VALUE_TOKEN(VAR_SIGN)
+		STATIC_VALUE_TOKEN(DIR_SIGN)
+		STATIC_VALUE_TOKEN(ELLIPSIS)
+		STATIC_VALUE_TOKEN(EQUALS)
+		STATIC_VALUE_TOKEN(BANG)
+		STATIC_VALUE_TOKEN(PIPE)
+		STATIC_VALUE_TOKEN(AMP)
+		STATIC_VALUE_TOKEN(SCHEMA)
+		STATIC_VALUE_TOKEN(SCALAR)
+		STATIC_VALUE_TOKEN(EXTEND)
+		STATIC_VALUE_TOKEN(IMPLEMENTS)
+		STATIC_VALUE_TOKEN(INTERFACE)
+		STATIC_VALUE_TOKEN(UNION)
+		STATIC_VALUE_TOKEN(ENUM)
+		STATIC_VALUE_TOKEN(DIRECTIVE)
+		STATIC_VALUE_TOKEN(INPUT)
+		case TYPE_LITERAL:
+		return GraphQL_type_str;
+		case TRUE_LITERAL:
+		return GraphQL_true_str;
+		case FALSE_LITERAL:
+		return GraphQL_false_str;
+		case NULL_LITERAL:
+		return GraphQL_null_str;
+		case IDENTIFIER:
+		if (intern_identifiers) {
+			return rb_enc_interned_str(ts, token->byte_length, rb_utf8_encoding());
+		} else {
+			return rb_utf8_str_new(ts, token->byte_length);
+		}
+		case INT:
+		case FLOAT:
+		case UNKNOWN_CHAR:
+		return rb_utf8_str_new(ts, token->byte_length);
+		case STRING:
+		case BAD_UNICODE_ESCAPE:
+		// These were prepared by `emit`, unless it ran without the GVL
+		if (token->value == Qnil) {
+			return string_token_content(ts, token->byte_length);
+		}
+		return token->value;
+		default:
+		return token->value;
 	}
-	int quotes_length = 0; // set by string tokens below
-	int line_incr = 0;
-	VALUE token_sym = Qnil;
-	VALUE token_content = Qnil;
-	int this_token_is_number = 0;
+}
+
+#define TOKEN_SYM(token_type) \
+case token_type: \
+return ID2SYM(rb_intern(#token_type));
+
+static VALUE token_sym(TokenType tt) {
 	switch(tt) {
-		STATIC_VALUE_TOKEN(ON, "on")
-		STATIC_VALUE_TOKEN(FRAGMENT, "fragment")
-		STATIC_VALUE_TOKEN(QUERY, "query")
-		STATIC_VALUE_TOKEN(MUTATION, "mutation")
-		STATIC_VALUE_TOKEN(SUBSCRIPTION, "subscription")
-		STATIC_VALUE_TOKEN(REPEATABLE, "repeatable")
-		STATIC_VALUE_TOKEN(RCURLY, "}")
-	STATIC_VALUE_TOKEN(LCURLY, "{")
-		STATIC_VALUE_TOKEN(RBRACKET, "]")
-		STATIC_VALUE_TOKEN(LBRACKET, "[")
-		STATIC_VALUE_TOKEN(RPAREN, ")")
-		STATIC_VALUE_TOKEN(LPAREN, "(")
-		STATIC_VALUE_TOKEN(COLON, ":")
-		STATIC_VALUE_TOKEN(VAR_SIGN, "$")
-		STATIC_VALUE_TOKEN(DIR_SIGN, "@")
-		STATIC_VALUE_TOKEN(ELLIPSIS, "...")
-		STATIC_VALUE_TOKEN(EQUALS, "=")
-		STATIC_VALUE_TOKEN(BANG, "!")
-		STATIC_VALUE_TOKEN(PIPE, "|")
-		STATIC_VALUE_TOKEN(AMP, "&")
-		STATIC_VALUE_TOKEN(SCHEMA, "schema")
-		STATIC_VALUE_TOKEN(SCALAR, "scalar")
-		STATIC_VALUE_TOKEN(EXTEND, "extend")
-		STATIC_VALUE_TOKEN(IMPLEMENTS, "implements")
-		STATIC_VALUE_TOKEN(INTERFACE, "interface")
-		STATIC_VALUE_TOKEN(UNION, "union")
-		STATIC_VALUE_TOKEN(ENUM, "enum")
-		STATIC_VALUE_TOKEN(DIRECTIVE, "directive")
-		STATIC_VALUE_TOKEN(INPUT, "input")
+		TOKEN_SYM(AMP)
+		TOKEN_SYM(BANG)
+		TOKEN_SYM(COLON)
+		TOKEN_SYM(DIRECTIVE)
+		TOKEN_SYM(DIR_SIGN)
+		TOKEN_SYM(ENUM)
+		TOKEN_SYM(ELLIPSIS)
+		TOKEN_SYM(EQUALS)
+		TOKEN_SYM(EXTEND)
+		TOKEN_SYM(FLOAT)
+		TOKEN_SYM(FRAGMENT)
+		TOKEN_SYM(IDENTIFIER)
+		TOKEN_SYM(INPUT)
+		TOKEN_SYM(IMPLEMENTS)
+		TOKEN_SYM(INT)
+		TOKEN_SYM(INTERFACE)
+		TOKEN_SYM(LBRACKET)
+		TOKEN_SYM(LCURLY)
+		TOKEN_SYM(LPAREN)
+		TOKEN_SYM(MUTATION)
+		TOKEN_SYM(ON)
+		TOKEN_SYM(PIPE)
+		TOKEN_SYM(QUERY)
+		TOKEN_SYM(RBRACKET)
+		TOKEN_SYM(RCURLY)
+		TOKEN_SYM(REPEATABLE)
+		TOKEN_SYM(RPAREN)
+		TOKEN_SYM(SCALAR)
+		TOKEN_SYM(SCHEMA)
+		TOKEN_SYM(STRING)
+		TOKEN_SYM(SUBSCRIPTION)
+		TOKEN_SYM(UNION)
+		TOKEN_SYM(VAR_SIGN)
+		TOKEN_SYM(BLOCK_STRING)
+		TOKEN_SYM(QUOTED_STRING)
+		TOKEN_SYM(UNKNOWN_CHAR)
+		TOKEN_SYM(COMMENT)
+		TOKEN_SYM(BAD_UNICODE_ESCAPE)
 		// For these, the enum name doesn't match the symbol name:
 		case TYPE_LITERAL:
-		token_sym = ID2SYM(rb_intern("TYPE"));
-		token_content = GraphQL_type_str;
-		break;
+		return ID2SYM(rb_intern("TYPE"));
 		case TRUE_LITERAL:
-		token_sym = ID2SYM(rb_intern("TRUE"));
-		token_content = GraphQL_true_str;
+		return ID2SYM(rb_intern("TRUE"));
+		case FALSE_LITERAL:
+		return ID2SYM(rb_intern("FALSE"));
+		case NULL_LITERAL:
+		return ID2SYM(rb_intern("NULL"));
+	}
+	return Qnil;
+}
+
+// Build the `[symbol, line, col, content, type]` array that `Lexer.tokenize` returns
+VALUE token_to_array(VALUE source, int intern_identifiers, GraphQLToken *token) {
+	return rb_ary_new_from_args(5,
+	token_sym((TokenType)(token->type - 200)),
+	INT2FIX(token->line),
+	INT2FIX(token->col),
+	token_content(source, intern_identifiers, token),
+	INT2FIX(token->type)
+	);
+}
+
+// The text of consecutive `#` comment lines, without the `#` and one space after it,
+// joined with newlines. This is the inverse of `GraphQL::Language::Comment.print`.
+VALUE comment_content(VALUE source, long offset, long length) {
+	const char *p = RSTRING_PTR(source) + offset;
+	const char *pe = p + length;
+	VALUE content = rb_utf8_str_new(NULL, 0);
+	int first_line = 1;
+	while (p < pe && (p = memchr(p, '#', pe - p)) != NULL) {
+		p++;
+		if (p < pe && *p == ' ') {
+			p++;
+		}
+		const char *line_end = p;
+		while (line_end < pe && *line_end != '\n' && *line_end != '\r') {
+			line_end++;
+		}
+		if (!first_line) {
+			rb_str_cat(content, "\n", 1);
+		}
+		rb_str_cat(content, p, line_end - p);
+		first_line = 0;
+		p = line_end;
+	}
+	return content;
+}
+
+#define MAX_PACKABLE_CODEPOINT 0x7FFFFFFFUL
+
+static int hex_digit_value(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+// Read `\uXXXX`, or `\u{XXXX...}` if `allow_braces`, starting at `p`.
+// Returns a pointer to the next character, or NULL if there's no escape here.
+// Code points too big for `pack("U")` are returned as `MAX_PACKABLE_CODEPOINT + 1`.
+static const char *read_unicode_escape(const char *p, const char *pe, int allow_braces, unsigned long *codepoint) {
+	if (pe - p < 6 || p[0] != '\\' || (p[1] != 'u' && p[1] != 'U')) {
+		return NULL;
+	}
+	p += 2;
+	unsigned long value = 0;
+	if (allow_braces && p[0] == '{') {
+			const char *digits_start = ++p;
+			while (p < pe && hex_digit_value(*p) >= 0) {
+				if (value <= MAX_PACKABLE_CODEPOINT) {
+					value = value * 16 + hex_digit_value(*p);
+				}
+				p++;
+			}
+			if (p - digits_start < 4 || p == pe || *p != '}') {
+			return NULL;
+		}
+		p++;
+	} else {
+		for (int i = 0; i < 4; i++) {
+			int digit = hex_digit_value(p[i]);
+			if (digit < 0) {
+				return NULL;
+			}
+			value = value * 16 + digit;
+		}
+		p += 4;
+	}
+	*codepoint = value > MAX_PACKABLE_CODEPOINT ? MAX_PACKABLE_CODEPOINT + 1 : value;
+	return p;
+}
+
+// Like `[codepoint].pack("U")`, which also encodes surrogates and values past U+10FFFF
+static char *write_codepoint(char *out, unsigned long codepoint) {
+	if (codepoint < 0x80) {
+		*out++ = (char)codepoint;
+	} else if (codepoint < 0x800) {
+		*out++ = (char)(0xC0 | (codepoint >> 6));
+		*out++ = (char)(0x80 | (codepoint & 0x3F));
+	} else if (codepoint < 0x10000) {
+		*out++ = (char)(0xE0 | (codepoint >> 12));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (codepoint & 0x3F));
+	} else if (codepoint < 0x200000) {
+		*out++ = (char)(0xF0 | (codepoint >> 18));
+		*out++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (codepoint & 0x3F));
+	} else if (codepoint < 0x4000000) {
+		*out++ = (char)(0xF8 | (codepoint >> 24));
+		*out++ = (char)(0x80 | ((codepoint >> 18) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (codepoint & 0x3F));
+	} else {
+		*out++ = (char)(0xFC | (codepoint >> 30));
+		*out++ = (char)(0x80 | ((codepoint >> 24) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 18) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (codepoint & 0x3F));
+	}
+	return out;
+}
+
+static int is_valid_codepoint(unsigned long codepoint) {
+	return codepoint <= 0x10FFFF && !(codepoint >= 0xD800 && codepoint <= 0xDFFF);
+}
+
+typedef enum QuotedStringStatus {
+	QUOTED_STRING_VALID,
+	QUOTED_STRING_INVALID_ENCODING,
+	QUOTED_STRING_INVALID_ESCAPE,
+	QUOTED_STRING_OUT_OF_RANGE
+} QuotedStringStatus;
+
+// Decode the content of a quoted string in one pass. This matches
+// `Lexer::VALID_STRING` followed by `Lexer.replace_escaped_characters_in_place`
+// and `valid_encoding?` in lexer.rb, including the bytes of invalid results
+// which go into error messages.
+//
+// The result is written to `out`, which has room for `length` bytes, since every escape
+// is at least as long as what it decodes to. If `out` is NULL, the string is only checked.
+static QuotedStringStatus decode_quoted_string(const char *str, long length, char *out, long *out_length) {
+	const char *p = memchr(str, '\\', length);
+	const char *pe = str + length;
+	char *out_start = out;
+	int valid_encoding = 1;
+	int out_of_range = 0;
+	const char *copy_from = str;
+	while (p != NULL) {
+		if (out) {
+			memcpy(out, copy_from, p - copy_from);
+			out += p - copy_from;
+		}
+		unsigned long codepoint_1, codepoint_2;
+		const char *escape_end;
+		if (p + 1 < pe && (p[1] == '"' || p[1] == '\\' || p[1] == '/' || p[1] == 'b' || p[1] == 'f' || p[1] == 'n' || p[1] == 'r' || p[1] == 't')) {
+			if (out) {
+				switch (p[1]) {
+					case 'b': *out++ = '\b'; break;
+					case 'f': *out++ = '\f'; break;
+					case 'n': *out++ = '\n'; break;
+					case 'r': *out++ = '\r'; break;
+					case 't': *out++ = '\t'; break;
+					default: *out++ = p[1]; break;
+				}
+			}
+			escape_end = p + 2;
+		} else if ((escape_end = read_unicode_escape(p, pe, 1, &codepoint_1)) != NULL) {
+			// Like `Lexer::UTF_8`, this takes a following `\uXXXX`, too
+			const char *second_escape_end = read_unicode_escape(escape_end, pe, 0, &codepoint_2);
+			if (second_escape_end != NULL) {
+				escape_end = second_escape_end;
+				if ((codepoint_1 >= 0xD800 && codepoint_1 <= 0xDBFF) && (codepoint_2 >= 0xDC00 && codepoint_2 <= 0xDFFF)) {
+					// A surrogate pair
+					codepoint_1 = ((codepoint_1 - 0xD800) * 0x400) + (codepoint_2 - 0xDC00) + 0x10000;
+					second_escape_end = NULL;
+				}
+			}
+			if (codepoint_1 > MAX_PACKABLE_CODEPOINT) {
+				out_of_range = 1;
+			} else {
+				valid_encoding &= is_valid_codepoint(codepoint_1);
+				if (out) {
+					out = write_codepoint(out, codepoint_1);
+				}
+			}
+			if (second_escape_end != NULL) {
+				valid_encoding &= is_valid_codepoint(codepoint_2);
+				if (out) {
+					out = write_codepoint(out, codepoint_2);
+				}
+			}
+		} else {
+			// This backslash doesn't start an escape, so the string doesn't match `VALID_STRING`
+			return QUOTED_STRING_INVALID_ESCAPE;
+		}
+		copy_from = escape_end;
+		p = memchr(copy_from, '\\', pe - copy_from);
+	}
+	if (out_of_range) {
+		return QUOTED_STRING_OUT_OF_RANGE;
+	}
+	if (out) {
+		memcpy(out, copy_from, pe - copy_from);
+		out += pe - copy_from;
+		*out_length = out - out_start;
+	}
+	return valid_encoding ? QUOTED_STRING_VALID : QUOTED_STRING_INVALID_ENCODING;
+}
+
+// The source string's encoding was already checked, see `init_lexer`.
+// Returns 0 if this should be a BAD_UNICODE_ESCAPE token.
+static int unescape_quoted_string(const char *str, long length, VALUE *token_value) {
+	if (memchr(str, '\\', length) == NULL) {
+		// Nothing to decode
+		*token_value = rb_utf8_str_new(str, length);
+		return 1;
+	}
+	VALUE decoded = rb_utf8_str_new(NULL, length);
+	long decoded_length;
+	QuotedStringStatus status = decode_quoted_string(str, length, RSTRING_PTR(decoded), &decoded_length);
+	switch (status) {
+		case QUOTED_STRING_INVALID_ESCAPE:
+		*token_value = rb_utf8_str_new(str, length);
+		return 0;
+		case QUOTED_STRING_OUT_OF_RANGE:
+		rb_raise(rb_eRangeError, "pack(U): value out of range");
+		default:
+		rb_str_set_len(decoded, decoded_length);
+		*token_value = decoded;
+		return status == QUOTED_STRING_VALID;
+	}
+}
+
+static int is_blank_line(const char *line, long length) {
+	for (long i = 0; i < length; i++) {
+		switch (line[i]) {
+			case ' ': case '\t': case '\r': case '\f': case '\v':
+			break;
+			default:
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// The same as `GraphQL::Language::BlockString.trim_whitespace` in block_string.rb:
+// remove the common indentation from each line after the first,
+// then remove blank lines from the start and end.
+static VALUE trim_block_string(const char *str, long length) {
+	const char *pe = str + length;
+	if (length == 0 || (memchr(str, '\n', length) == NULL && str[0] != ' ')) {
+		return rb_utf8_str_new(str, length);
+	}
+	
+	long common_indent = -1;
+	long first_kept_line = -1;
+	long last_kept_line = -1;
+	long line_index = 0;
+	for (const char *line = str; line <= pe; line_index++) {
+		const char *line_end = memchr(line, '\n', pe - line);
+		if (line_end == NULL) {
+			line_end = pe;
+		}
+		long line_length = line_end - line;
+		if (line_index > 0) {
+			long leading = 0;
+			while (leading < line_length && line[leading] == ' ') {
+				leading++;
+			}
+			if (leading < line_length && (common_indent < 0 || leading < common_indent)) {
+				common_indent = leading;
+			}
+		}
+		if (!is_blank_line(line, line_length)) {
+			if (first_kept_line < 0) {
+				first_kept_line = line_index;
+			}
+			last_kept_line = line_index;
+		}
+		line = line_end + 1;
+	}
+	
+	if (first_kept_line < 0) {
+		return rb_utf8_str_new("", 0);
+	}
+	if (common_indent < 0) {
+		common_indent = 0;
+	}
+	VALUE trimmed = rb_utf8_str_new(NULL, length);
+	char *out_start = RSTRING_PTR(trimmed);
+	char *out = out_start;
+	line_index = 0;
+	for (const char *line = str; line_index <= last_kept_line; line_index++) {
+		const char *line_end = memchr(line, '\n', pe - line);
+		if (line_end == NULL) {
+			line_end = pe;
+		}
+		if (line_index >= first_kept_line) {
+			const char *line_start = line;
+			if (line_index > 0) {
+				line_start += (line_end - line < common_indent) ? line_end - line : common_indent;
+			}
+			if (line_index > first_kept_line) {
+				*out++ = '\n';
+			}
+			memcpy(out, line_start, line_end - line_start);
+			out += line_end - line_start;
+		}
+		line = line_end + 1;
+	}
+	rb_str_set_len(trimmed, out - out_start);
+	return trimmed;
+}
+
+static int count_newlines(const char *str, long length) {
+	int count = 0;
+	const char *pe = str + length;
+	while ((str = memchr(str, '\n', pe - str)) != NULL) {
+		count++;
+		str++;
+	}
+	return count;
+}
+
+// The content of a STRING or BAD_UNICODE_ESCAPE token, including its quotes
+static VALUE string_token_content(const char *ts, long length) {
+	if (length >= 6 && ts[0] == '"' && ts[1] == '"' && ts[2] == '"') {
+		return trim_block_string(ts + 3, length - 6);
+	}
+	VALUE token_value;
+	unescape_quoted_string(ts + 1, length - 2, &token_value);
+	return token_value;
+}
+
+// `GraphQL::ParseError.new(message, line, col, query)`, for errors found in C.
+// `query` is the string being parsed, not a copy, so rejecting a big string costs the same as a small one.
+// Like `ParseError#initialize`, `filename` is added to the message.
+VALUE parse_error_new(VALUE message, VALUE line, VALUE col, VALUE query, VALUE filename) {
+	VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
+	VALUE cParseError = rb_const_get_at(mGraphQL, rb_intern("ParseError"));
+	if (RTEST(filename)) {
+		rb_str_catf(message, " (%"PRIsVALUE")", filename);
+	}
+	VALUE args[4] = { message, line, col, query };
+	return rb_class_new_instance(4, args, cParseError);
+}
+
+// The line and column of the error, from its byte offset, like `GraphQL::Language::Lexer#line_number` and `#column_number`.
+// Only `\n` ends a line, and columns count bytes, like `document_line_at`.
+static void lexer_error_position(GraphQLLexer *meta, VALUE *line, VALUE *col) {
+	long line_number = 1;
+	long line_start = 0;
+	const char *p = meta->query_cstr;
+	const char *pe = meta->query_cstr + meta->error_offset;
+	while ((p = memchr(p, '\n', pe - p)) != NULL) {
+		line_number++;
+		p++;
+		line_start = p - meta->query_cstr;
+	}
+	*line = LONG2NUM(line_number);
+	*col = LONG2NUM(meta->error_offset - line_start + 1);
+}
+
+void raise_lexer_error(GraphQLLexer *meta) {
+	VALUE exception;
+	VALUE line;
+	VALUE col;
+	lexer_error_position(meta, &line, &col);
+	switch (meta->error) {
+		case LEXER_ERROR_TOO_MANY_TOKENS:
+		exception = parse_error_new(
+		rb_utf8_str_new_cstr("This query is too large to execute."),
+		line,
+		col,
+		meta->source,
+		Qnil
+		);
+		break;
+		case LEXER_ERROR_NUMBER_FOLLOWED_BY_NAME: {
+			VALUE message = rb_utf8_str_new_cstr("Name after number is not allowed (in `");
+			rb_str_append(message, token_content(meta->source, meta->intern_identifiers, &meta->token));
+			rb_str_cat(message, meta->query_cstr + meta->error_offset, meta->error_length);
+			rb_str_cat_cstr(message, "`)");
+			exception = parse_error_new(message, line, col, meta->source, Qnil);
+			break;
+		}
+		case LEXER_ERROR_CODEPOINT_OUT_OF_RANGE:
+		exception = rb_exc_new_cstr(rb_eRangeError, "pack(U): value out of range");
 		break;
+		default:
+		return;
+	}
+	rb_exc_raise(exception);
+}
+
+// Raise now, or if the lexer is running without the GVL, stop and leave it for `raise_lexer_error`
+static void lexer_error(GraphQLLexerError error, char *ts, char *te, GraphQLLexer *meta) {
+	meta->error = error;
+	meta->error_offset = ts - meta->query_cstr;
+	meta->error_length = te - ts;
+	if (!meta->without_gvl) {
+		raise_lexer_error(meta);
+	}
+}
+
+#define SIGNATURE_MULTIPLIER 0x9E3779B97F4A7C15ULL
+#define SIGNATURE_SEED 0x243F6A8885A308D3ULL
+
+static uint64_t signature_mix(uint64_t signature, uint64_t value) {
+	signature = (signature ^ value) * SIGNATURE_MULTIPLIER;
+	return signature ^ (signature >> 29);
+}
+
+// Add a token to the lexer's signature. Whitespace, commas and comments aren't tokens,
+// and literal values are replaced by their type, so `f(a: 1)` and `f(a: 2)` make the same signature.
+static void add_to_signature(TokenType tt, const char *ts, const char *te, GraphQLLexer *meta) {
+	switch (tt) {
+		case IDENTIFIER: {
+			// Names are the only tokens whose bytes matter; the length separates one name from the next
+			uint64_t signature = signature_mix(meta->signature, ((uint64_t)(te - ts) << 8) | (uint64_t)tt);
+			while (ts < te) {
+				uint64_t word = 0;
+				for (int i = 0; i < 8 && ts < te; i++) {
+					word |= ((uint64_t)(unsigned char)*ts++) << (8 * i);
+				}
+				signature = signature_mix(signature, word);
+			}
+			meta->signature = signature;
+			return;
+		}
 		case FALSE_LITERAL:
-		token_sym = ID2SYM(rb_intern("FALSE"));
-		token_content = GraphQL_false_str;
+		tt = TRUE_LITERAL; // Boolean
 		break;
-		case NULL_LITERAL:
-		token_sym = ID2SYM(rb_intern("NULL"));
-		token_content = GraphQL_null_str;
+		case BAD_UNICODE_ESCAPE:
+		tt = STRING;
 		break;
+		default:
+		break;
+	}
+	meta->signature = signature_mix(meta->signature, (uint64_t)tt);
+}
+
+void emit(TokenType tt, char *ts, char *te, GraphQLLexer *meta) {
+	meta->tokens_count++;
+	// -1 indicates that there is no limit:
+	if (meta->max_tokens > 0 && meta->tokens_count > meta->max_tokens) {
+		lexer_error(LEXER_ERROR_TOO_MANY_TOKENS, ts, te, meta);
+		return;
+	}
+	int quotes_length = 0; // set by string tokens below
+	int line_incr = 0;
+	VALUE token_value = Qnil;
+	int this_token_is_number = 0;
+	switch(tt) {
 		case IDENTIFIER:
 		if (meta->reject_numbers_followed_by_names && meta->preceeded_by_number) {
-			VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-			VALUE mCParser = rb_const_get_at(mGraphQL, rb_intern("CParser"));
-			VALUE prev_token = rb_ary_entry(meta->tokens, -1);
-			VALUE exception = rb_funcall(
-			mCParser, rb_intern("prepare_number_name_parse_error"), 5,
-			LONG2NUM(meta->line),
-			LONG2NUM(meta->col),
-			rb_str_new_cstr(meta->query_cstr),
-			rb_ary_entry(prev_token, 3),
-			rb_utf8_str_new(ts, te - ts)
-			);
-			rb_exc_raise(exception);
-		}
-		token_sym = ID2SYM(rb_intern("IDENTIFIER"));
-		if (meta->dedup_identifiers) {
-			token_content = rb_enc_interned_str(ts, te - ts, rb_utf8_encoding());
-		} else {
-			token_content = rb_utf8_str_new(ts, te - ts);
+			lexer_error(LEXER_ERROR_NUMBER_FOLLOWED_BY_NAME, ts, te, meta);
+			return;
 		}
 		break;
-		// Can't use these while we're in backwards-compat mode:
-		// DYNAMIC_VALUE_TOKEN(INT)
-		// DYNAMIC_VALUE_TOKEN(FLOAT)
 		case INT:
-		token_sym = ID2SYM(rb_intern("INT"));
-		token_content = rb_utf8_str_new(ts, te - ts);
-		this_token_is_number = 1;
-		break;
 		case FLOAT:
-		token_sym = ID2SYM(rb_intern("FLOAT"));
-		token_content = rb_utf8_str_new(ts, te - ts);
 		this_token_is_number = 1;
 		break;
-		DYNAMIC_VALUE_TOKEN(COMMENT)
+		case COMMENT:
+		// Comments count toward `max_tokens`, but they aren't passed to the parser.
+		// If they're kept, consecutive comment lines are attached to the next token,
+		// except for comments on the same line as the previous token.
+		if (meta->keep_comments && meta->line != meta->last_token_line) {
+			if (meta->comment_length > 0 && meta->line <= meta->comment_line + 1) {
+				meta->comment_length = (te - meta->query_cstr) - meta->comment_offset;
+			} else {
+				meta->comment_offset = ts - meta->query_cstr;
+				meta->comment_length = te - ts;
+			}
+			meta->comment_line = meta->line;
+		}
+		meta->preceeded_by_number = 0;
+		meta->col += te - ts;
+		return;
 		case UNKNOWN_CHAR:
 		if (ts[0] == '\0') {
 			return;
-		} else {
-			token_content = rb_utf8_str_new(ts, te - ts);
-			token_sym = ID2SYM(rb_intern("UNKNOWN_CHAR"));
-			break;
 		}
+		break;
 		case QUOTED_STRING:
 		quotes_length = 1;
-		token_content = rb_utf8_str_new(ts + quotes_length, (te - ts - (2 * quotes_length)));
-		token_sym = ID2SYM(rb_intern("STRING"));
+		if (meta->without_gvl) {
+			// Only check the string here, it's decoded by `token_content`
+			QuotedStringStatus status = decode_quoted_string(ts + quotes_length, (te - ts - (2 * quotes_length)), NULL, NULL);
+			if (status == QUOTED_STRING_OUT_OF_RANGE) {
+				lexer_error(LEXER_ERROR_CODEPOINT_OUT_OF_RANGE, ts, te, meta);
+				return;
+			}
+			tt = status == QUOTED_STRING_VALID ? STRING : BAD_UNICODE_ESCAPE;
+		} else {
+			tt = unescape_quoted_string(ts + quotes_length, (te - ts - (2 * quotes_length)), &token_value) ? STRING : BAD_UNICODE_ESCAPE;
+		}
 		break;
 		case BLOCK_STRING:
-		token_sym = ID2SYM(rb_intern("STRING"));
 		quotes_length = 3;
-		token_content = rb_utf8_str_new(ts + quotes_length, (te - ts - (2 * quotes_length)));
-		line_incr = FIX2INT(rb_funcall(token_content, rb_intern("count"), 1, rb_utf8_str_new_cstr("\n")));
+		if (!meta->without_gvl) {
+			token_value = trim_block_string(ts + quotes_length, (te - ts - (2 * quotes_length)));
+		}
+		line_incr = count_newlines(ts + quotes_length, (te - ts - (2 * quotes_length)));
+		tt = STRING;
 		break;
-		// These are used only by the parser, this is never reached
-		case STRING:
-		case BAD_UNICODE_ESCAPE:
+		default:
 		break;
 	}
 	
-	if (token_sym != Qnil) {
-		if (tt == BLOCK_STRING || tt == QUOTED_STRING) {
-			VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-			VALUE mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
-			VALUE mGraphQLLanguageLexer = rb_const_get_at(mGraphQLLanguage, rb_intern("Lexer"));
-			VALUE valid_string_pattern = rb_const_get_at(mGraphQLLanguageLexer, rb_intern("VALID_STRING"));
-			if (tt == BLOCK_STRING) {
-				VALUE mGraphQLLanguageBlockString = rb_const_get_at(mGraphQLLanguage, rb_intern("BlockString"));
-				token_content = rb_funcall(mGraphQLLanguageBlockString, rb_intern("trim_whitespace"), 1, token_content);
-				tt = STRING;
-			} else {
-				tt = STRING;
-				if (
-					RB_TEST(rb_funcall(token_content, rb_intern("valid_encoding?"), 0)) &&
-				RB_TEST(rb_funcall(token_content, rb_intern("match?"), 1, valid_string_pattern))
-				) {
-					rb_funcall(mGraphQLLanguageLexer, rb_intern("replace_escaped_characters_in_place"), 1, token_content);
-					if (!RB_TEST(rb_funcall(token_content, rb_intern("valid_encoding?"), 0))) {
-						token_sym = ID2SYM(rb_intern("BAD_UNICODE_ESCAPE"));
-						tt = BAD_UNICODE_ESCAPE;
-					}
-				} else {
-					token_sym = ID2SYM(rb_intern("BAD_UNICODE_ESCAPE"));
-					tt = BAD_UNICODE_ESCAPE;
-				}
-			}
-		}
-		
-		VALUE token = rb_ary_new_from_args(5,
-		token_sym,
-		rb_int2inum(meta->line),
-		rb_int2inum(meta->col),
-		token_content,
-		INT2FIX(200 + (int)tt)
-		);
-		
-		if (tt != COMMENT) {
-			rb_ary_push(meta->tokens, token);
-		}
-		meta->preceeded_by_number = this_token_is_number;
-	}
+	GraphQLToken token = {
+		200 + (int)tt,
+		meta->line,
+		meta->col,
+		ts - meta->query_cstr,
+		te - ts,
+		token_value,
+		meta->comment_offset,
+		meta->comment_length
+	};
+	meta->comment_length = 0;
+	meta->token = token;
+	meta->has_token = 1;
+	add_to_signature(tt, ts, te, meta);
+	meta->preceeded_by_number = this_token_is_number;
 	// Bump the column counter for the next token
 	meta->col += te - ts;
 	meta->line += line_incr;
+	meta->last_token_line = meta->line;
 }
 
-VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens) {
+static void init_lexer(GraphQLLexer *meta, VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens, int keep_comments) {
 	int cs = 0;
 	int act = 0;
 	char *p = StringValuePtr(query_rbstr);
-	long query_len = RSTRING_LEN(query_rbstr);
-	char *pe = p + query_len;
-	char *eof = pe;
 	char *ts = 0;
 	char *te = 0;
-	VALUE tokens = rb_ary_new();
-	struct Meta meta_s = {1, 1, p, pe, tokens, fstring_identifiers, reject_numbers_followed_by_names, 0, max_tokens, 0};
-	Meta *meta = &meta_s;
 	
 	
-#line 987 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1507 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 	{
 		cs = (int)graphql_c_lexer_start;
 		ts = 0;
@@ -991,10 +1511,91 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 		act = 0;
 	}
 	
-#line 407 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+#line 930 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+	
+	
+	meta->line = 1;
+	meta->col = 1;
+	meta->query_cstr = p;
+	meta->pe = p + RSTRING_LEN(query_rbstr);
+	meta->reject_numbers_followed_by_names = reject_numbers_followed_by_names;
+	meta->preceeded_by_number = 0;
+	meta->max_tokens = max_tokens;
+	meta->tokens_count = 0;
+	meta->cs = cs;
+	meta->act = act;
+	meta->p = p;
+	meta->ts = ts;
+	meta->te = te;
+	meta->source = query_rbstr;
+	meta->intern_identifiers = fstring_identifiers;
+	meta->bad_encoding = rb_enc_str_coderange(query_rbstr) == ENC_CODERANGE_BROKEN;
+	meta->has_token = 0;
+	meta->token.type = 0;
+	meta->token.value = Qnil;
+	meta->keep_comments = keep_comments;
+	meta->comment_offset = 0;
+	meta->comment_length = 0;
+	meta->comment_line = 0;
+	meta->last_token_line = 0;
+	meta->without_gvl = 0;
+	meta->error = LEXER_ERROR_NONE;
+	meta->error_offset = 0;
+	meta->error_length = 0;
+	meta->signature = SIGNATURE_SEED;
+}
+
+// Run the machine until it emits a token for the parser.
+// Returns the token's type, or 0 at the end of the input.
+int next_token(GraphQLLexer *meta) {
+	int cs = meta->cs;
+	int act = meta->act;
+	char *p = meta->p;
+	char *pe = meta->pe;
+	char *eof = pe;
+	char *ts = meta->ts;
+	char *te = meta->te;
 	
+	meta->has_token = 0;
+	if (meta->bad_encoding) {
+		// Report the whole string as one bad token, see `prepare_bad_unicode_error`
+		GraphQLToken bad_token = {200 + BAD_UNICODE_ESCAPE, 1, 1, 0, pe - meta->query_cstr, meta->source};
+		meta->token = bad_token;
+		meta->has_token = 1;
+		meta->bad_encoding = 0;
+		add_to_signature(BAD_UNICODE_ESCAPE, meta->query_cstr, pe, meta);
+		p = pe;
+	}
 	
-#line 998 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+	while (!meta->has_token && !meta->error && p != pe) {
+		if (cs == graphql_c_lexer_start) {
+			// Between tokens, find the end of blanks, comments and strings without escapes
+			// a block at a time, then hand the next interesting byte back to the machine.
+			char *blanks_end = (char *)scan_kernels->skip_blanks(p, pe);
+			if (blanks_end != p) {
+				meta->col += blanks_end - p;
+				meta->preceeded_by_number = 0;
+				p = blanks_end;
+				if (p == pe) {
+					break;
+				}
+			}
+			if (*p == '#') {
+				char *comment_end = (char *)scan_kernels->find_line_end(p + 1, pe);
+				emit(COMMENT, p, comment_end, meta);
+				p = comment_end;
+				continue;
+			} else if (*p == '"' && !(pe - p >= 3 && p[1] == '"' && p[2] == '"')) {
+				char *string_end = (char *)scan_kernels->find_string_end(p + 1, pe);
+				if (string_end != pe && *string_end == '"') {
+					emit(QUOTED_STRING, p, string_end + 1, meta);
+					p = string_end + 1;
+					continue;
+				}
+			}
+		}
+		
+#line 1599 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 	{
 		unsigned int _trans = 0;
 		const char * _keys;
@@ -1009,7 +1610,7 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 					{ts = p;}}
 				
-#line 1013 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1614 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 				
 				
 				break; 
@@ -1047,7 +1648,7 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1051 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1652 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1057,10 +1658,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 75 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 75 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(RCURLY, ts, te, meta); }
+								emit(RCURLY, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1064 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1665 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1070,10 +1671,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 76 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 76 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(LCURLY, ts, te, meta); }
+								emit(LCURLY, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1077 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1678 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1083,10 +1684,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 77 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 77 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(RPAREN, ts, te, meta); }
+								emit(RPAREN, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1090 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1691 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1096,10 +1697,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 78 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 78 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(LPAREN, ts, te, meta); }
+								emit(LPAREN, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1103 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1704 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1109,10 +1710,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 79 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 79 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(RBRACKET, ts, te, meta); }
+								emit(RBRACKET, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1116 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1717 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1122,10 +1723,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 80 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 80 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(LBRACKET, ts, te, meta); }
+								emit(LBRACKET, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1129 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1730 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1135,10 +1736,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 81 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 81 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(COLON, ts, te, meta); }
+								emit(COLON, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1142 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1743 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1148,10 +1749,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(BLOCK_STRING, ts, te, meta); }
+								emit(BLOCK_STRING, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1155 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1756 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1161,10 +1762,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(QUOTED_STRING, ts, te, meta); }
+								emit(QUOTED_STRING, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1168 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1769 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1174,10 +1775,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 84 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 84 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(VAR_SIGN, ts, te, meta); }
+								emit(VAR_SIGN, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1181 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1782 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1187,10 +1788,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 85 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 85 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(DIR_SIGN, ts, te, meta); }
+								emit(DIR_SIGN, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1194 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1795 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1200,10 +1801,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 86 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 86 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(ELLIPSIS, ts, te, meta); }
+								emit(ELLIPSIS, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1207 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1808 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1213,10 +1814,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 87 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 87 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(EQUALS, ts, te, meta); }
+								emit(EQUALS, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1220 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1821 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1226,10 +1827,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 88 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 88 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(BANG, ts, te, meta); }
+								emit(BANG, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1233 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1834 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1239,10 +1840,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 89 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 89 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(PIPE, ts, te, meta); }
+								emit(PIPE, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1246 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1847 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1252,10 +1853,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 90 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 90 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(AMP, ts, te, meta); }
+								emit(AMP, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1259 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1860 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1266,13 +1867,14 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 						{te = p+1;{
 #line 93 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 								
-								meta->line += 1;
-								meta->col = 1;
+								// Only `\n` starts a line, like in the Ruby lexer and `document_line_at`
+								if (*ts == '\n') { meta->line += 1; meta->col = 1; } else { meta->col += 1; }
 								meta->preceeded_by_number = 0;
+								{p += 1; goto _out; }
 							}
 						}}
 					
-#line 1276 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1878 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1282,10 +1884,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 104 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p+1;{
 #line 104 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(UNKNOWN_CHAR, ts, te, meta); }
+								emit(UNKNOWN_CHAR, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1289 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1891 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1295,10 +1897,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 54 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 54 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(INT, ts, te, meta); }
+								emit(INT, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1302 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1904 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1308,10 +1910,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 55 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 55 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(FLOAT, ts, te, meta); }
+								emit(FLOAT, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1315 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1917 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1321,10 +1923,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(BLOCK_STRING, ts, te, meta); }
+								emit(BLOCK_STRING, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1328 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1930 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1334,10 +1936,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(QUOTED_STRING, ts, te, meta); }
+								emit(QUOTED_STRING, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1341 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1943 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1347,10 +1949,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 91 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 91 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(IDENTIFIER, ts, te, meta); }
+								emit(IDENTIFIER, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1354 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1956 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1360,10 +1962,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 92 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 92 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(COMMENT, ts, te, meta); }
+								emit(COMMENT, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1367 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1969 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1376,10 +1978,11 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 								
 								meta->col += te - ts;
 								meta->preceeded_by_number = 0;
+								{p += 1; goto _out; }
 							}
 						}}
 					
-#line 1383 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1986 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1389,10 +1992,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 104 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{te = p;p = p - 1;{
 #line 104 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(UNKNOWN_CHAR, ts, te, meta); }
+								emit(UNKNOWN_CHAR, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1396 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 1999 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1403,10 +2006,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 						{p = ((te))-1;
 							{
 #line 54 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(INT, ts, te, meta); }
+								emit(INT, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1410 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2013 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1417,10 +2020,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 						{p = ((te))-1;
 							{
 #line 55 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(FLOAT, ts, te, meta); }
+								emit(FLOAT, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1424 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2027 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1431,10 +2034,10 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 						{p = ((te))-1;
 							{
 #line 104 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-								emit(UNKNOWN_CHAR, ts, te, meta); }
+								emit(UNKNOWN_CHAR, ts, te, meta); {p += 1; goto _out; } }
 						}}
 					
-#line 1438 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2041 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1447,160 +2050,160 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 									p = ((te))-1;
 									{
 #line 56 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(ON, ts, te, meta); }
+										emit(ON, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 4:  {
 									p = ((te))-1;
 									{
 #line 57 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(FRAGMENT, ts, te, meta); }
+										emit(FRAGMENT, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 5:  {
 									p = ((te))-1;
 									{
 #line 58 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(TRUE_LITERAL, ts, te, meta); }
+										emit(TRUE_LITERAL, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 6:  {
 									p = ((te))-1;
 									{
 #line 59 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(FALSE_LITERAL, ts, te, meta); }
+										emit(FALSE_LITERAL, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 7:  {
 									p = ((te))-1;
 									{
 #line 60 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(NULL_LITERAL, ts, te, meta); }
+										emit(NULL_LITERAL, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 8:  {
 									p = ((te))-1;
 									{
 #line 61 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(QUERY, ts, te, meta); }
+										emit(QUERY, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 9:  {
 									p = ((te))-1;
 									{
 #line 62 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(MUTATION, ts, te, meta); }
+										emit(MUTATION, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 10:  {
 									p = ((te))-1;
 									{
 #line 63 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(SUBSCRIPTION, ts, te, meta); }
+										emit(SUBSCRIPTION, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 11:  {
 									p = ((te))-1;
 									{
 #line 64 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(SCHEMA, ts, te, meta); }
+										emit(SCHEMA, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 12:  {
 									p = ((te))-1;
 									{
 #line 65 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(SCALAR, ts, te, meta); }
+										emit(SCALAR, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 13:  {
 									p = ((te))-1;
 									{
 #line 66 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(TYPE_LITERAL, ts, te, meta); }
+										emit(TYPE_LITERAL, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 14:  {
 									p = ((te))-1;
 									{
 #line 67 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(EXTEND, ts, te, meta); }
+										emit(EXTEND, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 15:  {
 									p = ((te))-1;
 									{
 #line 68 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(IMPLEMENTS, ts, te, meta); }
+										emit(IMPLEMENTS, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 16:  {
 									p = ((te))-1;
 									{
 #line 69 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(INTERFACE, ts, te, meta); }
+										emit(INTERFACE, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 17:  {
 									p = ((te))-1;
 									{
 #line 70 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(UNION, ts, te, meta); }
+										emit(UNION, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 18:  {
 									p = ((te))-1;
 									{
 #line 71 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(ENUM, ts, te, meta); }
+										emit(ENUM, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 19:  {
 									p = ((te))-1;
 									{
 #line 72 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(INPUT, ts, te, meta); }
+										emit(INPUT, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 20:  {
 									p = ((te))-1;
 									{
 #line 73 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(DIRECTIVE, ts, te, meta); }
+										emit(DIRECTIVE, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 21:  {
 									p = ((te))-1;
 									{
 #line 74 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(REPEATABLE, ts, te, meta); }
+										emit(REPEATABLE, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 29:  {
 									p = ((te))-1;
 									{
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(BLOCK_STRING, ts, te, meta); }
+										emit(BLOCK_STRING, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 30:  {
 									p = ((te))-1;
 									{
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(QUOTED_STRING, ts, te, meta); }
+										emit(QUOTED_STRING, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 								case 38:  {
 									p = ((te))-1;
 									{
 #line 91 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
-										emit(IDENTIFIER, ts, te, meta); }
+										emit(IDENTIFIER, ts, te, meta); {p += 1; goto _out; } }
 									break; 
 								}
 							}}
 					}
 					
-#line 1604 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2207 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1610,13 +2213,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1614 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2217 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 56 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 3;}}
 					
-#line 1620 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2223 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1626,13 +2229,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1630 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2233 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 57 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 4;}}
 					
-#line 1636 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2239 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1642,13 +2245,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1646 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2249 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 58 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 5;}}
 					
-#line 1652 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2255 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1658,13 +2261,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1662 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2265 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 59 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 6;}}
 					
-#line 1668 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2271 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1674,13 +2277,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1678 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2281 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 60 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 7;}}
 					
-#line 1684 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2287 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1690,13 +2293,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1694 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2297 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 61 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 8;}}
 					
-#line 1700 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2303 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1706,13 +2309,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1710 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2313 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 62 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 9;}}
 					
-#line 1716 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2319 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1722,13 +2325,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1726 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2329 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 63 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 10;}}
 					
-#line 1732 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2335 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1738,13 +2341,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1742 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2345 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 64 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 11;}}
 					
-#line 1748 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2351 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1754,13 +2357,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1758 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2361 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 65 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 12;}}
 					
-#line 1764 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2367 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1770,13 +2373,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1774 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2377 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 66 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 13;}}
 					
-#line 1780 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2383 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1786,13 +2389,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1790 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2393 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 67 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 14;}}
 					
-#line 1796 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2399 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1802,13 +2405,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1806 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2409 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 68 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 15;}}
 					
-#line 1812 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2415 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1818,13 +2421,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1822 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2425 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 69 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 16;}}
 					
-#line 1828 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2431 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1834,13 +2437,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1838 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2441 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 70 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 17;}}
 					
-#line 1844 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2447 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1850,13 +2453,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1854 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2457 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 71 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 18;}}
 					
-#line 1860 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2463 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1866,13 +2469,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1870 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2473 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 72 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 19;}}
 					
-#line 1876 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2479 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1882,13 +2485,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1886 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2489 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 73 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 20;}}
 					
-#line 1892 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2495 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1898,13 +2501,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1902 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2505 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 74 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 21;}}
 					
-#line 1908 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2511 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1914,13 +2517,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1918 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2521 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 82 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 29;}}
 					
-#line 1924 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2527 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1930,13 +2533,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1934 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2537 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 83 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 30;}}
 					
-#line 1940 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2543 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1946,13 +2549,13 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{te = p+1;}}
 					
-#line 1950 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2553 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					{
 #line 91 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
 						{act = 38;}}
 					
-#line 1956 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2559 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1972,7 +2575,7 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 #line 1 "NONE"
 						{ts = 0;}}
 					
-#line 1976 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
+#line 2579 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.c"
 					
 					
 					break; 
@@ -1985,16 +2588,147 @@ VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_fo
 		_out: {}
 	}
 	
-#line 408 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+#line 1012 "graphql-c_parser/ext/graphql_c_parser_ext/lexer.rl"
+		
+	}
+	
+	meta->cs = cs;
+	meta->act = act;
+	meta->p = p;
+	meta->ts = ts;
+	meta->te = te;
+	return meta->has_token ? meta->token.type : 0;
+}
+
+VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens) {
+	GraphQLTokenBuffer *buffer;
+	VALUE tokens = TypedData_Make_Struct(GraphQL_CParser_TokenBuffer, GraphQLTokenBuffer, &token_buffer_data_type, buffer);
+	buffer->source = query_rbstr;
+	buffer->intern_identifiers = fstring_identifiers;
+	GraphQLLexer lexer;
+	init_lexer(&lexer, query_rbstr, fstring_identifiers, reject_numbers_followed_by_names, max_tokens, 0);
 	
+	while (next_token(&lexer)) {
+		push_token(buffer, &lexer.token);
+	}
 	
 	return tokens;
 }
 
+VALUE token_stream(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens, int keep_comments) {
+	GraphQLLexer *lexer;
+	VALUE stream = TypedData_Make_Struct(GraphQL_CParser_TokenStream, GraphQLLexer, &token_stream_data_type, lexer);
+	init_lexer(lexer, query_rbstr, fstring_identifiers, reject_numbers_followed_by_names, max_tokens, keep_comments);
+	return stream;
+}
+
+// Lex the whole string without making any tokens or Ruby objects, only the signature
+VALUE signature(VALUE query_rbstr, int reject_numbers_followed_by_names) {
+	GraphQLLexer lexer;
+	init_lexer(&lexer, query_rbstr, 0, reject_numbers_followed_by_names, -1, 0);
+	// Strings are checked, but not decoded, and errors are raised after the loop
+	lexer.without_gvl = 1;
+	while (next_token(&lexer)) {
+	}
+	if (lexer.error) {
+		raise_lexer_error(&lexer);
+	}
+	RB_GC_GUARD(query_rbstr);
+	return signature_to_s(&lexer);
+}
+
+static int is_name_byte(char c) {
+	return c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+// If `previous` and `next` would run together without a space between them, like `query Q` or `1 2`
+static int needs_separator(const GraphQLToken *previous, const GraphQLToken *next, const char *query_cstr) {
+	char last = query_cstr[previous->byte_offset + previous->byte_length - 1];
+	char first = query_cstr[next->byte_offset];
+	if (is_name_byte(last)) {
+		// `.` after a number would start a float, and a float's exponent doesn't need an `e`, see `FLOAT` above
+		return is_name_byte(first) || first == '.' || (previous->type == 200 + FLOAT && (first == '-' || first == '+'));
+	} else if (last == '"') {
+		// `"" "a"` isn't `"""a"`, and `"""a""" "b"` isn't `"""a""""b"`
+		return first == '"';
+	}
+	return 0;
+}
+
+// Lex the whole string and copy its tokens, with a space only where two tokens would run together.
+// Whitespace, commas and comments are left out. Tokens are copied from the query as they are,
+// so parsing the result makes the same document as parsing the query.
+//
+// From the first invalid character on, the rest of the query is copied as it is, so that the result fails to parse like the query does.
+// (A `"` without an end, for example, would take in the next line's tokens.)
+VALUE minify(VALUE query_rbstr, int reject_numbers_followed_by_names) {
+	GraphQLLexer lexer;
+	init_lexer(&lexer, query_rbstr, 0, reject_numbers_followed_by_names, -1, 0);
+	// Strings are checked, but not decoded, and errors are raised after the loop
+	lexer.without_gvl = 1;
+	// Spaces are only added where the query had something between two tokens, so the result is never longer than the query
+	VALUE minified = rb_str_buf_new(RSTRING_LEN(query_rbstr));
+	char *out_start = RSTRING_PTR(minified);
+	char *out = out_start;
+	GraphQLToken previous = { 0 };
+	int has_previous = 0;
+	while (next_token(&lexer)) {
+		GraphQLToken *token = &lexer.token;
+		const char *ts = lexer.query_cstr + token->byte_offset;
+		int after_gap = has_previous && token->byte_offset != previous.byte_offset + previous.byte_length;
+		if (token->type == 200 + UNKNOWN_CHAR) {
+			if (after_gap) {
+				*out++ = ' ';
+			}
+			memcpy(out, ts, lexer.pe - ts);
+			out += lexer.pe - ts;
+			break;
+		}
+		if (after_gap && needs_separator(&previous, token, lexer.query_cstr)) {
+			*out++ = ' ';
+		}
+		memcpy(out, ts, token->byte_length);
+		out += token->byte_length;
+		previous = *token;
+		has_previous = 1;
+	}
+	if (lexer.error) {
+		raise_lexer_error(&lexer);
+	}
+	rb_str_set_len(minified, out - out_start);
+	rb_enc_copy(minified, query_rbstr);
+	RB_GC_GUARD(query_rbstr);
+	return minified;
+}
+
+// Finish the lexer's signature and encode it as hex
+VALUE signature_to_s(GraphQLLexer *lexer) {
+	// The finalizer from MurmurHash3, so that every bit of the signature depends on every token
+	uint64_t h = lexer->signature;
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb93fe53ea87bULL;
+	h ^= h >> 33;
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016" PRIx64, h);
+	return rb_usascii_str_new(hex, 16);
+}
+
+void initialize_token_buffer_class(VALUE token_buffer_class) {
+	GraphQL_CParser_TokenBuffer = token_buffer_class;
+	rb_global_variable(&GraphQL_CParser_TokenBuffer);
+}
+
+void initialize_token_stream_class(VALUE token_stream_class) {
+	GraphQL_CParser_TokenStream = token_stream_class;
+	rb_global_variable(&GraphQL_CParser_TokenStream);
+}
+
 
+// These strings are returned to every Ractor, so they must be frozen (and interned, like `-"query"`)
 #define SETUP_STATIC_TOKEN_VARIABLE(token_name, token_content) \
-GraphQLTokenString##token_name = rb_utf8_str_new_cstr(token_content); \
-rb_funcall(GraphQLTokenString##token_name, rb_intern("-@"), 0); \
+GraphQLTokenString##token_name = rb_str_to_interned_str(rb_utf8_str_new_cstr(token_content)); \
 rb_global_variable(&GraphQLTokenString##token_name); \
 
 #define SETUP_STATIC_STRING(var_name, str_content) \
@@ -1,6 +1,88 @@
 #ifndef Graphql_lexer_h
 #define Graphql_lexer_h
 #include <ruby.h>
+#include <stdint.h>
+
+// A token found by the lexer. Its content is read from the source string on demand,
+// see `token_content`.
+typedef struct GraphQLToken {
+  int type; // The parser's token number, see `%token` in parser.y
+  int line;
+  int col;
+  long byte_offset;
+  long byte_length;
+  VALUE value; // The unescaped content of STRING tokens, unless the lexer ran without the GVL, otherwise Qnil
+  // The `#` comment lines right before this token, if the lexer keeps comments. `comment_length` is 0 if there aren't any.
+  long comment_offset;
+  long comment_length;
+} GraphQLToken;
+
+typedef struct GraphQLTokenBuffer {
+  GraphQLToken *tokens;
+  long length;
+  long capacity;
+  VALUE source;
+  int intern_identifiers;
+} GraphQLTokenBuffer;
+
+typedef enum GraphQLLexerError {
+  LEXER_ERROR_NONE,
+  LEXER_ERROR_TOO_MANY_TOKENS,
+  LEXER_ERROR_NUMBER_FOLLOWED_BY_NAME,
+  LEXER_ERROR_CODEPOINT_OUT_OF_RANGE
+} GraphQLLexerError;
+
+// The Ragel machine's state between calls to `next_token`
+typedef struct GraphQLLexer {
+  int line;
+  int col;
+  char *query_cstr;
+  char *pe;
+  int reject_numbers_followed_by_names;
+  int preceeded_by_number;
+  int max_tokens;
+  int tokens_count;
+  int cs;
+  int act;
+  char *p;
+  char *ts;
+  char *te;
+  VALUE source;
+  int intern_identifiers;
+  int bad_encoding;
+  int has_token;
+  GraphQLToken token; // The most recently emitted token
+  int keep_comments;
+  // The comment lines since the last token, see `emit`
+  long comment_offset;
+  long comment_length;
+  int comment_line;
+  int last_token_line; // The line where the most recent token ended
+  // If set, the lexer doesn't touch Ruby objects. Instead of raising, it stops at an error
+  // and `raise_lexer_error` raises it later. STRING tokens are decoded by `token_content`.
+  int without_gvl;
+  GraphQLLexerError error;
+  long error_offset; // The bytes which caused `error`
+  long error_length;
+  // A rolling hash of the tokens so far, without literal values, see `add_to_signature`
+  uint64_t signature;
+} GraphQLLexer;
+
 VALUE tokenize(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens);
+VALUE token_stream(VALUE query_rbstr, int fstring_identifiers, int reject_numbers_followed_by_names, int max_tokens, int keep_comments);
+VALUE signature(VALUE query_rbstr, int reject_numbers_followed_by_names);
+VALUE signature_to_s(GraphQLLexer *lexer);
+VALUE minify(VALUE query_rbstr, int reject_numbers_followed_by_names);
+int next_token(GraphQLLexer *lexer);
+void raise_lexer_error(GraphQLLexer *lexer);
+VALUE parse_error_new(VALUE message, VALUE line, VALUE col, VALUE query, VALUE filename);
+GraphQLTokenBuffer *get_token_buffer(VALUE token_buffer);
+GraphQLLexer *get_token_stream(VALUE token_stream);
+int token_is_identifier(int token_type);
+VALUE token_content(VALUE source, int intern_identifiers, GraphQLToken *token);
+VALUE comment_content(VALUE source, long offset, long length);
+VALUE token_to_array(VALUE source, int intern_identifiers, GraphQLToken *token);
 void setup_static_token_variables();
+void initialize_token_buffer_class(VALUE token_buffer_class);
+void initialize_token_stream_class(VALUE token_stream_class);
 #endif
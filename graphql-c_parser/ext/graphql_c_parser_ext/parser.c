@@ -71,58 +71,51 @@
 
 // C Declarations
 #include <ruby.h>
-#define YYSTYPE VALUE
-#define YYSTACK_USE_ALLOCA 1
-
-int yylex(YYSTYPE *, VALUE, VALUE);
-void yyerror(VALUE, VALUE, const char*);
+#include <ruby/thread.h>
+#include <ruby/atomic.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#include "parser.h"
+
+// When Bison's stacks are full, move them to `state->stack`, see `grow_parser_stack`.
+// Bison checks that `capacity` grew, and stops parsing if it didn't.
+#define yyoverflow(message, states, states_bytesize, values, values_bytesize, capacity) do { \
+    void *grown_states = *(states); \
+    void *grown_values = *(values); \
+    long grown_capacity = (long)*(capacity); \
+    if (grow_parser_stack(parser, state, &grown_states, (states_bytesize), &grown_values, (values_bytesize), &grown_capacity)) { \
+      *(states) = grown_states; \
+      *(values) = grown_values; \
+      *(capacity) = grown_capacity; \
+    } \
+  } while (0)
 
-static VALUE GraphQL_Language_Nodes_NONE;
 static VALUE r_string_query;
 
-#define MAKE_AST_NODE(node_class_name, nargs, ...) rb_funcall(GraphQL_Language_Nodes_##node_class_name, rb_intern("from_a"), nargs + 1, filename,__VA_ARGS__)
-
-#define SETUP_NODE_CLASS_VARIABLE(node_class_name) static VALUE GraphQL_Language_Nodes_##node_class_name;
-
-SETUP_NODE_CLASS_VARIABLE(Argument)
-SETUP_NODE_CLASS_VARIABLE(Directive)
-SETUP_NODE_CLASS_VARIABLE(Document)
-SETUP_NODE_CLASS_VARIABLE(Enum)
-SETUP_NODE_CLASS_VARIABLE(Field)
-SETUP_NODE_CLASS_VARIABLE(FragmentDefinition)
-SETUP_NODE_CLASS_VARIABLE(FragmentSpread)
-SETUP_NODE_CLASS_VARIABLE(InlineFragment)
-SETUP_NODE_CLASS_VARIABLE(InputObject)
-SETUP_NODE_CLASS_VARIABLE(ListType)
-SETUP_NODE_CLASS_VARIABLE(NonNullType)
-SETUP_NODE_CLASS_VARIABLE(NullValue)
-SETUP_NODE_CLASS_VARIABLE(OperationDefinition)
-SETUP_NODE_CLASS_VARIABLE(TypeName)
-SETUP_NODE_CLASS_VARIABLE(VariableDefinition)
-SETUP_NODE_CLASS_VARIABLE(VariableIdentifier)
-
-SETUP_NODE_CLASS_VARIABLE(ScalarTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(ObjectTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(InterfaceTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(UnionTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(EnumTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(InputObjectTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(EnumValueDefinition)
-SETUP_NODE_CLASS_VARIABLE(DirectiveDefinition)
-SETUP_NODE_CLASS_VARIABLE(DirectiveLocation)
-SETUP_NODE_CLASS_VARIABLE(FieldDefinition)
-SETUP_NODE_CLASS_VARIABLE(InputValueDefinition)
-SETUP_NODE_CLASS_VARIABLE(SchemaDefinition)
-
-SETUP_NODE_CLASS_VARIABLE(ScalarTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(ObjectTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(InterfaceTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(UnionTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(EnumTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(InputObjectTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
-
-#line 126 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+// Takes the node's byte offset in the source, then the arguments to `.from_a` after `filename`, `line` and `col`,
+// and adds a node to the document's arena, see ast.c. Lines and columns are found from the offset when they're read.
+#define MAKE_AST_NODE(node_class_name, nargs, pos, ...) AST_NODE_VALUE(ast_node_new(state->ast, AST_##node_class_name, pos, nargs, __VA_ARGS__))
+// A token's content is read from the source string when the node is made, see `materialize_value`
+#define TOKEN_VALUE(token) ast_token_value(state->ast, token.type, token.byte_offset, token.byte_length, token.value)
+// The `#` comments before a token, or nil, see `comment_content`
+#define COMMENT_VALUE(token) ast_comment_value(token.comment_offset, token.comment_length)
+#define NUMBER_VALUE(value_type, token) ast_number_value(state->ast, value_type, token.type, token.byte_offset, token.byte_length)
+#define MAKE_AST_LIST(first_value) make_ast_list(state->ast, first_value)
+#define AST_LIST_PUSH(list, value) ast_list_push(state->ast, list, value)
+
+// Count a rule for `Document#parse_stats`. If the document is over one of `Parser.new`'s limits, stop parsing.
+#define ENTER_SELECTION_SET(token) if (enter_selection_set(state, token)) { YYABORT; }
+#define COUNT_FIELD(token, aliased) if (count_field(state, token, aliased)) { YYABORT; }
+
+static GraphQLAstValue make_ast_list(GraphQLDocument *doc, GraphQLAstValue first_value);
+static int enter_selection_set(GraphQLParser *state, GraphQLToken token);
+static int count_field(GraphQLParser *state, GraphQLToken token, int aliased);
+static int enter_nesting(GraphQLParser *state, GraphQLToken token);
+static int grow_parser_stack(VALUE parser, GraphQLParser *state, void **states, long states_bytesize, void **values, long values_bytesize, long *capacity);
+static void set_operation_types(GraphQLAstValue operation_types, GraphQLAstValue other_operation_types);
+
+#line 119 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -248,7 +241,17 @@ extern int yydebug;
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef int YYSTYPE;
+union YYSTYPE
+{
+#line 56 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+
+  GraphQLAstValue node;
+  GraphQLToken token;
+
+#line 252 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
 # define YYSTYPE_IS_DECLARED 1
 #endif
@@ -256,7 +259,7 @@ typedef int YYSTYPE;
 
 
 
-int yyparse (VALUE parser, VALUE filename);
+int yyparse (VALUE parser, GraphQLParser *state);
 
 
 
@@ -311,93 +314,102 @@ enum yysymbol_kind_t
   YYSYMBOL_definition = 44,                /* definition  */
   YYSYMBOL_executable_definition = 45,     /* executable_definition  */
   YYSYMBOL_operation_definition = 46,      /* operation_definition  */
-  YYSYMBOL_operation_type = 47,            /* operation_type  */
-  YYSYMBOL_operation_name_opt = 48,        /* operation_name_opt  */
-  YYSYMBOL_variable_definitions_opt = 49,  /* variable_definitions_opt  */
-  YYSYMBOL_variable_definitions_list = 50, /* variable_definitions_list  */
-  YYSYMBOL_variable_definition = 51,       /* variable_definition  */
-  YYSYMBOL_default_value_opt = 52,         /* default_value_opt  */
-  YYSYMBOL_selection_list = 53,            /* selection_list  */
-  YYSYMBOL_selection = 54,                 /* selection  */
-  YYSYMBOL_selection_set = 55,             /* selection_set  */
-  YYSYMBOL_selection_set_opt = 56,         /* selection_set_opt  */
-  YYSYMBOL_field = 57,                     /* field  */
-  YYSYMBOL_arguments_opt = 58,             /* arguments_opt  */
-  YYSYMBOL_arguments_list = 59,            /* arguments_list  */
-  YYSYMBOL_argument = 60,                  /* argument  */
-  YYSYMBOL_literal_value = 61,             /* literal_value  */
-  YYSYMBOL_input_value = 62,               /* input_value  */
-  YYSYMBOL_null_value = 63,                /* null_value  */
-  YYSYMBOL_variable = 64,                  /* variable  */
-  YYSYMBOL_list_value = 65,                /* list_value  */
-  YYSYMBOL_list_value_list = 66,           /* list_value_list  */
-  YYSYMBOL_enum_name = 67,                 /* enum_name  */
-  YYSYMBOL_enum_value = 68,                /* enum_value  */
-  YYSYMBOL_object_value = 69,              /* object_value  */
-  YYSYMBOL_object_value_list_opt = 70,     /* object_value_list_opt  */
-  YYSYMBOL_object_value_list = 71,         /* object_value_list  */
-  YYSYMBOL_object_value_field = 72,        /* object_value_field  */
-  YYSYMBOL_object_literal_value = 73,      /* object_literal_value  */
-  YYSYMBOL_object_literal_value_list_opt = 74, /* object_literal_value_list_opt  */
-  YYSYMBOL_object_literal_value_list = 75, /* object_literal_value_list  */
-  YYSYMBOL_object_literal_value_field = 76, /* object_literal_value_field  */
-  YYSYMBOL_directives_list_opt = 77,       /* directives_list_opt  */
-  YYSYMBOL_directives_list = 78,           /* directives_list  */
-  YYSYMBOL_directive = 79,                 /* directive  */
-  YYSYMBOL_name = 80,                      /* name  */
-  YYSYMBOL_schema_keyword = 81,            /* schema_keyword  */
-  YYSYMBOL_name_without_on = 82,           /* name_without_on  */
-  YYSYMBOL_fragment_spread = 83,           /* fragment_spread  */
-  YYSYMBOL_inline_fragment = 84,           /* inline_fragment  */
-  YYSYMBOL_fragment_definition = 85,       /* fragment_definition  */
-  YYSYMBOL_fragment_name_opt = 86,         /* fragment_name_opt  */
-  YYSYMBOL_type = 87,                      /* type  */
-  YYSYMBOL_nullable_type = 88,             /* nullable_type  */
-  YYSYMBOL_type_system_definition = 89,    /* type_system_definition  */
-  YYSYMBOL_schema_definition = 90,         /* schema_definition  */
-  YYSYMBOL_operation_type_definition_list_opt = 91, /* operation_type_definition_list_opt  */
-  YYSYMBOL_operation_type_definition_list = 92, /* operation_type_definition_list  */
-  YYSYMBOL_operation_type_definition = 93, /* operation_type_definition  */
-  YYSYMBOL_type_definition = 94,           /* type_definition  */
-  YYSYMBOL_description = 95,               /* description  */
-  YYSYMBOL_description_opt = 96,           /* description_opt  */
-  YYSYMBOL_scalar_type_definition = 97,    /* scalar_type_definition  */
-  YYSYMBOL_object_type_definition = 98,    /* object_type_definition  */
-  YYSYMBOL_implements_opt = 99,            /* implements_opt  */
-  YYSYMBOL_interfaces_list = 100,          /* interfaces_list  */
-  YYSYMBOL_legacy_interfaces_list = 101,   /* legacy_interfaces_list  */
-  YYSYMBOL_input_value_definition = 102,   /* input_value_definition  */
-  YYSYMBOL_input_value_definition_list = 103, /* input_value_definition_list  */
-  YYSYMBOL_arguments_definitions_opt = 104, /* arguments_definitions_opt  */
-  YYSYMBOL_field_definition = 105,         /* field_definition  */
-  YYSYMBOL_field_definition_list_opt = 106, /* field_definition_list_opt  */
-  YYSYMBOL_field_definition_list = 107,    /* field_definition_list  */
-  YYSYMBOL_interface_type_definition = 108, /* interface_type_definition  */
-  YYSYMBOL_pipe_opt = 109,                 /* pipe_opt  */
-  YYSYMBOL_union_members = 110,            /* union_members  */
-  YYSYMBOL_union_type_definition = 111,    /* union_type_definition  */
-  YYSYMBOL_enum_type_definition = 112,     /* enum_type_definition  */
-  YYSYMBOL_enum_value_definition = 113,    /* enum_value_definition  */
-  YYSYMBOL_enum_value_definitions = 114,   /* enum_value_definitions  */
-  YYSYMBOL_input_object_type_definition = 115, /* input_object_type_definition  */
-  YYSYMBOL_directive_definition = 116,     /* directive_definition  */
-  YYSYMBOL_directive_repeatable_opt = 117, /* directive_repeatable_opt  */
-  YYSYMBOL_directive_locations = 118,      /* directive_locations  */
-  YYSYMBOL_type_system_extension = 119,    /* type_system_extension  */
-  YYSYMBOL_schema_extension = 120,         /* schema_extension  */
-  YYSYMBOL_type_extension = 121,           /* type_extension  */
-  YYSYMBOL_scalar_type_extension = 122,    /* scalar_type_extension  */
-  YYSYMBOL_object_type_extension = 123,    /* object_type_extension  */
-  YYSYMBOL_interface_type_extension = 124, /* interface_type_extension  */
-  YYSYMBOL_union_type_extension = 125,     /* union_type_extension  */
-  YYSYMBOL_enum_type_extension = 126,      /* enum_type_extension  */
-  YYSYMBOL_input_object_type_extension = 127, /* input_object_type_extension  */
-  YYSYMBOL_NamedTypeForCondition = 128     /* NamedTypeForCondition  */
+  YYSYMBOL_47_1 = 47,                      /* $@1  */
+  YYSYMBOL_operation_type = 48,            /* operation_type  */
+  YYSYMBOL_operation_name_opt = 49,        /* operation_name_opt  */
+  YYSYMBOL_variable_definitions_opt = 50,  /* variable_definitions_opt  */
+  YYSYMBOL_variable_definitions_list = 51, /* variable_definitions_list  */
+  YYSYMBOL_variable_definition = 52,       /* variable_definition  */
+  YYSYMBOL_default_value_opt = 53,         /* default_value_opt  */
+  YYSYMBOL_selection_list = 54,            /* selection_list  */
+  YYSYMBOL_selection = 55,                 /* selection  */
+  YYSYMBOL_selection_set = 56,             /* selection_set  */
+  YYSYMBOL_57_2 = 57,                      /* $@2  */
+  YYSYMBOL_selection_set_opt = 58,         /* selection_set_opt  */
+  YYSYMBOL_field = 59,                     /* field  */
+  YYSYMBOL_arguments_opt = 60,             /* arguments_opt  */
+  YYSYMBOL_arguments_list = 61,            /* arguments_list  */
+  YYSYMBOL_argument = 62,                  /* argument  */
+  YYSYMBOL_literal_value = 63,             /* literal_value  */
+  YYSYMBOL_input_value = 64,               /* input_value  */
+  YYSYMBOL_null_value = 65,                /* null_value  */
+  YYSYMBOL_variable = 66,                  /* variable  */
+  YYSYMBOL_list_value = 67,                /* list_value  */
+  YYSYMBOL_list_value_list = 68,           /* list_value_list  */
+  YYSYMBOL_enum_name = 69,                 /* enum_name  */
+  YYSYMBOL_enum_value = 70,                /* enum_value  */
+  YYSYMBOL_object_value = 71,              /* object_value  */
+  YYSYMBOL_object_value_list_opt = 72,     /* object_value_list_opt  */
+  YYSYMBOL_object_value_list = 73,         /* object_value_list  */
+  YYSYMBOL_object_value_field = 74,        /* object_value_field  */
+  YYSYMBOL_object_literal_value = 75,      /* object_literal_value  */
+  YYSYMBOL_object_literal_value_list_opt = 76, /* object_literal_value_list_opt  */
+  YYSYMBOL_object_literal_value_list = 77, /* object_literal_value_list  */
+  YYSYMBOL_object_literal_value_field = 78, /* object_literal_value_field  */
+  YYSYMBOL_directives_list_opt = 79,       /* directives_list_opt  */
+  YYSYMBOL_directives_list = 80,           /* directives_list  */
+  YYSYMBOL_directive = 81,                 /* directive  */
+  YYSYMBOL_name = 82,                      /* name  */
+  YYSYMBOL_schema_keyword = 83,            /* schema_keyword  */
+  YYSYMBOL_name_without_on = 84,           /* name_without_on  */
+  YYSYMBOL_fragment_spread = 85,           /* fragment_spread  */
+  YYSYMBOL_inline_fragment = 86,           /* inline_fragment  */
+  YYSYMBOL_fragment_definition = 87,       /* fragment_definition  */
+  YYSYMBOL_fragment_name_opt = 88,         /* fragment_name_opt  */
+  YYSYMBOL_type = 89,                      /* type  */
+  YYSYMBOL_nullable_type = 90,             /* nullable_type  */
+  YYSYMBOL_type_system_definition = 91,    /* type_system_definition  */
+  YYSYMBOL_schema_definition = 92,         /* schema_definition  */
+  YYSYMBOL_operation_type_definition_list_opt = 93, /* operation_type_definition_list_opt  */
+  YYSYMBOL_operation_type_definition_list = 94, /* operation_type_definition_list  */
+  YYSYMBOL_operation_type_definition = 95, /* operation_type_definition  */
+  YYSYMBOL_type_definition = 96,           /* type_definition  */
+  YYSYMBOL_description = 97,               /* description  */
+  YYSYMBOL_description_opt = 98,           /* description_opt  */
+  YYSYMBOL_scalar_type_definition = 99,    /* scalar_type_definition  */
+  YYSYMBOL_object_type_definition = 100,   /* object_type_definition  */
+  YYSYMBOL_implements_opt = 101,           /* implements_opt  */
+  YYSYMBOL_interfaces_list = 102,          /* interfaces_list  */
+  YYSYMBOL_legacy_interfaces_list = 103,   /* legacy_interfaces_list  */
+  YYSYMBOL_input_value_definition = 104,   /* input_value_definition  */
+  YYSYMBOL_input_value_definition_list = 105, /* input_value_definition_list  */
+  YYSYMBOL_arguments_definitions_opt = 106, /* arguments_definitions_opt  */
+  YYSYMBOL_field_definition = 107,         /* field_definition  */
+  YYSYMBOL_field_definition_list_opt = 108, /* field_definition_list_opt  */
+  YYSYMBOL_field_definition_list = 109,    /* field_definition_list  */
+  YYSYMBOL_interface_type_definition = 110, /* interface_type_definition  */
+  YYSYMBOL_pipe_opt = 111,                 /* pipe_opt  */
+  YYSYMBOL_union_members = 112,            /* union_members  */
+  YYSYMBOL_union_type_definition = 113,    /* union_type_definition  */
+  YYSYMBOL_enum_type_definition = 114,     /* enum_type_definition  */
+  YYSYMBOL_enum_value_definition = 115,    /* enum_value_definition  */
+  YYSYMBOL_enum_value_definitions = 116,   /* enum_value_definitions  */
+  YYSYMBOL_input_object_type_definition = 117, /* input_object_type_definition  */
+  YYSYMBOL_directive_definition = 118,     /* directive_definition  */
+  YYSYMBOL_directive_repeatable_opt = 119, /* directive_repeatable_opt  */
+  YYSYMBOL_directive_locations = 120,      /* directive_locations  */
+  YYSYMBOL_type_system_extension = 121,    /* type_system_extension  */
+  YYSYMBOL_schema_extension = 122,         /* schema_extension  */
+  YYSYMBOL_type_extension = 123,           /* type_extension  */
+  YYSYMBOL_scalar_type_extension = 124,    /* scalar_type_extension  */
+  YYSYMBOL_object_type_extension = 125,    /* object_type_extension  */
+  YYSYMBOL_interface_type_extension = 126, /* interface_type_extension  */
+  YYSYMBOL_union_type_extension = 127,     /* union_type_extension  */
+  YYSYMBOL_enum_type_extension = 128,      /* enum_type_extension  */
+  YYSYMBOL_input_object_type_extension = 129, /* input_object_type_extension  */
+  YYSYMBOL_NamedTypeForCondition = 130     /* NamedTypeForCondition  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
 
 
+/* Unqualified %code blocks.  */
+#line 61 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+
+int yylex(YYSTYPE *, VALUE, GraphQLParser *);
+void yyerror(VALUE, GraphQLParser *, const char*);
+
+#line 413 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
 
 #ifdef short
 # undef short
@@ -718,18 +730,18 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  79
+#define YYFINAL  71
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   820
+#define YYLAST   782
 
 /* YYNTOKENS -- Number of terminals.  */
 #define YYNTOKENS  40
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  89
+#define YYNNTS  91
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  185
+#define YYNRULES  187
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  314
+#define YYNSTATES  316
 
 /* YYMAXUTOK -- Last valid token kind.  */
 #define YYMAXUTOK   257
@@ -778,25 +790,25 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int16 yyrline[] =
 {
-       0,   107,   107,   109,   123,   124,   127,   128,   129,   132,
-     133,   136,   147,   158,   171,   172,   173,   176,   177,   180,
-     181,   184,   185,   188,   200,   201,   204,   205,   208,   209,
-     210,   213,   216,   217,   220,   231,   244,   245,   248,   249,
-     252,   262,   263,   264,   265,   266,   267,   268,   269,   270,
-     273,   274,   275,   277,   285,   294,   295,   298,   299,   302,
-     303,   304,   305,   307,   316,   325,   326,   329,   330,   333,
-     344,   353,   354,   357,   358,   361,   372,   373,   376,   377,
-     379,   389,   390,   393,   394,   395,   396,   397,   398,   399,
-     400,   401,   402,   403,   404,   407,   408,   409,   410,   411,
-     412,   416,   426,   435,   446,   458,   459,   462,   463,   466,
-     473,   482,   483,   484,   487,   500,   501,   504,   508,   513,
-     518,   519,   520,   521,   522,   523,   525,   528,   529,   532,
-     544,   558,   559,   560,   561,   564,   572,   578,   586,   591,
-     605,   606,   609,   610,   613,   627,   628,   631,   632,   633,
-     636,   650,   651,   654,   662,   667,   680,   693,   705,   706,
-     709,   722,   736,   737,   740,   741,   745,   746,   749,   760,
-     772,   773,   774,   775,   776,   777,   779,   789,   801,   813,
-     822,   833,   842,   853,   862,   873
+       0,   126,   126,   128,   134,   135,   138,   139,   140,   143,
+     144,   147,   157,   157,   168,   180,   181,   182,   185,   186,
+     189,   190,   193,   194,   197,   208,   209,   212,   213,   216,
+     217,   218,   221,   221,   227,   228,   231,   242,   255,   256,
+     259,   260,   263,   272,   273,   274,   275,   276,   277,   278,
+     279,   280,   283,   284,   285,   287,   294,   302,   303,   311,
+     312,   315,   316,   317,   318,   320,   328,   336,   337,   340,
+     341,   344,   354,   362,   363,   366,   367,   370,   380,   381,
+     384,   385,   387,   397,   398,   401,   402,   403,   404,   405,
+     406,   407,   408,   409,   410,   411,   412,   415,   416,   417,
+     418,   419,   420,   424,   434,   442,   452,   463,   464,   467,
+     468,   471,   477,   485,   486,   487,   490,   501,   502,   505,
+     506,   511,   518,   519,   520,   521,   522,   523,   525,   528,
+     529,   532,   543,   556,   557,   558,   559,   562,   569,   575,
+     582,   587,   600,   601,   604,   605,   608,   621,   622,   625,
+     626,   627,   630,   643,   644,   647,   654,   659,   671,   683,
+     694,   695,   698,   710,   723,   724,   727,   728,   732,   733,
+     736,   745,   756,   757,   758,   759,   760,   761,   763,   772,
+     783,   794,   802,   812,   820,   830,   838,   848
 };
 #endif
 
@@ -821,10 +833,10 @@ yysymbol_name (yysymbol_kind_t yysymbol)
   "REPEATABLE", "RPAREN", "SCALAR", "SCHEMA", "STRING", "SUBSCRIPTION",
   "TRUE_LITERAL", "TYPE_LITERAL", "UNION", "VAR_SIGN", "$accept", "start",
   "document", "definitions_list", "definition", "executable_definition",
-  "operation_definition", "operation_type", "operation_name_opt",
+  "operation_definition", "$@1", "operation_type", "operation_name_opt",
   "variable_definitions_opt", "variable_definitions_list",
   "variable_definition", "default_value_opt", "selection_list",
-  "selection", "selection_set", "selection_set_opt", "field",
+  "selection", "selection_set", "$@2", "selection_set_opt", "field",
   "arguments_opt", "arguments_list", "argument", "literal_value",
   "input_value", "null_value", "variable", "list_value", "list_value_list",
   "enum_name", "enum_value", "object_value", "object_value_list_opt",
@@ -855,12 +867,12 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#define YYPACT_NINF (-249)
+#define YYPACT_NINF (-269)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
 
-#define YYTABLE_NINF (-148)
+#define YYTABLE_NINF (-150)
 
 #define yytable_value_is_error(Yyn) \
   0
@@ -869,38 +881,38 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int16 yypact[] =
 {
-     148,   179,   749,   485,  -249,  -249,    14,  -249,  -249,    45,
-    -249,    83,  -249,  -249,  -249,   716,  -249,  -249,  -249,  -249,
-    -249,   120,  -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,
-    -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,   716,   716,
-     716,   716,    14,   716,   716,  -249,  -249,  -249,  -249,  -249,
-    -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,
-    -249,  -249,  -249,  -249,    21,   584,  -249,  -249,   518,  -249,
-    -249,    11,  -249,  -249,  -249,   716,    47,    14,  -249,  -249,
-    -249,    58,  -249,    74,   716,   716,   716,   716,   716,   716,
-      14,    14,    65,    14,    75,    27,    65,    14,   716,   716,
-      84,    14,  -249,  -249,   716,   716,    14,    93,   174,  -249,
-    -249,    95,    14,   716,    14,    14,    65,    14,    65,    14,
-     111,    27,   122,    27,   317,    14,    14,   174,    14,   140,
-     102,  -249,    14,    14,   617,  -249,  -249,    93,   650,  -249,
-     149,    84,  -249,   155,    72,  -249,   716,    48,  -249,    84,
-     144,   146,   151,    14,  -249,    14,   160,   143,   143,   716,
-     208,   171,   716,   158,   118,   158,   162,    84,    84,   551,
-      14,  -249,  -249,   418,  -249,  -249,   716,  -249,  -249,   181,
-    -249,  -249,  -249,   143,   154,   143,   143,   158,   158,   162,
-     782,  -249,   -11,   716,  -249,   -10,  -249,   171,   716,  -249,
-      15,  -249,  -249,  -249,  -249,   716,   165,  -249,  -249,  -249,
-      84,  -249,  -249,  -249,  -249,   350,   716,  -249,  -249,  -249,
-    -249,   716,  -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,
-    -249,  -249,  -249,  -249,   683,    88,  -249,   169,    35,    55,
-    -249,  -249,   165,    14,  -249,  -249,   194,  -249,  -249,  -249,
-     716,  -249,    69,  -249,   716,  -249,  -249,  -249,   384,   173,
-     716,  -249,   176,   716,  -249,   195,  -249,   683,  -249,   196,
-     203,  -249,   716,  -249,  -249,  -249,   683,   144,  -249,  -249,
-    -249,  -249,  -249,  -249,  -249,   205,  -249,  -249,   209,   418,
-     185,   452,    14,  -249,  -249,   192,   196,   214,   418,   452,
-    -249,  -249,  -249,   716,  -249,  -249,   716,    14,   683,  -249,
-    -249,  -249,    14,  -249
+     225,   172,   711,    18,  -269,  -269,    44,  -269,  -269,    15,
+    -269,   200,  -269,  -269,  -269,   678,  -269,  -269,  -269,  -269,
+    -269,   160,  -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,   678,   678,
+     678,   678,    44,   678,   678,  -269,  -269,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,    24,  -269,   546,   678,    39,    44,
+    -269,  -269,  -269,  -269,    52,  -269,  -269,    69,   678,   678,
+     678,   678,   678,   678,    44,    44,    92,    44,    90,    14,
+      92,    44,   678,   579,   480,  -269,  -269,    51,  -269,  -269,
+      93,    23,  -269,  -269,    86,    44,   678,    44,    44,    92,
+      44,    92,    44,   110,    14,   111,    14,   298,    44,    44,
+      23,    44,   128,    38,  -269,    44,   678,   120,    44,  -269,
+    -269,   678,   678,    44,  -269,   137,    62,  -269,   678,     5,
+    -269,   120,   121,   124,   125,    44,  -269,    44,   138,   119,
+     119,   678,    83,   155,   678,   140,    87,   140,   133,   120,
+      44,  -269,  -269,  -269,    93,   612,  -269,   157,   120,   678,
+    -269,  -269,   159,  -269,  -269,  -269,   119,   135,   119,   119,
+     140,   140,   133,   744,  -269,   -12,   678,  -269,    41,  -269,
+     155,   678,  -269,    59,  -269,  -269,  -269,  -269,   678,   143,
+    -269,   120,   546,    44,  -269,  -269,   413,  -269,  -269,  -269,
+     645,    56,  -269,   146,    70,    94,  -269,  -269,   143,  -269,
+    -269,  -269,    44,  -269,  -269,  -269,   168,  -269,  -269,  -269,
+     678,  -269,   105,  -269,   678,  -269,   513,   120,  -269,  -269,
+    -269,   345,   678,  -269,  -269,  -269,   678,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,  -269,  -269,   645,  -269,   164,   174,
+    -269,   678,  -269,  -269,  -269,   645,   121,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,   379,   152,   678,  -269,   153,   678,
+    -269,   180,  -269,   162,   447,    44,  -269,  -269,   169,   164,
+     189,  -269,  -269,  -269,  -269,   194,  -269,  -269,   198,   413,
+    -269,   678,  -269,  -269,   678,    44,   645,   413,   447,  -269,
+    -269,  -269,  -269,    44,  -269,  -269
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -908,66 +920,68 @@ static const yytype_int16 yypact[] =
    means the default is an error.  */
 static const yytype_uint8 yydefact[] =
 {
-     127,     0,   105,     0,    15,    14,    76,   126,    16,     0,
-       2,   127,     4,     6,     9,    17,    10,     7,   111,   112,
-     128,     0,   120,   121,   122,   123,   124,   125,   113,     8,
-     166,   167,   170,   171,   172,   173,   174,   175,     0,     0,
-       0,     0,    76,     0,     0,    91,    89,    92,    97,    93,
-      95,    90,    86,    87,    98,    94,    84,    83,    96,    85,
-      88,    99,   100,   106,     0,    76,    82,    13,     0,    26,
-      28,    36,    81,    29,    30,     0,   115,    77,    78,     1,
-       5,    19,    18,     0,     0,     0,     0,     0,     0,     0,
-      76,    76,   131,     0,     0,   169,   131,    76,     0,     0,
-       0,    76,    12,    27,     0,     0,    76,    36,     0,   114,
-      79,     0,    76,     0,    76,    76,   131,    76,   131,    76,
-       0,   182,     0,   184,     0,    76,   176,     0,    76,     0,
-     180,   185,    76,    76,     0,   103,   101,    36,     0,    38,
-       0,    32,    80,     0,     0,   117,     0,     0,    21,     0,
-     142,     0,     0,    76,   129,    76,     0,   127,   127,     0,
-     135,   133,   134,   145,     0,   145,   151,     0,     0,     0,
-      76,    37,    39,     0,    33,    35,     0,   116,   118,     0,
-      20,    22,    11,   127,   162,   127,   127,   145,   145,   151,
-       0,   158,   127,     0,   140,   127,   135,   132,     0,   138,
-     127,   178,   168,   177,   152,     0,   179,   104,   102,    31,
-      32,    45,    41,    59,    42,     0,    65,    53,    60,    43,
-      44,     0,    61,    50,    40,    46,    51,    48,    63,    47,
-      52,    49,    62,   119,     0,   127,   163,     0,   127,   127,
-     150,   130,   155,    76,   181,   159,     0,   183,   141,   136,
-       0,   148,   127,   153,     0,    34,    55,    57,     0,     0,
-      66,    67,     0,    72,    73,     0,    54,     0,   109,    24,
-     107,   143,     0,   156,   160,   157,     0,   142,   146,   149,
-     154,    56,    58,    64,    68,     0,    70,    74,     0,     0,
-       0,     0,    76,   108,   164,   161,    24,     0,     0,     0,
-      50,    69,   110,    71,    25,    23,     0,    76,     0,    75,
-     165,   139,    76,   144
+     129,     0,   107,    12,    16,    15,    78,   128,    17,     0,
+       2,   129,     4,     6,     9,    18,    10,     7,   113,   114,
+     130,     0,   122,   123,   124,   125,   126,   127,   115,     8,
+     168,   169,   172,   173,   174,   175,   176,   177,     0,     0,
+       0,     0,    78,     0,     0,    93,    91,    94,    99,    95,
+      97,    92,    88,    89,   100,    96,    86,    85,    98,    87,
+      90,   101,   102,   108,     0,    14,     0,     0,   117,    79,
+      80,     1,     5,    84,    20,    19,    83,     0,     0,     0,
+       0,     0,     0,     0,    78,    78,   133,     0,     0,   171,
+     133,    78,     0,    78,     0,    27,    29,    38,    30,    31,
+      38,     0,   116,    81,     0,    78,     0,    78,    78,   133,
+      78,   133,    78,     0,   184,     0,   186,     0,    78,   178,
+       0,    78,     0,   182,   187,    78,     0,     0,    78,    13,
+      28,     0,     0,    78,    82,     0,     0,   119,     0,     0,
+      22,     0,   144,     0,     0,    78,   131,    78,     0,   129,
+     129,     0,   137,   135,   136,   147,     0,   147,   153,     0,
+      78,    32,   105,   103,    38,     0,    40,     0,    34,     0,
+     118,   120,     0,    21,    23,    11,   129,   164,   129,   129,
+     147,   147,   153,     0,   160,   129,     0,   142,   129,   137,
+     134,     0,   140,   129,   180,   170,   179,   154,     0,   181,
+     106,     0,     0,    78,    39,    41,     0,    35,    37,   121,
+       0,   129,   165,     0,   129,   129,   152,   132,   157,    61,
+      62,    63,    78,    64,   183,   161,     0,   185,   143,   138,
+       0,   150,   129,   155,     0,   104,     0,    34,    47,    43,
+      44,     0,    67,    55,    45,    46,     0,    52,    42,    48,
+      53,    50,    65,    49,    54,    51,     0,   111,    25,   109,
+     145,     0,   158,   162,   159,     0,   144,   148,   151,   156,
+      33,    36,    57,    59,     0,     0,    68,    69,     0,    74,
+      75,     0,    56,     0,     0,    78,   110,   166,   163,    25,
+       0,    58,    60,    66,    70,     0,    72,    76,     0,     0,
+     112,    73,    26,    24,     0,    78,     0,     0,     0,    52,
+      71,   167,   141,    78,    77,   146
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int16 yypgoto[] =
 {
-    -249,  -249,  -249,  -249,   211,  -249,  -249,     0,  -249,  -249,
-    -249,    77,   -70,    94,   -67,   -90,    17,  -249,   -98,  -249,
-      91,  -248,  -165,  -249,  -249,  -249,  -249,    40,  -249,  -249,
-    -249,  -249,   -29,  -249,  -249,  -249,   -28,    23,   -36,   -63,
-     -13,  -168,     1,  -249,  -249,  -249,  -249,  -238,  -249,  -249,
-    -249,  -249,   107,  -127,  -249,  -249,     4,  -249,  -249,   -76,
-      80,  -249,  -183,   -18,   -41,   -12,  -152,  -249,  -249,  -249,
-      54,  -249,  -249,  -185,    60,  -249,  -249,  -249,  -249,  -249,
-    -249,  -249,  -249,  -249,  -249,  -249,  -249,  -249,   147
+    -269,  -269,  -269,  -269,   196,  -269,  -269,  -269,     0,  -269,
+    -269,  -269,    73,   -81,    11,   -92,  -121,  -269,   -22,  -269,
+     -93,  -269,    53,  -268,  -202,  -269,  -269,  -269,  -269,    34,
+    -269,  -269,  -269,  -269,   -57,  -269,  -269,  -269,   -55,    42,
+     -30,   -37,   -14,  -178,     1,  -269,  -269,  -269,  -269,  -247,
+    -269,  -269,  -269,  -269,   106,  -113,  -269,  -269,     8,  -269,
+    -269,   -28,    74,  -269,  -174,   -74,   -36,    -3,  -147,  -269,
+    -269,  -269,    49,  -269,  -269,  -172,    60,  -269,  -269,  -269,
+    -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,  -269,
+     117
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int16 yydefgoto[] =
 {
-       0,     9,    10,    11,    12,    13,    14,    61,    81,   112,
-     147,   148,   292,    68,    69,   174,   175,    70,   106,   138,
-     139,   223,   301,   225,   226,   227,   258,   228,   229,   230,
-     259,   260,   261,   231,   262,   263,   264,    76,    77,    78,
-      71,    62,    72,    73,    74,    16,    64,   269,   270,    17,
-      18,   109,   144,   145,    19,    20,   193,    22,    23,   125,
-     161,   162,   194,   195,   184,   251,   201,   252,    24,   205,
-     206,    25,    26,   191,   192,    27,    28,   237,   295,    29,
-      30,    31,    32,    33,    34,    35,    36,    37,   132
+       0,     9,    10,    11,    12,    13,    14,    66,    61,    74,
+     105,   139,   140,   285,    94,    95,   207,   202,   208,    96,
+     133,   165,   166,   247,   310,   249,   250,   251,   274,   252,
+     253,   254,   275,   276,   277,   255,   278,   279,   280,    68,
+      69,    70,    97,    62,    76,    98,    99,    16,    64,   258,
+     259,    17,    18,   102,   136,   137,    19,    20,   186,    22,
+      23,   118,   153,   154,   187,   188,   177,   231,   194,   232,
+      24,   198,   199,    25,    26,   184,   185,    27,    28,   213,
+     288,    29,    30,    31,    32,    33,    34,    35,    36,    37,
+     125
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -975,176 +989,168 @@ static const yytype_int16 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int16 yytable[] =
 {
-      15,   103,    82,    63,    21,   232,    95,   245,   224,   142,
-     135,    15,   248,   203,   110,    21,   104,   178,   244,   247,
-     128,    75,   232,     7,     7,    90,    91,    92,    93,   290,
-      96,    97,   110,   105,    75,   240,   241,   178,   296,   170,
-     153,   300,   155,   304,  -147,    79,    98,   232,   -77,     7,
-     257,   309,   248,   245,   121,   123,   248,   126,   110,   182,
-     110,   130,   107,   110,   273,    94,   101,   110,   108,     7,
-     312,   114,   115,   116,   117,   118,   119,   207,   208,   180,
-     111,   113,   124,    -3,   274,   131,   131,   146,   100,     7,
-     232,   137,   140,   282,     1,     4,   127,     2,   278,     5,
-     150,   177,   103,     7,     3,   134,     4,     8,   143,    75,
-       5,   160,   -77,   120,   122,   105,     6,     7,     8,   271,
-     129,   232,     7,   232,   136,   140,    83,   143,    84,   141,
-     232,   232,   157,   179,   146,   149,    85,   151,   152,    86,
-     154,     4,   156,   158,   143,     5,   196,   202,   163,   199,
-     166,   165,    87,     8,   173,   167,   168,    88,    89,     1,
-     176,   190,     2,   233,   143,   235,   183,   185,   239,     3,
-     189,     4,   186,   222,   198,     5,   187,     7,   188,   200,
-     246,     6,     7,     8,   236,   249,   234,    38,   204,   190,
-     222,   254,   253,   210,   272,    39,   190,     4,    40,   276,
-     289,     5,   283,   265,   250,   286,   291,   293,   266,     8,
-     298,    41,    42,   302,   299,   222,    43,    44,   306,   308,
-    -137,   268,    80,  -137,   181,  -137,   307,   255,   169,   172,
-     243,   284,  -137,  -137,   164,   287,   297,   277,  -137,   197,
-     279,   280,   190,   242,  -137,   238,   133,   285,     0,     0,
-     288,     0,     0,     0,   268,     0,   250,     0,   222,   294,
-       0,     0,     0,   268,     0,     0,   275,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,     0,     0,     0,     0,   222,
-     288,   222,     0,   310,     0,   268,     0,     0,   222,   222,
-       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
-       0,     0,     0,     0,     0,   305,     0,     0,     0,     0,
-     159,     0,     0,    45,     0,    46,     0,     0,    47,    48,
-     311,    49,    50,    51,    52,   313,    53,     0,     0,     0,
-       4,    54,    66,     0,     5,     0,     0,    55,     0,    56,
-      57,     0,     8,    58,    59,    60,    45,     0,    46,     0,
-       0,    47,   211,   212,    49,   213,    51,    52,   214,    53,
-     215,   216,     0,     4,   217,   218,     0,     5,   256,     0,
-      55,     0,    56,    57,   219,     8,   220,    59,    60,   221,
-      45,     0,    46,     0,     0,    47,   211,   212,    49,   213,
-      51,    52,   214,    53,   215,   216,     0,     4,   217,   218,
-       0,     5,   281,     0,    55,     0,    56,    57,   219,     8,
-     220,    59,    60,   221,    45,     0,    46,     0,     0,    47,
-     211,   212,    49,   213,    51,    52,   214,    53,   215,   216,
-       0,     4,   217,   218,     0,     5,     0,     0,    55,     0,
-      56,    57,   219,     8,   220,    59,    60,   221,    45,     0,
-      46,     0,     0,    47,   211,   212,    49,   213,    51,    52,
-     214,    53,   215,   303,     0,     4,   217,   218,     0,     5,
-       0,     0,    55,     0,    56,    57,   219,     8,   220,    59,
-      60,    45,     0,    46,    65,     0,    47,    48,     0,    49,
-      50,    51,    52,     0,    53,     0,     0,     0,     4,    54,
-      66,     0,     5,     0,    67,    55,     0,    56,    57,     0,
-       8,    58,    59,    60,    45,     0,    46,    65,     0,    47,
+      15,    75,   130,    63,   248,   223,   162,   134,    21,   283,
+     196,    15,    89,   225,   228,    71,   302,   224,   289,    21,
+     175,    67,     7,   171,    84,    85,    86,    87,   223,    90,
+      91,   309,   103,   216,   217,   -79,   173,   228,   200,   273,
+     314,   228,   225,   171,   138,    67,     4,    65,   -79,    92,
+       5,    67,   103,   100,   114,   116,   131,   119,     8,   313,
+     101,   123,   121,   223,   107,   108,   109,   110,   111,   112,
+     227,   203,   292,   132,   104,     7,   106,   103,   124,   103,
+     235,   145,   103,   147,    88,     4,   103,   260,  -149,     5,
+       7,   170,   142,     7,   128,  -139,   223,     8,  -139,   262,
+    -139,   135,   211,   152,     7,   215,   223,  -139,  -139,   117,
+       4,   120,   124,  -139,     5,   132,   195,   164,   167,  -139,
+     135,   223,     8,   263,   172,   138,   113,   115,     7,   223,
+     223,   149,   150,   122,   267,   127,   135,   189,   158,     7,
+     192,   161,   169,   176,   130,   178,   179,   141,   182,   143,
+     144,   167,   146,     7,   148,   209,   135,   183,   191,   197,
+     155,   193,   206,   157,   210,   212,    77,   159,    78,   234,
+     163,   261,   226,   265,   284,   168,    79,   229,   286,    80,
+      38,   293,   296,   221,   233,   299,   183,   180,    39,   181,
+     300,    40,    81,   183,   306,   304,   257,    82,    83,   307,
+      -3,   230,   201,   308,    41,    42,   221,    72,   305,    43,
+      44,     1,   174,   236,     2,   271,   266,   222,   205,   294,
+     269,     3,   183,     4,   297,   190,   156,     5,   281,   268,
+     290,   218,   282,     6,     7,     8,     1,     0,   214,     2,
+     230,   221,   257,   160,     0,   237,     3,   287,     4,     0,
+       0,   257,     5,     0,     0,     0,     0,     0,     6,     7,
+       8,     0,   295,     0,   264,   298,     0,     0,     0,     0,
+       0,     0,     0,     0,   221,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,   221,     0,     0,   298,     0,     0,
+     311,     0,   257,     0,     0,     0,     0,     0,     0,   221,
+       0,   151,     0,     0,    45,     0,    46,   221,   221,    47,
       48,     0,    49,    50,    51,    52,     0,    53,     0,     0,
-       0,     4,    54,    66,     0,     5,     0,   102,    55,     0,
-      56,    57,     0,     8,    58,    59,    60,    45,     0,    46,
-      65,     0,    47,    48,     0,    49,    50,    51,    52,     0,
-      53,     0,     0,     0,     4,    54,    66,     0,     5,     0,
-     209,    55,     0,    56,    57,     0,     8,    58,    59,    60,
-      45,    75,    46,     0,     0,    47,    48,     0,    49,    50,
-      51,    52,     0,    53,     0,     0,     0,     4,    54,    99,
-       0,     5,     0,     0,    55,     0,    56,    57,     0,     8,
-      58,    59,    60,    45,     0,    46,    65,     0,    47,    48,
-       0,    49,    50,    51,    52,     0,    53,     0,     0,     0,
-       4,    54,    66,     0,     5,     0,     0,    55,     0,    56,
-      57,     0,     8,    58,    59,    60,    45,     0,    46,     0,
+       0,     4,    54,    73,     0,     5,     0,   303,    55,     0,
+      56,    57,     0,     8,    58,    59,    60,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,   312,     0,     0,
+       0,    45,     0,    46,     0,   315,    47,   238,   239,    49,
+     219,    51,    52,   240,    53,   241,   242,     0,     4,   243,
+     220,     0,     5,   272,     0,    55,     0,    56,    57,   244,
+       8,   245,    59,    60,   246,    45,     0,    46,     0,     0,
+      47,   238,   239,    49,   219,    51,    52,   240,    53,   241,
+     242,     0,     4,   243,   220,     0,     5,   291,     0,    55,
+       0,    56,    57,   244,     8,   245,    59,    60,   246,    45,
+       0,    46,     0,     0,    47,   238,   239,    49,   219,    51,
+      52,   240,    53,   241,   242,     0,     4,   243,   220,     0,
+       5,     0,     0,    55,     0,    56,    57,   244,     8,   245,
+      59,    60,   246,    45,     0,    46,     0,     0,    47,   238,
+     239,    49,   219,    51,    52,   240,    53,   241,   301,     0,
+       4,   243,   220,     0,     5,     0,     0,    55,     0,    56,
+      57,   244,     8,   245,    59,    60,    45,     0,    46,    93,
        0,    47,    48,     0,    49,    50,    51,    52,     0,    53,
-       0,     0,     0,     4,    54,    66,     0,     5,     0,     0,
-      55,   171,    56,    57,     0,     8,    58,    59,    60,    45,
-       0,    46,     0,     0,    47,    48,     0,    49,    50,    51,
-      52,     0,    53,   267,     0,     0,     4,    54,    66,     0,
-       5,     0,     0,    55,     0,    56,    57,     0,     8,    58,
-      59,    60,    45,     0,    46,     0,     0,    47,    48,     0,
+       0,     0,     0,     4,    54,    73,     0,     5,     0,   129,
+      55,     0,    56,    57,     0,     8,    58,    59,    60,    45,
+       0,    46,    93,     0,    47,    48,     0,    49,    50,    51,
+      52,     0,    53,     0,     0,     0,     4,    54,    73,     0,
+       5,     0,   270,    55,     0,    56,    57,     0,     8,    58,
+      59,    60,    45,     0,    46,    93,     0,    47,    48,     0,
       49,    50,    51,    52,     0,    53,     0,     0,     0,     4,
-      54,    66,     0,     5,     0,     0,    55,     0,    56,    57,
-       0,     8,    58,    59,    60,    45,     0,    46,     0,     0,
+      54,    73,     0,     5,     0,     0,    55,     0,    56,    57,
+       0,     8,    58,    59,    60,    45,    67,    46,     0,     0,
       47,    48,     0,    49,    50,    51,    52,     0,    53,     0,
-       0,     0,     4,    54,     0,     0,     5,     0,     0,    55,
+       0,     0,     4,    54,   126,     0,     5,     0,     0,    55,
        0,    56,    57,     0,     8,    58,    59,    60,    45,     0,
-      46,     0,     0,    47,     0,     0,    49,   213,    51,    52,
-       0,    53,     0,     0,     0,     4,     0,   218,     0,     5,
-       0,     0,    55,     0,    56,    57,     0,     8,     0,    59,
-      60
+      46,     0,     0,    47,    48,     0,    49,    50,    51,    52,
+       0,    53,     0,     0,     0,     4,    54,    73,     0,     5,
+       0,     0,    55,   204,    56,    57,     0,     8,    58,    59,
+      60,    45,     0,    46,     0,     0,    47,    48,     0,    49,
+      50,    51,    52,     0,    53,   256,     0,     0,     4,    54,
+      73,     0,     5,     0,     0,    55,     0,    56,    57,     0,
+       8,    58,    59,    60,    45,     0,    46,     0,     0,    47,
+      48,     0,    49,    50,    51,    52,     0,    53,     0,     0,
+       0,     4,    54,    73,     0,     5,     0,     0,    55,     0,
+      56,    57,     0,     8,    58,    59,    60,    45,     0,    46,
+       0,     0,    47,    48,     0,    49,    50,    51,    52,     0,
+      53,     0,     0,     0,     4,    54,     0,     0,     5,     0,
+       0,    55,     0,    56,    57,     0,     8,    58,    59,    60,
+      45,     0,    46,     0,     0,    47,     0,     0,    49,   219,
+      51,    52,     0,    53,     0,     0,     0,     4,     0,   220,
+       0,     5,     0,     0,    55,     0,    56,    57,     0,     8,
+       0,    59,    60
 };
 
 static const yytype_int16 yycheck[] =
 {
-       0,    68,    15,     2,     0,   173,    42,   192,   173,   107,
-     100,    11,   195,   165,    77,    11,     5,   144,    29,    29,
-      96,     7,   190,    34,    34,    38,    39,    40,    41,   267,
-      43,    44,    95,    22,     7,   187,   188,   164,   276,   137,
-     116,   289,   118,   291,    29,     0,    25,   215,    21,    34,
-     215,   299,   235,   238,    90,    91,   239,    93,   121,   149,
-     123,    97,    75,   126,    29,    42,    65,   130,    21,    34,
-     308,    84,    85,    86,    87,    88,    89,   167,   168,    31,
-      22,     7,    17,     0,    29,    98,    99,    39,    65,    34,
-     258,   104,   105,   258,    11,    23,    21,    14,    29,    27,
-     113,    29,   169,    34,    21,    21,    23,    35,   108,     7,
-      27,   124,    10,    90,    91,    22,    33,    34,    35,    31,
-      97,   289,    34,   291,   101,   138,     6,   127,     8,   106,
-     298,   299,    21,   146,    39,   112,    16,   114,   115,    19,
-     117,    23,   119,    21,   144,    27,   159,    29,   125,   162,
-      10,   128,    32,    35,     5,   132,   133,    37,    38,    11,
-       5,   157,    14,   176,   164,   183,    22,    21,   186,    21,
-      10,    23,    21,   173,     3,    27,   153,    34,   155,    21,
-     193,    33,    34,    35,    30,   198,     5,     8,    26,   185,
-     190,    26,   205,   170,    25,    16,   192,    23,    19,     5,
-       5,    27,    29,   216,   200,    29,    10,     4,   221,    35,
-       5,    32,    33,    28,     5,   215,    37,    38,    26,     5,
-      12,   234,    11,    15,   147,    17,   296,   210,   134,   138,
-     190,   260,    24,    25,   127,   263,   277,   250,    30,   159,
-     252,   254,   238,   189,    36,   185,    99,   260,    -1,    -1,
-     263,    -1,    -1,    -1,   267,    -1,   252,    -1,   258,   272,
-      -1,    -1,    -1,   276,    -1,    -1,   243,    -1,    -1,    -1,
-      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
-      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,   289,
-     303,   291,    -1,   306,    -1,   308,    -1,    -1,   298,   299,
-      -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
-      -1,    -1,    -1,    -1,    -1,   292,    -1,    -1,    -1,    -1,
-       3,    -1,    -1,     6,    -1,     8,    -1,    -1,    11,    12,
-     307,    14,    15,    16,    17,   312,    19,    -1,    -1,    -1,
-      23,    24,    25,    -1,    27,    -1,    -1,    30,    -1,    32,
-      33,    -1,    35,    36,    37,    38,     6,    -1,     8,    -1,
-      -1,    11,    12,    13,    14,    15,    16,    17,    18,    19,
-      20,    21,    -1,    23,    24,    25,    -1,    27,    28,    -1,
-      30,    -1,    32,    33,    34,    35,    36,    37,    38,    39,
-       6,    -1,     8,    -1,    -1,    11,    12,    13,    14,    15,
-      16,    17,    18,    19,    20,    21,    -1,    23,    24,    25,
-      -1,    27,    28,    -1,    30,    -1,    32,    33,    34,    35,
-      36,    37,    38,    39,     6,    -1,     8,    -1,    -1,    11,
-      12,    13,    14,    15,    16,    17,    18,    19,    20,    21,
-      -1,    23,    24,    25,    -1,    27,    -1,    -1,    30,    -1,
-      32,    33,    34,    35,    36,    37,    38,    39,     6,    -1,
-       8,    -1,    -1,    11,    12,    13,    14,    15,    16,    17,
-      18,    19,    20,    21,    -1,    23,    24,    25,    -1,    27,
-      -1,    -1,    30,    -1,    32,    33,    34,    35,    36,    37,
-      38,     6,    -1,     8,     9,    -1,    11,    12,    -1,    14,
-      15,    16,    17,    -1,    19,    -1,    -1,    -1,    23,    24,
-      25,    -1,    27,    -1,    29,    30,    -1,    32,    33,    -1,
-      35,    36,    37,    38,     6,    -1,     8,     9,    -1,    11,
+       0,    15,    94,     2,   206,   183,   127,   100,     0,   256,
+     157,    11,    42,   185,   188,     0,   284,    29,   265,    11,
+     141,     7,    34,   136,    38,    39,    40,    41,   206,    43,
+      44,   299,    69,   180,   181,    21,    31,   211,   159,   241,
+     308,   215,   214,   156,    39,     7,    23,    29,    10,    25,
+      27,     7,    89,    67,    84,    85,     5,    87,    35,   306,
+      21,    91,    90,   241,    78,    79,    80,    81,    82,    83,
+      29,   164,   274,    22,    22,    34,     7,   114,    92,   116,
+     201,   109,   119,   111,    42,    23,   123,    31,    29,    27,
+      34,    29,   106,    34,    93,    12,   274,    35,    15,    29,
+      17,   101,   176,   117,    34,   179,   284,    24,    25,    17,
+      23,    21,   126,    30,    27,    22,    29,   131,   132,    36,
+     120,   299,    35,    29,   138,    39,    84,    85,    34,   307,
+     308,    21,    21,    91,    29,    93,   136,   151,    10,    34,
+     154,    21,     5,    22,   236,    21,    21,   105,    10,   107,
+     108,   165,   110,    34,   112,   169,   156,   149,     3,    26,
+     118,    21,     5,   121,     5,    30,     6,   125,     8,    26,
+     128,    25,   186,     5,    10,   133,    16,   191,     4,    19,
+       8,    29,    29,   183,   198,     5,   178,   145,    16,   147,
+      28,    19,    32,   185,     5,    26,   210,    37,    38,     5,
+       0,   193,   160,     5,    32,    33,   206,    11,   289,    37,
+      38,    11,   139,   202,    14,   237,   230,   183,   165,   276,
+     234,    21,   214,    23,   279,   151,   120,    27,   242,   232,
+     266,   182,   246,    33,    34,    35,    11,    -1,   178,    14,
+     232,   241,   256,   126,    -1,   203,    21,   261,    23,    -1,
+      -1,   265,    27,    -1,    -1,    -1,    -1,    -1,    33,    34,
+      35,    -1,   276,    -1,   222,   279,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,   274,    -1,    -1,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,   284,    -1,    -1,   301,    -1,    -1,
+     304,    -1,   306,    -1,    -1,    -1,    -1,    -1,    -1,   299,
+      -1,     3,    -1,    -1,     6,    -1,     8,   307,   308,    11,
       12,    -1,    14,    15,    16,    17,    -1,    19,    -1,    -1,
-      -1,    23,    24,    25,    -1,    27,    -1,    29,    30,    -1,
-      32,    33,    -1,    35,    36,    37,    38,     6,    -1,     8,
-       9,    -1,    11,    12,    -1,    14,    15,    16,    17,    -1,
-      19,    -1,    -1,    -1,    23,    24,    25,    -1,    27,    -1,
-      29,    30,    -1,    32,    33,    -1,    35,    36,    37,    38,
-       6,     7,     8,    -1,    -1,    11,    12,    -1,    14,    15,
-      16,    17,    -1,    19,    -1,    -1,    -1,    23,    24,    25,
-      -1,    27,    -1,    -1,    30,    -1,    32,    33,    -1,    35,
-      36,    37,    38,     6,    -1,     8,     9,    -1,    11,    12,
-      -1,    14,    15,    16,    17,    -1,    19,    -1,    -1,    -1,
+      -1,    23,    24,    25,    -1,    27,    -1,   285,    30,    -1,
+      32,    33,    -1,    35,    36,    37,    38,    -1,    -1,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,   305,    -1,    -1,
+      -1,     6,    -1,     8,    -1,   313,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    -1,    23,    24,
+      25,    -1,    27,    28,    -1,    30,    -1,    32,    33,    34,
+      35,    36,    37,    38,    39,     6,    -1,     8,    -1,    -1,
+      11,    12,    13,    14,    15,    16,    17,    18,    19,    20,
+      21,    -1,    23,    24,    25,    -1,    27,    28,    -1,    30,
+      -1,    32,    33,    34,    35,    36,    37,    38,    39,     6,
+      -1,     8,    -1,    -1,    11,    12,    13,    14,    15,    16,
+      17,    18,    19,    20,    21,    -1,    23,    24,    25,    -1,
+      27,    -1,    -1,    30,    -1,    32,    33,    34,    35,    36,
+      37,    38,    39,     6,    -1,     8,    -1,    -1,    11,    12,
+      13,    14,    15,    16,    17,    18,    19,    20,    21,    -1,
       23,    24,    25,    -1,    27,    -1,    -1,    30,    -1,    32,
-      33,    -1,    35,    36,    37,    38,     6,    -1,     8,    -1,
+      33,    34,    35,    36,    37,    38,     6,    -1,     8,     9,
       -1,    11,    12,    -1,    14,    15,    16,    17,    -1,    19,
-      -1,    -1,    -1,    23,    24,    25,    -1,    27,    -1,    -1,
-      30,    31,    32,    33,    -1,    35,    36,    37,    38,     6,
-      -1,     8,    -1,    -1,    11,    12,    -1,    14,    15,    16,
-      17,    -1,    19,    20,    -1,    -1,    23,    24,    25,    -1,
-      27,    -1,    -1,    30,    -1,    32,    33,    -1,    35,    36,
-      37,    38,     6,    -1,     8,    -1,    -1,    11,    12,    -1,
+      -1,    -1,    -1,    23,    24,    25,    -1,    27,    -1,    29,
+      30,    -1,    32,    33,    -1,    35,    36,    37,    38,     6,
+      -1,     8,     9,    -1,    11,    12,    -1,    14,    15,    16,
+      17,    -1,    19,    -1,    -1,    -1,    23,    24,    25,    -1,
+      27,    -1,    29,    30,    -1,    32,    33,    -1,    35,    36,
+      37,    38,     6,    -1,     8,     9,    -1,    11,    12,    -1,
       14,    15,    16,    17,    -1,    19,    -1,    -1,    -1,    23,
       24,    25,    -1,    27,    -1,    -1,    30,    -1,    32,    33,
-      -1,    35,    36,    37,    38,     6,    -1,     8,    -1,    -1,
+      -1,    35,    36,    37,    38,     6,     7,     8,    -1,    -1,
       11,    12,    -1,    14,    15,    16,    17,    -1,    19,    -1,
-      -1,    -1,    23,    24,    -1,    -1,    27,    -1,    -1,    30,
+      -1,    -1,    23,    24,    25,    -1,    27,    -1,    -1,    30,
       -1,    32,    33,    -1,    35,    36,    37,    38,     6,    -1,
-       8,    -1,    -1,    11,    -1,    -1,    14,    15,    16,    17,
-      -1,    19,    -1,    -1,    -1,    23,    -1,    25,    -1,    27,
-      -1,    -1,    30,    -1,    32,    33,    -1,    35,    -1,    37,
-      38
+       8,    -1,    -1,    11,    12,    -1,    14,    15,    16,    17,
+      -1,    19,    -1,    -1,    -1,    23,    24,    25,    -1,    27,
+      -1,    -1,    30,    31,    32,    33,    -1,    35,    36,    37,
+      38,     6,    -1,     8,    -1,    -1,    11,    12,    -1,    14,
+      15,    16,    17,    -1,    19,    20,    -1,    -1,    23,    24,
+      25,    -1,    27,    -1,    -1,    30,    -1,    32,    33,    -1,
+      35,    36,    37,    38,     6,    -1,     8,    -1,    -1,    11,
+      12,    -1,    14,    15,    16,    17,    -1,    19,    -1,    -1,
+      -1,    23,    24,    25,    -1,    27,    -1,    -1,    30,    -1,
+      32,    33,    -1,    35,    36,    37,    38,     6,    -1,     8,
+      -1,    -1,    11,    12,    -1,    14,    15,    16,    17,    -1,
+      19,    -1,    -1,    -1,    23,    24,    -1,    -1,    27,    -1,
+      -1,    30,    -1,    32,    33,    -1,    35,    36,    37,    38,
+       6,    -1,     8,    -1,    -1,    11,    -1,    -1,    14,    15,
+      16,    17,    -1,    19,    -1,    -1,    -1,    23,    -1,    25,
+      -1,    27,    -1,    -1,    30,    -1,    32,    33,    -1,    35,
+      -1,    37,    38
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
@@ -1152,85 +1158,85 @@ static const yytype_int16 yycheck[] =
 static const yytype_uint8 yystos[] =
 {
        0,    11,    14,    21,    23,    27,    33,    34,    35,    41,
-      42,    43,    44,    45,    46,    47,    85,    89,    90,    94,
-      95,    96,    97,    98,   108,   111,   112,   115,   116,   119,
-     120,   121,   122,   123,   124,   125,   126,   127,     8,    16,
+      42,    43,    44,    45,    46,    48,    87,    91,    92,    96,
+      97,    98,    99,   100,   110,   113,   114,   117,   118,   121,
+     122,   123,   124,   125,   126,   127,   128,   129,     8,    16,
       19,    32,    33,    37,    38,     6,     8,    11,    12,    14,
       15,    16,    17,    19,    24,    30,    32,    33,    36,    37,
-      38,    47,    81,    82,    86,     9,    25,    29,    53,    54,
-      57,    80,    82,    83,    84,     7,    77,    78,    79,     0,
-      44,    48,    80,     6,     8,    16,    19,    32,    37,    38,
-      80,    80,    80,    80,    77,    78,    80,    80,    25,    25,
-      77,    82,    29,    54,     5,    22,    58,    80,    21,    91,
-      79,    22,    49,     7,    80,    80,    80,    80,    80,    80,
-      77,    78,    77,    78,    17,    99,    78,    21,    99,    77,
-      78,    80,   128,   128,    21,    55,    77,    80,    59,    60,
-      80,    77,    58,    47,    92,    93,    39,    50,    51,    77,
-      80,    77,    77,    99,    77,    99,    77,    21,    21,     3,
-      80,   100,   101,    77,    92,    77,    10,    77,    77,    53,
-      58,    31,    60,     5,    55,    56,     5,    29,    93,    80,
-      31,    51,    55,    22,   104,    21,    21,    77,    77,    10,
-      96,   113,   114,    96,   102,   103,    80,   100,     3,    80,
-      21,   106,    29,   106,    26,   109,   110,    55,    55,    29,
-      77,    12,    13,    15,    18,    20,    21,    24,    25,    34,
-      36,    39,    47,    61,    62,    63,    64,    65,    67,    68,
-      69,    73,    81,    80,     5,   103,    30,   117,   114,   103,
-     106,   106,   110,    67,    29,   113,    80,    29,   102,    80,
-      96,   105,   107,    80,    26,    56,    28,    62,    66,    70,
-      71,    72,    74,    75,    76,    80,    80,    20,    80,    87,
-      88,    31,    25,    29,    29,    77,     5,    80,    29,   105,
-      80,    28,    62,    29,    72,    80,    29,    76,    80,     5,
-      87,    10,    52,     4,    80,   118,    87,   104,     5,     5,
-      61,    62,    28,    21,    61,    77,    26,    52,     5,    61,
-      80,    77,    87,    77
+      38,    48,    83,    84,    88,    29,    47,     7,    79,    80,
+      81,     0,    44,    25,    49,    82,    84,     6,     8,    16,
+      19,    32,    37,    38,    82,    82,    82,    82,    79,    80,
+      82,    82,    25,     9,    54,    55,    59,    82,    85,    86,
+      82,    21,    93,    81,    22,    50,     7,    82,    82,    82,
+      82,    82,    82,    79,    80,    79,    80,    17,   101,    80,
+      21,   101,    79,    80,    82,   130,    25,    79,    84,    29,
+      55,     5,    22,    60,    60,    48,    94,    95,    39,    51,
+      52,    79,    82,    79,    79,   101,    79,   101,    79,    21,
+      21,     3,    82,   102,   103,    79,    94,    79,    10,    79,
+     130,    21,    56,    79,    82,    61,    62,    82,    79,     5,
+      29,    95,    82,    31,    52,    56,    22,   106,    21,    21,
+      79,    79,    10,    98,   115,   116,    98,   104,   105,    82,
+     102,     3,    82,    21,   108,    29,   108,    26,   111,   112,
+      56,    79,    57,    60,    31,    62,     5,    56,    58,    82,
+       5,   105,    30,   119,   116,   105,   108,   108,   112,    15,
+      25,    48,    69,    83,    29,   115,    82,    29,   104,    82,
+      98,   107,   109,    82,    26,    56,    54,    79,    12,    13,
+      18,    20,    21,    24,    34,    36,    39,    63,    64,    65,
+      66,    67,    69,    70,    71,    75,    20,    82,    89,    90,
+      31,    25,    29,    29,    79,     5,    82,    29,   107,    82,
+      29,    58,    28,    64,    68,    72,    73,    74,    76,    77,
+      78,    82,    82,    89,    10,    53,     4,    82,   120,    89,
+     106,    28,    64,    29,    74,    82,    29,    78,    82,     5,
+      28,    21,    63,    79,    26,    53,     5,     5,     5,    63,
+      64,    82,    79,    89,    63,    79
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_uint8 yyr1[] =
 {
        0,    40,    41,    42,    43,    43,    44,    44,    44,    45,
-      45,    46,    46,    46,    47,    47,    47,    48,    48,    49,
-      49,    50,    50,    51,    52,    52,    53,    53,    54,    54,
-      54,    55,    56,    56,    57,    57,    58,    58,    59,    59,
-      60,    61,    61,    61,    61,    61,    61,    61,    61,    61,
-      62,    62,    62,    63,    64,    65,    65,    66,    66,    67,
-      67,    67,    67,    68,    69,    70,    70,    71,    71,    72,
-      73,    74,    74,    75,    75,    76,    77,    77,    78,    78,
-      79,    80,    80,    81,    81,    81,    81,    81,    81,    81,
-      81,    81,    81,    81,    81,    82,    82,    82,    82,    82,
-      82,    83,    84,    84,    85,    86,    86,    87,    87,    88,
-      88,    89,    89,    89,    90,    91,    91,    92,    92,    93,
-      94,    94,    94,    94,    94,    94,    95,    96,    96,    97,
-      98,    99,    99,    99,    99,   100,   100,   101,   101,   102,
-     103,   103,   104,   104,   105,   106,   106,   107,   107,   107,
-     108,   109,   109,   110,   110,   111,   112,   113,   114,   114,
-     115,   116,   117,   117,   118,   118,   119,   119,   120,   120,
-     121,   121,   121,   121,   121,   121,   122,   123,   124,   125,
-     125,   126,   126,   127,   127,   128
+      45,    46,    47,    46,    46,    48,    48,    48,    49,    49,
+      50,    50,    51,    51,    52,    53,    53,    54,    54,    55,
+      55,    55,    57,    56,    58,    58,    59,    59,    60,    60,
+      61,    61,    62,    63,    63,    63,    63,    63,    63,    63,
+      63,    63,    64,    64,    64,    65,    66,    67,    67,    68,
+      68,    69,    69,    69,    69,    70,    71,    72,    72,    73,
+      73,    74,    75,    76,    76,    77,    77,    78,    79,    79,
+      80,    80,    81,    82,    82,    83,    83,    83,    83,    83,
+      83,    83,    83,    83,    83,    83,    83,    84,    84,    84,
+      84,    84,    84,    85,    86,    86,    87,    88,    88,    89,
+      89,    90,    90,    91,    91,    91,    92,    93,    93,    94,
+      94,    95,    96,    96,    96,    96,    96,    96,    97,    98,
+      98,    99,   100,   101,   101,   101,   101,   102,   102,   103,
+     103,   104,   105,   105,   106,   106,   107,   108,   108,   109,
+     109,   109,   110,   111,   111,   112,   112,   113,   114,   115,
+     116,   116,   117,   118,   119,   119,   120,   120,   121,   121,
+     122,   122,   123,   123,   123,   123,   123,   123,   124,   125,
+     126,   127,   127,   128,   128,   129,   129,   130
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     1,     1,     1,     2,     1,     1,     1,     1,
-       1,     5,     3,     2,     1,     1,     1,     0,     1,     0,
-       3,     1,     2,     6,     0,     2,     1,     2,     1,     1,
-       1,     3,     0,     1,     6,     4,     0,     3,     1,     2,
-       3,     1,     1,     1,     1,     1,     1,     1,     1,     1,
-       1,     1,     1,     1,     2,     2,     3,     1,     2,     1,
-       1,     1,     1,     1,     3,     0,     1,     1,     2,     3,
-       3,     0,     1,     1,     2,     3,     0,     1,     1,     2,
-       3,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+       1,     5,     0,     4,     2,     1,     1,     1,     0,     1,
+       0,     3,     1,     2,     6,     0,     2,     1,     2,     1,
+       1,     1,     0,     4,     0,     1,     6,     4,     0,     3,
+       1,     2,     3,     1,     1,     1,     1,     1,     1,     1,
+       1,     1,     1,     1,     1,     1,     2,     2,     3,     1,
+       2,     1,     1,     1,     1,     1,     3,     0,     1,     1,
+       2,     3,     3,     0,     1,     1,     2,     3,     0,     1,
+       1,     2,     3,     1,     1,     1,     1,     1,     1,     1,
        1,     1,     1,     1,     1,     1,     1,     1,     1,     1,
-       1,     3,     5,     3,     6,     0,     1,     1,     2,     1,
-       3,     1,     1,     1,     3,     0,     3,     1,     2,     3,
-       1,     1,     1,     1,     1,     1,     1,     0,     1,     4,
-       6,     0,     3,     2,     2,     1,     3,     1,     2,     6,
-       1,     2,     0,     3,     6,     0,     3,     0,     1,     2,
-       6,     0,     1,     2,     3,     6,     7,     3,     1,     2,
-       7,     8,     0,     1,     1,     3,     1,     1,     6,     3,
-       1,     1,     1,     1,     1,     1,     4,     6,     6,     6,
-       4,     7,     4,     7,     4,     1
+       1,     1,     1,     3,     5,     3,     6,     0,     1,     1,
+       2,     1,     3,     1,     1,     1,     3,     0,     3,     1,
+       2,     3,     1,     1,     1,     1,     1,     1,     1,     0,
+       1,     4,     6,     0,     3,     2,     2,     1,     3,     1,
+       2,     6,     1,     2,     0,     3,     6,     0,     3,     0,
+       1,     2,     6,     0,     1,     2,     3,     6,     7,     3,
+       1,     2,     7,     8,     0,     1,     1,     3,     1,     1,
+       6,     3,     1,     1,     1,     1,     1,     1,     4,     6,
+       6,     6,     4,     7,     4,     7,     4,     1
 };
 
 
@@ -1259,7 +1265,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (parser, filename, YY_("syntax error: cannot back up")); \
+        yyerror (parser, state, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -1292,7 +1298,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value, parser, filename); \
+                  Kind, Value, parser, state); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -1304,12 +1310,12 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, VALUE parser, VALUE filename)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, VALUE parser, GraphQLParser *state)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
   YY_USE (parser);
-  YY_USE (filename);
+  YY_USE (state);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -1324,12 +1330,12 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, VALUE parser, VALUE filename)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, VALUE parser, GraphQLParser *state)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
-  yy_symbol_value_print (yyo, yykind, yyvaluep, parser, filename);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, parser, state);
   YYFPRINTF (yyo, ")");
 }
 
@@ -1363,7 +1369,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
-                 int yyrule, VALUE parser, VALUE filename)
+                 int yyrule, VALUE parser, GraphQLParser *state)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -1376,7 +1382,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
       YYFPRINTF (stderr, "   $%d = ", yyi + 1);
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
-                       &yyvsp[(yyi + 1) - (yynrhs)], parser, filename);
+                       &yyvsp[(yyi + 1) - (yynrhs)], parser, state);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -1384,7 +1390,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, Rule, parser, filename); \
+    yy_reduce_print (yyssp, yyvsp, Rule, parser, state); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1643,11 +1649,11 @@ yysyntax_error (YYPTRDIFF_T *yymsg_alloc, char **yymsg,
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, VALUE parser, VALUE filename)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, VALUE parser, GraphQLParser *state)
 {
   YY_USE (yyvaluep);
   YY_USE (parser);
-  YY_USE (filename);
+  YY_USE (state);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -1667,7 +1673,7 @@ yydestruct (const char *yymsg,
 `----------*/
 
 int
-yyparse (VALUE parser, VALUE filename)
+yyparse (VALUE parser, GraphQLParser *state)
 {
 /* Lookahead token kind.  */
 int yychar;
@@ -1837,7 +1843,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex (&yylval, parser, filename);
+      yychar = yylex (&yylval, parser, state);
     }
 
   if (yychar <= YYEOF)
@@ -1925,1131 +1931,1104 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* start: document  */
-#line 107 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                  { rb_ivar_set(parser, rb_intern("@result"), yyvsp[0]); }
-#line 1931 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 126 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                  { state->ast->root = (yyvsp[0].node); }
+#line 1937 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
   case 3: /* document: definitions_list  */
-#line 109 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+#line 128 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                              {
-    VALUE position_source = rb_ary_entry(yyvsp[0], 0);
-    VALUE line, col;
-    if (RB_TEST(position_source)) {
-      line = rb_funcall(position_source, rb_intern("line"), 0);
-      col = rb_funcall(position_source, rb_intern("col"), 0);
-    } else {
-      line = INT2FIX(1);
-      col = INT2FIX(1);
-    }
-    yyval = MAKE_AST_NODE(Document, 3, line, col, yyvsp[0]);
+    GraphQLAstNode *position_source = (yyvsp[0].node).as.list->first->value.as.node;
+    (yyval.node) = MAKE_AST_NODE(Document, 1, position_source->pos, (yyvsp[0].node));
   }
-#line 1948 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 1946 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
   case 4: /* definitions_list: definition  */
-#line 123 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                  { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 1954 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 134 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                  { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 1952 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
   case 5: /* definitions_list: definitions_list definition  */
-#line 124 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                  { rb_ary_push(yyval, yyvsp[0]); }
-#line 1960 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 135 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                  { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 1958 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
   case 11: /* operation_definition: operation_type operation_name_opt variable_definitions_opt directives_list_opt selection_set  */
-#line 136 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+#line 147 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                                    {
-        yyval = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          (RB_TEST(yyvsp[-3]) ? rb_ary_entry(yyvsp[-3], 3) : Qnil),
-          yyvsp[-2],
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(OperationDefinition, 5,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-3].node),
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 1976 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
-    break;
-
-  case 12: /* operation_definition: LCURLY selection_list RCURLY  */
-#line 147 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                   {
-        yyval = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          r_string_query,
-          Qnil,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE,
-          yyvsp[-1]
+#line 1973 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+    break;
+
+  case 12: /* $@1: %empty  */
+#line 157 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+             { ENTER_SELECTION_SET((yyvsp[0].token)); }
+#line 1979 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+    break;
+
+  case 13: /* operation_definition: LCURLY $@1 selection_list RCURLY  */
+#line 157 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                                {
+        state->ast->stats.depth--;
+        (yyval.node) = MAKE_AST_NODE(OperationDefinition, 5,
+          (yyvsp[-3].token).byte_offset,
+          ast_static_value(r_string_query),
+          AST_NIL,
+          AST_NONE,
+          AST_NONE,
+          (yyvsp[-1].node)
         );
       }
-#line 1992 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 1995 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 13: /* operation_definition: LCURLY RCURLY  */
-#line 158 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 14: /* operation_definition: LCURLY RCURLY  */
+#line 168 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                     {
-        yyval = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry(yyvsp[-1], 1),
-          rb_ary_entry(yyvsp[-1], 2),
-          r_string_query,
-          Qnil,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE
+        (yyval.node) = MAKE_AST_NODE(OperationDefinition, 5,
+          (yyvsp[-1].token).byte_offset,
+          ast_static_value(r_string_query),
+          AST_NIL,
+          AST_NONE,
+          AST_NONE,
+          AST_NONE
         );
       }
-#line 2008 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2010 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 17: /* operation_name_opt: %empty  */
-#line 176 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                 { yyval = Qnil; }
-#line 2014 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 18: /* operation_name_opt: %empty  */
+#line 185 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                 { (yyval.node) = AST_NIL; }
+#line 2016 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 19: /* variable_definitions_opt: %empty  */
-#line 180 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                              { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2020 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 19: /* operation_name_opt: name  */
+#line 186 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+           { (yyval.node) = TOKEN_VALUE((yyvsp[0].token)); }
+#line 2022 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 20: /* variable_definitions_opt: LPAREN variable_definitions_list RPAREN  */
-#line 181 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                              { yyval = yyvsp[-1]; }
-#line 2026 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 20: /* variable_definitions_opt: %empty  */
+#line 189 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                              { (yyval.node) = AST_NONE; }
+#line 2028 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 21: /* variable_definitions_list: variable_definition  */
-#line 184 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                    { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2032 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 21: /* variable_definitions_opt: LPAREN variable_definitions_list RPAREN  */
+#line 190 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                              { (yyval.node) = (yyvsp[-1].node); }
+#line 2034 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 22: /* variable_definitions_list: variable_definitions_list variable_definition  */
-#line 185 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                    { rb_ary_push(yyval, yyvsp[0]); }
-#line 2038 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 22: /* variable_definitions_list: variable_definition  */
+#line 193 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                    { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2040 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+    break;
+
+  case 23: /* variable_definitions_list: variable_definitions_list variable_definition  */
+#line 194 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                    { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2046 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 23: /* variable_definition: VAR_SIGN name COLON type default_value_opt directives_list_opt  */
-#line 188 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 24: /* variable_definition: VAR_SIGN name COLON type default_value_opt directives_list_opt  */
+#line 197 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                      {
-        yyval = MAKE_AST_NODE(VariableDefinition, 6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          yyvsp[-2],
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(VariableDefinition, 4,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 2053 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2060 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 24: /* default_value_opt: %empty  */
-#line 200 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                            { yyval = Qnil; }
-#line 2059 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 25: /* default_value_opt: %empty  */
+#line 208 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                            { (yyval.node) = AST_NIL; }
+#line 2066 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 25: /* default_value_opt: EQUALS literal_value  */
-#line 201 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                            { yyval = yyvsp[0]; }
-#line 2065 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 26: /* default_value_opt: EQUALS literal_value  */
+#line 209 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                            { (yyval.node) = (yyvsp[0].node); }
+#line 2072 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 26: /* selection_list: selection  */
-#line 204 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2071 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 27: /* selection_list: selection  */
+#line 212 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2078 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 27: /* selection_list: selection_list selection  */
-#line 205 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                { rb_ary_push(yyval, yyvsp[0]); }
-#line 2077 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 28: /* selection_list: selection_list selection  */
+#line 213 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2084 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 31: /* selection_set: LCURLY selection_list RCURLY  */
-#line 213 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                   { yyval = yyvsp[-1]; }
-#line 2083 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 32: /* $@2: %empty  */
+#line 221 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+             { ENTER_SELECTION_SET((yyvsp[0].token)); }
+#line 2090 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 32: /* selection_set_opt: %empty  */
-#line 216 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                    { yyval = rb_ary_new(); }
-#line 2089 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 33: /* selection_set: LCURLY $@2 selection_list RCURLY  */
+#line 221 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                                {
+        state->ast->stats.depth--;
+        (yyval.node) = (yyvsp[-1].node);
+      }
+#line 2099 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 34: /* field: name COLON name arguments_opt directives_list_opt selection_set_opt  */
-#line 220 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 34: /* selection_set_opt: %empty  */
+#line 227 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                    { (yyval.node) = ast_list_new(state->ast); }
+#line 2105 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+    break;
+
+  case 36: /* field: name COLON name arguments_opt directives_list_opt selection_set_opt  */
+#line 231 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                         {
-      yyval = MAKE_AST_NODE(Field, 7,
-        rb_ary_entry(yyvsp[-5], 1),
-        rb_ary_entry(yyvsp[-5], 2),
-        rb_ary_entry(yyvsp[-5], 3), // alias
-        rb_ary_entry(yyvsp[-3], 3), // name
-        yyvsp[-2], // args
-        yyvsp[-1], // directives
-        yyvsp[0] // subselections
+      COUNT_FIELD((yyvsp[-5].token), 1);
+      (yyval.node) = MAKE_AST_NODE(Field, 5,
+        (yyvsp[-5].token).byte_offset,
+        TOKEN_VALUE((yyvsp[-5].token)), // alias
+        TOKEN_VALUE((yyvsp[-3].token)), // name
+        (yyvsp[-2].node), // args
+        (yyvsp[-1].node), // directives
+        (yyvsp[0].node) // subselections
       );
     }
-#line 2105 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2121 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 35: /* field: name arguments_opt directives_list_opt selection_set_opt  */
-#line 231 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 37: /* field: name arguments_opt directives_list_opt selection_set_opt  */
+#line 242 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                {
-      yyval = MAKE_AST_NODE(Field, 7,
-        rb_ary_entry(yyvsp[-3], 1),
-        rb_ary_entry(yyvsp[-3], 2),
-        Qnil, // alias
-        rb_ary_entry(yyvsp[-3], 3), // name
-        yyvsp[-2], // args
-        yyvsp[-1], // directives
-        yyvsp[0] // subselections
+      COUNT_FIELD((yyvsp[-3].token), 0);
+      (yyval.node) = MAKE_AST_NODE(Field, 5,
+        (yyvsp[-3].token).byte_offset,
+        AST_NIL, // alias
+        TOKEN_VALUE((yyvsp[-3].token)), // name
+        (yyvsp[-2].node), // args
+        (yyvsp[-1].node), // directives
+        (yyvsp[0].node) // subselections
       );
     }
-#line 2121 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2137 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 36: /* arguments_opt: %empty  */
-#line 244 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                    { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2127 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 38: /* arguments_opt: %empty  */
+#line 255 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                    { (yyval.node) = AST_NONE; }
+#line 2143 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 37: /* arguments_opt: LPAREN arguments_list RPAREN  */
-#line 245 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                    { yyval = yyvsp[-1]; }
-#line 2133 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 39: /* arguments_opt: LPAREN arguments_list RPAREN  */
+#line 256 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                    { (yyval.node) = (yyvsp[-1].node); }
+#line 2149 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 38: /* arguments_list: argument  */
-#line 248 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                              { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2139 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 40: /* arguments_list: argument  */
+#line 259 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                              { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2155 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 39: /* arguments_list: arguments_list argument  */
-#line 249 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                              { rb_ary_push(yyval, yyvsp[0]); }
-#line 2145 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 41: /* arguments_list: arguments_list argument  */
+#line 260 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                              { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2161 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 40: /* argument: name COLON input_value  */
-#line 252 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 42: /* argument: name COLON input_value  */
+#line 263 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                              {
-        yyval = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          rb_ary_entry(yyvsp[-2], 3),
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(Argument, 2,
+          (yyvsp[-2].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-2].token)),
+          (yyvsp[0].node)
         );
       }
-#line 2158 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2173 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 41: /* literal_value: FLOAT  */
-#line 262 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                  { yyval = rb_funcall(rb_ary_entry(yyvsp[0], 3), rb_intern("to_f"), 0); }
-#line 2164 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 43: /* literal_value: FLOAT  */
+#line 272 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                  { (yyval.node) = NUMBER_VALUE(AST_VALUE_FLOAT, (yyvsp[0].token)); }
+#line 2179 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 42: /* literal_value: INT  */
-#line 263 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                  { yyval = rb_funcall(rb_ary_entry(yyvsp[0], 3), rb_intern("to_i"), 0); }
-#line 2170 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 44: /* literal_value: INT  */
+#line 273 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                  { (yyval.node) = NUMBER_VALUE(AST_VALUE_INT, (yyvsp[0].token)); }
+#line 2185 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 43: /* literal_value: STRING  */
-#line 264 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                  { yyval = rb_ary_entry(yyvsp[0], 3); }
-#line 2176 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 45: /* literal_value: STRING  */
+#line 274 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                  { (yyval.node) = TOKEN_VALUE((yyvsp[0].token)); }
+#line 2191 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 44: /* literal_value: TRUE_LITERAL  */
-#line 265 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                          { yyval = Qtrue; }
-#line 2182 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 46: /* literal_value: TRUE_LITERAL  */
+#line 275 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                          { (yyval.node) = AST_TRUE; }
+#line 2197 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 45: /* literal_value: FALSE_LITERAL  */
-#line 266 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                          { yyval = Qfalse; }
-#line 2188 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 47: /* literal_value: FALSE_LITERAL  */
+#line 276 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                          { (yyval.node) = AST_FALSE; }
+#line 2203 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 53: /* null_value: NULL_LITERAL  */
-#line 277 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 55: /* null_value: NULL_LITERAL  */
+#line 287 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                            {
-    yyval = MAKE_AST_NODE(NullValue, 3,
-      rb_ary_entry(yyvsp[0], 1),
-      rb_ary_entry(yyvsp[0], 2),
-      rb_ary_entry(yyvsp[0], 3)
+    (yyval.node) = MAKE_AST_NODE(NullValue, 1,
+      (yyvsp[0].token).byte_offset,
+      TOKEN_VALUE((yyvsp[0].token))
     );
   }
-#line 2200 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2214 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 54: /* variable: VAR_SIGN name  */
-#line 285 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 56: /* variable: VAR_SIGN name  */
+#line 294 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                           {
-    yyval = MAKE_AST_NODE(VariableIdentifier, 3,
-      rb_ary_entry(yyvsp[-1], 1),
-      rb_ary_entry(yyvsp[-1], 2),
-      rb_ary_entry(yyvsp[0], 3)
+    (yyval.node) = MAKE_AST_NODE(VariableIdentifier, 1,
+      (yyvsp[-1].token).byte_offset,
+      TOKEN_VALUE((yyvsp[0].token))
     );
   }
-#line 2212 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2225 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 55: /* list_value: LBRACKET RBRACKET  */
-#line 294 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                        { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2218 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 57: /* list_value: LBRACKET RBRACKET  */
+#line 302 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                        { (yyval.node) = AST_NONE; }
+#line 2231 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 56: /* list_value: LBRACKET list_value_list RBRACKET  */
-#line 295 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                        { yyval = yyvsp[-1]; }
-#line 2224 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 58: /* list_value: LBRACKET list_value_list RBRACKET  */
+#line 303 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                        {
+        if ((yyvsp[-1].node).as.list->length > state->ast->stats.max_list_size) {
+          state->ast->stats.max_list_size = (yyvsp[-1].node).as.list->length;
+        }
+        (yyval.node) = (yyvsp[-1].node);
+      }
+#line 2242 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 57: /* list_value_list: input_value  */
-#line 298 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                  { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2230 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 59: /* list_value_list: input_value  */
+#line 311 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                  { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2248 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 58: /* list_value_list: list_value_list input_value  */
-#line 299 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                  { rb_ary_push(yyval, yyvsp[0]); }
-#line 2236 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 60: /* list_value_list: list_value_list input_value  */
+#line 312 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                  { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2254 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 63: /* enum_value: enum_name  */
-#line 307 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 65: /* enum_value: enum_name  */
+#line 320 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                         {
-    yyval = MAKE_AST_NODE(Enum, 3,
-      rb_ary_entry(yyvsp[0], 1),
-      rb_ary_entry(yyvsp[0], 2),
-      rb_ary_entry(yyvsp[0], 3)
+    (yyval.node) = MAKE_AST_NODE(Enum, 1,
+      (yyvsp[0].token).byte_offset,
+      TOKEN_VALUE((yyvsp[0].token))
     );
   }
-#line 2248 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2265 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 64: /* object_value: LCURLY object_value_list_opt RCURLY  */
-#line 316 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 66: /* object_value: LCURLY object_value_list_opt RCURLY  */
+#line 328 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                         {
-      yyval = MAKE_AST_NODE(InputObject, 3,
-        rb_ary_entry(yyvsp[-2], 1),
-        rb_ary_entry(yyvsp[-2], 2),
-        yyvsp[-1]
+      (yyval.node) = MAKE_AST_NODE(InputObject, 1,
+        (yyvsp[-2].token).byte_offset,
+        (yyvsp[-1].node)
       );
     }
-#line 2260 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2276 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 65: /* object_value_list_opt: %empty  */
-#line 325 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                        { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2266 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 67: /* object_value_list_opt: %empty  */
+#line 336 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                        { (yyval.node) = AST_NONE; }
+#line 2282 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 67: /* object_value_list: object_value_field  */
-#line 329 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                            { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2272 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 69: /* object_value_list: object_value_field  */
+#line 340 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                            { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2288 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 68: /* object_value_list: object_value_list object_value_field  */
-#line 330 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                            { rb_ary_push(yyval, yyvsp[0]); }
-#line 2278 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 70: /* object_value_list: object_value_list object_value_field  */
+#line 341 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                            { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2294 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 69: /* object_value_field: name COLON input_value  */
-#line 333 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 71: /* object_value_field: name COLON input_value  */
+#line 344 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                              {
-        yyval = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          rb_ary_entry(yyvsp[-2], 3),
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(Argument, 2,
+          (yyvsp[-2].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-2].token)),
+          (yyvsp[0].node)
         );
       }
-#line 2291 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2306 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 70: /* object_literal_value: LCURLY object_literal_value_list_opt RCURLY  */
-#line 344 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 72: /* object_literal_value: LCURLY object_literal_value_list_opt RCURLY  */
+#line 354 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                   {
-        yyval = MAKE_AST_NODE(InputObject, 3,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(InputObject, 1,
+          (yyvsp[-2].token).byte_offset,
+          (yyvsp[-1].node)
         );
       }
-#line 2303 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2317 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 71: /* object_literal_value_list_opt: %empty  */
-#line 353 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2309 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 73: /* object_literal_value_list_opt: %empty  */
+#line 362 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                { (yyval.node) = AST_NONE; }
+#line 2323 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 73: /* object_literal_value_list: object_literal_value_field  */
-#line 357 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                            { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2315 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 75: /* object_literal_value_list: object_literal_value_field  */
+#line 366 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                            { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2329 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 74: /* object_literal_value_list: object_literal_value_list object_literal_value_field  */
-#line 358 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                            { rb_ary_push(yyval, yyvsp[0]); }
-#line 2321 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 76: /* object_literal_value_list: object_literal_value_list object_literal_value_field  */
+#line 367 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                            { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2335 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 75: /* object_literal_value_field: name COLON literal_value  */
-#line 361 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 77: /* object_literal_value_field: name COLON literal_value  */
+#line 370 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                {
-        yyval = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          rb_ary_entry(yyvsp[-2], 3),
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(Argument, 2,
+          (yyvsp[-2].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-2].token)),
+          (yyvsp[0].node)
         );
       }
-#line 2334 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2347 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 76: /* directives_list_opt: %empty  */
-#line 372 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                      { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2340 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 78: /* directives_list_opt: %empty  */
+#line 380 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                      { (yyval.node) = AST_NONE; }
+#line 2353 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 78: /* directives_list: directive  */
-#line 376 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2346 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 80: /* directives_list: directive  */
+#line 384 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2359 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 79: /* directives_list: directives_list directive  */
-#line 377 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                { rb_ary_push(yyval, yyvsp[0]); }
-#line 2352 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 81: /* directives_list: directives_list directive  */
+#line 385 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2365 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 80: /* directive: DIR_SIGN name arguments_opt  */
-#line 379 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 82: /* directive: DIR_SIGN name arguments_opt  */
+#line 387 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                          {
-    yyval = MAKE_AST_NODE(Directive, 4,
-      rb_ary_entry(yyvsp[-2], 1),
-      rb_ary_entry(yyvsp[-2], 2),
-      rb_ary_entry(yyvsp[-1], 3),
-      yyvsp[0]
+    state->ast->stats.directives++;
+    (yyval.node) = MAKE_AST_NODE(Directive, 2,
+      (yyvsp[-2].token).byte_offset,
+      TOKEN_VALUE((yyvsp[-1].token)),
+      (yyvsp[0].node)
     );
   }
-#line 2365 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2378 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 101: /* fragment_spread: ELLIPSIS name_without_on directives_list_opt  */
-#line 416 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 103: /* fragment_spread: ELLIPSIS name_without_on directives_list_opt  */
+#line 424 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                    {
-        yyval = MAKE_AST_NODE(FragmentSpread, 4,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          rb_ary_entry(yyvsp[-1], 3),
-          yyvsp[0]
+        state->ast->stats.fragment_spreads++;
+        (yyval.node) = MAKE_AST_NODE(FragmentSpread, 2,
+          (yyvsp[-2].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-1].token)),
+          (yyvsp[0].node)
         );
       }
-#line 2378 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2391 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 102: /* inline_fragment: ELLIPSIS ON NamedTypeForCondition directives_list_opt selection_set  */
-#line 426 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 104: /* inline_fragment: ELLIPSIS ON NamedTypeForCondition directives_list_opt selection_set  */
+#line 434 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                           {
-        yyval = MAKE_AST_NODE(InlineFragment, 5,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          yyvsp[-2],
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(InlineFragment, 3,
+          (yyvsp[-4].token).byte_offset,
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 2392 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2404 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 103: /* inline_fragment: ELLIPSIS directives_list_opt selection_set  */
-#line 435 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 105: /* inline_fragment: ELLIPSIS directives_list_opt selection_set  */
+#line 442 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                  {
-        yyval = MAKE_AST_NODE(InlineFragment, 5,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          Qnil,
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(InlineFragment, 3,
+          (yyvsp[-2].token).byte_offset,
+          AST_NIL,
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 2406 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2417 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 104: /* fragment_definition: FRAGMENT fragment_name_opt ON NamedTypeForCondition directives_list_opt selection_set  */
-#line 446 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 106: /* fragment_definition: FRAGMENT fragment_name_opt ON NamedTypeForCondition directives_list_opt selection_set  */
+#line 452 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                           {
-      yyval = MAKE_AST_NODE(FragmentDefinition, 6,
-        rb_ary_entry(yyvsp[-5], 1),
-        rb_ary_entry(yyvsp[-5], 2),
-        yyvsp[-4],
-        yyvsp[-2],
-        yyvsp[-1],
-        yyvsp[0]
+      (yyval.node) = MAKE_AST_NODE(FragmentDefinition, 4,
+        (yyvsp[-5].token).byte_offset,
+        (yyvsp[-4].node),
+        (yyvsp[-2].node),
+        (yyvsp[-1].node),
+        (yyvsp[0].node)
       );
     }
-#line 2421 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2431 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 105: /* fragment_name_opt: %empty  */
-#line 458 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                 { yyval = Qnil; }
-#line 2427 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 107: /* fragment_name_opt: %empty  */
+#line 463 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                 { (yyval.node) = AST_NIL; }
+#line 2437 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 106: /* fragment_name_opt: name_without_on  */
-#line 459 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                      { yyval = rb_ary_entry(yyvsp[0], 3); }
-#line 2433 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 108: /* fragment_name_opt: name_without_on  */
+#line 464 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                      { (yyval.node) = TOKEN_VALUE((yyvsp[0].token)); }
+#line 2443 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 108: /* type: nullable_type BANG  */
-#line 463 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                              { yyval = MAKE_AST_NODE(NonNullType, 3, rb_funcall(yyvsp[-1], rb_intern("line"), 0), rb_funcall(yyvsp[-1], rb_intern("col"), 0), yyvsp[-1]); }
-#line 2439 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 110: /* type: nullable_type BANG  */
+#line 468 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                              { (yyval.node) = MAKE_AST_NODE(NonNullType, 1, (yyvsp[-1].node).as.node->pos, (yyvsp[-1].node)); }
+#line 2449 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 109: /* nullable_type: name  */
-#line 466 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 111: /* nullable_type: name  */
+#line 471 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                              {
-        yyval = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry(yyvsp[0], 1),
-          rb_ary_entry(yyvsp[0], 2),
-          rb_ary_entry(yyvsp[0], 3)
+        (yyval.node) = MAKE_AST_NODE(TypeName, 1,
+          (yyvsp[0].token).byte_offset,
+          TOKEN_VALUE((yyvsp[0].token))
         );
       }
-#line 2451 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2460 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 110: /* nullable_type: LBRACKET type RBRACKET  */
-#line 473 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 112: /* nullable_type: LBRACKET type RBRACKET  */
+#line 477 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                              {
-        yyval = MAKE_AST_NODE(ListType, 3,
-          rb_funcall(yyvsp[-1], rb_intern("line"), 0),
-          rb_funcall(yyvsp[-1], rb_intern("col"), 0),
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(ListType, 1,
+          (yyvsp[-1].node).as.node->pos,
+          (yyvsp[-1].node)
         );
       }
-#line 2463 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2471 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 114: /* schema_definition: SCHEMA directives_list_opt operation_type_definition_list_opt  */
-#line 487 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 116: /* schema_definition: SCHEMA directives_list_opt operation_type_definition_list_opt  */
+#line 490 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                     {
-        yyval = MAKE_AST_NODE(SchemaDefinition, 6,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          // TODO use static strings:
-          rb_hash_aref(yyvsp[0], rb_str_new_cstr("query")),
-          rb_hash_aref(yyvsp[0], rb_str_new_cstr("mutation")),
-          rb_hash_aref(yyvsp[0], rb_str_new_cstr("subscription")),
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(SchemaDefinition, 4,
+          (yyvsp[-2].token).byte_offset,
+          (yyvsp[0].node).as.node->values[0], // query
+          (yyvsp[0].node).as.node->values[1], // mutation
+          (yyvsp[0].node).as.node->values[2], // subscription
+          (yyvsp[-1].node)
         );
       }
-#line 2479 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
-    break;
-
-  case 115: /* operation_type_definition_list_opt: %empty  */
-#line 500 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                 { yyval = rb_hash_new(); }
 #line 2485 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 116: /* operation_type_definition_list_opt: LCURLY operation_type_definition_list RCURLY  */
+  case 117: /* operation_type_definition_list_opt: %empty  */
 #line 501 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                   { yyval = yyvsp[-1]; }
+                 { (yyval.node) = AST_NODE_VALUE(ast_node_new(state->ast, AST_OperationTypes, 0, 3, AST_NIL, AST_NIL, AST_NIL)); }
 #line 2491 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 117: /* operation_type_definition_list: operation_type_definition  */
-#line 504 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                {
-        yyval = rb_hash_new();
-        rb_hash_aset(yyval, rb_ary_entry(yyvsp[0], 0), rb_ary_entry(yyvsp[0], 1));
-      }
-#line 2500 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 118: /* operation_type_definition_list_opt: LCURLY operation_type_definition_list RCURLY  */
+#line 502 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                   { (yyval.node) = (yyvsp[-1].node); }
+#line 2497 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 118: /* operation_type_definition_list: operation_type_definition_list operation_type_definition  */
-#line 508 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 120: /* operation_type_definition_list: operation_type_definition_list operation_type_definition  */
+#line 506 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                {
-      rb_hash_aset(yyval, rb_ary_entry(yyvsp[0], 0), rb_ary_entry(yyvsp[0], 1));
+      set_operation_types((yyval.node), (yyvsp[0].node));
     }
-#line 2508 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2505 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 119: /* operation_type_definition: operation_type COLON name  */
-#line 513 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 121: /* operation_type_definition: operation_type COLON name  */
+#line 511 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                 {
-        yyval = rb_ary_new_from_args(2, rb_ary_entry(yyvsp[-2], 3), rb_ary_entry(yyvsp[0], 3));
+        (yyval.node) = AST_NODE_VALUE(ast_node_new(state->ast, AST_OperationTypes, (yyvsp[-2].token).byte_offset, 3, AST_NIL, AST_NIL, AST_NIL));
+        int operation_index = (yyvsp[-2].token).type == QUERY ? 0 : ((yyvsp[-2].token).type == MUTATION ? 1 : 2);
+        (yyval.node).as.node->values[operation_index] = TOKEN_VALUE((yyvsp[0].token));
       }
-#line 2516 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2515 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 127: /* description_opt: %empty  */
+  case 129: /* description_opt: %empty  */
 #line 528 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                      { yyval = Qnil; }
-#line 2522 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+                      { (yyval.node) = AST_NIL; }
+#line 2521 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+    break;
+
+  case 130: /* description_opt: description  */
+#line 529 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                      { (yyval.node) = TOKEN_VALUE((yyvsp[0].token)); }
+#line 2527 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 129: /* scalar_type_definition: description_opt SCALAR name directives_list_opt  */
+  case 131: /* scalar_type_definition: description_opt SCALAR name directives_list_opt  */
 #line 532 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                       {
-        yyval = MAKE_AST_NODE(ScalarTypeDefinition, 5,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          rb_ary_entry(yyvsp[-1], 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-3]) ? rb_ary_entry(yyvsp[-3], 3) : Qnil),
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(ScalarTypeDefinition, 4,
+          (yyvsp[-2].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-1].token)),
+          (yyvsp[-3].node),
+          (yyvsp[0].node),
+          COMMENT_VALUE((yyvsp[-2].token))
         );
       }
-#line 2537 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2541 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 130: /* object_type_definition: description_opt TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt  */
-#line 544 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 132: /* object_type_definition: description_opt TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt  */
+#line 543 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                                      {
-        yyval = MAKE_AST_NODE(ObjectTypeDefinition, 7,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          yyvsp[-2], // implements
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-5]) ? rb_ary_entry(yyvsp[-5], 3) : Qnil),
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(ObjectTypeDefinition, 6,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[-2].node), // implements
+          (yyvsp[-5].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node),
+          COMMENT_VALUE((yyvsp[-4].token))
         );
       }
-#line 2554 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2557 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 131: /* implements_opt: %empty  */
-#line 558 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                 { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2560 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 133: /* implements_opt: %empty  */
+#line 556 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                 { (yyval.node) = AST_NONE; }
+#line 2563 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 132: /* implements_opt: IMPLEMENTS AMP interfaces_list  */
-#line 559 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                     { yyval = yyvsp[0]; }
-#line 2566 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 134: /* implements_opt: IMPLEMENTS AMP interfaces_list  */
+#line 557 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                     { (yyval.node) = (yyvsp[0].node); }
+#line 2569 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 133: /* implements_opt: IMPLEMENTS interfaces_list  */
-#line 560 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                 { yyval = yyvsp[0]; }
-#line 2572 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 135: /* implements_opt: IMPLEMENTS interfaces_list  */
+#line 558 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                 { (yyval.node) = (yyvsp[0].node); }
+#line 2575 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 134: /* implements_opt: IMPLEMENTS legacy_interfaces_list  */
-#line 561 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                        { yyval = yyvsp[0]; }
-#line 2578 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 136: /* implements_opt: IMPLEMENTS legacy_interfaces_list  */
+#line 559 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                        { (yyval.node) = (yyvsp[0].node); }
+#line 2581 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 135: /* interfaces_list: name  */
-#line 564 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 137: /* interfaces_list: name  */
+#line 562 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
            {
-        VALUE new_name = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry(yyvsp[0], 1),
-          rb_ary_entry(yyvsp[0], 2),
-          rb_ary_entry(yyvsp[0], 3)
+        GraphQLAstValue new_name = MAKE_AST_NODE(TypeName, 1,
+          (yyvsp[0].token).byte_offset,
+          TOKEN_VALUE((yyvsp[0].token))
         );
-        yyval = rb_ary_new_from_args(1, new_name);
+        (yyval.node) = MAKE_AST_LIST(new_name);
       }
-#line 2591 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2593 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 136: /* interfaces_list: interfaces_list AMP name  */
-#line 572 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 138: /* interfaces_list: interfaces_list AMP name  */
+#line 569 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                {
-      VALUE new_name =  MAKE_AST_NODE(TypeName, 3, rb_ary_entry(yyvsp[0], 1), rb_ary_entry(yyvsp[0], 2), rb_ary_entry(yyvsp[0], 3));
-      rb_ary_push(yyval, new_name);
+      GraphQLAstValue new_name =  MAKE_AST_NODE(TypeName, 1, (yyvsp[0].token).byte_offset, TOKEN_VALUE((yyvsp[0].token)));
+      AST_LIST_PUSH((yyval.node), new_name);
     }
-#line 2600 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2602 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 137: /* legacy_interfaces_list: name  */
-#line 578 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 139: /* legacy_interfaces_list: name  */
+#line 575 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
            {
-        VALUE new_name = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry(yyvsp[0], 1),
-          rb_ary_entry(yyvsp[0], 2),
-          rb_ary_entry(yyvsp[0], 3)
+        GraphQLAstValue new_name = MAKE_AST_NODE(TypeName, 1,
+          (yyvsp[0].token).byte_offset,
+          TOKEN_VALUE((yyvsp[0].token))
         );
-        yyval = rb_ary_new_from_args(1, new_name);
+        (yyval.node) = MAKE_AST_LIST(new_name);
       }
-#line 2613 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2614 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 138: /* legacy_interfaces_list: legacy_interfaces_list name  */
-#line 586 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 140: /* legacy_interfaces_list: legacy_interfaces_list name  */
+#line 582 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                   {
-      rb_ary_push(yyval, MAKE_AST_NODE(TypeName, 3, rb_ary_entry(yyvsp[0], 1), rb_ary_entry(yyvsp[0], 2), rb_ary_entry(yyvsp[0], 3)));
+      AST_LIST_PUSH((yyval.node), MAKE_AST_NODE(TypeName, 1, (yyvsp[0].token).byte_offset, TOKEN_VALUE((yyvsp[0].token))));
     }
-#line 2621 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2622 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 139: /* input_value_definition: description_opt name COLON type default_value_opt directives_list_opt  */
-#line 591 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 141: /* input_value_definition: description_opt name COLON type default_value_opt directives_list_opt  */
+#line 587 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                             {
-        yyval = MAKE_AST_NODE(InputValueDefinition, 7,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          yyvsp[-2],
-          yyvsp[-1],
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-5]) ? rb_ary_entry(yyvsp[-5], 3) : Qnil),
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(InputValueDefinition, 6,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[-5].node),
+          (yyvsp[0].node),
+          COMMENT_VALUE((yyvsp[-4].token))
         );
       }
 #line 2638 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 140: /* input_value_definition_list: input_value_definition  */
-#line 605 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                         { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
+  case 142: /* input_value_definition_list: input_value_definition  */
+#line 600 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                         { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
 #line 2644 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 141: /* input_value_definition_list: input_value_definition_list input_value_definition  */
-#line 606 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                         { rb_ary_push(yyval, yyvsp[0]); }
+  case 143: /* input_value_definition_list: input_value_definition_list input_value_definition  */
+#line 601 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                         { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
 #line 2650 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 142: /* arguments_definitions_opt: %empty  */
-#line 609 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                { yyval = GraphQL_Language_Nodes_NONE; }
+  case 144: /* arguments_definitions_opt: %empty  */
+#line 604 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                { (yyval.node) = AST_NONE; }
 #line 2656 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 143: /* arguments_definitions_opt: LPAREN input_value_definition_list RPAREN  */
-#line 610 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                { yyval = yyvsp[-1]; }
+  case 145: /* arguments_definitions_opt: LPAREN input_value_definition_list RPAREN  */
+#line 605 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                { (yyval.node) = (yyvsp[-1].node); }
 #line 2662 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 144: /* field_definition: description_opt name arguments_definitions_opt COLON type directives_list_opt  */
-#line 613 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 146: /* field_definition: description_opt name arguments_definitions_opt COLON type directives_list_opt  */
+#line 608 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                     {
-        yyval = MAKE_AST_NODE(FieldDefinition, 7,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          yyvsp[-1],
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-5]) ? rb_ary_entry(yyvsp[-5], 3) : Qnil),
-          yyvsp[-3],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(FieldDefinition, 6,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-1].node),
+          (yyvsp[-5].node),
+          (yyvsp[-3].node),
+          (yyvsp[0].node),
+          COMMENT_VALUE((yyvsp[-4].token))
         );
       }
-#line 2679 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2678 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 145: /* field_definition_list_opt: %empty  */
-#line 627 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-               { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2685 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 147: /* field_definition_list_opt: %empty  */
+#line 621 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+               { (yyval.node) = AST_NONE; }
+#line 2684 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 146: /* field_definition_list_opt: LCURLY field_definition_list RCURLY  */
-#line 628 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                          { yyval = yyvsp[-1]; }
-#line 2691 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 148: /* field_definition_list_opt: LCURLY field_definition_list RCURLY  */
+#line 622 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                          { (yyval.node) = (yyvsp[-1].node); }
+#line 2690 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 147: /* field_definition_list: %empty  */
-#line 631 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                                                { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2697 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 149: /* field_definition_list: %empty  */
+#line 625 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                                                { (yyval.node) = AST_NONE; }
+#line 2696 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 148: /* field_definition_list: field_definition  */
-#line 632 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                             { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2703 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 150: /* field_definition_list: field_definition  */
+#line 626 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                             { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2702 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 149: /* field_definition_list: field_definition_list field_definition  */
-#line 633 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                             { rb_ary_push(yyval, yyvsp[0]); }
-#line 2709 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 151: /* field_definition_list: field_definition_list field_definition  */
+#line 627 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                             { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2708 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 150: /* interface_type_definition: description_opt INTERFACE name implements_opt directives_list_opt field_definition_list_opt  */
-#line 636 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 152: /* interface_type_definition: description_opt INTERFACE name implements_opt directives_list_opt field_definition_list_opt  */
+#line 630 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                                   {
-        yyval = MAKE_AST_NODE(InterfaceTypeDefinition, 7,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-5]) ? rb_ary_entry(yyvsp[-5], 3) : Qnil),
-          yyvsp[-2],
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(InterfaceTypeDefinition, 6,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[-5].node),
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node),
+          COMMENT_VALUE((yyvsp[-4].token))
         );
       }
-#line 2726 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2724 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 151: /* pipe_opt: %empty  */
-#line 650 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                 { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2732 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 153: /* pipe_opt: %empty  */
+#line 643 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                 { (yyval.node) = AST_NONE; }
+#line 2730 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 152: /* pipe_opt: PIPE  */
-#line 651 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-               { yyval = GraphQL_Language_Nodes_NONE; }
-#line 2738 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 154: /* pipe_opt: PIPE  */
+#line 644 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+               { (yyval.node) = AST_NONE; }
+#line 2736 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 153: /* union_members: pipe_opt name  */
-#line 654 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 155: /* union_members: pipe_opt name  */
+#line 647 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                     {
-        VALUE new_member = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry(yyvsp[0], 1),
-          rb_ary_entry(yyvsp[0], 2),
-          rb_ary_entry(yyvsp[0], 3)
+        GraphQLAstValue new_member = MAKE_AST_NODE(TypeName, 1,
+          (yyvsp[0].token).byte_offset,
+          TOKEN_VALUE((yyvsp[0].token))
         );
-        yyval = rb_ary_new_from_args(1, new_member);
+        (yyval.node) = MAKE_AST_LIST(new_member);
       }
-#line 2751 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2748 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 154: /* union_members: union_members PIPE name  */
-#line 662 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 156: /* union_members: union_members PIPE name  */
+#line 654 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                               {
-        rb_ary_push(yyval, MAKE_AST_NODE(TypeName, 3, rb_ary_entry(yyvsp[0], 1), rb_ary_entry(yyvsp[0], 2), rb_ary_entry(yyvsp[0], 3)));
+        AST_LIST_PUSH((yyval.node), MAKE_AST_NODE(TypeName, 1, (yyvsp[0].token).byte_offset, TOKEN_VALUE((yyvsp[0].token))));
       }
-#line 2759 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2756 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 155: /* union_type_definition: description_opt UNION name directives_list_opt EQUALS union_members  */
-#line 667 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 157: /* union_type_definition: description_opt UNION name directives_list_opt EQUALS union_members  */
+#line 659 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                           {
-        yyval = MAKE_AST_NODE(UnionTypeDefinition,  6,
-          rb_ary_entry(yyvsp[-4], 1),
-          rb_ary_entry(yyvsp[-4], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          yyvsp[0], // types
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-5]) ? rb_ary_entry(yyvsp[-5], 3) : Qnil),
-          yyvsp[-2]
+        (yyval.node) = MAKE_AST_NODE(UnionTypeDefinition, 5,
+          (yyvsp[-4].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[0].node), // types
+          (yyvsp[-5].node),
+          (yyvsp[-2].node),
+          COMMENT_VALUE((yyvsp[-4].token))
         );
       }
-#line 2775 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2771 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 156: /* enum_type_definition: description_opt ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY  */
-#line 680 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 158: /* enum_type_definition: description_opt ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY  */
+#line 671 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                          {
-        yyval = MAKE_AST_NODE(EnumTypeDefinition,  6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-6]) ? rb_ary_entry(yyvsp[-6], 3) : Qnil),
-          yyvsp[-3],
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(EnumTypeDefinition, 5,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-6].node),
+          (yyvsp[-3].node),
+          (yyvsp[-1].node),
+          COMMENT_VALUE((yyvsp[-5].token))
         );
       }
-#line 2791 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2786 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 157: /* enum_value_definition: description_opt enum_name directives_list_opt  */
-#line 693 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 159: /* enum_value_definition: description_opt enum_name directives_list_opt  */
+#line 683 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                   {
-      yyval = MAKE_AST_NODE(EnumValueDefinition, 5,
-        rb_ary_entry(yyvsp[-1], 1),
-        rb_ary_entry(yyvsp[-1], 2),
-        rb_ary_entry(yyvsp[-1], 3),
-        // TODO see get_description for reading a description from comments
-        (RB_TEST(yyvsp[-2]) ? rb_ary_entry(yyvsp[-2], 3) : Qnil),
-        yyvsp[0]
+      (yyval.node) = MAKE_AST_NODE(EnumValueDefinition, 4,
+        (yyvsp[-1].token).byte_offset,
+        TOKEN_VALUE((yyvsp[-1].token)),
+        (yyvsp[-2].node),
+        (yyvsp[0].node),
+        COMMENT_VALUE((yyvsp[-1].token))
       );
     }
-#line 2806 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2800 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 158: /* enum_value_definitions: enum_value_definition  */
-#line 705 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                   { yyval = rb_ary_new_from_args(1, yyvsp[0]); }
-#line 2812 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 160: /* enum_value_definitions: enum_value_definition  */
+#line 694 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                   { (yyval.node) = MAKE_AST_LIST((yyvsp[0].node)); }
+#line 2806 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 159: /* enum_value_definitions: enum_value_definitions enum_value_definition  */
-#line 706 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                                   { rb_ary_push(yyval, yyvsp[0]); }
-#line 2818 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 161: /* enum_value_definitions: enum_value_definitions enum_value_definition  */
+#line 695 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                                   { AST_LIST_PUSH((yyval.node), (yyvsp[0].node)); }
+#line 2812 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 160: /* input_object_type_definition: description_opt INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY  */
-#line 709 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 162: /* input_object_type_definition: description_opt INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY  */
+#line 698 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                                {
-        yyval = MAKE_AST_NODE(InputObjectTypeDefinition, 6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-6]) ? rb_ary_entry(yyvsp[-6], 3) : Qnil),
-          yyvsp[-3],
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(InputObjectTypeDefinition, 5,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-6].node),
+          (yyvsp[-3].node),
+          (yyvsp[-1].node),
+          COMMENT_VALUE((yyvsp[-5].token))
         );
       }
-#line 2834 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2827 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 161: /* directive_definition: description_opt DIRECTIVE DIR_SIGN name arguments_definitions_opt directive_repeatable_opt ON directive_locations  */
-#line 722 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 163: /* directive_definition: description_opt DIRECTIVE DIR_SIGN name arguments_definitions_opt directive_repeatable_opt ON directive_locations  */
+#line 710 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                                                         {
-        yyval = MAKE_AST_NODE(DirectiveDefinition, 7,
-          rb_ary_entry(yyvsp[-6], 1),
-          rb_ary_entry(yyvsp[-6], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          (RB_TEST(yyvsp[-2]) ? Qtrue : Qfalse), // repeatable
+        (yyval.node) = MAKE_AST_NODE(DirectiveDefinition, 5,
+          (yyvsp[-6].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-2].node), // repeatable
           // TODO see get_description for reading a description from comments
-          (RB_TEST(yyvsp[-7]) ? rb_ary_entry(yyvsp[-7], 3) : Qnil),
-          yyvsp[-3],
-          yyvsp[0]
+          (yyvsp[-7].node),
+          (yyvsp[-3].node),
+          (yyvsp[0].node)
         );
       }
-#line 2851 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2843 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 162: /* directive_repeatable_opt: %empty  */
-#line 736 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                    { yyval = Qnil; }
-#line 2857 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 164: /* directive_repeatable_opt: %empty  */
+#line 723 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                    { (yyval.node) = AST_FALSE; }
+#line 2849 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 163: /* directive_repeatable_opt: REPEATABLE  */
-#line 737 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                    { yyval = Qtrue; }
-#line 2863 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 165: /* directive_repeatable_opt: REPEATABLE  */
+#line 724 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                    { (yyval.node) = AST_TRUE; }
+#line 2855 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 164: /* directive_locations: name  */
-#line 740 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                    { yyval = rb_ary_new_from_args(1, MAKE_AST_NODE(DirectiveLocation, 3, rb_ary_entry(yyvsp[0], 1), rb_ary_entry(yyvsp[0], 2), rb_ary_entry(yyvsp[0], 3))); }
-#line 2869 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 166: /* directive_locations: name  */
+#line 727 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                    { (yyval.node) = MAKE_AST_LIST(MAKE_AST_NODE(DirectiveLocation, 1, (yyvsp[0].token).byte_offset, TOKEN_VALUE((yyvsp[0].token)))); }
+#line 2861 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 165: /* directive_locations: directive_locations PIPE name  */
-#line 741 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
-                                    { rb_ary_push(yyval, MAKE_AST_NODE(DirectiveLocation, 3, rb_ary_entry(yyvsp[0], 1), rb_ary_entry(yyvsp[0], 2), rb_ary_entry(yyvsp[0], 3))); }
-#line 2875 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+  case 167: /* directive_locations: directive_locations PIPE name  */
+#line 728 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+                                    { AST_LIST_PUSH((yyval.node), MAKE_AST_NODE(DirectiveLocation, 1, (yyvsp[0].token).byte_offset, TOKEN_VALUE((yyvsp[0].token)))); }
+#line 2867 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 168: /* schema_extension: EXTEND SCHEMA directives_list_opt LCURLY operation_type_definition_list RCURLY  */
-#line 749 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 170: /* schema_extension: EXTEND SCHEMA directives_list_opt LCURLY operation_type_definition_list RCURLY  */
+#line 736 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                      {
-        yyval = MAKE_AST_NODE(SchemaExtension, 6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          // TODO use static strings:
-          rb_hash_aref(yyvsp[-1], rb_str_new_cstr("query")),
-          rb_hash_aref(yyvsp[-1], rb_str_new_cstr("mutation")),
-          rb_hash_aref(yyvsp[-1], rb_str_new_cstr("subscription")),
-          yyvsp[-3]
+        (yyval.node) = MAKE_AST_NODE(SchemaExtension, 4,
+          (yyvsp[-5].token).byte_offset,
+          (yyvsp[-1].node).as.node->values[0], // query
+          (yyvsp[-1].node).as.node->values[1], // mutation
+          (yyvsp[-1].node).as.node->values[2], // subscription
+          (yyvsp[-3].node)
         );
       }
-#line 2891 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2881 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 169: /* schema_extension: EXTEND SCHEMA directives_list  */
-#line 760 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 171: /* schema_extension: EXTEND SCHEMA directives_list  */
+#line 745 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                     {
-        yyval = MAKE_AST_NODE(SchemaExtension, 6,
-          rb_ary_entry(yyvsp[-2], 1),
-          rb_ary_entry(yyvsp[-2], 2),
-          Qnil,
-          Qnil,
-          Qnil,
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(SchemaExtension, 4,
+          (yyvsp[-2].token).byte_offset,
+          AST_NIL,
+          AST_NIL,
+          AST_NIL,
+          (yyvsp[0].node)
         );
       }
-#line 2906 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2895 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 176: /* scalar_type_extension: EXTEND SCALAR name directives_list  */
-#line 779 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 178: /* scalar_type_extension: EXTEND SCALAR name directives_list  */
+#line 763 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                             {
-    yyval = MAKE_AST_NODE(ScalarTypeExtension, 4,
-      rb_ary_entry(yyvsp[-3], 1),
-      rb_ary_entry(yyvsp[-3], 2),
-      rb_ary_entry(yyvsp[-1], 3),
-      yyvsp[0]
+    (yyval.node) = MAKE_AST_NODE(ScalarTypeExtension, 2,
+      (yyvsp[-3].token).byte_offset,
+      TOKEN_VALUE((yyvsp[-1].token)),
+      (yyvsp[0].node)
     );
   }
-#line 2919 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2907 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 177: /* object_type_extension: EXTEND TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt  */
-#line 789 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 179: /* object_type_extension: EXTEND TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt  */
+#line 772 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                             {
-        yyval = MAKE_AST_NODE(ObjectTypeExtension, 6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          yyvsp[-2], // implements
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(ObjectTypeExtension, 4,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[-2].node), // implements
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 2934 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2921 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 178: /* interface_type_extension: EXTEND INTERFACE name implements_opt directives_list_opt field_definition_list_opt  */
-#line 801 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 180: /* interface_type_extension: EXTEND INTERFACE name implements_opt directives_list_opt field_definition_list_opt  */
+#line 783 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                          {
-        yyval = MAKE_AST_NODE(InterfaceTypeExtension, 6,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          yyvsp[-2],
-          yyvsp[-1],
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(InterfaceTypeExtension, 4,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[-2].node),
+          (yyvsp[-1].node),
+          (yyvsp[0].node)
         );
       }
-#line 2949 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2935 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 179: /* union_type_extension: EXTEND UNION name directives_list_opt EQUALS union_members  */
-#line 813 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 181: /* union_type_extension: EXTEND UNION name directives_list_opt EQUALS union_members  */
+#line 794 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                  {
-        yyval = MAKE_AST_NODE(UnionTypeExtension, 5,
-          rb_ary_entry(yyvsp[-5], 1),
-          rb_ary_entry(yyvsp[-5], 2),
-          rb_ary_entry(yyvsp[-3], 3),
-          yyvsp[0], // types
-          yyvsp[-2]
+        (yyval.node) = MAKE_AST_NODE(UnionTypeExtension, 3,
+          (yyvsp[-5].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-3].token)),
+          (yyvsp[0].node), // types
+          (yyvsp[-2].node)
         );
       }
-#line 2963 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2948 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 180: /* union_type_extension: EXTEND UNION name directives_list  */
-#line 822 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 182: /* union_type_extension: EXTEND UNION name directives_list  */
+#line 802 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                         {
-        yyval = MAKE_AST_NODE(UnionTypeExtension, 5,
-          rb_ary_entry(yyvsp[-3], 1),
-          rb_ary_entry(yyvsp[-3], 2),
-          rb_ary_entry(yyvsp[-1], 3),
-          GraphQL_Language_Nodes_NONE, // types
-          yyvsp[0]
+        (yyval.node) = MAKE_AST_NODE(UnionTypeExtension, 3,
+          (yyvsp[-3].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-1].token)),
+          AST_NONE, // types
+          (yyvsp[0].node)
         );
       }
-#line 2977 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2961 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 181: /* enum_type_extension: EXTEND ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY  */
-#line 833 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 183: /* enum_type_extension: EXTEND ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY  */
+#line 812 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                 {
-        yyval = MAKE_AST_NODE(EnumTypeExtension, 5,
-          rb_ary_entry(yyvsp[-6], 1),
-          rb_ary_entry(yyvsp[-6], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          yyvsp[-3],
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(EnumTypeExtension, 3,
+          (yyvsp[-6].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-3].node),
+          (yyvsp[-1].node)
         );
       }
-#line 2991 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2974 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 182: /* enum_type_extension: EXTEND ENUM name directives_list  */
-#line 842 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 184: /* enum_type_extension: EXTEND ENUM name directives_list  */
+#line 820 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                        {
-        yyval = MAKE_AST_NODE(EnumTypeExtension, 5,
-          rb_ary_entry(yyvsp[-3], 1),
-          rb_ary_entry(yyvsp[-3], 2),
-          rb_ary_entry(yyvsp[-1], 3),
-          yyvsp[0],
-          GraphQL_Language_Nodes_NONE
+        (yyval.node) = MAKE_AST_NODE(EnumTypeExtension, 3,
+          (yyvsp[-3].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-1].token)),
+          (yyvsp[0].node),
+          AST_NONE
         );
       }
-#line 3005 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 2987 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 183: /* input_object_type_extension: EXTEND INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY  */
-#line 853 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 185: /* input_object_type_extension: EXTEND INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY  */
+#line 830 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                                                                       {
-        yyval = MAKE_AST_NODE(InputObjectTypeExtension, 5,
-          rb_ary_entry(yyvsp[-6], 1),
-          rb_ary_entry(yyvsp[-6], 2),
-          rb_ary_entry(yyvsp[-4], 3),
-          yyvsp[-3],
-          yyvsp[-1]
+        (yyval.node) = MAKE_AST_NODE(InputObjectTypeExtension, 3,
+          (yyvsp[-6].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-4].token)),
+          (yyvsp[-3].node),
+          (yyvsp[-1].node)
         );
       }
-#line 3019 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 3000 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 184: /* input_object_type_extension: EXTEND INPUT name directives_list  */
-#line 862 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 186: /* input_object_type_extension: EXTEND INPUT name directives_list  */
+#line 838 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
                                         {
-        yyval = MAKE_AST_NODE(InputObjectTypeExtension, 5,
-          rb_ary_entry(yyvsp[-3], 1),
-          rb_ary_entry(yyvsp[-3], 2),
-          rb_ary_entry(yyvsp[-1], 3),
-          yyvsp[0],
-          GraphQL_Language_Nodes_NONE
+        (yyval.node) = MAKE_AST_NODE(InputObjectTypeExtension, 3,
+          (yyvsp[-3].token).byte_offset,
+          TOKEN_VALUE((yyvsp[-1].token)),
+          (yyvsp[0].node),
+          AST_NONE
         );
       }
-#line 3033 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 3013 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
-  case 185: /* NamedTypeForCondition: name  */
-#line 874 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+  case 187: /* NamedTypeForCondition: name  */
+#line 849 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
           {
               /* This action creates a TypeName AST node.
                  $1 (yyvsp[0] in C) refers to the semantic value of 'name'.
                  The MAKE_AST_NODE macro is used, consistent with other rules.
-                 'name' (represented by $1) provides an array: [filename, line, col, name_string] */
-              yyval = MAKE_AST_NODE(TypeName, 3,
-                                 rb_ary_entry(yyvsp[0], 1), /* line from name token */
-                                 rb_ary_entry(yyvsp[0], 2), /* col from name token */
-                                 rb_ary_entry(yyvsp[0], 3)  /* name string itself */
+                 'name' (represented by $1) is a token with its position and the name string as its value */
+              (yyval.node) = MAKE_AST_NODE(TypeName, 1,
+                                 (yyvsp[0].token).byte_offset,
+                                 TOKEN_VALUE((yyvsp[0].token))  /* name string itself */
                                 );
           }
-#line 3049 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 3028 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
     break;
 
 
-#line 3053 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
+#line 3032 "graphql-c_parser/ext/graphql_c_parser_ext/parser.c"
 
       default: break;
     }
@@ -3123,7 +3102,7 @@ yyerrlab:
                 yysyntax_error_status = YYENOMEM;
               }
           }
-        yyerror (parser, filename, yymsgp);
+        yyerror (parser, state, yymsgp);
         if (yysyntax_error_status == YYENOMEM)
           YYNOMEM;
       }
@@ -3143,7 +3122,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, parser, filename);
+                      yytoken, &yylval, parser, state);
           yychar = YYEMPTY;
         }
     }
@@ -3199,7 +3178,7 @@ yyerrlab1:
 
 
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp, parser, filename);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, parser, state);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -3237,7 +3216,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (parser, filename, YY_("memory exhausted"));
+  yyerror (parser, state, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -3252,7 +3231,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, parser, filename);
+                  yytoken, &yylval, parser, state);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -3261,7 +3240,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, parser, filename);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, parser, state);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -3273,99 +3252,419 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 887 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
+#line 861 "graphql-c_parser/ext/graphql_c_parser_ext/parser.y"
 
 
 // Custom functions
-int yylex (YYSTYPE *lvalp, VALUE parser, VALUE filename) {
-  VALUE next_token_idx_rb_int = rb_ivar_get(parser, rb_intern("@next_token_index"));
-  int next_token_idx = FIX2INT(next_token_idx_rb_int);
-  VALUE tokens = rb_ivar_get(parser, rb_intern("@tokens"));
-  VALUE next_token = rb_ary_entry(tokens, next_token_idx);
+// Parse errors are made here, without copying the query string. Only the offending token is read from it.
+static VALUE current_token_inspect(GraphQLLexer *lexer) {
+  return rb_inspect(token_content(lexer->source, lexer->intern_identifiers, &lexer->token));
+}
+
+// Errors get the same lines and columns as nodes, from their byte offset, see `document_line_at`.
+// Unless `message` is `Qnil`, ` at [line, col]` is added to it.
+static void error_location(GraphQLParser *state, long offset, VALUE message, VALUE *line, VALUE *col) {
+  long line_number, column_number;
+  document_position_at(state->ast, offset, &line_number, &column_number);
+  if (!NIL_P(message)) {
+    rb_str_catf(message, " at [%ld, %ld]", line_number, column_number);
+  }
+  *line = LONG2NUM(line_number);
+  *col = LONG2NUM(column_number);
+}
 
-  if (!RB_TEST(next_token)) {
+static void raise_bad_unicode_error(GraphQLParser *state) {
+  VALUE message = rb_utf8_str_new_cstr("Parse error on bad Unicode escape sequence: ");
+  rb_str_append(message, current_token_inspect(state->lexer));
+  rb_str_cat_cstr(message, " (error)");
+  VALUE line, col;
+  error_location(state, state->lexer->token.byte_offset, message, &line, &col);
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
+}
+
+int yylex (YYSTYPE *lvalp, VALUE parser, GraphQLParser *state) {
+  // The lexer runs one token ahead of the parser, see `next_token` in lexer.rl
+  GraphQLLexer *lexer = state->lexer;
+  int next_token_type = next_token(lexer);
+
+  if (lexer->error) {
+    // The lexer stopped without raising, see `raise_deferred_parse_error`.
+    // This token makes `yyparse` return without calling `yyerror`.
+    return YYerror;
+  }
+  if (next_token_type == 0) {
     return YYEOF;
   }
-  rb_ivar_set(parser, rb_intern("@next_token_index"), INT2FIX(next_token_idx + 1));
-  VALUE token_type_rb_int = rb_ary_entry(next_token, 4);
-  int next_token_type = FIX2INT(token_type_rb_int);
   if (next_token_type == 241) { // BAD_UNICODE_ESCAPE
-    VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-    VALUE mCParser = rb_const_get_at(mGraphQL, rb_intern("CParser"));
-    VALUE bad_unicode_error = rb_funcall(
-        mCParser, rb_intern("prepare_bad_unicode_error"), 1,
-        parser
-    );
-    rb_exc_raise(bad_unicode_error);
+    if (state->without_gvl) {
+      state->bad_unicode = 1;
+      return YYerror;
+    }
+    raise_bad_unicode_error(state);
   }
-  *lvalp = next_token;
+  switch (next_token_type) {
+    case LCURLY:
+    case LBRACKET:
+    case LPAREN:
+      if (enter_nesting(state, lexer->token)) {
+        return YYerror;
+      }
+      break;
+    case RCURLY:
+    case RBRACKET:
+    case RPAREN:
+      state->nesting--;
+      break;
+  }
+  // Token content is read later, when nodes are made from the arena
+  lvalp->token = lexer->token;
   return next_token_type;
 }
 
-void yyerror(VALUE parser, VALUE filename, const char *msg) {
-  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-  VALUE mCParser = rb_const_get_at(mGraphQL, rb_intern("CParser"));
-  VALUE rb_message = rb_str_new_cstr(msg);
-  VALUE exception = rb_funcall(
-      mCParser, rb_intern("prepare_parse_error"), 2,
-      rb_message,
-      parser
-  );
-  rb_exc_raise(exception);
+// Where `/, unexpected ([a-zA-Z ]+)(,| at)/` would end its first group in Bison's message, or -1.
+// The unexpected token's text is added there.
+static long unexpected_token_end(const char *message, long length) {
+  static const char prefix[] = ", unexpected ";
+  for (const char *match = strstr(message, prefix); match; match = strstr(match + 1, prefix)) {
+    long words_start = (match - message) + (long)(sizeof(prefix) - 1);
+    long words_end = words_start;
+    while (words_end < length && ((message[words_end] >= 'a' && message[words_end] <= 'z') || (message[words_end] >= 'A' && message[words_end] <= 'Z') || message[words_end] == ' ')) {
+      words_end++;
+    }
+    // Backtrack like the regular expression would, to the last word followed by `,` or ` at`
+    for (long end = words_end; end > words_start; end--) {
+      if (message[end] == ',' || strncmp(message + end, " at", 3) == 0) {
+        return end;
+      }
+    }
+  }
+  return -1;
+}
+
+static void raise_parse_error(GraphQLParser *state, const char *msg) {
+  if (strncmp(msg, "memory exhausted", 16) == 0) {
+    rb_exc_raise(parse_error_new(rb_utf8_str_new_cstr("This query is too large to execute."), Qnil, Qnil, state->query_string, state->filename));
+  }
+  VALUE message = rb_utf8_str_new_cstr(msg);
+  GraphQLLexer *lexer = state->lexer;
+  // There might not be a token if it's a comments-only string
+  if (lexer->token.type == 0) {
+    rb_exc_raise(parse_error_new(message, Qnil, Qnil, state->query_string, state->filename));
+  }
+  VALUE line, col;
+  error_location(state, lexer->token.byte_offset, message, &line, &col);
+  if (strstr(msg, "end of file") == NULL) {
+    long insert_at = unexpected_token_end(RSTRING_PTR(message), RSTRING_LEN(message));
+    if (insert_at >= 0) {
+      VALUE token_text = rb_utf8_str_new_cstr(" (");
+      rb_str_append(token_text, current_token_inspect(lexer));
+      rb_str_cat_cstr(token_text, ")");
+      rb_str_update(message, insert_at, 0, token_text);
+    }
+  }
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
 }
 
-#define INITIALIZE_NODE_CLASS_VARIABLE(node_class_name) \
-    rb_global_variable(&GraphQL_Language_Nodes_##node_class_name); \
-    GraphQL_Language_Nodes_##node_class_name = rb_const_get_at(mGraphQLLanguageNodes, rb_intern(#node_class_name));
+void yyerror(VALUE parser, GraphQLParser *state, const char *msg) {
+  if (state->without_gvl) {
+    // Bison's messages are short, this is only a precaution
+    snprintf(state->error_message, sizeof(state->error_message), "%s", msg);
+    return;
+  }
+  raise_parse_error(state, msg);
+}
 
-void initialize_node_class_variables() {
-  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-  VALUE mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
-  VALUE mGraphQLLanguageNodes = rb_const_get_at(mGraphQLLanguage, rb_intern("Nodes"));
+static void raise_limit_error(GraphQLParser *state) {
+  VALUE message = rb_utf8_str_new_cstr(state->error_message);
+  VALUE line, col;
+  error_location(state, state->limit_offset, state->limit_location_in_message ? message : Qnil, &line, &col);
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
+}
 
-  rb_global_variable(&GraphQL_Language_Nodes_NONE);
-  GraphQL_Language_Nodes_NONE = rb_ary_new();
-  rb_ary_freeze(GraphQL_Language_Nodes_NONE);
+// Record an error at `token` (its message is in `error_message`), and return 1 so that the parse stops.
+// Without the GVL, the error is raised afterward by `raise_deferred_parse_error`.
+static int stop_parse_at(GraphQLParser *state, GraphQLToken token, int location_in_message) {
+  state->limit_exceeded = 1;
+  state->limit_offset = token.byte_offset;
+  state->limit_location_in_message = location_in_message;
+  if (!state->without_gvl) {
+    raise_limit_error(state);
+  }
+  return 1;
+}
+
+// Stop the parse because `count` is over `limit`
+static int exceed_limit(GraphQLParser *state, GraphQLToken token, const char *format, long count, long limit) {
+  snprintf(state->error_message, sizeof(state->error_message), format, count, limit);
+  return stop_parse_at(state, token, 1);
+}
+
+// Brackets are counted as they're lexed, so that deeply-nested strings stop before Bison's stacks grow.
+// Lists of any length are parsed with left recursion, so the stacks only grow with nesting.
+// The message is the same as for `max_tokens:` and the Ruby parser's `SystemStackError`.
+static int enter_nesting(GraphQLParser *state, GraphQLToken token) {
+  state->nesting++;
+  if (state->max_nesting >= 0 && state->nesting > state->max_nesting) {
+    snprintf(state->error_message, sizeof(state->error_message), "This query is too large to execute.");
+    return stop_parse_at(state, token, 0);
+  }
+  return 0;
+}
+
+// Bison calls this (with `yyoverflow`) when its stacks are full. They start in `yyparse`'s frame (`YYINITDEPTH` entries),
+// then move to `state->stack`, which doubles each time it's too small. Nesting is limited by `enter_nesting`, so this is bounded too.
+static int grow_parser_stack(VALUE parser, GraphQLParser *state, void **states, long states_bytesize, void **values, long values_bytesize, long *capacity) {
+  GraphQLParserStack *stack = state->stack;
+  // The stacks are full, so each one has `*capacity` entries
+  long state_size = states_bytesize / *capacity;
+  long value_size = values_bytesize / *capacity;
+  long new_capacity = *capacity * 2;
+  if (stack->capacity < new_capacity) {
+    void *new_states = malloc(new_capacity * state_size);
+    void *new_values = malloc(new_capacity * value_size);
+    if (new_states == NULL || new_values == NULL) {
+      free(new_states);
+      free(new_values);
+      yyerror(parser, state, "memory exhausted");
+      return 0;
+    }
+    memcpy(new_states, *states, states_bytesize);
+    memcpy(new_values, *values, values_bytesize);
+    free(stack->states);
+    free(stack->values);
+    stack->states = new_states;
+    stack->values = new_values;
+    stack->capacity = new_capacity;
+  } else if (*states != stack->states) {
+    // This stack was grown by an earlier parse on this thread
+    memcpy(stack->states, *states, states_bytesize);
+    memcpy(stack->values, *values, values_bytesize);
+  }
+  *states = stack->states;
+  *values = stack->values;
+  *capacity = stack->capacity;
+  return 1;
+}
+
+static void free_parser_stack(GraphQLParserStack *stack) {
+  free(stack->states);
+  free(stack->values);
+  stack->states = NULL;
+  stack->values = NULL;
+  stack->capacity = 0;
+}
+
+// Depth is checked as each selection set opens, before anything inside it is parsed
+static int enter_selection_set(GraphQLParser *state, GraphQLToken token) {
+  GraphQLParseStats *stats = &state->ast->stats;
+  stats->depth++;
+  if (stats->depth > stats->max_depth) {
+    stats->max_depth = stats->depth;
+  }
+  if (state->max_depth >= 0 && stats->depth > state->max_depth) {
+    return exceed_limit(state, token, "Query has depth of %ld, which exceeds max depth of %ld", stats->depth, state->max_depth);
+  }
+  return 0;
+}
+
+// Fields are counted when they reduce, so a field's subselections are counted before it
+static int count_field(GraphQLParser *state, GraphQLToken token, int aliased) {
+  GraphQLParseStats *stats = &state->ast->stats;
+  stats->fields++;
+  if (state->max_fields >= 0 && stats->fields > state->max_fields) {
+    return exceed_limit(state, token, "Query has %ld fields, which exceeds max fields of %ld", stats->fields, state->max_fields);
+  }
+  if (aliased) {
+    stats->aliases++;
+    if (state->max_aliases >= 0 && stats->aliases > state->max_aliases) {
+      return exceed_limit(state, token, "Query has %ld aliases, which exceeds max aliases of %ld", stats->aliases, state->max_aliases);
+    }
+  }
+  return 0;
+}
+
+// Raise an error from the lexer or parser, after running without the GVL
+void raise_deferred_parse_error(VALUE parser, GraphQLParser *state) {
+  if (state->lexer->error) {
+    raise_lexer_error(state->lexer);
+  } else if (state->bad_unicode) {
+    raise_bad_unicode_error(state);
+  } else if (state->limit_exceeded) {
+    raise_limit_error(state);
+  } else if (state->error_message[0] != '\0') {
+    raise_parse_error(state, state->error_message);
+  }
+}
+
+static void set_without_gvl(GraphQLParser *state, int without_gvl) {
+  state->without_gvl = without_gvl;
+  state->lexer->without_gvl = without_gvl;
+  state->ast->without_gvl = without_gvl;
+  if (without_gvl) {
+    state->bad_unicode = 0;
+    state->limit_exceeded = 0;
+    state->error_message[0] = '\0';
+  }
+}
+
+typedef struct ParseBatch {
+  GraphQLParseJob *jobs;
+  long count;
+  int threads_count;
+  rb_atomic_t next_job; // Each thread takes the next job until they're all started
+} ParseBatch;
+
+static void *run_parse_jobs(void *ptr) {
+  ParseBatch *batch = ptr;
+  // This thread's parses share one stack
+  GraphQLParserStack stack = { NULL, NULL, 0 };
+  long i;
+  while ((i = (long)RUBY_ATOMIC_FETCH_ADD(batch->next_job, 1)) < batch->count) {
+    GraphQLParser *state = batch->jobs[i].state;
+    state->stack = &stack;
+    yyparse(batch->jobs[i].parser, state);
+    state->stack = NULL;
+  }
+  free_parser_stack(&stack);
+  return NULL;
+}
+
+static void *run_parse_batch(void *ptr) {
+  ParseBatch *batch = ptr;
+#ifdef HAVE_PTHREAD_H
+  // The workers are started for each batch and joined at the end; there's no pool.
+  // This thread parses too, alongside the workers
+  pthread_t workers[MAX_PARSE_THREADS];
+  int workers_count = 0;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  // Room for `yyparse`'s frame, see `grow_parser_stack`
+  pthread_attr_setstacksize(&attr, PARSE_THREAD_STACK_SIZE);
+  while (workers_count < batch->threads_count - 1) {
+    if (pthread_create(&workers[workers_count], &attr, run_parse_jobs, batch) != 0) {
+      // Make do with the threads that started
+      break;
+    }
+    workers_count++;
+  }
+  pthread_attr_destroy(&attr);
+#endif
+  run_parse_jobs(batch);
+#ifdef HAVE_PTHREAD_H
+  for (int i = 0; i < workers_count; i++) {
+    pthread_join(workers[i], NULL);
+  }
+#endif
+  return NULL;
+}
+
+// Build each job's AST on up to `threads_count` native threads, while other threads run Ruby code.
+// Ruby strings are made later, by `materialize_document`, and errors are raised by `raise_deferred_parse_error`.
+// The source strings must be frozen, so that other threads can't change them.
+void parse_many_without_gvl(GraphQLParseJob *jobs, long count, int threads_count) {
+  if (threads_count > MAX_PARSE_THREADS) {
+    threads_count = MAX_PARSE_THREADS;
+  }
+  if (threads_count > count) {
+    threads_count = (int)count;
+  }
+  for (long i = 0; i < count; i++) {
+    set_without_gvl(jobs[i].state, 1);
+  }
+  ParseBatch batch = { jobs, count, threads_count, 0 };
+  rb_thread_call_without_gvl(run_parse_batch, &batch, NULL, NULL);
+  for (long i = 0; i < count; i++) {
+    set_without_gvl(jobs[i].state, 0);
+  }
+}
+
+static VALUE run_parse_with_gvl(VALUE job_ptr) {
+  GraphQLParseJob *job = (GraphQLParseJob *)job_ptr;
+  yyparse(job->parser, job->state);
+  return Qnil;
+}
+
+static VALUE free_parse_stack(VALUE stack_ptr) {
+  free_parser_stack((GraphQLParserStack *)stack_ptr);
+  return Qnil;
+}
+
+// Errors are raised from inside `yyparse`, so its stack is freed by `rb_ensure`
+void parse_with_gvl(VALUE parser, GraphQLParser *state) {
+  GraphQLParserStack stack = { NULL, NULL, 0 };
+  GraphQLParseJob job = { parser, state };
+  state->stack = &stack;
+  rb_ensure(run_parse_with_gvl, (VALUE)&job, free_parse_stack, (VALUE)&stack);
+  state->stack = NULL;
+}
+
+void parse_without_gvl(VALUE parser, GraphQLParser *state) {
+  GraphQLParseJob job = { parser, state };
+  parse_many_without_gvl(&job, 1, 1);
+  raise_deferred_parse_error(parser, state);
+}
+
+static void parser_mark(void *ptr) {
+  GraphQLParser *state = ptr;
+  rb_gc_mark(state->query_string);
+  rb_gc_mark(state->filename);
+  rb_gc_mark(state->token_stream);
+  rb_gc_mark(state->document);
+  rb_gc_mark(state->result);
+}
+
+static size_t parser_memsize(const void *ptr) {
+  return sizeof(GraphQLParser);
+}
+
+static const rb_data_type_t parser_data_type = {
+  "GraphQL::CParser::Parser",
+  { parser_mark, RUBY_TYPED_DEFAULT_FREE, parser_memsize, },
+  0, 0, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE parser_alloc(VALUE parser_class) {
+  GraphQLParser *state;
+  VALUE parser = TypedData_Make_Struct(parser_class, GraphQLParser, &parser_data_type, state);
+  state->query_string = Qnil;
+  state->filename = Qnil;
+  state->token_stream = Qnil;
+  state->lexer = NULL;
+  state->result = Qnil;
+  state->without_gvl = 0;
+  state->max_depth = -1;
+  state->max_aliases = -1;
+  state->max_fields = -1;
+  state->max_nesting = -1;
+  state->stack = NULL;
+  return parser;
+}
+
+GraphQLParser *get_parser(VALUE parser) {
+  GraphQLParser *state;
+  TypedData_Get_Struct(parser, GraphQLParser, &parser_data_type, state);
+  return state;
+}
+
+void initialize_parser_class(VALUE parser_class) {
+  rb_define_alloc_func(parser_class, parser_alloc);
 
   rb_global_variable(&r_string_query);
   r_string_query = rb_str_new_cstr("query");
   rb_str_freeze(r_string_query);
+}
+
+static GraphQLAstValue make_ast_list(GraphQLDocument *doc, GraphQLAstValue first_value) {
+  GraphQLAstValue list = ast_list_new(doc);
+  ast_list_push(doc, list, first_value);
+  return list;
+}
 
-  INITIALIZE_NODE_CLASS_VARIABLE(Argument)
-  INITIALIZE_NODE_CLASS_VARIABLE(Directive)
-  INITIALIZE_NODE_CLASS_VARIABLE(Document)
-  INITIALIZE_NODE_CLASS_VARIABLE(Enum)
-  INITIALIZE_NODE_CLASS_VARIABLE(Field)
-  INITIALIZE_NODE_CLASS_VARIABLE(FragmentDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(FragmentSpread)
-  INITIALIZE_NODE_CLASS_VARIABLE(InlineFragment)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObject)
-  INITIALIZE_NODE_CLASS_VARIABLE(ListType)
-  INITIALIZE_NODE_CLASS_VARIABLE(NonNullType)
-  INITIALIZE_NODE_CLASS_VARIABLE(NullValue)
-  INITIALIZE_NODE_CLASS_VARIABLE(OperationDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(TypeName)
-  INITIALIZE_NODE_CLASS_VARIABLE(VariableDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(VariableIdentifier)
-
-  INITIALIZE_NODE_CLASS_VARIABLE(ScalarTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(ObjectTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InterfaceTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(UnionTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObjectTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumValueDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(DirectiveDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(DirectiveLocation)
-  INITIALIZE_NODE_CLASS_VARIABLE(FieldDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputValueDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(SchemaDefinition)
-
-  INITIALIZE_NODE_CLASS_VARIABLE(ScalarTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(ObjectTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(InterfaceTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(UnionTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObjectTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(SchemaExtension)
+// Like merging hashes: a later `query: ...` replaces an earlier one.
+static void set_operation_types(GraphQLAstValue operation_types, GraphQLAstValue other_operation_types) {
+  for (int i = 0; i < 3; i++) {
+    if (other_operation_types.as.node->values[i].type != AST_VALUE_NIL) {
+      operation_types.as.node->values[i] = other_operation_types.as.node->values[i];
+    }
+  }
 }
@@ -1,5 +1,61 @@
 #ifndef Graphql_parser_h
 #define Graphql_parser_h
-int yyparse(VALUE parser, VALUE filename);
-void initialize_node_class_variables();
+#include <ruby.h>
+#include "lexer.h"
+#include "ast.h"
+
+// Bison's state and value stacks, after they outgrow the arrays in `yyparse`'s frame, see `grow_parser_stack`.
+// They're allocated with `malloc`, so that they can grow without the GVL. Each thread which parses has one, for all its parses.
+typedef struct GraphQLParserStack {
+  void *states;
+  void *values;
+  long capacity; // In entries of each stack
+} GraphQLParserStack;
+
+// The state of one parse, owned by a `GraphQL::CParser::Parser`
+typedef struct GraphQLParser {
+  VALUE query_string;
+  VALUE filename;
+  VALUE token_stream;
+  GraphQLLexer *lexer; // `token_stream`'s lexer, cached for `yylex`
+  VALUE document; // The `GraphQL::CParser::Document` whose arena holds the AST while parsing
+  GraphQLDocument *ast;
+  VALUE result;
+  // If set, `yyparse` doesn't touch Ruby objects, and errors are raised afterward by `raise_deferred_parse_error`
+  int without_gvl;
+  int bad_unicode;
+  char error_message[256];
+  // From `max_depth:`, `max_aliases:` and `max_fields:`, or -1 for no limit. They're checked against `ast->stats` as rules reduce.
+  long max_depth;
+  long max_aliases;
+  long max_fields;
+  // Where a limit was exceeded, for `raise_deferred_parse_error`. `error_message` has the message,
+  // and its line and column are found from `limit_offset` when it's raised, see `error_location`.
+  int limit_exceeded;
+  long limit_offset;
+  int limit_location_in_message;
+  // `{`, `[` and `(` which haven't been closed yet, checked against `max_nesting` (or -1 for no limit) as each one is lexed
+  long nesting;
+  long max_nesting;
+  // The stack of the thread which is running this parse, see `parse_with_gvl` and `run_parse_jobs`
+  GraphQLParserStack *stack;
+} GraphQLParser;
+
+// A document to parse without the GVL
+typedef struct GraphQLParseJob {
+  VALUE parser;
+  GraphQLParser *state;
+} GraphQLParseJob;
+
+#define MAX_PARSE_THREADS 64
+// Bison's stacks start in `yyparse`'s frame, then move to the heap
+#define PARSE_THREAD_STACK_SIZE (512 * 1024)
+
+int yyparse(VALUE parser, GraphQLParser *state);
+void parse_with_gvl(VALUE parser, GraphQLParser *state);
+void parse_without_gvl(VALUE parser, GraphQLParser *state);
+void parse_many_without_gvl(GraphQLParseJob *jobs, long count, int threads_count);
+void raise_deferred_parse_error(VALUE parser, GraphQLParser *state);
+GraphQLParser *get_parser(VALUE parser);
+void initialize_parser_class(VALUE parser_class);
 #endif
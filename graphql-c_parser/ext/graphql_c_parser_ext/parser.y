@@ -5,123 +5,134 @@
 %{
 // C Declarations
 #include <ruby.h>
-#define YYSTYPE VALUE
-#define YYSTACK_USE_ALLOCA 1
+#include <ruby/thread.h>
+#include <ruby/atomic.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+#include "parser.h"
+
+// When Bison's stacks are full, move them to `state->stack`, see `grow_parser_stack`.
+// Bison checks that `capacity` grew, and stops parsing if it didn't.
+#define yyoverflow(message, states, states_bytesize, values, values_bytesize, capacity) do { \
+    void *grown_states = *(states); \
+    void *grown_values = *(values); \
+    long grown_capacity = (long)*(capacity); \
+    if (grow_parser_stack(parser, state, &grown_states, (states_bytesize), &grown_values, (values_bytesize), &grown_capacity)) { \
+      *(states) = grown_states; \
+      *(values) = grown_values; \
+      *(capacity) = grown_capacity; \
+    } \
+  } while (0)
 
-int yylex(YYSTYPE *, VALUE, VALUE);
-void yyerror(VALUE, VALUE, const char*);
-
-static VALUE GraphQL_Language_Nodes_NONE;
 static VALUE r_string_query;
 
-#define MAKE_AST_NODE(node_class_name, nargs, ...) rb_funcall(GraphQL_Language_Nodes_##node_class_name, rb_intern("from_a"), nargs + 1, filename,__VA_ARGS__)
-
-#define SETUP_NODE_CLASS_VARIABLE(node_class_name) static VALUE GraphQL_Language_Nodes_##node_class_name;
-
-SETUP_NODE_CLASS_VARIABLE(Argument)
-SETUP_NODE_CLASS_VARIABLE(Directive)
-SETUP_NODE_CLASS_VARIABLE(Document)
-SETUP_NODE_CLASS_VARIABLE(Enum)
-SETUP_NODE_CLASS_VARIABLE(Field)
-SETUP_NODE_CLASS_VARIABLE(FragmentDefinition)
-SETUP_NODE_CLASS_VARIABLE(FragmentSpread)
-SETUP_NODE_CLASS_VARIABLE(InlineFragment)
-SETUP_NODE_CLASS_VARIABLE(InputObject)
-SETUP_NODE_CLASS_VARIABLE(ListType)
-SETUP_NODE_CLASS_VARIABLE(NonNullType)
-SETUP_NODE_CLASS_VARIABLE(NullValue)
-SETUP_NODE_CLASS_VARIABLE(OperationDefinition)
-SETUP_NODE_CLASS_VARIABLE(TypeName)
-SETUP_NODE_CLASS_VARIABLE(VariableDefinition)
-SETUP_NODE_CLASS_VARIABLE(VariableIdentifier)
-
-SETUP_NODE_CLASS_VARIABLE(ScalarTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(ObjectTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(InterfaceTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(UnionTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(EnumTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(InputObjectTypeDefinition)
-SETUP_NODE_CLASS_VARIABLE(EnumValueDefinition)
-SETUP_NODE_CLASS_VARIABLE(DirectiveDefinition)
-SETUP_NODE_CLASS_VARIABLE(DirectiveLocation)
-SETUP_NODE_CLASS_VARIABLE(FieldDefinition)
-SETUP_NODE_CLASS_VARIABLE(InputValueDefinition)
-SETUP_NODE_CLASS_VARIABLE(SchemaDefinition)
-
-SETUP_NODE_CLASS_VARIABLE(ScalarTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(ObjectTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(InterfaceTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(UnionTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(EnumTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(InputObjectTypeExtension)
-SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
+// Takes the node's byte offset in the source, then the arguments to `.from_a` after `filename`, `line` and `col`,
+// and adds a node to the document's arena, see ast.c. Lines and columns are found from the offset when they're read.
+#define MAKE_AST_NODE(node_class_name, nargs, pos, ...) AST_NODE_VALUE(ast_node_new(state->ast, AST_##node_class_name, pos, nargs, __VA_ARGS__))
+// A token's content is read from the source string when the node is made, see `materialize_value`
+#define TOKEN_VALUE(token) ast_token_value(state->ast, token.type, token.byte_offset, token.byte_length, token.value)
+// The `#` comments before a token, or nil, see `comment_content`
+#define COMMENT_VALUE(token) ast_comment_value(token.comment_offset, token.comment_length)
+#define NUMBER_VALUE(value_type, token) ast_number_value(state->ast, value_type, token.type, token.byte_offset, token.byte_length)
+#define MAKE_AST_LIST(first_value) make_ast_list(state->ast, first_value)
+#define AST_LIST_PUSH(list, value) ast_list_push(state->ast, list, value)
+
+// Count a rule for `Document#parse_stats`. If the document is over one of `Parser.new`'s limits, stop parsing.
+#define ENTER_SELECTION_SET(token) if (enter_selection_set(state, token)) { YYABORT; }
+#define COUNT_FIELD(token, aliased) if (count_field(state, token, aliased)) { YYABORT; }
+
+static GraphQLAstValue make_ast_list(GraphQLDocument *doc, GraphQLAstValue first_value);
+static int enter_selection_set(GraphQLParser *state, GraphQLToken token);
+static int count_field(GraphQLParser *state, GraphQLToken token, int aliased);
+static int enter_nesting(GraphQLParser *state, GraphQLToken token);
+static int grow_parser_stack(VALUE parser, GraphQLParser *state, void **states, long states_bytesize, void **values, long values_bytesize, long *capacity);
+static void set_operation_types(GraphQLAstValue operation_types, GraphQLAstValue other_operation_types);
 %}
 
 %param {VALUE parser}
-%param {VALUE filename}
+%param {GraphQLParser *state}
+
+%union {
+  GraphQLAstValue node;
+  GraphQLToken token;
+}
+
+%code {
+int yylex(YYSTYPE *, VALUE, GraphQLParser *);
+void yyerror(VALUE, GraphQLParser *, const char*);
+}
 
 // YACC Declarations
-%token AMP 200
-%token BANG 201
-%token COLON 202
-%token DIRECTIVE 203
-%token DIR_SIGN 204
-%token ENUM 205
-%token ELLIPSIS 206
-%token EQUALS 207
-%token EXTEND 208
-%token FALSE_LITERAL 209
-%token FLOAT 210
-%token FRAGMENT 211
-%token IDENTIFIER 212
-%token INPUT 213
-%token IMPLEMENTS 214
-%token INT 215
-%token INTERFACE 216
-%token LBRACKET 217
-%token LCURLY 218
-%token LPAREN 219
-%token MUTATION 220
-%token NULL_LITERAL 221
-%token ON 222
-%token PIPE 223
-%token QUERY 224
-%token RBRACKET 225
-%token RCURLY 226
-%token REPEATABLE 227
-%token RPAREN 228
-%token SCALAR 229
-%token SCHEMA 230
-%token STRING 231
-%token SUBSCRIPTION 232
-%token TRUE_LITERAL 233
-%token TYPE_LITERAL 234
-%token UNION 235
-%token VAR_SIGN 236
-
-%type NamedTypeForCondition
+%token <token> AMP 200
+%token <token> BANG 201
+%token <token> COLON 202
+%token <token> DIRECTIVE 203
+%token <token> DIR_SIGN 204
+%token <token> ENUM 205
+%token <token> ELLIPSIS 206
+%token <token> EQUALS 207
+%token <token> EXTEND 208
+%token <token> FALSE_LITERAL 209
+%token <token> FLOAT 210
+%token <token> FRAGMENT 211
+%token <token> IDENTIFIER 212
+%token <token> INPUT 213
+%token <token> IMPLEMENTS 214
+%token <token> INT 215
+%token <token> INTERFACE 216
+%token <token> LBRACKET 217
+%token <token> LCURLY 218
+%token <token> LPAREN 219
+%token <token> MUTATION 220
+%token <token> NULL_LITERAL 221
+%token <token> ON 222
+%token <token> PIPE 223
+%token <token> QUERY 224
+%token <token> RBRACKET 225
+%token <token> RCURLY 226
+%token <token> REPEATABLE 227
+%token <token> RPAREN 228
+%token <token> SCALAR 229
+%token <token> SCHEMA 230
+%token <token> STRING 231
+%token <token> SUBSCRIPTION 232
+%token <token> TRUE_LITERAL 233
+%token <token> TYPE_LITERAL 234
+%token <token> UNION 235
+%token <token> VAR_SIGN 236
+
+%type <token> name name_without_on operation_type schema_keyword enum_name description
+%type <node> document definitions_list definition executable_definition operation_definition
+%type <node> operation_name_opt variable_definitions_opt variable_definitions_list variable_definition default_value_opt
+%type <node> selection_list selection selection_set selection_set_opt field arguments_opt arguments_list argument
+%type <node> literal_value input_value null_value variable list_value list_value_list enum_value
+%type <node> object_value object_value_list_opt object_value_list object_value_field
+%type <node> object_literal_value object_literal_value_list_opt object_literal_value_list object_literal_value_field
+%type <node> directives_list_opt directives_list directive fragment_spread inline_fragment fragment_definition fragment_name_opt
+%type <node> type nullable_type NamedTypeForCondition
+%type <node> type_system_definition schema_definition operation_type_definition_list_opt operation_type_definition_list operation_type_definition
+%type <node> type_definition description_opt scalar_type_definition object_type_definition implements_opt interfaces_list legacy_interfaces_list
+%type <node> input_value_definition input_value_definition_list arguments_definitions_opt
+%type <node> field_definition field_definition_list_opt field_definition_list interface_type_definition pipe_opt union_members
+%type <node> union_type_definition enum_type_definition enum_value_definition enum_value_definitions input_object_type_definition
+%type <node> directive_definition directive_repeatable_opt directive_locations
+%type <node> type_system_extension schema_extension type_extension scalar_type_extension object_type_extension interface_type_extension
+%type <node> union_type_extension enum_type_extension input_object_type_extension
 
 %%
 
   // YACC Rules
-  start: document { rb_ivar_set(parser, rb_intern("@result"), $1); }
+  start: document { state->ast->root = $1; }
 
   document: definitions_list {
-    VALUE position_source = rb_ary_entry($1, 0);
-    VALUE line, col;
-    if (RB_TEST(position_source)) {
-      line = rb_funcall(position_source, rb_intern("line"), 0);
-      col = rb_funcall(position_source, rb_intern("col"), 0);
-    } else {
-      line = INT2FIX(1);
-      col = INT2FIX(1);
-    }
-    $$ = MAKE_AST_NODE(Document, 3, line, col, $1);
+    GraphQLAstNode *position_source = $1.as.list->first->value.as.node;
+    $$ = MAKE_AST_NODE(Document, 1, position_source->pos, $1);
   }
 
   definitions_list:
-      definition                  { $$ = rb_ary_new_from_args(1, $1); }
-    | definitions_list definition { rb_ary_push($$, $2); }
+      definition                  { $$ = MAKE_AST_LIST($1); }
+    | definitions_list definition { AST_LIST_PUSH($$, $2); }
 
   definition:
       executable_definition
@@ -134,36 +145,34 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
 
   operation_definition:
       operation_type operation_name_opt variable_definitions_opt directives_list_opt selection_set {
-        $$ = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3),
-          (RB_TEST($2) ? rb_ary_entry($2, 3) : Qnil),
+        $$ = MAKE_AST_NODE(OperationDefinition, 5,
+          $1.byte_offset,
+          TOKEN_VALUE($1),
+          $2,
           $3,
           $4,
           $5
         );
       }
-    | LCURLY selection_list RCURLY {
-        $$ = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          r_string_query,
-          Qnil,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE,
-          $2
+    | LCURLY { ENTER_SELECTION_SET($1); } selection_list RCURLY {
+        state->ast->stats.depth--;
+        $$ = MAKE_AST_NODE(OperationDefinition, 5,
+          $1.byte_offset,
+          ast_static_value(r_string_query),
+          AST_NIL,
+          AST_NONE,
+          AST_NONE,
+          $3
         );
       }
     | LCURLY RCURLY {
-        $$ = MAKE_AST_NODE(OperationDefinition, 7,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          r_string_query,
-          Qnil,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE,
-          GraphQL_Language_Nodes_NONE
+        $$ = MAKE_AST_NODE(OperationDefinition, 5,
+          $1.byte_offset,
+          ast_static_value(r_string_query),
+          AST_NIL,
+          AST_NONE,
+          AST_NONE,
+          AST_NONE
         );
       }
 
@@ -173,23 +182,22 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     | SUBSCRIPTION
 
   operation_name_opt:
-      /* none */ { $$ = Qnil; }
-    | name
+      /* none */ { $$ = AST_NIL; }
+    | name { $$ = TOKEN_VALUE($1); }
 
   variable_definitions_opt:
-      /* none */                              { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */                              { $$ = AST_NONE; }
     | LPAREN variable_definitions_list RPAREN { $$ = $2; }
 
   variable_definitions_list:
-      variable_definition                           { $$ = rb_ary_new_from_args(1, $1); }
-    | variable_definitions_list variable_definition { rb_ary_push($$, $2); }
+      variable_definition                           { $$ = MAKE_AST_LIST($1); }
+    | variable_definitions_list variable_definition { AST_LIST_PUSH($$, $2); }
 
   variable_definition:
       VAR_SIGN name COLON type default_value_opt directives_list_opt {
-        $$ = MAKE_AST_NODE(VariableDefinition, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($2, 3),
+        $$ = MAKE_AST_NODE(VariableDefinition, 4,
+          $1.byte_offset,
+          TOKEN_VALUE($2),
           $4,
           $5,
           $6
@@ -197,12 +205,12 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
       }
 
   default_value_opt:
-      /* none */            { $$ = Qnil; }
+      /* none */            { $$ = AST_NIL; }
     | EQUALS literal_value  { $$ = $2; }
 
   selection_list:
-      selection                 { $$ = rb_ary_new_from_args(1, $1); }
-    | selection_list selection  { rb_ary_push($$, $2); }
+      selection                 { $$ = MAKE_AST_LIST($1); }
+    | selection_list selection  { AST_LIST_PUSH($$, $2); }
 
   selection:
       field
@@ -210,30 +218,33 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     | inline_fragment
 
   selection_set:
-      LCURLY selection_list RCURLY { $$ = $2; }
+      LCURLY { ENTER_SELECTION_SET($1); } selection_list RCURLY {
+        state->ast->stats.depth--;
+        $$ = $3;
+      }
 
   selection_set_opt:
-      /* none */    { $$ = rb_ary_new(); }
+      /* none */    { $$ = ast_list_new(state->ast); }
     | selection_set
 
   field:
     name COLON name arguments_opt directives_list_opt selection_set_opt {
-      $$ = MAKE_AST_NODE(Field, 7,
-        rb_ary_entry($1, 1),
-        rb_ary_entry($1, 2),
-        rb_ary_entry($1, 3), // alias
-        rb_ary_entry($3, 3), // name
+      COUNT_FIELD($1, 1);
+      $$ = MAKE_AST_NODE(Field, 5,
+        $1.byte_offset,
+        TOKEN_VALUE($1), // alias
+        TOKEN_VALUE($3), // name
         $4, // args
         $5, // directives
         $6 // subselections
       );
     }
     | name arguments_opt directives_list_opt selection_set_opt {
-      $$ = MAKE_AST_NODE(Field, 7,
-        rb_ary_entry($1, 1),
-        rb_ary_entry($1, 2),
-        Qnil, // alias
-        rb_ary_entry($1, 3), // name
+      COUNT_FIELD($1, 0);
+      $$ = MAKE_AST_NODE(Field, 5,
+        $1.byte_offset,
+        AST_NIL, // alias
+        TOKEN_VALUE($1), // name
         $2, // args
         $3, // directives
         $4 // subselections
@@ -241,29 +252,28 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     }
 
   arguments_opt:
-      /* none */                    { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */                    { $$ = AST_NONE; }
     | LPAREN arguments_list RPAREN  { $$ = $2; }
 
   arguments_list:
-      argument                { $$ = rb_ary_new_from_args(1, $1); }
-    | arguments_list argument { rb_ary_push($$, $2); }
+      argument                { $$ = MAKE_AST_LIST($1); }
+    | arguments_list argument { AST_LIST_PUSH($$, $2); }
 
   argument:
       name COLON input_value {
-        $$ = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3),
+        $$ = MAKE_AST_NODE(Argument, 2,
+          $1.byte_offset,
+          TOKEN_VALUE($1),
           $3
         );
       }
 
   literal_value:
-      FLOAT       { $$ = rb_funcall(rb_ary_entry($1, 3), rb_intern("to_f"), 0); }
-    | INT         { $$ = rb_funcall(rb_ary_entry($1, 3), rb_intern("to_i"), 0); }
-    | STRING      { $$ = rb_ary_entry($1, 3); }
-    | TRUE_LITERAL        { $$ = Qtrue; }
-    | FALSE_LITERAL       { $$ = Qfalse; }
+      FLOAT       { $$ = NUMBER_VALUE(AST_VALUE_FLOAT, $1); }
+    | INT         { $$ = NUMBER_VALUE(AST_VALUE_INT, $1); }
+    | STRING      { $$ = TOKEN_VALUE($1); }
+    | TRUE_LITERAL        { $$ = AST_TRUE; }
+    | FALSE_LITERAL       { $$ = AST_FALSE; }
     | null_value
     | enum_value
     | list_value
@@ -275,28 +285,31 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     | object_value
 
   null_value: NULL_LITERAL {
-    $$ = MAKE_AST_NODE(NullValue, 3,
-      rb_ary_entry($1, 1),
-      rb_ary_entry($1, 2),
-      rb_ary_entry($1, 3)
+    $$ = MAKE_AST_NODE(NullValue, 1,
+      $1.byte_offset,
+      TOKEN_VALUE($1)
     );
   }
 
   variable: VAR_SIGN name {
-    $$ = MAKE_AST_NODE(VariableIdentifier, 3,
-      rb_ary_entry($1, 1),
-      rb_ary_entry($1, 2),
-      rb_ary_entry($2, 3)
+    $$ = MAKE_AST_NODE(VariableIdentifier, 1,
+      $1.byte_offset,
+      TOKEN_VALUE($2)
     );
   }
 
   list_value:
-      LBRACKET RBRACKET                 { $$ = GraphQL_Language_Nodes_NONE; }
-    | LBRACKET list_value_list RBRACKET { $$ = $2; }
+      LBRACKET RBRACKET                 { $$ = AST_NONE; }
+    | LBRACKET list_value_list RBRACKET {
+        if ($2.as.list->length > state->ast->stats.max_list_size) {
+          state->ast->stats.max_list_size = $2.as.list->length;
+        }
+        $$ = $2;
+      }
 
   list_value_list:
-      input_value                 { $$ = rb_ary_new_from_args(1, $1); }
-    | list_value_list input_value { rb_ary_push($$, $2); }
+      input_value                 { $$ = MAKE_AST_LIST($1); }
+    | list_value_list input_value { AST_LIST_PUSH($$, $2); }
 
   enum_name: /* any identifier, but not "true", "false" or "null" */
       IDENTIFIER
@@ -305,36 +318,33 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     | schema_keyword
 
   enum_value: enum_name {
-    $$ = MAKE_AST_NODE(Enum, 3,
-      rb_ary_entry($1, 1),
-      rb_ary_entry($1, 2),
-      rb_ary_entry($1, 3)
+    $$ = MAKE_AST_NODE(Enum, 1,
+      $1.byte_offset,
+      TOKEN_VALUE($1)
     );
   }
 
   object_value:
     LCURLY object_value_list_opt RCURLY {
-      $$ = MAKE_AST_NODE(InputObject, 3,
-        rb_ary_entry($1, 1),
-        rb_ary_entry($1, 2),
+      $$ = MAKE_AST_NODE(InputObject, 1,
+        $1.byte_offset,
         $2
       );
     }
 
   object_value_list_opt:
-      /* nothing */     { $$ = GraphQL_Language_Nodes_NONE; }
+      /* nothing */     { $$ = AST_NONE; }
     | object_value_list
 
   object_value_list:
-      object_value_field                    { $$ = rb_ary_new_from_args(1, $1); }
-    | object_value_list object_value_field  { rb_ary_push($$, $2); }
+      object_value_field                    { $$ = MAKE_AST_LIST($1); }
+    | object_value_list object_value_field  { AST_LIST_PUSH($$, $2); }
 
   object_value_field:
       name COLON input_value {
-        $$ = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3),
+        $$ = MAKE_AST_NODE(Argument, 2,
+          $1.byte_offset,
+          TOKEN_VALUE($1),
           $3
         );
       }
@@ -342,45 +352,43 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
   /* like the previous, but with literals only: */
   object_literal_value:
       LCURLY object_literal_value_list_opt RCURLY {
-        $$ = MAKE_AST_NODE(InputObject, 3,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
+        $$ = MAKE_AST_NODE(InputObject, 1,
+          $1.byte_offset,
           $2
         );
       }
 
   object_literal_value_list_opt:
-      /* nothing */             { $$ = GraphQL_Language_Nodes_NONE; }
+      /* nothing */             { $$ = AST_NONE; }
     | object_literal_value_list
 
   object_literal_value_list:
-      object_literal_value_field                            { $$ = rb_ary_new_from_args(1, $1); }
-    | object_literal_value_list object_literal_value_field  { rb_ary_push($$, $2); }
+      object_literal_value_field                            { $$ = MAKE_AST_LIST($1); }
+    | object_literal_value_list object_literal_value_field  { AST_LIST_PUSH($$, $2); }
 
   object_literal_value_field:
       name COLON literal_value {
-        $$ = MAKE_AST_NODE(Argument, 4,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3),
+        $$ = MAKE_AST_NODE(Argument, 2,
+          $1.byte_offset,
+          TOKEN_VALUE($1),
           $3
         );
       }
 
 
   directives_list_opt:
-      /* none */      { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */      { $$ = AST_NONE; }
     | directives_list
 
   directives_list:
-      directive                 { $$ = rb_ary_new_from_args(1, $1); }
-    | directives_list directive { rb_ary_push($$, $2); }
+      directive                 { $$ = MAKE_AST_LIST($1); }
+    | directives_list directive { AST_LIST_PUSH($$, $2); }
 
   directive: DIR_SIGN name arguments_opt {
-    $$ = MAKE_AST_NODE(Directive, 4,
-      rb_ary_entry($1, 1),
-      rb_ary_entry($1, 2),
-      rb_ary_entry($2, 3),
+    state->ast->stats.directives++;
+    $$ = MAKE_AST_NODE(Directive, 2,
+      $1.byte_offset,
+      TOKEN_VALUE($2),
       $3
     );
   }
@@ -414,29 +422,27 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
 
   fragment_spread:
       ELLIPSIS name_without_on directives_list_opt {
-        $$ = MAKE_AST_NODE(FragmentSpread, 4,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($2, 3),
+        state->ast->stats.fragment_spreads++;
+        $$ = MAKE_AST_NODE(FragmentSpread, 2,
+          $1.byte_offset,
+          TOKEN_VALUE($2),
           $3
         );
       }
 
   inline_fragment:
       ELLIPSIS ON NamedTypeForCondition directives_list_opt selection_set {
-        $$ = MAKE_AST_NODE(InlineFragment, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
+        $$ = MAKE_AST_NODE(InlineFragment, 3,
+          $1.byte_offset,
           $3,
           $4,
           $5
         );
       }
     | ELLIPSIS directives_list_opt selection_set {
-        $$ = MAKE_AST_NODE(InlineFragment, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          Qnil,
+        $$ = MAKE_AST_NODE(InlineFragment, 3,
+          $1.byte_offset,
+          AST_NIL,
           $2,
           $3
         );
@@ -444,9 +450,8 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
 
   fragment_definition:
     FRAGMENT fragment_name_opt ON NamedTypeForCondition directives_list_opt selection_set {
-      $$ = MAKE_AST_NODE(FragmentDefinition, 6,
-        rb_ary_entry($1, 1),
-        rb_ary_entry($1, 2),
+      $$ = MAKE_AST_NODE(FragmentDefinition, 4,
+        $1.byte_offset,
         $2,
         $4,
         $5,
@@ -455,25 +460,23 @@ SETUP_NODE_CLASS_VARIABLE(SchemaExtension)
     }
 
   fragment_name_opt:
-      /* none */ { $$ = Qnil; }
-    | name_without_on { $$ = rb_ary_entry($1, 3); }
+      /* none */ { $$ = AST_NIL; }
+    | name_without_on { $$ = TOKEN_VALUE($1); }
 
   type:
       nullable_type
-    | nullable_type BANG      { $$ = MAKE_AST_NODE(NonNullType, 3, rb_funcall($1, rb_intern("line"), 0), rb_funcall($1, rb_intern("col"), 0), $1); }
+    | nullable_type BANG      { $$ = MAKE_AST_NODE(NonNullType, 1, $1.as.node->pos, $1); }
 
   nullable_type:
       name                   {
-        $$ = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3)
+        $$ = MAKE_AST_NODE(TypeName, 1,
+          $1.byte_offset,
+          TOKEN_VALUE($1)
         );
       }
     | LBRACKET type RBRACKET {
-        $$ = MAKE_AST_NODE(ListType, 3,
-          rb_funcall($2, rb_intern("line"), 0),
-          rb_funcall($2, rb_intern("col"), 0),
+        $$ = MAKE_AST_NODE(ListType, 1,
+          $2.as.node->pos,
           $2
         );
       }
@@ -485,33 +488,30 @@ type_system_definition:
 
   schema_definition:
       SCHEMA directives_list_opt operation_type_definition_list_opt {
-        $$ = MAKE_AST_NODE(SchemaDefinition, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          // TODO use static strings:
-          rb_hash_aref($3, rb_str_new_cstr("query")),
-          rb_hash_aref($3, rb_str_new_cstr("mutation")),
-          rb_hash_aref($3, rb_str_new_cstr("subscription")),
+        $$ = MAKE_AST_NODE(SchemaDefinition, 4,
+          $1.byte_offset,
+          $3.as.node->values[0], // query
+          $3.as.node->values[1], // mutation
+          $3.as.node->values[2], // subscription
           $2
         );
       }
 
   operation_type_definition_list_opt:
-      /* none */ { $$ = rb_hash_new(); }
+      /* none */ { $$ = AST_NODE_VALUE(ast_node_new(state->ast, AST_OperationTypes, 0, 3, AST_NIL, AST_NIL, AST_NIL)); }
     | LCURLY operation_type_definition_list RCURLY { $$ = $2; }
 
   operation_type_definition_list:
-      operation_type_definition {
-        $$ = rb_hash_new();
-        rb_hash_aset($$, rb_ary_entry($1, 0), rb_ary_entry($1, 1));
-      }
+      operation_type_definition
     | operation_type_definition_list operation_type_definition {
-      rb_hash_aset($$, rb_ary_entry($2, 0), rb_ary_entry($2, 1));
+      set_operation_types($$, $2);
     }
 
   operation_type_definition:
       operation_type COLON name {
-        $$ = rb_ary_new_from_args(2, rb_ary_entry($1, 3), rb_ary_entry($3, 3));
+        $$ = AST_NODE_VALUE(ast_node_new(state->ast, AST_OperationTypes, $1.byte_offset, 3, AST_NIL, AST_NIL, AST_NIL));
+        int operation_index = $1.type == QUERY ? 0 : ($1.type == MUTATION ? 1 : 2);
+        $$.as.node->values[operation_index] = TOKEN_VALUE($3);
       }
 
   type_definition:
@@ -525,220 +525,207 @@ type_system_definition:
   description: STRING
 
   description_opt:
-      /* none */      { $$ = Qnil; }
-    | description
+      /* none */      { $$ = AST_NIL; }
+    | description     { $$ = TOKEN_VALUE($1); }
 
   scalar_type_definition:
       description_opt SCALAR name directives_list_opt {
-        $$ = MAKE_AST_NODE(ScalarTypeDefinition, 5,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
-          $4
+        $$ = MAKE_AST_NODE(ScalarTypeDefinition, 4,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
+          $1,
+          $4,
+          COMMENT_VALUE($2)
         );
       }
 
   object_type_definition:
       description_opt TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt {
-        $$ = MAKE_AST_NODE(ObjectTypeDefinition, 7,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(ObjectTypeDefinition, 6,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
           $4, // implements
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+          $1,
           $5,
-          $6
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   implements_opt:
-      /* none */ { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */ { $$ = AST_NONE; }
     | IMPLEMENTS AMP interfaces_list { $$ = $3; }
     | IMPLEMENTS interfaces_list { $$ = $2; }
     | IMPLEMENTS legacy_interfaces_list { $$ = $2; }
 
   interfaces_list:
       name {
-        VALUE new_name = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3)
+        GraphQLAstValue new_name = MAKE_AST_NODE(TypeName, 1,
+          $1.byte_offset,
+          TOKEN_VALUE($1)
         );
-        $$ = rb_ary_new_from_args(1, new_name);
+        $$ = MAKE_AST_LIST(new_name);
       }
     | interfaces_list AMP name {
-      VALUE new_name =  MAKE_AST_NODE(TypeName, 3, rb_ary_entry($3, 1), rb_ary_entry($3, 2), rb_ary_entry($3, 3));
-      rb_ary_push($$, new_name);
+      GraphQLAstValue new_name =  MAKE_AST_NODE(TypeName, 1, $3.byte_offset, TOKEN_VALUE($3));
+      AST_LIST_PUSH($$, new_name);
     }
 
   legacy_interfaces_list:
       name {
-        VALUE new_name = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($1, 3)
+        GraphQLAstValue new_name = MAKE_AST_NODE(TypeName, 1,
+          $1.byte_offset,
+          TOKEN_VALUE($1)
         );
-        $$ = rb_ary_new_from_args(1, new_name);
+        $$ = MAKE_AST_LIST(new_name);
       }
     | legacy_interfaces_list name {
-      rb_ary_push($$, MAKE_AST_NODE(TypeName, 3, rb_ary_entry($2, 1), rb_ary_entry($2, 2), rb_ary_entry($2, 3)));
+      AST_LIST_PUSH($$, MAKE_AST_NODE(TypeName, 1, $2.byte_offset, TOKEN_VALUE($2)));
     }
 
   input_value_definition:
       description_opt name COLON type default_value_opt directives_list_opt {
-        $$ = MAKE_AST_NODE(InputValueDefinition, 7,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($2, 3),
+        $$ = MAKE_AST_NODE(InputValueDefinition, 6,
+          $2.byte_offset,
+          TOKEN_VALUE($2),
           $4,
           $5,
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
-          $6
+          $1,
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   input_value_definition_list:
-      input_value_definition                             { $$ = rb_ary_new_from_args(1, $1); }
-    | input_value_definition_list input_value_definition { rb_ary_push($$, $2); }
+      input_value_definition                             { $$ = MAKE_AST_LIST($1); }
+    | input_value_definition_list input_value_definition { AST_LIST_PUSH($$, $2); }
 
   arguments_definitions_opt:
-      /* none */                                { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */                                { $$ = AST_NONE; }
     | LPAREN input_value_definition_list RPAREN { $$ = $2; }
 
   field_definition:
       description_opt name arguments_definitions_opt COLON type directives_list_opt {
-        $$ = MAKE_AST_NODE(FieldDefinition, 7,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($2, 3),
+        $$ = MAKE_AST_NODE(FieldDefinition, 6,
+          $2.byte_offset,
+          TOKEN_VALUE($2),
           $5,
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+          $1,
           $3,
-          $6
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   field_definition_list_opt:
-    /* none */ { $$ = GraphQL_Language_Nodes_NONE; }
+    /* none */ { $$ = AST_NONE; }
     | LCURLY field_definition_list RCURLY { $$ = $2; }
 
   field_definition_list:
-    /* none - this is not actually valid but graphql-ruby used to print this */ { $$ = GraphQL_Language_Nodes_NONE; }
-    | field_definition                       { $$ = rb_ary_new_from_args(1, $1); }
-    | field_definition_list field_definition { rb_ary_push($$, $2); }
+    /* none - this is not actually valid but graphql-ruby used to print this */ { $$ = AST_NONE; }
+    | field_definition                       { $$ = MAKE_AST_LIST($1); }
+    | field_definition_list field_definition { AST_LIST_PUSH($$, $2); }
 
   interface_type_definition:
       description_opt INTERFACE name implements_opt directives_list_opt field_definition_list_opt {
-        $$ = MAKE_AST_NODE(InterfaceTypeDefinition, 7,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+        $$ = MAKE_AST_NODE(InterfaceTypeDefinition, 6,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
+          $1,
           $4,
           $5,
-          $6
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   pipe_opt:
-      /* none */ { $$ = GraphQL_Language_Nodes_NONE; }
-    | PIPE     { $$ = GraphQL_Language_Nodes_NONE; }
+      /* none */ { $$ = AST_NONE; }
+    | PIPE     { $$ = AST_NONE; }
 
   union_members:
       pipe_opt name {
-        VALUE new_member = MAKE_AST_NODE(TypeName, 3,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($2, 3)
+        GraphQLAstValue new_member = MAKE_AST_NODE(TypeName, 1,
+          $2.byte_offset,
+          TOKEN_VALUE($2)
         );
-        $$ = rb_ary_new_from_args(1, new_member);
+        $$ = MAKE_AST_LIST(new_member);
       }
     | union_members PIPE name {
-        rb_ary_push($$, MAKE_AST_NODE(TypeName, 3, rb_ary_entry($3, 1), rb_ary_entry($3, 2), rb_ary_entry($3, 3)));
+        AST_LIST_PUSH($$, MAKE_AST_NODE(TypeName, 1, $3.byte_offset, TOKEN_VALUE($3)));
       }
 
   union_type_definition:
       description_opt UNION name directives_list_opt EQUALS union_members {
-        $$ = MAKE_AST_NODE(UnionTypeDefinition,  6,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(UnionTypeDefinition, 5,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
           $6, // types
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
-          $4
+          $1,
+          $4,
+          COMMENT_VALUE($2)
         );
       }
 
   enum_type_definition:
       description_opt ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY {
-        $$ = MAKE_AST_NODE(EnumTypeDefinition,  6,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+        $$ = MAKE_AST_NODE(EnumTypeDefinition, 5,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
+          $1,
           $4,
-          $6
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   enum_value_definition:
     description_opt enum_name directives_list_opt {
-      $$ = MAKE_AST_NODE(EnumValueDefinition, 5,
-        rb_ary_entry($2, 1),
-        rb_ary_entry($2, 2),
-        rb_ary_entry($2, 3),
-        // TODO see get_description for reading a description from comments
-        (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
-        $3
+      $$ = MAKE_AST_NODE(EnumValueDefinition, 4,
+        $2.byte_offset,
+        TOKEN_VALUE($2),
+        $1,
+        $3,
+        COMMENT_VALUE($2)
       );
     }
 
   enum_value_definitions:
-      enum_value_definition                        { $$ = rb_ary_new_from_args(1, $1); }
-    | enum_value_definitions enum_value_definition { rb_ary_push($$, $2); }
+      enum_value_definition                        { $$ = MAKE_AST_LIST($1); }
+    | enum_value_definitions enum_value_definition { AST_LIST_PUSH($$, $2); }
 
   input_object_type_definition:
       description_opt INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY {
-        $$ = MAKE_AST_NODE(InputObjectTypeDefinition, 6,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($3, 3),
-          // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+        $$ = MAKE_AST_NODE(InputObjectTypeDefinition, 5,
+          $2.byte_offset,
+          TOKEN_VALUE($3),
+          $1,
           $4,
-          $6
+          $6,
+          COMMENT_VALUE($2)
         );
       }
 
   directive_definition:
       description_opt DIRECTIVE DIR_SIGN name arguments_definitions_opt directive_repeatable_opt ON directive_locations {
-        $$ = MAKE_AST_NODE(DirectiveDefinition, 7,
-          rb_ary_entry($2, 1),
-          rb_ary_entry($2, 2),
-          rb_ary_entry($4, 3),
-          (RB_TEST($6) ? Qtrue : Qfalse), // repeatable
+        $$ = MAKE_AST_NODE(DirectiveDefinition, 5,
+          $2.byte_offset,
+          TOKEN_VALUE($4),
+          $6, // repeatable
           // TODO see get_description for reading a description from comments
-          (RB_TEST($1) ? rb_ary_entry($1, 3) : Qnil),
+          $1,
           $5,
           $8
         );
       }
 
   directive_repeatable_opt:
-    /* nothing */   { $$ = Qnil; }
-    | REPEATABLE    { $$ = Qtrue; }
+    /* nothing */   { $$ = AST_FALSE; }
+    | REPEATABLE    { $$ = AST_TRUE; }
 
   directive_locations:
-      name                          { $$ = rb_ary_new_from_args(1, MAKE_AST_NODE(DirectiveLocation, 3, rb_ary_entry($1, 1), rb_ary_entry($1, 2), rb_ary_entry($1, 3))); }
-    | directive_locations PIPE name { rb_ary_push($$, MAKE_AST_NODE(DirectiveLocation, 3, rb_ary_entry($3, 1), rb_ary_entry($3, 2), rb_ary_entry($3, 3))); }
+      name                          { $$ = MAKE_AST_LIST(MAKE_AST_NODE(DirectiveLocation, 1, $1.byte_offset, TOKEN_VALUE($1))); }
+    | directive_locations PIPE name { AST_LIST_PUSH($$, MAKE_AST_NODE(DirectiveLocation, 1, $3.byte_offset, TOKEN_VALUE($3))); }
 
 
   type_system_extension:
@@ -747,23 +734,20 @@ type_system_definition:
 
   schema_extension:
       EXTEND SCHEMA directives_list_opt LCURLY operation_type_definition_list RCURLY {
-        $$ = MAKE_AST_NODE(SchemaExtension, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          // TODO use static strings:
-          rb_hash_aref($5, rb_str_new_cstr("query")),
-          rb_hash_aref($5, rb_str_new_cstr("mutation")),
-          rb_hash_aref($5, rb_str_new_cstr("subscription")),
+        $$ = MAKE_AST_NODE(SchemaExtension, 4,
+          $1.byte_offset,
+          $5.as.node->values[0], // query
+          $5.as.node->values[1], // mutation
+          $5.as.node->values[2], // subscription
           $3
         );
       }
     | EXTEND SCHEMA directives_list {
-        $$ = MAKE_AST_NODE(SchemaExtension, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          Qnil,
-          Qnil,
-          Qnil,
+        $$ = MAKE_AST_NODE(SchemaExtension, 4,
+          $1.byte_offset,
+          AST_NIL,
+          AST_NIL,
+          AST_NIL,
           $3
         );
       }
@@ -777,20 +761,18 @@ type_system_definition:
     | input_object_type_extension
 
   scalar_type_extension: EXTEND SCALAR name directives_list {
-    $$ = MAKE_AST_NODE(ScalarTypeExtension, 4,
-      rb_ary_entry($1, 1),
-      rb_ary_entry($1, 2),
-      rb_ary_entry($3, 3),
+    $$ = MAKE_AST_NODE(ScalarTypeExtension, 2,
+      $1.byte_offset,
+      TOKEN_VALUE($3),
       $4
     );
   }
 
   object_type_extension:
       EXTEND TYPE_LITERAL name implements_opt directives_list_opt field_definition_list_opt {
-        $$ = MAKE_AST_NODE(ObjectTypeExtension, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(ObjectTypeExtension, 4,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4, // implements
           $5,
           $6
@@ -799,10 +781,9 @@ type_system_definition:
 
   interface_type_extension:
       EXTEND INTERFACE name implements_opt directives_list_opt field_definition_list_opt {
-        $$ = MAKE_AST_NODE(InterfaceTypeExtension, 6,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(InterfaceTypeExtension, 4,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4,
           $5,
           $6
@@ -811,61 +792,55 @@ type_system_definition:
 
   union_type_extension:
       EXTEND UNION name directives_list_opt EQUALS union_members {
-        $$ = MAKE_AST_NODE(UnionTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(UnionTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $6, // types
           $4
         );
       }
     | EXTEND UNION name directives_list {
-        $$ = MAKE_AST_NODE(UnionTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
-          GraphQL_Language_Nodes_NONE, // types
+        $$ = MAKE_AST_NODE(UnionTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
+          AST_NONE, // types
           $4
         );
       }
 
   enum_type_extension:
       EXTEND ENUM name directives_list_opt LCURLY enum_value_definitions RCURLY {
-        $$ = MAKE_AST_NODE(EnumTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(EnumTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4,
           $6
         );
       }
     | EXTEND ENUM name directives_list {
-        $$ = MAKE_AST_NODE(EnumTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(EnumTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4,
-          GraphQL_Language_Nodes_NONE
+          AST_NONE
         );
       }
 
   input_object_type_extension:
       EXTEND INPUT name directives_list_opt LCURLY input_value_definition_list RCURLY {
-        $$ = MAKE_AST_NODE(InputObjectTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(InputObjectTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4,
           $6
         );
       }
     | EXTEND INPUT name directives_list {
-        $$ = MAKE_AST_NODE(InputObjectTypeExtension, 5,
-          rb_ary_entry($1, 1),
-          rb_ary_entry($1, 2),
-          rb_ary_entry($3, 3),
+        $$ = MAKE_AST_NODE(InputObjectTypeExtension, 3,
+          $1.byte_offset,
+          TOKEN_VALUE($3),
           $4,
-          GraphQL_Language_Nodes_NONE
+          AST_NONE
         );
       }
 
@@ -875,11 +850,10 @@ type_system_definition:
               /* This action creates a TypeName AST node.
                  $1 (yyvsp[0] in C) refers to the semantic value of 'name'.
                  The MAKE_AST_NODE macro is used, consistent with other rules.
-                 'name' (represented by $1) provides an array: [filename, line, col, name_string] */
-              $$ = MAKE_AST_NODE(TypeName, 3,
-                                 rb_ary_entry($1, 1), /* line from name token */
-                                 rb_ary_entry($1, 2), /* col from name token */
-                                 rb_ary_entry($1, 3)  /* name string itself */
+                 'name' (represented by $1) is a token with its position and the name string as its value */
+              $$ = MAKE_AST_NODE(TypeName, 1,
+                                 $1.byte_offset,
+                                 TOKEN_VALUE($1)  /* name string itself */
                                 );
           }
   ;
@@ -887,95 +861,415 @@ type_system_definition:
 %%
 
 // Custom functions
-int yylex (YYSTYPE *lvalp, VALUE parser, VALUE filename) {
-  VALUE next_token_idx_rb_int = rb_ivar_get(parser, rb_intern("@next_token_index"));
-  int next_token_idx = FIX2INT(next_token_idx_rb_int);
-  VALUE tokens = rb_ivar_get(parser, rb_intern("@tokens"));
-  VALUE next_token = rb_ary_entry(tokens, next_token_idx);
+// Parse errors are made here, without copying the query string. Only the offending token is read from it.
+static VALUE current_token_inspect(GraphQLLexer *lexer) {
+  return rb_inspect(token_content(lexer->source, lexer->intern_identifiers, &lexer->token));
+}
+
+// Errors get the same lines and columns as nodes, from their byte offset, see `document_line_at`.
+// Unless `message` is `Qnil`, ` at [line, col]` is added to it.
+static void error_location(GraphQLParser *state, long offset, VALUE message, VALUE *line, VALUE *col) {
+  long line_number, column_number;
+  document_position_at(state->ast, offset, &line_number, &column_number);
+  if (!NIL_P(message)) {
+    rb_str_catf(message, " at [%ld, %ld]", line_number, column_number);
+  }
+  *line = LONG2NUM(line_number);
+  *col = LONG2NUM(column_number);
+}
 
-  if (!RB_TEST(next_token)) {
+static void raise_bad_unicode_error(GraphQLParser *state) {
+  VALUE message = rb_utf8_str_new_cstr("Parse error on bad Unicode escape sequence: ");
+  rb_str_append(message, current_token_inspect(state->lexer));
+  rb_str_cat_cstr(message, " (error)");
+  VALUE line, col;
+  error_location(state, state->lexer->token.byte_offset, message, &line, &col);
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
+}
+
+int yylex (YYSTYPE *lvalp, VALUE parser, GraphQLParser *state) {
+  // The lexer runs one token ahead of the parser, see `next_token` in lexer.rl
+  GraphQLLexer *lexer = state->lexer;
+  int next_token_type = next_token(lexer);
+
+  if (lexer->error) {
+    // The lexer stopped without raising, see `raise_deferred_parse_error`.
+    // This token makes `yyparse` return without calling `yyerror`.
+    return YYerror;
+  }
+  if (next_token_type == 0) {
     return YYEOF;
   }
-  rb_ivar_set(parser, rb_intern("@next_token_index"), INT2FIX(next_token_idx + 1));
-  VALUE token_type_rb_int = rb_ary_entry(next_token, 4);
-  int next_token_type = FIX2INT(token_type_rb_int);
   if (next_token_type == 241) { // BAD_UNICODE_ESCAPE
-    VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-    VALUE mCParser = rb_const_get_at(mGraphQL, rb_intern("CParser"));
-    VALUE bad_unicode_error = rb_funcall(
-        mCParser, rb_intern("prepare_bad_unicode_error"), 1,
-        parser
-    );
-    rb_exc_raise(bad_unicode_error);
+    if (state->without_gvl) {
+      state->bad_unicode = 1;
+      return YYerror;
+    }
+    raise_bad_unicode_error(state);
+  }
+  switch (next_token_type) {
+    case LCURLY:
+    case LBRACKET:
+    case LPAREN:
+      if (enter_nesting(state, lexer->token)) {
+        return YYerror;
+      }
+      break;
+    case RCURLY:
+    case RBRACKET:
+    case RPAREN:
+      state->nesting--;
+      break;
   }
-  *lvalp = next_token;
+  // Token content is read later, when nodes are made from the arena
+  lvalp->token = lexer->token;
   return next_token_type;
 }
 
-void yyerror(VALUE parser, VALUE filename, const char *msg) {
-  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-  VALUE mCParser = rb_const_get_at(mGraphQL, rb_intern("CParser"));
-  VALUE rb_message = rb_str_new_cstr(msg);
-  VALUE exception = rb_funcall(
-      mCParser, rb_intern("prepare_parse_error"), 2,
-      rb_message,
-      parser
-  );
-  rb_exc_raise(exception);
+// Where `/, unexpected ([a-zA-Z ]+)(,| at)/` would end its first group in Bison's message, or -1.
+// The unexpected token's text is added there.
+static long unexpected_token_end(const char *message, long length) {
+  static const char prefix[] = ", unexpected ";
+  for (const char *match = strstr(message, prefix); match; match = strstr(match + 1, prefix)) {
+    long words_start = (match - message) + (long)(sizeof(prefix) - 1);
+    long words_end = words_start;
+    while (words_end < length && ((message[words_end] >= 'a' && message[words_end] <= 'z') || (message[words_end] >= 'A' && message[words_end] <= 'Z') || message[words_end] == ' ')) {
+      words_end++;
+    }
+    // Backtrack like the regular expression would, to the last word followed by `,` or ` at`
+    for (long end = words_end; end > words_start; end--) {
+      if (message[end] == ',' || strncmp(message + end, " at", 3) == 0) {
+        return end;
+      }
+    }
+  }
+  return -1;
+}
+
+static void raise_parse_error(GraphQLParser *state, const char *msg) {
+  if (strncmp(msg, "memory exhausted", 16) == 0) {
+    rb_exc_raise(parse_error_new(rb_utf8_str_new_cstr("This query is too large to execute."), Qnil, Qnil, state->query_string, state->filename));
+  }
+  VALUE message = rb_utf8_str_new_cstr(msg);
+  GraphQLLexer *lexer = state->lexer;
+  // There might not be a token if it's a comments-only string
+  if (lexer->token.type == 0) {
+    rb_exc_raise(parse_error_new(message, Qnil, Qnil, state->query_string, state->filename));
+  }
+  VALUE line, col;
+  error_location(state, lexer->token.byte_offset, message, &line, &col);
+  if (strstr(msg, "end of file") == NULL) {
+    long insert_at = unexpected_token_end(RSTRING_PTR(message), RSTRING_LEN(message));
+    if (insert_at >= 0) {
+      VALUE token_text = rb_utf8_str_new_cstr(" (");
+      rb_str_append(token_text, current_token_inspect(lexer));
+      rb_str_cat_cstr(token_text, ")");
+      rb_str_update(message, insert_at, 0, token_text);
+    }
+  }
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
 }
 
-#define INITIALIZE_NODE_CLASS_VARIABLE(node_class_name) \
-    rb_global_variable(&GraphQL_Language_Nodes_##node_class_name); \
-    GraphQL_Language_Nodes_##node_class_name = rb_const_get_at(mGraphQLLanguageNodes, rb_intern(#node_class_name));
+void yyerror(VALUE parser, GraphQLParser *state, const char *msg) {
+  if (state->without_gvl) {
+    // Bison's messages are short, this is only a precaution
+    snprintf(state->error_message, sizeof(state->error_message), "%s", msg);
+    return;
+  }
+  raise_parse_error(state, msg);
+}
 
-void initialize_node_class_variables() {
-  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
-  VALUE mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
-  VALUE mGraphQLLanguageNodes = rb_const_get_at(mGraphQLLanguage, rb_intern("Nodes"));
+static void raise_limit_error(GraphQLParser *state) {
+  VALUE message = rb_utf8_str_new_cstr(state->error_message);
+  VALUE line, col;
+  error_location(state, state->limit_offset, state->limit_location_in_message ? message : Qnil, &line, &col);
+  rb_exc_raise(parse_error_new(message, line, col, state->query_string, state->filename));
+}
 
-  rb_global_variable(&GraphQL_Language_Nodes_NONE);
-  GraphQL_Language_Nodes_NONE = rb_ary_new();
-  rb_ary_freeze(GraphQL_Language_Nodes_NONE);
+// Record an error at `token` (its message is in `error_message`), and return 1 so that the parse stops.
+// Without the GVL, the error is raised afterward by `raise_deferred_parse_error`.
+static int stop_parse_at(GraphQLParser *state, GraphQLToken token, int location_in_message) {
+  state->limit_exceeded = 1;
+  state->limit_offset = token.byte_offset;
+  state->limit_location_in_message = location_in_message;
+  if (!state->without_gvl) {
+    raise_limit_error(state);
+  }
+  return 1;
+}
+
+// Stop the parse because `count` is over `limit`
+static int exceed_limit(GraphQLParser *state, GraphQLToken token, const char *format, long count, long limit) {
+  snprintf(state->error_message, sizeof(state->error_message), format, count, limit);
+  return stop_parse_at(state, token, 1);
+}
+
+// Brackets are counted as they're lexed, so that deeply-nested strings stop before Bison's stacks grow.
+// Lists of any length are parsed with left recursion, so the stacks only grow with nesting.
+// The message is the same as for `max_tokens:` and the Ruby parser's `SystemStackError`.
+static int enter_nesting(GraphQLParser *state, GraphQLToken token) {
+  state->nesting++;
+  if (state->max_nesting >= 0 && state->nesting > state->max_nesting) {
+    snprintf(state->error_message, sizeof(state->error_message), "This query is too large to execute.");
+    return stop_parse_at(state, token, 0);
+  }
+  return 0;
+}
+
+// Bison calls this (with `yyoverflow`) when its stacks are full. They start in `yyparse`'s frame (`YYINITDEPTH` entries),
+// then move to `state->stack`, which doubles each time it's too small. Nesting is limited by `enter_nesting`, so this is bounded too.
+static int grow_parser_stack(VALUE parser, GraphQLParser *state, void **states, long states_bytesize, void **values, long values_bytesize, long *capacity) {
+  GraphQLParserStack *stack = state->stack;
+  // The stacks are full, so each one has `*capacity` entries
+  long state_size = states_bytesize / *capacity;
+  long value_size = values_bytesize / *capacity;
+  long new_capacity = *capacity * 2;
+  if (stack->capacity < new_capacity) {
+    void *new_states = malloc(new_capacity * state_size);
+    void *new_values = malloc(new_capacity * value_size);
+    if (new_states == NULL || new_values == NULL) {
+      free(new_states);
+      free(new_values);
+      yyerror(parser, state, "memory exhausted");
+      return 0;
+    }
+    memcpy(new_states, *states, states_bytesize);
+    memcpy(new_values, *values, values_bytesize);
+    free(stack->states);
+    free(stack->values);
+    stack->states = new_states;
+    stack->values = new_values;
+    stack->capacity = new_capacity;
+  } else if (*states != stack->states) {
+    // This stack was grown by an earlier parse on this thread
+    memcpy(stack->states, *states, states_bytesize);
+    memcpy(stack->values, *values, values_bytesize);
+  }
+  *states = stack->states;
+  *values = stack->values;
+  *capacity = stack->capacity;
+  return 1;
+}
+
+static void free_parser_stack(GraphQLParserStack *stack) {
+  free(stack->states);
+  free(stack->values);
+  stack->states = NULL;
+  stack->values = NULL;
+  stack->capacity = 0;
+}
+
+// Depth is checked as each selection set opens, before anything inside it is parsed
+static int enter_selection_set(GraphQLParser *state, GraphQLToken token) {
+  GraphQLParseStats *stats = &state->ast->stats;
+  stats->depth++;
+  if (stats->depth > stats->max_depth) {
+    stats->max_depth = stats->depth;
+  }
+  if (state->max_depth >= 0 && stats->depth > state->max_depth) {
+    return exceed_limit(state, token, "Query has depth of %ld, which exceeds max depth of %ld", stats->depth, state->max_depth);
+  }
+  return 0;
+}
+
+// Fields are counted when they reduce, so a field's subselections are counted before it
+static int count_field(GraphQLParser *state, GraphQLToken token, int aliased) {
+  GraphQLParseStats *stats = &state->ast->stats;
+  stats->fields++;
+  if (state->max_fields >= 0 && stats->fields > state->max_fields) {
+    return exceed_limit(state, token, "Query has %ld fields, which exceeds max fields of %ld", stats->fields, state->max_fields);
+  }
+  if (aliased) {
+    stats->aliases++;
+    if (state->max_aliases >= 0 && stats->aliases > state->max_aliases) {
+      return exceed_limit(state, token, "Query has %ld aliases, which exceeds max aliases of %ld", stats->aliases, state->max_aliases);
+    }
+  }
+  return 0;
+}
+
+// Raise an error from the lexer or parser, after running without the GVL
+void raise_deferred_parse_error(VALUE parser, GraphQLParser *state) {
+  if (state->lexer->error) {
+    raise_lexer_error(state->lexer);
+  } else if (state->bad_unicode) {
+    raise_bad_unicode_error(state);
+  } else if (state->limit_exceeded) {
+    raise_limit_error(state);
+  } else if (state->error_message[0] != '\0') {
+    raise_parse_error(state, state->error_message);
+  }
+}
+
+static void set_without_gvl(GraphQLParser *state, int without_gvl) {
+  state->without_gvl = without_gvl;
+  state->lexer->without_gvl = without_gvl;
+  state->ast->without_gvl = without_gvl;
+  if (without_gvl) {
+    state->bad_unicode = 0;
+    state->limit_exceeded = 0;
+    state->error_message[0] = '\0';
+  }
+}
+
+typedef struct ParseBatch {
+  GraphQLParseJob *jobs;
+  long count;
+  int threads_count;
+  rb_atomic_t next_job; // Each thread takes the next job until they're all started
+} ParseBatch;
+
+static void *run_parse_jobs(void *ptr) {
+  ParseBatch *batch = ptr;
+  // This thread's parses share one stack
+  GraphQLParserStack stack = { NULL, NULL, 0 };
+  long i;
+  while ((i = (long)RUBY_ATOMIC_FETCH_ADD(batch->next_job, 1)) < batch->count) {
+    GraphQLParser *state = batch->jobs[i].state;
+    state->stack = &stack;
+    yyparse(batch->jobs[i].parser, state);
+    state->stack = NULL;
+  }
+  free_parser_stack(&stack);
+  return NULL;
+}
+
+static void *run_parse_batch(void *ptr) {
+  ParseBatch *batch = ptr;
+#ifdef HAVE_PTHREAD_H
+  // The workers are started for each batch and joined at the end; there's no pool.
+  // This thread parses too, alongside the workers
+  pthread_t workers[MAX_PARSE_THREADS];
+  int workers_count = 0;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  // Room for `yyparse`'s frame, see `grow_parser_stack`
+  pthread_attr_setstacksize(&attr, PARSE_THREAD_STACK_SIZE);
+  while (workers_count < batch->threads_count - 1) {
+    if (pthread_create(&workers[workers_count], &attr, run_parse_jobs, batch) != 0) {
+      // Make do with the threads that started
+      break;
+    }
+    workers_count++;
+  }
+  pthread_attr_destroy(&attr);
+#endif
+  run_parse_jobs(batch);
+#ifdef HAVE_PTHREAD_H
+  for (int i = 0; i < workers_count; i++) {
+    pthread_join(workers[i], NULL);
+  }
+#endif
+  return NULL;
+}
+
+// Build each job's AST on up to `threads_count` native threads, while other threads run Ruby code.
+// Ruby strings are made later, by `materialize_document`, and errors are raised by `raise_deferred_parse_error`.
+// The source strings must be frozen, so that other threads can't change them.
+void parse_many_without_gvl(GraphQLParseJob *jobs, long count, int threads_count) {
+  if (threads_count > MAX_PARSE_THREADS) {
+    threads_count = MAX_PARSE_THREADS;
+  }
+  if (threads_count > count) {
+    threads_count = (int)count;
+  }
+  for (long i = 0; i < count; i++) {
+    set_without_gvl(jobs[i].state, 1);
+  }
+  ParseBatch batch = { jobs, count, threads_count, 0 };
+  rb_thread_call_without_gvl(run_parse_batch, &batch, NULL, NULL);
+  for (long i = 0; i < count; i++) {
+    set_without_gvl(jobs[i].state, 0);
+  }
+}
+
+static VALUE run_parse_with_gvl(VALUE job_ptr) {
+  GraphQLParseJob *job = (GraphQLParseJob *)job_ptr;
+  yyparse(job->parser, job->state);
+  return Qnil;
+}
+
+static VALUE free_parse_stack(VALUE stack_ptr) {
+  free_parser_stack((GraphQLParserStack *)stack_ptr);
+  return Qnil;
+}
+
+// Errors are raised from inside `yyparse`, so its stack is freed by `rb_ensure`
+void parse_with_gvl(VALUE parser, GraphQLParser *state) {
+  GraphQLParserStack stack = { NULL, NULL, 0 };
+  GraphQLParseJob job = { parser, state };
+  state->stack = &stack;
+  rb_ensure(run_parse_with_gvl, (VALUE)&job, free_parse_stack, (VALUE)&stack);
+  state->stack = NULL;
+}
+
+void parse_without_gvl(VALUE parser, GraphQLParser *state) {
+  GraphQLParseJob job = { parser, state };
+  parse_many_without_gvl(&job, 1, 1);
+  raise_deferred_parse_error(parser, state);
+}
+
+static void parser_mark(void *ptr) {
+  GraphQLParser *state = ptr;
+  rb_gc_mark(state->query_string);
+  rb_gc_mark(state->filename);
+  rb_gc_mark(state->token_stream);
+  rb_gc_mark(state->document);
+  rb_gc_mark(state->result);
+}
+
+static size_t parser_memsize(const void *ptr) {
+  return sizeof(GraphQLParser);
+}
+
+static const rb_data_type_t parser_data_type = {
+  "GraphQL::CParser::Parser",
+  { parser_mark, RUBY_TYPED_DEFAULT_FREE, parser_memsize, },
+  0, 0, RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE parser_alloc(VALUE parser_class) {
+  GraphQLParser *state;
+  VALUE parser = TypedData_Make_Struct(parser_class, GraphQLParser, &parser_data_type, state);
+  state->query_string = Qnil;
+  state->filename = Qnil;
+  state->token_stream = Qnil;
+  state->lexer = NULL;
+  state->result = Qnil;
+  state->without_gvl = 0;
+  state->max_depth = -1;
+  state->max_aliases = -1;
+  state->max_fields = -1;
+  state->max_nesting = -1;
+  state->stack = NULL;
+  return parser;
+}
+
+GraphQLParser *get_parser(VALUE parser) {
+  GraphQLParser *state;
+  TypedData_Get_Struct(parser, GraphQLParser, &parser_data_type, state);
+  return state;
+}
+
+void initialize_parser_class(VALUE parser_class) {
+  rb_define_alloc_func(parser_class, parser_alloc);
 
   rb_global_variable(&r_string_query);
   r_string_query = rb_str_new_cstr("query");
   rb_str_freeze(r_string_query);
+}
 
-  INITIALIZE_NODE_CLASS_VARIABLE(Argument)
-  INITIALIZE_NODE_CLASS_VARIABLE(Directive)
-  INITIALIZE_NODE_CLASS_VARIABLE(Document)
-  INITIALIZE_NODE_CLASS_VARIABLE(Enum)
-  INITIALIZE_NODE_CLASS_VARIABLE(Field)
-  INITIALIZE_NODE_CLASS_VARIABLE(FragmentDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(FragmentSpread)
-  INITIALIZE_NODE_CLASS_VARIABLE(InlineFragment)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObject)
-  INITIALIZE_NODE_CLASS_VARIABLE(ListType)
-  INITIALIZE_NODE_CLASS_VARIABLE(NonNullType)
-  INITIALIZE_NODE_CLASS_VARIABLE(NullValue)
-  INITIALIZE_NODE_CLASS_VARIABLE(OperationDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(TypeName)
-  INITIALIZE_NODE_CLASS_VARIABLE(VariableDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(VariableIdentifier)
-
-  INITIALIZE_NODE_CLASS_VARIABLE(ScalarTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(ObjectTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InterfaceTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(UnionTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObjectTypeDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumValueDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(DirectiveDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(DirectiveLocation)
-  INITIALIZE_NODE_CLASS_VARIABLE(FieldDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputValueDefinition)
-  INITIALIZE_NODE_CLASS_VARIABLE(SchemaDefinition)
-
-  INITIALIZE_NODE_CLASS_VARIABLE(ScalarTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(ObjectTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(InterfaceTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(UnionTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(EnumTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(InputObjectTypeExtension)
-  INITIALIZE_NODE_CLASS_VARIABLE(SchemaExtension)
+static GraphQLAstValue make_ast_list(GraphQLDocument *doc, GraphQLAstValue first_value) {
+  GraphQLAstValue list = ast_list_new(doc);
+  ast_list_push(doc, list, first_value);
+  return list;
+}
+
+// Like merging hashes: a later `query: ...` replaces an earlier one.
+static void set_operation_types(GraphQLAstValue operation_types, GraphQLAstValue other_operation_types) {
+  for (int i = 0; i < 3; i++) {
+    if (other_operation_types.as.node->values[i].type != AST_VALUE_NIL) {
+      operation_types.as.node->values[i] = other_operation_types.as.node->values[i];
+    }
+  }
 }
@@ -0,0 +1,1288 @@
+#include "printer.h"
+#include <string.h>
+
+// Deeper values are left for the Ruby printer
+#define PRINTER_MAX_DEPTH 1000
+// Like `TruncatableBuffer::DEFAULT_INIT_CAPACITY`
+#define PRINTER_INIT_CAPACITY 500
+
+// Each `print_` function returns nonzero when printing stopped, because the output was truncated or something was unsupported
+#define PRINT(expr) do { if (expr) return 1; } while (0)
+
+// The classes which `Printer#print_node` handles. Subclasses (like lazy nodes) are printed like their superclasses.
+typedef enum PrinterNodeKind {
+  PRINT_Document,
+  PRINT_Argument,
+  PRINT_Directive,
+  PRINT_Enum,
+  PRINT_NullValue,
+  PRINT_Field,
+  PRINT_FragmentDefinition,
+  PRINT_FragmentSpread,
+  PRINT_InlineFragment,
+  PRINT_InputObject,
+  PRINT_ListType,
+  PRINT_NonNullType,
+  PRINT_OperationDefinition,
+  PRINT_TypeName,
+  PRINT_VariableDefinition,
+  PRINT_VariableIdentifier,
+  PRINT_SchemaDefinition,
+  PRINT_SchemaExtension,
+  PRINT_ScalarTypeDefinition,
+  PRINT_ScalarTypeExtension,
+  PRINT_ObjectTypeDefinition,
+  PRINT_ObjectTypeExtension,
+  PRINT_InputValueDefinition,
+  PRINT_FieldDefinition,
+  PRINT_InterfaceTypeDefinition,
+  PRINT_InterfaceTypeExtension,
+  PRINT_UnionTypeDefinition,
+  PRINT_UnionTypeExtension,
+  PRINT_EnumTypeDefinition,
+  PRINT_EnumTypeExtension,
+  PRINT_EnumValueDefinition,
+  PRINT_InputObjectTypeDefinition,
+  PRINT_InputObjectTypeExtension,
+  PRINT_DirectiveDefinition,
+  PRINT_NODE_KINDS_COUNT
+} PrinterNodeKind;
+
+// The attributes which the Ruby printer reads
+typedef enum PrinterNodeAttribute {
+  ATTR_name,
+  ATTR_alias,
+  ATTR_value,
+  ATTR_arguments,
+  ATTR_directives,
+  ATTR_selections,
+  ATTR_type,
+  ATTR_operation_type,
+  ATTR_variables,
+  ATTR_default_value,
+  ATTR_definitions,
+  ATTR_of_type,
+  ATTR_description,
+  ATTR_comment,
+  ATTR_interfaces,
+  ATTR_fields,
+  ATTR_types,
+  ATTR_values,
+  ATTR_locations,
+  ATTR_repeatable,
+  ATTR_query,
+  ATTR_mutation,
+  ATTR_subscription,
+  PRINT_ATTRS_COUNT
+} PrinterNodeAttribute;
+
+typedef struct PrinterNodeAttributeIds {
+  ID ivar;
+  ID method;
+} PrinterNodeAttributeIds;
+
+static PrinterNodeAttributeIds node_attributes[PRINT_ATTRS_COUNT];
+static VALUE node_classes[PRINT_NODE_KINDS_COUNT];
+static st_table *node_kinds; // class => PrinterNodeKind
+static VALUE mGraphQLLanguage;
+static VALUE omission;
+static ID id_serialize;
+// Methods which `SanitizedPrinter` calls
+static ID id_aref, id_context, id_directives, id_field, id_get_argument, id_kind, id_list_p, id_non_null_p, id_of_type, id_public_send,
+  id_redact_argument_value_p, id_redacted_argument_value, id_scalar_p, id_schema, id_type, id_types, id_unwrap, id_value_to_ast, id_variables;
+
+static int print_node(GraphQLPrinter *p, VALUE node, VALUE indent, int indent_levels);
+static int print_directive(GraphQLPrinter *p, VALUE directive);
+static int print_input_value_definition(GraphQLPrinter *p, VALUE input_value);
+
+static int unsupported(GraphQLPrinter *p) {
+  p->unsupported = 1;
+  return 1;
+}
+
+// Nodes of the classes in `GraphQL::Language::Nodes` are read by their instance variables.
+// Anything else (lazy nodes, custom subclasses) is read by calling its methods, like the Ruby printer does.
+static int direct_p(VALUE node) {
+  return !RB_SPECIAL_CONST_P(node) && st_is_member(node_kinds, (st_data_t)RBASIC_CLASS(node));
+}
+
+static VALUE get(VALUE node, int direct, PrinterNodeAttribute attr) {
+  if (direct) {
+    return rb_ivar_get(node, node_attributes[attr].ivar);
+  } else {
+    return rb_funcall(node, node_attributes[attr].method, 0);
+  }
+}
+
+// The Ruby printer calls `#each_with_index` and `#empty?` on lists, so anything else is left for it
+static int get_list(GraphQLPrinter *p, VALUE node, int direct, PrinterNodeAttribute attr, VALUE *list) {
+  *list = get(node, direct, attr);
+  if (!RB_TYPE_P(*list, T_ARRAY)) {
+    return unsupported(p);
+  }
+  return 0;
+}
+
+static long utf8_length(const char *ptr, long length) {
+  long chars = 0;
+  for (long i = 0; i < length; i++) {
+    chars += ((unsigned char)ptr[i] & 0xC0) != 0x80;
+  }
+  return chars;
+}
+
+// The number of bytes in the first `chars` characters
+static long utf8_offset(const char *ptr, long length, long chars) {
+  long i = 0;
+  while (i < length) {
+    if (((unsigned char)ptr[i] & 0xC0) != 0x80 && chars-- == 0) {
+      break;
+    }
+    i++;
+  }
+  return i;
+}
+
+static int ascii_only_p(const char *ptr, long length) {
+  for (long i = 0; i < length; i++) {
+    if ((unsigned char)ptr[i] >= 0x80) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Like `TruncatableBuffer#append`: past `truncate_size`, only the characters which fit are written.
+// `ptr` is ASCII or UTF-8, and `ascii_only` may be 0 when it's not known yet.
+static int write_bytes(GraphQLPrinter *p, const char *ptr, long length, int ascii_only) {
+  if (length == 0) {
+    return 0;
+  }
+  ascii_only = ascii_only || ascii_only_p(ptr, length);
+  if (p->truncate_size >= 0) {
+    long chars = ascii_only ? length : utf8_length(ptr, length);
+    if (p->chars + chars > p->truncate_size) {
+      long fitting_chars = p->truncate_size - p->chars;
+      length = ascii_only ? fitting_chars : utf8_offset(ptr, length, fitting_chars);
+      p->non_ascii |= !ascii_only_p(ptr, length);
+      rb_str_cat(p->out, ptr, length);
+      p->truncated = 1;
+      return 1;
+    }
+    p->chars += chars;
+  }
+  p->non_ascii |= !ascii_only;
+  rb_str_cat(p->out, ptr, length);
+  return 0;
+}
+
+#define write_literal(p, str) write_bytes(p, str, sizeof(str) - 1, 1)
+
+// Strings which `<<` would add to the output without an encoding error: ASCII, or valid UTF-8.
+// Returns 1 for ASCII-only strings, 0 for UTF-8, and -1 for anything else.
+static int string_kind(VALUE str) {
+  if (!RB_TYPE_P(str, T_STRING)) {
+    return -1;
+  }
+  int coderange = rb_enc_str_coderange(str);
+  if (coderange == ENC_CODERANGE_7BIT) {
+    return rb_enc_asciicompat(rb_enc_get(str)) ? 1 : -1;
+  } else if (coderange == ENC_CODERANGE_VALID && ENCODING_GET(str) == rb_utf8_encindex()) {
+    return 0;
+  } else {
+    return -1;
+  }
+}
+
+static int write_string(GraphQLPrinter *p, VALUE str) {
+  int kind = string_kind(str);
+  if (kind < 0) {
+    return unsupported(p);
+  }
+  int result = write_bytes(p, RSTRING_PTR(str), RSTRING_LEN(str), kind);
+  RB_GC_GUARD(str);
+  return result;
+}
+
+static int write_spaces(GraphQLPrinter *p, int count) {
+  static const char spaces[] = "        ";
+  while (count > 0) {
+    int length = count < (int)sizeof(spaces) - 1 ? count : (int)sizeof(spaces) - 1;
+    PRINT(write_bytes(p, spaces, length, 1));
+    count -= length;
+  }
+  return 0;
+}
+
+// Selections are indented by the `indent:` given to `print` (or nothing, for nested values), then two spaces for each level
+static int write_indent(GraphQLPrinter *p, VALUE indent, int indent_levels) {
+  if (!NIL_P(indent)) {
+    PRINT(write_string(p, indent));
+  }
+  return write_spaces(p, indent_levels * 2);
+}
+
+// Like `JSON.generate(str)`, for the strings where `GraphQL::Language.serialize` is `JSON.generate`
+static int write_json_string(GraphQLPrinter *p, VALUE str, int ascii_only) {
+  static const char hex[] = "0123456789abcdef";
+  const char *ptr = RSTRING_PTR(str);
+  long length = RSTRING_LEN(str);
+  long run_start = 0;
+  PRINT(write_literal(p, "\""));
+  for (long i = 0; i < length; i++) {
+    unsigned char c = (unsigned char)ptr[i];
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    PRINT(write_bytes(p, ptr + run_start, i - run_start, ascii_only));
+    run_start = i + 1;
+    switch (c) {
+      case '"': PRINT(write_literal(p, "\\\"")); break;
+      case '\\': PRINT(write_literal(p, "\\\\")); break;
+      case '\b': PRINT(write_literal(p, "\\b")); break;
+      case '\f': PRINT(write_literal(p, "\\f")); break;
+      case '\n': PRINT(write_literal(p, "\\n")); break;
+      case '\r': PRINT(write_literal(p, "\\r")); break;
+      case '\t': PRINT(write_literal(p, "\\t")); break;
+      default: {
+        char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 15] };
+        PRINT(write_bytes(p, escape, sizeof(escape), 1));
+      }
+    }
+  }
+  PRINT(write_bytes(p, ptr + run_start, length - run_start, ascii_only));
+  RB_GC_GUARD(str);
+  return write_literal(p, "\"");
+}
+
+// Like `GraphQL::Language.serialize` for a scalar. Floats and unusual strings are passed to it.
+static int print_scalar(GraphQLPrinter *p, VALUE value) {
+  switch (TYPE(value)) {
+    case T_NIL:
+      return write_literal(p, "null");
+    case T_TRUE:
+      return write_literal(p, "true");
+    case T_FALSE:
+      return write_literal(p, "false");
+    case T_FIXNUM: {
+      char digits[24];
+      int length = snprintf(digits, sizeof(digits), "%ld", FIX2LONG(value));
+      return write_bytes(p, digits, length, 1);
+    }
+    case T_STRING: {
+      int kind = string_kind(value);
+      if (kind >= 0 && rb_obj_class(value) == rb_cString) {
+        return write_json_string(p, value, kind);
+      }
+      break;
+    }
+  }
+  return write_string(p, rb_funcall(mGraphQLLanguage, id_serialize, 1, value));
+}
+
+// Like `GraphQL::Language::BlockString.break_line`, which splits long lines with
+// `/((?: |^).{15,#{length - 40}}(?= |$))/`, then rejoins the pieces after the first two matches, at their leading spaces.
+// This finds where the regexp would match, starting at `start`, and returns the match's start (or -1) and end.
+static long find_line_break(const char *line, long length, long start, long max_chars, long *match_end) {
+  for (long i = start; i < length; i++) {
+    if (line[i] != ' ' && i != 0) {
+      const char *space = memchr(line + i, ' ', length - i);
+      if (space == NULL) {
+        return -1;
+      }
+      i = space - line;
+    }
+    // `(?: |^)` tries the space first, then the start of the line
+    for (int alternative = 0; alternative < 2; alternative++) {
+      long pos;
+      if (alternative == 0 && line[i] == ' ') {
+        pos = i + 1;
+      } else if (alternative == 1 && i == 0) {
+        pos = 0;
+      } else {
+        continue;
+      }
+      // `.{15,max_chars}` is greedy, so the longest one which is followed by a space or the end wins
+      long chars = 0;
+      long found = -1;
+      while (chars < max_chars && pos < length) {
+        pos++;
+        while (pos < length && ((unsigned char)line[pos] & 0xC0) == 0x80) {
+          pos++;
+        }
+        chars++;
+        if (chars >= 15 && (pos == length || line[pos] == ' ')) {
+          found = pos;
+        }
+      }
+      if (found >= 0) {
+        *match_end = found;
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+static int write_block_string_line(GraphQLPrinter *p, int indent, const char *line, long length) {
+  PRINT(write_spaces(p, indent));
+  PRINT(write_bytes(p, line, length, 0));
+  return write_literal(p, "\n");
+}
+
+static int print_block_string_line(GraphQLPrinter *p, int indent, const char *line, long length, long line_length) {
+  if (utf8_length(line, length) < line_length + 5) {
+    return write_block_string_line(p, indent, line, length);
+  }
+  long max_chars = line_length - 40;
+  if (max_chars < 15) {
+    // The Ruby printer's regexp would be invalid
+    return unsupported(p);
+  }
+  // Fewer than two matches leaves the line as-is. Otherwise, it's split at the start of each match after the first,
+  // and those matches' leading spaces are removed.
+  long match_end;
+  long first_match = find_line_break(line, length, 0, max_chars, &match_end);
+  long split_at = first_match < 0 ? -1 : find_line_break(line, length, match_end, max_chars, &match_end);
+  if (split_at < 0) {
+    return write_block_string_line(p, indent, line, length);
+  }
+  PRINT(write_block_string_line(p, indent, line, split_at));
+  long next_split_at;
+  while ((next_split_at = find_line_break(line, length, match_end, max_chars, &match_end)) >= 0) {
+    PRINT(write_block_string_line(p, indent, line + split_at + 1, next_split_at - split_at - 1));
+    split_at = next_split_at;
+  }
+  return write_block_string_line(p, indent, line + split_at + 1, length - split_at - 1);
+}
+
+// `str.split("\n")` leaves out any empty strings at the end
+static long trim_trailing_newlines(const char *ptr, long length) {
+  while (length > 0 && ptr[length - 1] == '\n') {
+    length--;
+  }
+  return length;
+}
+
+// Like `GraphQL::Language::BlockString.print(str, indent: " " * indent)`
+static int print_block_string(GraphQLPrinter *p, VALUE str, int indent) {
+  if (string_kind(str) < 0) {
+    return unsupported(p);
+  }
+  const char *ptr = RSTRING_PTR(str);
+  long length = RSTRING_LEN(str);
+  long line_length = 120 - indent;
+  PRINT(write_spaces(p, indent));
+  PRINT(write_literal(p, "\"\"\"\n"));
+  if (memchr(ptr, '\n', length) == NULL) {
+    PRINT(print_block_string_line(p, indent, ptr, length, line_length));
+  } else {
+    length = trim_trailing_newlines(ptr, length);
+    long line_start = 0;
+    while (line_start < length) {
+      const char *newline = memchr(ptr + line_start, '\n', length - line_start);
+      long line_end = newline ? newline - ptr : length;
+      if (line_end == line_start) {
+        PRINT(write_literal(p, "\n"));
+      } else {
+        PRINT(print_block_string_line(p, indent, ptr + line_start, line_end - line_start, line_length));
+      }
+      line_start = line_end + 1;
+    }
+  }
+  PRINT(write_spaces(p, indent));
+  RB_GC_GUARD(str);
+  return write_literal(p, "\"\"\"\n");
+}
+
+// The characters which `String#rstrip` removes
+static int rstrip_p(char c) {
+  return c == ' ' || c == '\0' || (c >= '\t' && c <= '\r');
+}
+
+// Like `GraphQL::Language::Comment.print(str, indent: " " * indent)`
+static int print_comment_string(GraphQLPrinter *p, VALUE str, int indent) {
+  if (string_kind(str) < 0) {
+    return unsupported(p);
+  }
+  const char *ptr = RSTRING_PTR(str);
+  long length = trim_trailing_newlines(ptr, RSTRING_LEN(str));
+  long line_start = 0;
+  while (line_start < length) {
+    const char *newline = memchr(ptr + line_start, '\n', length - line_start);
+    long line_end = newline ? newline - ptr : length;
+    if (line_start > 0) {
+      PRINT(write_literal(p, "\n"));
+    }
+    // Each line is `rstrip`ped, which can remove the space after `#`, too
+    long stripped_end = line_end;
+    while (stripped_end > line_start && rstrip_p(ptr[stripped_end - 1])) {
+      stripped_end--;
+    }
+    PRINT(write_spaces(p, indent));
+    if (stripped_end == line_start) {
+      PRINT(write_literal(p, "#"));
+    } else {
+      PRINT(write_literal(p, "# "));
+      PRINT(write_bytes(p, ptr + line_start, stripped_end - line_start, 0));
+    }
+    line_start = line_end + 1;
+  }
+  RB_GC_GUARD(str);
+  return write_literal(p, "\n");
+}
+
+static int print_description(GraphQLPrinter *p, VALUE node, int direct, int indent, int first_in_block) {
+  VALUE description = get(node, direct, ATTR_description);
+  if (!RTEST(description)) {
+    return 0;
+  }
+  if (indent > 0 && !first_in_block) {
+    PRINT(write_literal(p, "\n"));
+  }
+  return print_block_string(p, description, indent);
+}
+
+static int print_comment(GraphQLPrinter *p, VALUE node, int direct, int indent, int first_in_block) {
+  VALUE comment = get(node, direct, ATTR_comment);
+  if (!RTEST(comment)) {
+    return 0;
+  }
+  if (indent > 0 && !first_in_block) {
+    PRINT(write_literal(p, "\n"));
+  }
+  return print_comment_string(p, comment, indent);
+}
+
+static int print_description_and_comment(GraphQLPrinter *p, VALUE node, int direct) {
+  PRINT(print_description(p, node, direct, 0, 1));
+  return print_comment(p, node, direct, 0, 1);
+}
+
+static int print_name(GraphQLPrinter *p, VALUE node, int direct) {
+  return write_string(p, get(node, direct, ATTR_name));
+}
+
+// The names of `interfaces`, `types` or `locations`, separated by `separator`
+static int print_names(GraphQLPrinter *p, VALUE nodes, const char *separator) {
+  for (long i = 0; i < RARRAY_LEN(nodes); i++) {
+    if (i > 0) {
+      PRINT(write_bytes(p, separator, strlen(separator), 1));
+    }
+    VALUE node = RARRAY_AREF(nodes, i);
+    PRINT(print_name(p, node, direct_p(node)));
+  }
+  return 0;
+}
+
+// `SanitizedPrinter` keeps track of types like this:
+
+// `type` without its non-null wrapper
+static VALUE nullable_type(VALUE type) {
+  return RTEST(rb_funcall(type, id_non_null_p, 0)) ? rb_funcall(type, id_of_type, 0) : type;
+}
+
+// `query.get_type(type_name.name)`
+static VALUE sanitizer_get_type(GraphQLSanitizer *s, VALUE type_name) {
+  return rb_funcall(s->types, id_type, 1, get(type_name, direct_p(type_name), ATTR_name));
+}
+
+// Like `SanitizedPrinter#coerce_argument_value_to_list?`
+static int coerce_argument_value_to_list_p(VALUE type, VALUE value) {
+  return RTEST(rb_funcall(type, id_list_p, 0)) &&
+    !rb_obj_is_kind_of(value, rb_cArray) &&
+    !NIL_P(value) &&
+    !rb_obj_is_kind_of(value, node_classes[PRINT_VariableIdentifier]);
+}
+
+// Like `SanitizedPrinter#print_argument`, for arguments whose owner has type information
+static int sanitize_argument(GraphQLPrinter *p, VALUE argument, int direct, VALUE value) {
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE arg_owner = RTEST(s->current_input_type) ? s->current_input_type : (RTEST(s->current_directive) ? s->current_directive : s->current_field);
+  VALUE old_current_argument = s->current_argument;
+  VALUE old_input_type = s->current_input_type;
+  s->current_argument = rb_funcall(arg_owner, id_get_argument, 2, get(argument, direct, ATTR_name), s->context);
+  s->current_input_type = nullable_type(rb_funcall(s->current_argument, id_type, 0));
+  if (coerce_argument_value_to_list_p(s->current_input_type, value)) {
+    value = rb_ary_new_from_values(1, &value);
+  }
+  PRINT(print_name(p, argument, direct));
+  PRINT(write_literal(p, ": "));
+  PRINT(print_node(p, value, Qnil, 0));
+  s->current_input_type = old_input_type;
+  s->current_argument = old_current_argument;
+  return 0;
+}
+
+// Like `SanitizedPrinter#print_node` for `true`, `false`, numbers and strings
+static int sanitize_scalar(GraphQLPrinter *p, VALUE value) {
+  GraphQLSanitizer *s = p->sanitizer;
+  if (RTEST(s->current_argument) && !NIL_P(value) && !RB_SYMBOL_P(value) &&
+      RTEST(rb_funcall(s->printer, id_redact_argument_value_p, 2, s->current_argument, value))) {
+    return write_string(p, rb_funcall(s->printer, id_redacted_argument_value, 1, s->current_argument));
+  }
+  return print_scalar(p, value);
+}
+
+// Like `SanitizedPrinter#print_variable_identifier` with `inline_variables: true`
+static int sanitize_variable_identifier(GraphQLPrinter *p, VALUE variable_identifier, int direct) {
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE variables = rb_funcall(s->query, id_variables, 0);
+  VALUE variable_value = rb_funcall(variables, id_aref, 1, get(variable_identifier, direct, ATTR_name));
+  return print_node(p, rb_funcall(s->printer, id_value_to_ast, 2, variable_value, s->current_input_type), Qnil, 0);
+}
+
+static int print_argument(GraphQLPrinter *p, VALUE argument) {
+  int direct = direct_p(argument);
+  VALUE value = get(argument, direct, ATTR_value);
+  GraphQLSanitizer *s = p->sanitizer;
+  // `SanitizedPrinter` won't have type information if it's recursing into a custom scalar
+  if (s && !(RTEST(s->current_input_type) && RTEST(rb_funcall(rb_funcall(s->current_input_type, id_kind, 0), id_scalar_p, 0)))) {
+    return sanitize_argument(p, argument, direct, value);
+  }
+  PRINT(print_name(p, argument, direct));
+  PRINT(write_literal(p, ": "));
+  return print_node(p, value, Qnil, 0);
+}
+
+// `(a: 1, b: 2)`, or just `open` and `close` for `InputObject`s
+static int print_argument_list(GraphQLPrinter *p, VALUE arguments, const char *open, const char *close) {
+  PRINT(write_bytes(p, open, 1, 1));
+  for (long i = 0; i < RARRAY_LEN(arguments); i++) {
+    if (i > 0) {
+      PRINT(write_literal(p, ", "));
+    }
+    PRINT(print_argument(p, RARRAY_AREF(arguments, i)));
+  }
+  return write_bytes(p, close, 1, 1);
+}
+
+static int print_directive(GraphQLPrinter *p, VALUE directive) {
+  int direct = direct_p(directive);
+  VALUE arguments;
+  GraphQLSanitizer *s = p->sanitizer;
+  if (s) {
+    s->current_directive = rb_funcall(rb_funcall(s->schema, id_directives, 0), id_aref, 1, get(directive, direct, ATTR_name));
+  }
+  PRINT(write_literal(p, "@"));
+  PRINT(print_name(p, directive, direct));
+  PRINT(get_list(p, directive, direct, ATTR_arguments, &arguments));
+  if (RARRAY_LEN(arguments) > 0) {
+    PRINT(print_argument_list(p, arguments, "(", ")"));
+  }
+  if (s) {
+    s->current_directive = Qnil;
+  }
+  return 0;
+}
+
+static int print_directives(GraphQLPrinter *p, VALUE node, int direct) {
+  VALUE directives;
+  PRINT(get_list(p, node, direct, ATTR_directives, &directives));
+  for (long i = 0; i < RARRAY_LEN(directives); i++) {
+    PRINT(write_literal(p, " "));
+    PRINT(print_directive(p, RARRAY_AREF(directives, i)));
+  }
+  return 0;
+}
+
+static int print_selections(GraphQLPrinter *p, VALUE node, int direct, VALUE indent, int indent_levels) {
+  VALUE selections;
+  PRINT(get_list(p, node, direct, ATTR_selections, &selections));
+  if (RARRAY_LEN(selections) == 0) {
+    return 0;
+  }
+  PRINT(write_literal(p, " {\n"));
+  for (long i = 0; i < RARRAY_LEN(selections); i++) {
+    PRINT(print_node(p, RARRAY_AREF(selections, i), indent, indent_levels + 1));
+    PRINT(write_literal(p, "\n"));
+  }
+  PRINT(write_indent(p, indent, indent_levels));
+  return write_literal(p, "}");
+}
+
+static int print_field(GraphQLPrinter *p, VALUE field, int direct, VALUE indent, int indent_levels) {
+  VALUE arguments;
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE old_type = Qnil;
+  if (s) {
+    // Like `SanitizedPrinter`, this leaves `current_field` as it is afterward
+    s->current_field = rb_funcall(s->types, id_field, 2, s->current_type, get(field, direct, ATTR_name));
+    old_type = s->current_type;
+    s->current_type = rb_funcall(rb_funcall(s->current_field, id_type, 0), id_unwrap, 0);
+  }
+  PRINT(write_indent(p, indent, indent_levels));
+  VALUE field_alias = get(field, direct, ATTR_alias);
+  if (RTEST(field_alias)) {
+    PRINT(write_string(p, field_alias));
+    PRINT(write_literal(p, ": "));
+  }
+  PRINT(print_name(p, field, direct));
+  PRINT(get_list(p, field, direct, ATTR_arguments, &arguments));
+  if (RARRAY_LEN(arguments) > 0) {
+    PRINT(print_argument_list(p, arguments, "(", ")"));
+  }
+  PRINT(print_directives(p, field, direct));
+  PRINT(print_selections(p, field, direct, indent, indent_levels));
+  if (s) {
+    s->current_type = old_type;
+  }
+  return 0;
+}
+
+static int print_fragment_definition(GraphQLPrinter *p, VALUE fragment_def, int direct, VALUE indent, int indent_levels) {
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE old_type = Qnil;
+  if (s) {
+    old_type = s->current_type;
+    s->current_type = sanitizer_get_type(s, get(fragment_def, direct, ATTR_type));
+  }
+  PRINT(write_indent(p, indent, indent_levels));
+  PRINT(write_literal(p, "fragment"));
+  VALUE name = get(fragment_def, direct, ATTR_name);
+  if (RTEST(name)) {
+    PRINT(write_literal(p, " "));
+    PRINT(write_string(p, name));
+  }
+  VALUE type = get(fragment_def, direct, ATTR_type);
+  if (RTEST(type)) {
+    PRINT(write_literal(p, " on "));
+    PRINT(print_node(p, type, Qnil, 0));
+  }
+  PRINT(print_directives(p, fragment_def, direct));
+  PRINT(print_selections(p, fragment_def, direct, indent, indent_levels));
+  if (s) {
+    s->current_type = old_type;
+  }
+  return 0;
+}
+
+static int print_inline_fragment(GraphQLPrinter *p, VALUE inline_fragment, int direct, VALUE indent, int indent_levels) {
+  VALUE type = get(inline_fragment, direct, ATTR_type);
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE old_type = Qnil;
+  if (s) {
+    old_type = s->current_type;
+    if (RTEST(type)) {
+      s->current_type = sanitizer_get_type(s, type);
+    }
+  }
+  PRINT(write_indent(p, indent, indent_levels));
+  PRINT(write_literal(p, "..."));
+  if (RTEST(type)) {
+    PRINT(write_literal(p, " on "));
+    PRINT(print_node(p, type, Qnil, 0));
+  }
+  PRINT(print_directives(p, inline_fragment, direct));
+  PRINT(print_selections(p, inline_fragment, direct, indent, indent_levels));
+  if (s) {
+    s->current_type = old_type;
+  }
+  return 0;
+}
+
+static int print_variable_definition(GraphQLPrinter *p, VALUE variable_definition) {
+  int direct = direct_p(variable_definition);
+  PRINT(write_literal(p, "$"));
+  PRINT(print_name(p, variable_definition, direct));
+  PRINT(write_literal(p, ": "));
+  PRINT(print_node(p, get(variable_definition, direct, ATTR_type), Qnil, 0));
+  VALUE default_value = get(variable_definition, direct, ATTR_default_value);
+  if (!NIL_P(default_value)) {
+    PRINT(write_literal(p, " = "));
+    PRINT(print_node(p, default_value, Qnil, 0));
+  }
+  return print_directives(p, variable_definition, direct);
+}
+
+static int print_operation_definition(GraphQLPrinter *p, VALUE operation_definition, int direct, VALUE indent, int indent_levels) {
+  VALUE variables;
+  VALUE operation_type = get(operation_definition, direct, ATTR_operation_type);
+  GraphQLSanitizer *s = p->sanitizer;
+  VALUE old_type = Qnil;
+  if (s) {
+    old_type = s->current_type;
+    s->current_type = rb_funcall(s->schema, id_public_send, 1, operation_type);
+  }
+  PRINT(write_indent(p, indent, indent_levels));
+  PRINT(write_string(p, operation_type));
+  VALUE name = get(operation_definition, direct, ATTR_name);
+  if (RTEST(name)) {
+    PRINT(write_literal(p, " "));
+    PRINT(write_string(p, name));
+  }
+  PRINT(get_list(p, operation_definition, direct, ATTR_variables, &variables));
+  // `SanitizedPrinter` leaves out variable definitions when it inlines their values
+  if (RARRAY_LEN(variables) > 0 && !(s && s->inline_variables)) {
+    PRINT(write_literal(p, "("));
+    for (long i = 0; i < RARRAY_LEN(variables); i++) {
+      if (i > 0) {
+        PRINT(write_literal(p, ", "));
+      }
+      PRINT(print_variable_definition(p, RARRAY_AREF(variables, i)));
+    }
+    PRINT(write_literal(p, ")"));
+  }
+  PRINT(print_directives(p, operation_definition, direct));
+  PRINT(print_selections(p, operation_definition, direct, indent, indent_levels));
+  if (s) {
+    s->current_type = old_type;
+  }
+  return 0;
+}
+
+static int print_schema_definition(GraphQLPrinter *p, VALUE schema, int direct, int extension) {
+  static const char *conventional_names[] = { "Query", "Mutation", "Subscription" };
+  static const char *labels[] = { "  query: ", "  mutation: ", "  subscription: " };
+  VALUE root_types[3] = {
+    get(schema, direct, ATTR_query),
+    get(schema, direct, ATTR_mutation),
+    get(schema, direct, ATTR_subscription),
+  };
+  VALUE directives;
+  int has_conventional_names = 1;
+  for (int i = 0; i < 3; i++) {
+    if (NIL_P(root_types[i])) {
+      continue;
+    } else if (!RB_TYPE_P(root_types[i], T_STRING)) {
+      // The Ruby printer interpolates it
+      return unsupported(p);
+    } else if (RSTRING_LEN(root_types[i]) != (long)strlen(conventional_names[i]) ||
+        memcmp(RSTRING_PTR(root_types[i]), conventional_names[i], RSTRING_LEN(root_types[i])) != 0) {
+      has_conventional_names = 0;
+    }
+  }
+  PRINT(get_list(p, schema, direct, ATTR_directives, &directives));
+  if (has_conventional_names && RARRAY_LEN(directives) == 0) {
+    return 0;
+  }
+  if (extension) {
+    PRINT(write_literal(p, "extend schema"));
+  } else {
+    PRINT(write_literal(p, "schema"));
+  }
+  if (RARRAY_LEN(directives) > 0) {
+    for (long i = 0; i < RARRAY_LEN(directives); i++) {
+      PRINT(write_literal(p, "\n  "));
+      PRINT(print_node(p, RARRAY_AREF(directives, i), Qnil, 0));
+    }
+    if (!has_conventional_names) {
+      PRINT(write_literal(p, "\n"));
+    }
+  }
+  if (!has_conventional_names) {
+    if (RARRAY_LEN(directives) == 0) {
+      PRINT(write_literal(p, " "));
+    }
+    PRINT(write_literal(p, "{\n"));
+    for (int i = 0; i < 3; i++) {
+      if (!NIL_P(root_types[i])) {
+        PRINT(write_bytes(p, labels[i], strlen(labels[i]), 1));
+        PRINT(write_string(p, root_types[i]));
+        PRINT(write_literal(p, "\n"));
+      }
+    }
+    PRINT(write_literal(p, "}"));
+  }
+  return 0;
+}
+
+// `extend ` for extensions, or the description and comment for definitions
+static int print_type_definition_start(GraphQLPrinter *p, VALUE node, int direct, int extension, const char *keyword) {
+  if (extension) {
+    PRINT(write_literal(p, "extend "));
+  } else {
+    PRINT(print_description_and_comment(p, node, direct));
+  }
+  PRINT(write_bytes(p, keyword, strlen(keyword), 1));
+  return print_name(p, node, direct);
+}
+
+static int print_implements(GraphQLPrinter *p, VALUE node, int direct) {
+  VALUE interfaces;
+  PRINT(get_list(p, node, direct, ATTR_interfaces, &interfaces));
+  if (RARRAY_LEN(interfaces) == 0) {
+    return 0;
+  }
+  PRINT(write_literal(p, " implements "));
+  return print_names(p, interfaces, " & ");
+}
+
+static int print_input_value_definition(GraphQLPrinter *p, VALUE input_value) {
+  int direct = direct_p(input_value);
+  PRINT(print_name(p, input_value, direct));
+  PRINT(write_literal(p, ": "));
+  PRINT(print_node(p, get(input_value, direct, ATTR_type), Qnil, 0));
+  VALUE default_value = get(input_value, direct, ATTR_default_value);
+  if (!NIL_P(default_value)) {
+    PRINT(write_literal(p, " = "));
+    PRINT(print_node(p, default_value, Qnil, 0));
+  }
+  return print_directives(p, input_value, direct);
+}
+
+// Arguments for fields and directive definitions go on one line unless any of them have descriptions or comments
+static int print_arguments(GraphQLPrinter *p, VALUE arguments, int indent) {
+  int multiline = 0;
+  for (long i = 0; i < RARRAY_LEN(arguments) && !multiline; i++) {
+    VALUE argument = RARRAY_AREF(arguments, i);
+    int direct = direct_p(argument);
+    multiline = RTEST(get(argument, direct, ATTR_description)) || RTEST(get(argument, direct, ATTR_comment));
+  }
+  if (!multiline) {
+    PRINT(write_literal(p, "("));
+    for (long i = 0; i < RARRAY_LEN(arguments); i++) {
+      if (i > 0) {
+        PRINT(write_literal(p, ", "));
+      }
+      PRINT(print_input_value_definition(p, RARRAY_AREF(arguments, i)));
+    }
+    return write_literal(p, ")");
+  }
+  PRINT(write_literal(p, "(\n"));
+  for (long i = 0; i < RARRAY_LEN(arguments); i++) {
+    VALUE argument = RARRAY_AREF(arguments, i);
+    int direct = direct_p(argument);
+    PRINT(print_comment(p, argument, direct, indent + 2, i == 0));
+    PRINT(print_description(p, argument, direct, indent + 2, i == 0));
+    PRINT(write_spaces(p, indent + 2));
+    PRINT(print_input_value_definition(p, argument));
+    if (i < RARRAY_LEN(arguments) - 1) {
+      PRINT(write_literal(p, "\n"));
+    }
+  }
+  PRINT(write_literal(p, "\n"));
+  PRINT(write_spaces(p, indent));
+  return write_literal(p, ")");
+}
+
+static int print_field_definition(GraphQLPrinter *p, VALUE field) {
+  int direct = direct_p(field);
+  VALUE arguments;
+  PRINT(print_name(p, field, direct));
+  PRINT(get_list(p, field, direct, ATTR_arguments, &arguments));
+  if (RARRAY_LEN(arguments) > 0) {
+    PRINT(print_arguments(p, arguments, 2));
+  }
+  PRINT(write_literal(p, ": "));
+  PRINT(print_node(p, get(field, direct, ATTR_type), Qnil, 0));
+  return print_directives(p, field, direct);
+}
+
+// Fields of object and interface types, or input object types' input values
+static int print_fields(GraphQLPrinter *p, VALUE node, int direct, int input_values) {
+  VALUE fields;
+  PRINT(get_list(p, node, direct, ATTR_fields, &fields));
+  if (RARRAY_LEN(fields) == 0) {
+    return 0;
+  }
+  PRINT(write_literal(p, " {\n"));
+  for (long i = 0; i < RARRAY_LEN(fields); i++) {
+    VALUE field = RARRAY_AREF(fields, i);
+    int field_direct = direct_p(field);
+    PRINT(print_description(p, field, field_direct, 2, i == 0));
+    PRINT(print_comment(p, field, field_direct, 2, i == 0));
+    PRINT(write_literal(p, "  "));
+    if (input_values) {
+      PRINT(print_input_value_definition(p, field));
+    } else {
+      PRINT(print_field_definition(p, field));
+    }
+    PRINT(write_literal(p, "\n"));
+  }
+  return write_literal(p, "}");
+}
+
+static int print_object_type_definition(GraphQLPrinter *p, VALUE object_type, int direct, int extension, const char *keyword) {
+  PRINT(print_type_definition_start(p, object_type, direct, extension, keyword));
+  PRINT(print_implements(p, object_type, direct));
+  PRINT(print_directives(p, object_type, direct));
+  return print_fields(p, object_type, direct, 0);
+}
+
+static int print_union_type_definition(GraphQLPrinter *p, VALUE union_type, int direct, int extension) {
+  VALUE types;
+  PRINT(print_type_definition_start(p, union_type, direct, extension, "union "));
+  PRINT(print_directives(p, union_type, direct));
+  PRINT(get_list(p, union_type, direct, ATTR_types, &types));
+  if (RARRAY_LEN(types) > 0) {
+    PRINT(write_literal(p, " = "));
+    PRINT(print_names(p, types, " | "));
+  }
+  return 0;
+}
+
+static int print_enum_value_definition(GraphQLPrinter *p, VALUE enum_value) {
+  int direct = direct_p(enum_value);
+  PRINT(write_literal(p, "  "));
+  PRINT(print_name(p, enum_value, direct));
+  PRINT(print_directives(p, enum_value, direct));
+  return write_literal(p, "\n");
+}
+
+static int print_enum_type_definition(GraphQLPrinter *p, VALUE enum_type, int direct, int extension) {
+  VALUE values;
+  PRINT(print_type_definition_start(p, enum_type, direct, extension, "enum "));
+  PRINT(print_directives(p, enum_type, direct));
+  PRINT(get_list(p, enum_type, direct, ATTR_values, &values));
+  if (RARRAY_LEN(values) == 0) {
+    return 0;
+  }
+  PRINT(write_literal(p, " {\n"));
+  for (long i = 0; i < RARRAY_LEN(values); i++) {
+    VALUE value = RARRAY_AREF(values, i);
+    int value_direct = direct_p(value);
+    PRINT(print_description(p, value, value_direct, 2, i == 0));
+    PRINT(print_comment(p, value, value_direct, 2, i == 0));
+    PRINT(print_enum_value_definition(p, value));
+  }
+  return write_literal(p, "}");
+}
+
+static int print_input_object_type_definition(GraphQLPrinter *p, VALUE input_object_type, int direct, int extension) {
+  PRINT(print_type_definition_start(p, input_object_type, direct, extension, "input "));
+  PRINT(print_directives(p, input_object_type, direct));
+  return print_fields(p, input_object_type, direct, 1);
+}
+
+static int print_directive_definition(GraphQLPrinter *p, VALUE directive, int direct) {
+  VALUE arguments;
+  VALUE locations;
+  PRINT(print_description(p, directive, direct, 0, 1));
+  PRINT(write_literal(p, "directive @"));
+  PRINT(print_name(p, directive, direct));
+  PRINT(get_list(p, directive, direct, ATTR_arguments, &arguments));
+  if (RARRAY_LEN(arguments) > 0) {
+    PRINT(print_arguments(p, arguments, 0));
+  }
+  if (RTEST(get(directive, direct, ATTR_repeatable))) {
+    PRINT(write_literal(p, " repeatable"));
+  }
+  PRINT(write_literal(p, " on "));
+  PRINT(get_list(p, directive, direct, ATTR_locations, &locations));
+  return print_names(p, locations, " | ");
+}
+
+static int print_document(GraphQLPrinter *p, VALUE document, int direct) {
+  VALUE definitions;
+  PRINT(get_list(p, document, direct, ATTR_definitions, &definitions));
+  for (long i = 0; i < RARRAY_LEN(definitions); i++) {
+    if (i > 0) {
+      PRINT(write_literal(p, "\n\n"));
+    }
+    PRINT(print_node(p, RARRAY_AREF(definitions, i), Qnil, 0));
+  }
+  return 0;
+}
+
+typedef struct PrintHashPairArgs {
+  GraphQLPrinter *printer;
+  long index;
+  int stopped;
+} PrintHashPairArgs;
+
+static int print_hash_pair(VALUE key, VALUE value, VALUE data) {
+  PrintHashPairArgs *args = (PrintHashPairArgs *)data;
+  GraphQLPrinter *p = args->printer;
+  if ((args->index++ > 0 && write_literal(p, ", ")) ||
+      write_string(p, key) ||
+      write_literal(p, ": ") ||
+      print_node(p, value, Qnil, 0)) {
+    args->stopped = 1;
+    return ST_STOP;
+  }
+  return ST_CONTINUE;
+}
+
+// The `case` in `Printer#print_node`, for classes the C printer knows
+static int print_known_node(GraphQLPrinter *p, PrinterNodeKind kind, VALUE node, int direct, VALUE indent, int indent_levels) {
+  switch (kind) {
+    case PRINT_Document:
+      return print_document(p, node, direct);
+    case PRINT_Argument:
+      return print_argument(p, node);
+    case PRINT_Directive:
+      return print_directive(p, node);
+    case PRINT_Enum:
+    case PRINT_TypeName:
+      return print_name(p, node, direct);
+    case PRINT_NullValue:
+      return write_literal(p, "null");
+    case PRINT_Field:
+      return print_field(p, node, direct, indent, indent_levels);
+    case PRINT_FragmentDefinition:
+      return print_fragment_definition(p, node, direct, indent, indent_levels);
+    case PRINT_FragmentSpread:
+      PRINT(write_indent(p, indent, indent_levels));
+      PRINT(write_literal(p, "..."));
+      PRINT(print_name(p, node, direct));
+      return print_directives(p, node, direct);
+    case PRINT_InlineFragment:
+      return print_inline_fragment(p, node, direct, indent, indent_levels);
+    case PRINT_InputObject: {
+      VALUE arguments;
+      PRINT(get_list(p, node, direct, ATTR_arguments, &arguments));
+      return print_argument_list(p, arguments, "{", "}");
+    }
+    case PRINT_ListType:
+      PRINT(write_literal(p, "["));
+      PRINT(print_node(p, get(node, direct, ATTR_of_type), Qnil, 0));
+      return write_literal(p, "]");
+    case PRINT_NonNullType:
+      PRINT(print_node(p, get(node, direct, ATTR_of_type), Qnil, 0));
+      return write_literal(p, "!");
+    case PRINT_OperationDefinition:
+      return print_operation_definition(p, node, direct, indent, indent_levels);
+    case PRINT_VariableDefinition:
+      return print_variable_definition(p, node);
+    case PRINT_VariableIdentifier:
+      if (p->sanitizer && p->sanitizer->inline_variables) {
+        return sanitize_variable_identifier(p, node, direct);
+      }
+      PRINT(write_literal(p, "$"));
+      return print_name(p, node, direct);
+    case PRINT_SchemaDefinition:
+    case PRINT_SchemaExtension:
+      return print_schema_definition(p, node, direct, kind == PRINT_SchemaExtension);
+    case PRINT_ScalarTypeDefinition:
+    case PRINT_ScalarTypeExtension:
+      PRINT(print_type_definition_start(p, node, direct, kind == PRINT_ScalarTypeExtension, "scalar "));
+      return print_directives(p, node, direct);
+    case PRINT_ObjectTypeDefinition:
+    case PRINT_ObjectTypeExtension:
+      return print_object_type_definition(p, node, direct, kind == PRINT_ObjectTypeExtension, "type ");
+    case PRINT_InputValueDefinition:
+      return print_input_value_definition(p, node);
+    case PRINT_FieldDefinition:
+      return print_field_definition(p, node);
+    case PRINT_InterfaceTypeDefinition:
+    case PRINT_InterfaceTypeExtension:
+      return print_object_type_definition(p, node, direct, kind == PRINT_InterfaceTypeExtension, "interface ");
+    case PRINT_UnionTypeDefinition:
+    case PRINT_UnionTypeExtension:
+      return print_union_type_definition(p, node, direct, kind == PRINT_UnionTypeExtension);
+    case PRINT_EnumTypeDefinition:
+    case PRINT_EnumTypeExtension:
+      return print_enum_type_definition(p, node, direct, kind == PRINT_EnumTypeExtension);
+    case PRINT_EnumValueDefinition:
+      return print_enum_value_definition(p, node);
+    case PRINT_InputObjectTypeDefinition:
+    case PRINT_InputObjectTypeExtension:
+      return print_input_object_type_definition(p, node, direct, kind == PRINT_InputObjectTypeExtension);
+    case PRINT_DirectiveDefinition:
+      return print_directive_definition(p, node, direct);
+    default:
+      return unsupported(p);
+  }
+}
+
+static int print_node(GraphQLPrinter *p, VALUE node, VALUE indent, int indent_levels) {
+  if (p->depth >= PRINTER_MAX_DEPTH) {
+    return unsupported(p);
+  }
+  p->depth++;
+  int result;
+  if (!RB_SPECIAL_CONST_P(node) && BUILTIN_TYPE(node) == T_OBJECT) {
+    // Find the nearest class that `print_node` handles
+    VALUE node_class = rb_obj_class(node);
+    st_data_t kind;
+    int direct = node_class == RBASIC_CLASS(node);
+    while (RTEST(node_class) && !st_lookup(node_kinds, (st_data_t)node_class, &kind)) {
+      node_class = rb_class_superclass(node_class);
+      direct = 0;
+    }
+    // Anything else is printed with `#to_s`
+    result = RTEST(node_class) ? print_known_node(p, (PrinterNodeKind)kind, node, direct, indent, indent_levels) : unsupported(p);
+  } else if (RB_TYPE_P(node, T_ARRAY)) {
+    GraphQLSanitizer *s = p->sanitizer;
+    VALUE old_input_type = Qnil;
+    if (s) {
+      // Like `SanitizedPrinter#print_node`, list items are printed with the list's item type
+      old_input_type = s->current_input_type;
+      if (RTEST(old_input_type) && RTEST(rb_funcall(old_input_type, id_list_p, 0))) {
+        s->current_input_type = nullable_type(rb_funcall(old_input_type, id_of_type, 0));
+      }
+    }
+    result = write_literal(p, "[");
+    for (long i = 0; i < RARRAY_LEN(node) && !result; i++) {
+      result = (i > 0 && write_literal(p, ", ")) || print_node(p, RARRAY_AREF(node, i), Qnil, 0);
+    }
+    result = result || write_literal(p, "]");
+    if (s) {
+      s->current_input_type = old_input_type;
+    }
+  } else if (RB_TYPE_P(node, T_HASH)) {
+    PrintHashPairArgs args = { p, 0, 0 };
+    result = write_literal(p, "{");
+    if (!result) {
+      rb_hash_foreach(node, print_hash_pair, (VALUE)&args);
+      result = args.stopped || write_literal(p, "}");
+    }
+  } else if (RB_TYPE_P(node, T_FLOAT) || RB_TYPE_P(node, T_BIGNUM) || RB_TYPE_P(node, T_FIXNUM) || RB_TYPE_P(node, T_STRING) ||
+      RB_TYPE_P(node, T_SYMBOL) || NIL_P(node) || node == Qtrue || node == Qfalse) {
+    result = p->sanitizer ? sanitize_scalar(p, node) : print_scalar(p, node);
+  } else {
+    result = unsupported(p);
+  }
+  p->depth--;
+  return result;
+}
+
+// Print `node` into a new string, or return `nil` if it should be printed by the Ruby printer instead
+static VALUE print_to_string(VALUE node, VALUE indent, long truncate_size, GraphQLSanitizer *sanitizer) {
+  GraphQLPrinter printer;
+  printer.out = rb_str_buf_new(PRINTER_INIT_CAPACITY);
+  printer.truncate_size = truncate_size;
+  printer.chars = 0;
+  printer.depth = 0;
+  printer.non_ascii = 0;
+  printer.truncated = 0;
+  printer.unsupported = 0;
+  printer.sanitizer = sanitizer;
+  print_node(&printer, node, indent, 0);
+  if (printer.unsupported) {
+    return Qnil;
+  }
+  rb_enc_associate_index(printer.out, printer.non_ascii ? rb_utf8_encindex() : rb_ascii8bit_encindex());
+  if (printer.truncated) {
+    rb_str_buf_append(printer.out, omission);
+  }
+  return printer.out;
+}
+
+static VALUE printer_print(VALUE self, VALUE node, VALUE indent, VALUE truncate_size) {
+  if (!RB_TYPE_P(indent, T_STRING)) {
+    return Qnil;
+  }
+  if (NIL_P(truncate_size)) {
+    return print_to_string(node, indent, -1, NULL);
+  } else if (FIXNUM_P(truncate_size) && FIX2LONG(truncate_size) >= 0) {
+    return print_to_string(node, indent, FIX2LONG(truncate_size), NULL);
+  } else {
+    return Qnil;
+  }
+}
+
+// `SanitizedPrinter#print(node)` for `sanitized_printer`, which prints `query`.
+// Only type lookups and the printer's own methods are called in Ruby, see `GraphQLSanitizer`.
+static VALUE printer_sanitize(VALUE self, VALUE node, VALUE sanitized_printer, VALUE query, VALUE inline_variables) {
+  GraphQLSanitizer sanitizer;
+  sanitizer.printer = sanitized_printer;
+  sanitizer.query = query;
+  sanitizer.schema = rb_funcall(query, id_schema, 0);
+  sanitizer.types = rb_funcall(query, id_types, 0);
+  sanitizer.context = rb_funcall(query, id_context, 0);
+  sanitizer.inline_variables = RTEST(inline_variables);
+  sanitizer.current_type = Qnil;
+  sanitizer.current_field = Qnil;
+  sanitizer.current_input_type = Qnil;
+  sanitizer.current_argument = Qnil;
+  sanitizer.current_directive = Qnil;
+  VALUE printed = print_to_string(node, Qnil, -1, &sanitizer);
+  RB_GC_GUARD(sanitized_printer);
+  RB_GC_GUARD(query);
+  return printed;
+}
+
+// Classes are looked up by address, so they're kept in global variables, which pins them
+#define REGISTER_NODE_CLASS(node_class_name) \
+  node_classes[PRINT_##node_class_name] = rb_const_get_at(mGraphQLLanguageNodes, rb_intern(#node_class_name)); \
+  rb_global_variable(&node_classes[PRINT_##node_class_name]); \
+  st_insert(node_kinds, (st_data_t)node_classes[PRINT_##node_class_name], PRINT_##node_class_name);
+
+#define REGISTER_ATTRIBUTE(attr_name) \
+  node_attributes[ATTR_##attr_name].ivar = rb_intern("@" #attr_name); \
+  node_attributes[ATTR_##attr_name].method = rb_intern(#attr_name);
+
+void initialize_printer_module(VALUE printer_module) {
+  VALUE mGraphQL = rb_const_get_at(rb_cObject, rb_intern("GraphQL"));
+  mGraphQLLanguage = rb_const_get_at(mGraphQL, rb_intern("Language"));
+  rb_global_variable(&mGraphQLLanguage);
+  VALUE mGraphQLLanguageNodes = rb_const_get_at(mGraphQLLanguage, rb_intern("Nodes"));
+  VALUE cGraphQLLanguagePrinter = rb_const_get_at(mGraphQLLanguage, rb_intern("Printer"));
+  omission = rb_const_get_at(cGraphQLLanguagePrinter, rb_intern("OMISSION"));
+  rb_global_variable(&omission);
+  id_serialize = rb_intern("serialize");
+  id_aref = rb_intern("[]");
+  id_context = rb_intern("context");
+  id_directives = rb_intern("directives");
+  id_field = rb_intern("field");
+  id_get_argument = rb_intern("get_argument");
+  id_kind = rb_intern("kind");
+  id_list_p = rb_intern("list?");
+  id_non_null_p = rb_intern("non_null?");
+  id_of_type = rb_intern("of_type");
+  id_public_send = rb_intern("public_send");
+  id_redact_argument_value_p = rb_intern("redact_argument_value?");
+  id_redacted_argument_value = rb_intern("redacted_argument_value");
+  id_scalar_p = rb_intern("scalar?");
+  id_schema = rb_intern("schema");
+  id_type = rb_intern("type");
+  id_types = rb_intern("types");
+  id_unwrap = rb_intern("unwrap");
+  id_value_to_ast = rb_intern("value_to_ast");
+  id_variables = rb_intern("variables");
+
+  node_kinds = st_init_numtable();
+  REGISTER_NODE_CLASS(Document)
+  REGISTER_NODE_CLASS(Argument)
+  REGISTER_NODE_CLASS(Directive)
+  REGISTER_NODE_CLASS(Enum)
+  REGISTER_NODE_CLASS(NullValue)
+  REGISTER_NODE_CLASS(Field)
+  REGISTER_NODE_CLASS(FragmentDefinition)
+  REGISTER_NODE_CLASS(FragmentSpread)
+  REGISTER_NODE_CLASS(InlineFragment)
+  REGISTER_NODE_CLASS(InputObject)
+  REGISTER_NODE_CLASS(ListType)
+  REGISTER_NODE_CLASS(NonNullType)
+  REGISTER_NODE_CLASS(OperationDefinition)
+  REGISTER_NODE_CLASS(TypeName)
+  REGISTER_NODE_CLASS(VariableDefinition)
+  REGISTER_NODE_CLASS(VariableIdentifier)
+  REGISTER_NODE_CLASS(SchemaDefinition)
+  REGISTER_NODE_CLASS(SchemaExtension)
+  REGISTER_NODE_CLASS(ScalarTypeDefinition)
+  REGISTER_NODE_CLASS(ScalarTypeExtension)
+  REGISTER_NODE_CLASS(ObjectTypeDefinition)
+  REGISTER_NODE_CLASS(ObjectTypeExtension)
+  REGISTER_NODE_CLASS(InputValueDefinition)
+  REGISTER_NODE_CLASS(FieldDefinition)
+  REGISTER_NODE_CLASS(InterfaceTypeDefinition)
+  REGISTER_NODE_CLASS(InterfaceTypeExtension)
+  REGISTER_NODE_CLASS(UnionTypeDefinition)
+  REGISTER_NODE_CLASS(UnionTypeExtension)
+  REGISTER_NODE_CLASS(EnumTypeDefinition)
+  REGISTER_NODE_CLASS(EnumTypeExtension)
+  REGISTER_NODE_CLASS(EnumValueDefinition)
+  REGISTER_NODE_CLASS(InputObjectTypeDefinition)
+  REGISTER_NODE_CLASS(InputObjectTypeExtension)
+  REGISTER_NODE_CLASS(DirectiveDefinition)
+
+  REGISTER_ATTRIBUTE(name)
+  REGISTER_ATTRIBUTE(alias)
+  REGISTER_ATTRIBUTE(value)
+  REGISTER_ATTRIBUTE(arguments)
+  REGISTER_ATTRIBUTE(directives)
+  REGISTER_ATTRIBUTE(selections)
+  REGISTER_ATTRIBUTE(type)
+  REGISTER_ATTRIBUTE(operation_type)
+  REGISTER_ATTRIBUTE(variables)
+  REGISTER_ATTRIBUTE(default_value)
+  REGISTER_ATTRIBUTE(definitions)
+  REGISTER_ATTRIBUTE(of_type)
+  REGISTER_ATTRIBUTE(description)
+  REGISTER_ATTRIBUTE(comment)
+  REGISTER_ATTRIBUTE(interfaces)
+  REGISTER_ATTRIBUTE(fields)
+  REGISTER_ATTRIBUTE(types)
+  REGISTER_ATTRIBUTE(values)
+  REGISTER_ATTRIBUTE(locations)
+  REGISTER_ATTRIBUTE(repeatable)
+  REGISTER_ATTRIBUTE(query)
+  REGISTER_ATTRIBUTE(mutation)
+  REGISTER_ATTRIBUTE(subscription)
+
+  rb_define_singleton_method(printer_module, "print", printer_print, 3);
+  rb_define_singleton_method(printer_module, "sanitize", printer_sanitize, 4);
+}
@@ -0,0 +1,38 @@
+#ifndef Graphql_printer_h
+#define Graphql_printer_h
+#include <ruby.h>
+#include <ruby/encoding.h>
+
+// What `SanitizedPrinter` tracks while it prints, see `sanitize` in printer.c.
+// Types, fields and arguments are looked up by calling the same Ruby methods it calls.
+typedef struct GraphQLSanitizer {
+  VALUE printer; // The `SanitizedPrinter`, for `redact_argument_value?`, `redacted_argument_value` and `value_to_ast`
+  VALUE query;
+  VALUE schema;
+  VALUE types;
+  VALUE context;
+  int inline_variables;
+  VALUE current_type;
+  VALUE current_field;
+  VALUE current_input_type;
+  VALUE current_argument;
+  VALUE current_directive;
+} GraphQLSanitizer;
+
+// Prints `GraphQL::Language::Nodes` like `GraphQL::Language::Printer#print`, into one string.
+//
+// Anything the Ruby printer would print differently (or raise for), like objects it calls `#to_s` on,
+// strings which aren't UTF-8, or very deep trees, stops printing, and `print` returns `nil` so that Ruby can print it instead.
+typedef struct GraphQLPrinter {
+  VALUE out;
+  long truncate_size; // In characters, or -1 for no limit
+  long chars; // Only counted with a `truncate_size`
+  int depth;
+  int non_ascii; // If so, the output is UTF-8. Otherwise, it's ASCII-8BIT, like `TruncatableBuffer` makes.
+  int truncated;
+  int unsupported;
+  GraphQLSanitizer *sanitizer; // Only while printing for `SanitizedPrinter`, otherwise NULL
+} GraphQLPrinter;
+
+void initialize_printer_module(VALUE printer_module);
+#endif
@@ -0,0 +1,197 @@
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAPHQL_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static const char *skip_blanks_scalar(const char *p, const char *pe) {
+  while (p < pe && (*p == ' ' || *p == ',' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+static const char *find_line_end_scalar(const char *p, const char *pe) {
+  while (p < pe && *p != '\n' && *p != '\r') {
+    p++;
+  }
+  return p;
+}
+
+static const char *find_string_end_scalar(const char *p, const char *pe) {
+  while (p < pe && *p != '"' && *p != '\\' && *p != '\n' && *p != '\r') {
+    p++;
+  }
+  return p;
+}
+
+static const GraphQLScanKernels scalar_kernels = {
+  "scalar",
+  skip_blanks_scalar,
+  find_line_end_scalar,
+  find_string_end_scalar,
+};
+
+#ifdef GRAPHQL_SCAN_X86
+// Each kernel compares a block of bytes at a time, then finishes the last partial block with the scalar version.
+
+__attribute__((target("sse2")))
+static const char *skip_blanks_sse2(const char *p, const char *pe) {
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i tab = _mm_set1_epi8('\t');
+  while (pe - p >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i blanks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, comma)), _mm_cmpeq_epi8(chunk, tab));
+    unsigned int others = ~(unsigned int)_mm_movemask_epi8(blanks) & 0xFFFF;
+    if (others) {
+      return p + __builtin_ctz(others);
+    }
+    p += 16;
+  }
+  return skip_blanks_scalar(p, pe);
+}
+
+__attribute__((target("sse2")))
+static const char *find_line_end_sse2(const char *p, const char *pe) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  while (pe - p >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    unsigned int found = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriage_return)));
+    if (found) {
+      return p + __builtin_ctz(found);
+    }
+    p += 16;
+  }
+  return find_line_end_scalar(p, pe);
+}
+
+__attribute__((target("sse2")))
+static const char *find_string_end_sse2(const char *p, const char *pe) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  while (pe - p >= 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i specials = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, carriage_return))
+    );
+    unsigned int found = (unsigned int)_mm_movemask_epi8(specials);
+    if (found) {
+      return p + __builtin_ctz(found);
+    }
+    p += 16;
+  }
+  return find_string_end_scalar(p, pe);
+}
+
+__attribute__((target("avx2")))
+static const char *skip_blanks_avx2(const char *p, const char *pe) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i comma = _mm256_set1_epi8(',');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  while (pe - p >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+    __m256i blanks = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, comma)), _mm256_cmpeq_epi8(chunk, tab));
+    unsigned int others = ~(unsigned int)_mm256_movemask_epi8(blanks);
+    if (others) {
+      return p + __builtin_ctz(others);
+    }
+    p += 32;
+  }
+  return skip_blanks_sse2(p, pe);
+}
+
+__attribute__((target("avx2")))
+static const char *find_line_end_avx2(const char *p, const char *pe) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+  while (pe - p >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+    unsigned int found = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, carriage_return)));
+    if (found) {
+      return p + __builtin_ctz(found);
+    }
+    p += 32;
+  }
+  return find_line_end_sse2(p, pe);
+}
+
+__attribute__((target("avx2")))
+static const char *find_string_end_avx2(const char *p, const char *pe) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i carriage_return = _mm256_set1_epi8('\r');
+  while (pe - p >= 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)p);
+    __m256i specials = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, carriage_return))
+    );
+    unsigned int found = (unsigned int)_mm256_movemask_epi8(specials);
+    if (found) {
+      return p + __builtin_ctz(found);
+    }
+    p += 32;
+  }
+  return find_string_end_sse2(p, pe);
+}
+
+static const GraphQLScanKernels sse2_kernels = {
+  "sse2",
+  skip_blanks_sse2,
+  find_line_end_sse2,
+  find_string_end_sse2,
+};
+
+static const GraphQLScanKernels avx2_kernels = {
+  "avx2",
+  skip_blanks_avx2,
+  find_line_end_avx2,
+  find_string_end_avx2,
+};
+#endif
+
+const GraphQLScanKernels *scan_kernels = &scalar_kernels;
+
+// Kernels which this CPU can run, best first
+static const GraphQLScanKernels *supported_kernels[4];
+
+void initialize_scan_kernels(void) {
+  int count = 0;
+#ifdef GRAPHQL_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    supported_kernels[count++] = &avx2_kernels;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    supported_kernels[count++] = &sse2_kernels;
+  }
+#endif
+  supported_kernels[count++] = &scalar_kernels;
+  supported_kernels[count] = NULL;
+  scan_kernels = supported_kernels[0];
+}
+
+int use_scan_kernels(const char *name) {
+  for (int i = 0; supported_kernels[i] != NULL; i++) {
+    if (strcmp(supported_kernels[i]->name, name) == 0) {
+      scan_kernels = supported_kernels[i];
+      return 1;
+    }
+  }
+  return 0;
+}
+
+VALUE available_scan_kernels(void) {
+  VALUE names = rb_ary_new();
+  for (int i = 0; supported_kernels[i] != NULL; i++) {
+    rb_ary_push(names, rb_str_new_cstr(supported_kernels[i]->name));
+  }
+  return names;
+}
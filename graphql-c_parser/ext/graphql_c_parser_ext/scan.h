@@ -0,0 +1,24 @@
+#ifndef Graphql_scan_h
+#define Graphql_scan_h
+#include <ruby.h>
+
+// Fast paths for the lexer. Each function returns a pointer to the first byte
+// in `[p, pe)` that it's looking for, or `pe` if there isn't one.
+typedef struct GraphQLScanKernels {
+  const char *name;
+  // The first byte that isn't a space, comma or tab
+  const char *(*skip_blanks)(const char *p, const char *pe);
+  // The first `\n` or `\r`
+  const char *(*find_line_end)(const char *p, const char *pe);
+  // The first `"`, `\`, `\n` or `\r`
+  const char *(*find_string_end)(const char *p, const char *pe);
+} GraphQLScanKernels;
+
+// The kernels in use, picked for this CPU by `initialize_scan_kernels`
+extern const GraphQLScanKernels *scan_kernels;
+
+void initialize_scan_kernels(void);
+// Returns 0 if there's no kernel with this name or this CPU doesn't support it
+int use_scan_kernels(const char *name);
+VALUE available_scan_kernels(void);
+#endif
@@ -1,94 +1,160 @@
 # frozen_string_literal: true
 
 require "graphql"
+# Parse errors are made in whichever Ractor is parsing, and autoload only works in the main Ractor
+require "graphql/parse_error"
 require "graphql/c_parser/version"
 require "graphql/graphql_c_parser_ext"
+require "etc"
+require "objspace"
 
 module GraphQL
   module CParser
-    def self.parse(query_str, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil)
-      Parser.parse(query_str, filename: filename, trace: trace, max_tokens: max_tokens)
+    # @param lazy [Boolean] If true, each node's children are made when they're first read, see {LazyNodes}
+    # @param comments [Boolean] If true, `#` comments before a type, field, argument or enum value definition are kept as its `comment`
+    # @param atoms [Boolean, AtomTable] If true, each name is made once per document, as a frozen string. Pass an {AtomTable} (see {AtomTable.for_schema}) to share names with the schema, too. By default, each name is a new, unfrozen string, like the Ruby parser makes.
+    # @param release_gvl [Boolean, nil] If true, other threads can run while the document is lexed and parsed. Ruby objects are made afterward, with the GVL. By default, it's released for strings of {.release_gvl_threshold} bytes or more.
+    # @param shareable [Boolean] If true, the document is deeply frozen as it's made, so that it's `Ractor.shareable?`. Its nodes' lines and columns are computed right away. It can't be `lazy:`.
+    # @param max_depth [Integer, nil] If given, parsing stops with a {GraphQL::ParseError} as soon as selection sets are nested deeper than this
+    # @param max_aliases [Integer, nil] If given, parsing stops with a {GraphQL::ParseError} once the document has more aliased fields than this
+    # @param max_fields [Integer, nil] If given, parsing stops with a {GraphQL::ParseError} once the document has more fields than this
+    # @param max_nesting [Integer, nil] How many `{`, `[` and `(` can be open at once. Past that, parsing stops with "This query is too large to execute." at the bracket which went over. `nil` means no limit.
+    #
+    # Parsed documents have {GraphQL::Language::Nodes::Document#parse_stats}, counted while parsing, for admitting or rejecting queries before they're validated.
+    #
+    # @example Rejecting a deeply-nested query before it's validated
+    #   GraphQL::CParser.parse("{ a { b { c } } }", max_depth: 2)
+    #   # GraphQL::ParseError: Query has depth of 3, which exceeds max depth of 2 at [1, 9]
+    #
+    # @example Parsing in a Ractor, then validating in another one
+    #   document = Ractor.new(query_str) { |str| GraphQL::CParser.parse(str, shareable: true) }.take
+    #   Ractor.new(document) { |doc| MySchema.validate(doc) }.take
+    def self.parse(query_str, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil, lazy: false, comments: false, atoms: false, release_gvl: nil, shareable: false, max_depth: nil, max_aliases: nil, max_fields: nil, max_nesting: self.max_nesting)
+      Parser.parse(query_str, filename: filename, trace: trace, max_tokens: max_tokens, lazy: lazy, comments: comments, atoms: atoms, release_gvl: release_gvl, shareable: shareable, max_depth: max_depth, max_aliases: max_aliases, max_fields: max_fields, max_nesting: max_nesting)
     end
 
+    # Lex and parse a batch of query strings on native threads, without the GVL, then make their nodes in order.
+    # The threads are started for each call and joined before it returns (there's no pool),
+    # so this is slower than {.parse} for a few small strings.
+    #
+    # @param query_strs [Array<String>]
+    # @param threads [Integer] How many native threads to use (at most)
+    # @param trace [GraphQL::Tracing::Trace] Its `parse` event wraps each document as its nodes are made
+    # @return [Array<GraphQL::Language::Nodes::Document, GraphQL::ParseError>] One for each query string, in order. Parse errors are returned, not raised.
+    def self.parse_many(query_strs, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil, lazy: false, comments: false, atoms: false, threads: parse_many_threads, shareable: false, max_depth: nil, max_aliases: nil, max_fields: nil, max_nesting: self.max_nesting)
+      Parser.parse_many(query_strs, filename: filename, trace: trace, max_tokens: max_tokens, lazy: lazy, comments: comments, atoms: atoms, threads: threads, shareable: shareable, max_depth: max_depth, max_aliases: max_aliases, max_fields: max_fields, max_nesting: max_nesting)
+    end
+
+    # @return [DocumentCache] A cache of frozen documents for {GraphQL::Schema.parser_cache_size}
+    def self.new_document_cache(max_size, max_bytes: DocumentCache::DEFAULT_MAX_BYTES)
+      DocumentCache.new(max_size, max_bytes: max_bytes)
+    end
+
+    class << self
+      # @return [Integer] The size in bytes of the smallest query string which is parsed without the GVL, unless `release_gvl:` is given
+      attr_accessor :release_gvl_threshold
+
+      # @return [Integer] The default number of native threads for {.parse_many}
+      attr_accessor :parse_many_threads
+
+      # @return [Integer, nil] The default `max_nesting:` for {.parse} and {.parse_many}
+      attr_accessor :max_nesting
+    end
+
+    self.parse_many_threads = Etc.nprocessors
+
+    # Bison's stacks used to stop at 10,000 entries (`YYMAXDEPTH`), and each bracket takes at least one,
+    # so anything which parsed with that limit still parses
+    self.max_nesting = 10_000
+
+    # Releasing and taking back the GVL costs a few microseconds, which is only worth it for big documents
+    self.release_gvl_threshold = 100_000
+
     def self.parse_file(filename)
       contents = File.read(filename)
       parse(contents, filename: filename)
     end
 
+    # A hash of `query_str`'s tokens, for grouping operations which differ only by whitespace, commas, comments or literal values.
+    # For example, `{ user(id: 1) { name } }` and `{user(id:2){name}}` have the same signature.
+    # Literal values are replaced by their type (`Int`, `Float`, `String` or `Boolean`). Names, including enum values, are kept.
+    #
+    # The string is lexed without making tokens. A parser computes the same signature as it lexes, see {Parser#signature}.
+    #
+    # @param query_str [String]
+    # @return [String] 16 hex digits
+    def self.signature(query_str)
+      Lexer.signature(query_str)
+    end
+
+    # `query_str` without whitespace, commas or comments, for storing it or using it as a key.
+    # Only the spaces which keep two tokens apart are left, and everything else is copied as it's written,
+    # so parsing the result makes a document `==` to the one made from `query_str`.
+    #
+    # The string is lexed once, without making tokens or a document.
+    #
+    # @example
+    #   GraphQL::CParser.minify("query Q {\n  user(id: 1, active: true) { name }\n}")
+    #   # => "query Q{user(id:1 active:true){name}}"
+    #
+    # @param query_str [String]
+    # @return [String]
+    def self.minify(query_str)
+      Lexer.minify(query_str)
+    end
+
     def self.tokenize_with_c(str)
       reject_numbers_followed_by_names = GraphQL.respond_to?(:reject_numbers_followed_by_names) && GraphQL.reject_numbers_followed_by_names
       tokenize_with_c_internal(str, false, reject_numbers_followed_by_names)
     end
 
-    def self.prepare_parse_error(message, parser)
-      query_str = parser.query_string
-      filename = parser.filename
-      if message.start_with?("memory exhausted")
-        return GraphQL::ParseError.new("This query is too large to execute.", nil, nil, query_str, filename: filename)
-      end
-      token = parser.tokens[parser.next_token_index - 1]
-      if token
-        # There might not be a token if it's a comments-only string
-        line = token[1]
-        col = token[2]
-        if line && col
-          location_str = " at [#{line}, #{col}]"
-          if !message.include?(location_str)
-            message += location_str
-          end
-        end
+    module Lexer
+      def self.tokenize(graphql_string, intern_identifiers: false, max_tokens: nil)
+        tokenize_to_buffer(graphql_string, intern_identifiers: intern_identifiers, max_tokens: max_tokens).to_a
+      end
 
-        if !message.include?("end of file")
-          message.sub!(/, unexpected ([a-zA-Z ]+)(,| at)/, ", unexpected \\1 (#{token[3].inspect})\\2")
-        end
+      # @return [GraphQL::CParser::TokenBuffer] Tokens stored in native memory
+      def self.tokenize_to_buffer(graphql_string, intern_identifiers: false, max_tokens: nil)
+        tokenize_with_c_internal(*lexer_args(graphql_string, intern_identifiers, max_tokens))
       end
 
-      GraphQL::ParseError.new(message, line, col, query_str, filename: filename)
-    end
+      # @see GraphQL::CParser.signature
+      def self.signature(graphql_string)
+        args = lexer_args(graphql_string, false, nil)
+        signature_with_c_internal(args[0], args[2])
+      end
 
-    def self.prepare_number_name_parse_error(line, col, query_str, number_part, name_part)
-      raise GraphQL::ParseError.new("Name after number is not allowed (in `#{number_part}#{name_part}`)", line, col, query_str)
-    end
+      # @see GraphQL::CParser.minify
+      def self.minify(graphql_string)
+        args = lexer_args(graphql_string, false, nil)
+        minify_with_c_internal(args[0], args[2])
+      end
 
-    def self.prepare_bad_unicode_error(parser)
-      token = parser.tokens[parser.next_token_index - 1]
-      line = token[1]
-      col = token[2]
-      GraphQL::ParseError.new(
-        "Parse error on bad Unicode escape sequence: #{token[3].inspect} (error) at [#{line}, #{col}]",
-        line,
-        col,
-        parser.query_string,
-        filename: parser.filename
-      )
-    end
+      # @param comments [Boolean] If true, each token keeps the `#` comment lines right before it. Otherwise, comments are skipped without allocating anything.
+      # @return [GraphQL::CParser::TokenStream] A lexer which {Parser} runs forward one token at a time
+      def self.token_stream(graphql_string, intern_identifiers: false, max_tokens: nil, comments: false)
+        args = lexer_args(graphql_string, intern_identifiers, max_tokens)
+        args << comments
+        token_stream_with_c_internal(*args)
+      end
 
-    module Lexer
-      def self.tokenize(graphql_string, intern_identifiers: false, max_tokens: nil)
+      def self.lexer_args(graphql_string, intern_identifiers, max_tokens)
         if !(graphql_string.encoding == Encoding::UTF_8 || graphql_string.ascii_only?)
           graphql_string = graphql_string.dup.force_encoding(Encoding::UTF_8)
         end
-        if !graphql_string.valid_encoding?
-          return [
-            [
-              :BAD_UNICODE_ESCAPE,
-              1,
-              1,
-              graphql_string,
-              241 # BAD_UNICODE_ESCAPE in lexer.rl
-            ]
-          ]
-        end
+        # If `graphql_string` isn't valid UTF-8, the lexer emits a single BAD_UNICODE_ESCAPE token.
         reject_numbers_followed_by_names = GraphQL.respond_to?(:reject_numbers_followed_by_names) && GraphQL.reject_numbers_followed_by_names
         # -1 indicates that there is no limit
         lexer_max_tokens = max_tokens.nil? ? -1 : max_tokens
-        tokenize_with_c_internal(graphql_string, intern_identifiers, reject_numbers_followed_by_names, lexer_max_tokens)
+        [graphql_string, intern_identifiers, reject_numbers_followed_by_names, lexer_max_tokens]
       end
+
+      private_class_method :lexer_args
     end
 
     class Parser
-      def self.parse(query_str, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil)
-        self.new(query_str, filename, trace, max_tokens).result
+      def self.parse(query_str, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil, lazy: false, comments: false, atoms: false, release_gvl: nil, shareable: false, max_depth: nil, max_aliases: nil, max_fields: nil, max_nesting: GraphQL::CParser.max_nesting)
+        self.new(query_str, filename, trace, max_tokens, lazy: lazy, comments: comments, atoms: atoms, release_gvl: release_gvl, shareable: shareable, max_depth: max_depth, max_aliases: max_aliases, max_fields: max_fields, max_nesting: max_nesting).result
       end
 
       def self.parse_file(filename)
@@ -96,49 +162,347 @@ module GraphQL
         parse(contents, filename: filename)
       end
 
-      def initialize(query_string, filename, trace, max_tokens)
+      # @see GraphQL::CParser.parse_many
+      def self.parse_many(query_strs, filename: nil, trace: GraphQL::Tracing::NullTrace, max_tokens: nil, lazy: false, comments: false, atoms: false, threads: GraphQL::CParser.parse_many_threads, shareable: false, max_depth: nil, max_aliases: nil, max_fields: nil, max_nesting: GraphQL::CParser.max_nesting)
+        results = Array.new(query_strs.size)
+        parsers = {}
+        query_strs.each_with_index do |query_str, idx|
+          parsers[idx] = self.new(query_str, filename, trace, max_tokens, lazy: lazy, comments: comments, atoms: atoms, release_gvl: true, shareable: shareable, max_depth: max_depth, max_aliases: max_aliases, max_fields: max_fields, max_nesting: max_nesting)
+        rescue GraphQL::ParseError => err
+          results[idx] = err
+        end
+        c_parse_many(parsers.values, parsers.each_value.map(&:prepare_token_stream), atoms, threads)
+        parsers.each do |idx, parser|
+          results[idx] = begin
+            parser.finish_parse
+          rescue GraphQL::ParseError => err
+            err
+          end
+        end
+        results
+      end
+
+      def initialize(query_string, filename, trace, max_tokens, lazy: false, comments: false, atoms: false, release_gvl: nil, shareable: false, max_depth: nil, max_aliases: nil, max_fields: nil, max_nesting: GraphQL::CParser.max_nesting)
         if query_string.nil?
           raise GraphQL::ParseError.new("No query string was present", nil, nil, query_string)
         end
-        @query_string = query_string
-        @filename = filename
-        @tokens = nil
-        @next_token_index = 0
+        if lazy && shareable
+          raise ArgumentError, "Lazy nodes can't be shareable, pass `lazy: false` with `shareable: true`"
+        end
+        # The query string, filename, limits and lexer are kept in native memory, see parser.h.
+        # -1 indicates that there is no limit
+        c_initialize(query_string, filename, max_depth || -1, max_aliases || -1, max_fields || -1, max_nesting || -1)
         @result = nil
         @trace = trace
         @intern_identifiers = false
         @max_tokens = max_tokens
+        @lazy = lazy
+        @comments = comments
+        @atoms = atoms
+        @release_gvl = release_gvl.nil? ? query_string.bytesize >= GraphQL::CParser.release_gvl_threshold : release_gvl
+        @shareable = shareable
       end
 
       def result
         if @result.nil?
-          @tokens = @trace.lex(query_string: @query_string) do
-            GraphQL::CParser::Lexer.tokenize(@query_string, intern_identifiers: @intern_identifiers, max_tokens: @max_tokens)
-          end
-          @trace.parse(query_string: @query_string) do
-            c_parse
-            @result
+          token_stream = prepare_token_stream
+          @trace.parse(query_string: query_string) do
+            # The AST is built in native memory, then turned into `GraphQL::Language::Nodes`
+            @result = c_parse(token_stream, @lazy, @atoms, @release_gvl, @shareable)
           end
         end
         @result
+      rescue SystemStackError
+        raise_too_large
       end
 
       def tokens_count
         result
-        @tokens.length
+        token_stream.tokens_count
       end
 
-      attr_reader :tokens, :next_token_index, :query_string, :filename
+      # @return [String] The signature of the parsed string, made while it was lexed (see {GraphQL::CParser.signature})
+      def signature
+        result
+        token_stream.signature
+      end
+
+      # Make the nodes of a document parsed by {.parse_many}, or raise its error
+      # @api private
+      def finish_parse
+        @trace.parse(query_string: query_string) do
+          @result = c_finish_parse(@lazy, @shareable)
+        end
+      rescue SystemStackError
+        raise_too_large
+      end
+
+      # @api private
+      def prepare_token_stream
+        source = query_string
+        if @release_gvl && !source.frozen?
+          # Other threads run during the parse, so they mustn't change the string.
+          # A frozen copy shares the original's bytes.
+          source = source.dup.freeze
+        end
+        @trace.lex(query_string: query_string) do
+          GraphQL::CParser::Lexer.token_stream(source, intern_identifiers: @intern_identifiers, max_tokens: @max_tokens, comments: @comments)
+        end
+      end
+
+      private
+
+      # Without `max_nesting:`, a document can be too deep to make nodes for, like in the Ruby parser
+      def raise_too_large
+        raise GraphQL::ParseError.new("This query is too large to execute.", nil, nil, query_string, filename: filename)
+      end
     end
 
     class SchemaParser < Parser
-      def initialize(*args)
+      def initialize(*args, **kwargs)
         super
         @intern_identifiers = true
       end
     end
   end
 
+  module CParser
+    # Frozen names which parsed documents share, instead of making new strings for them.
+    # Make one with {.new} from a list of names, or with {.for_schema}. Tables are frozen and `Ractor.shareable?`.
+    class AtomTable
+      # Tables are cached in the main Ractor. Other Ractors can only get the table of a schema which uses {GraphQL::Schema::RactorShareable},
+      # since it's built when that schema is frozen. For other schemas, call this in the main Ractor and send the table to them.
+      #
+      # @param schema [Class<GraphQL::Schema>]
+      # @return [AtomTable] The names of `schema`'s types, fields, arguments, enum values and directives, made once for each schema
+      def self.for_schema(schema)
+        if schema.respond_to?(:parser_atom_table) && (table = schema.parser_atom_table)
+          table
+        elsif Ractor.current.equal?(Ractor.main)
+          # This isn't synchronized, since a race only makes an extra table
+          cache = (@for_schema ||= ObjectSpace::WeakMap.new)
+          cache[schema] ||= new(schema_names(schema))
+        else
+          raise GraphQL::Error, "AtomTable.for_schema(#{schema}) can only be called in the main Ractor, unless the schema uses GraphQL::Schema::RactorShareable. Call it in the main Ractor and send the table to this one, it's shareable."
+        end
+      end
+
+      def self.schema_names(schema)
+        names = []
+        add_arguments = ->(owner) { owner.all_argument_definitions.each { |arg| names << arg.graphql_name } }
+        schema.types.each_value do |type|
+          names << type.graphql_name
+          if type.kind.fields?
+            type.all_field_definitions.each do |field|
+              names << field.graphql_name
+              add_arguments.call(field)
+            end
+          end
+          if type.kind.input_object?
+            add_arguments.call(type)
+          end
+          if type.kind.enum?
+            type.all_enum_value_definitions.each { |value| names << value.graphql_name }
+          end
+        end
+        schema.directives.each_value do |directive|
+          names << directive.graphql_name
+          add_arguments.call(directive)
+        end
+        names.uniq!
+        names
+      end
+
+      private_class_method :schema_names
+    end
+
+    # A thread-safe, least-recently-used cache of parsed documents, in native memory.
+    #
+    # Documents are looked up by their query strings' bytes, `max_tokens:` and `GraphQL.reject_numbers_followed_by_names`, so a hit costs a hash and a table lookup.
+    # Cached documents are parsed with `shareable: true`, so they're deeply frozen (like {GraphQL::Language::Nodes::AbstractNode#deep_freeze}) and shared by everyone who parses that string.
+    #
+    # @example Caching up to 500 documents, using at most 16MB
+    #   cache = GraphQL::CParser::DocumentCache.new(500, max_bytes: 16 * 1024 * 1024)
+    #   cache.parse("{ __typename }") # => #<GraphQL::Language::Nodes::Document ...>
+    #   cache.stats # => { size: 1, bytesize: 1432, hits: 0, misses: 1, evictions: 0, ... }
+    class DocumentCache
+      DEFAULT_MAX_BYTES = 64 * 1024 * 1024
+
+      # @param max_size [Integer] How many documents to keep
+      # @param max_bytes [Integer] How much memory (estimated with `ObjectSpace.memsize_of`) cached documents may use in total
+      def initialize(max_size, max_bytes: DEFAULT_MAX_BYTES)
+        c_initialize(max_size, max_bytes)
+      end
+
+      # Return the cached document for `query_str`, or parse, freeze and cache it.
+      # Parse errors are raised and not cached.
+      #
+      # `trace`'s `lex` and `parse` events run for hits too, with the same `query_string:`, so tracers see them for every query.
+      # Nothing is lexed for a hit, so its `lex` block returns `nil`. Hits are counted in {#stats}.
+      # @return [GraphQL::Language::Nodes::Document]
+      def parse(query_str, trace: GraphQL::Tracing::NullTrace, max_tokens: nil)
+        if query_str.nil?
+          return GraphQL::CParser.parse(query_str, trace: trace, max_tokens: max_tokens)
+        end
+        reject_numbers_followed_by_names = GraphQL.respond_to?(:reject_numbers_followed_by_names) && GraphQL.reject_numbers_followed_by_names
+        document = c_lookup(query_str, max_tokens, reject_numbers_followed_by_names)
+        if document
+          trace.lex(query_string: query_str) { nil }
+          trace.parse(query_string: query_str) { document }
+        else
+          # Cached documents are frozen anyway, so their names can be shared
+          document = GraphQL::CParser.parse(query_str, trace: trace, max_tokens: max_tokens, shareable: true, atoms: true)
+          c_store(query_str, max_tokens, reject_numbers_followed_by_names, document, memsize(document, {}.compare_by_identity))
+        end
+      end
+
+      # @return [GraphQL::Language::Nodes::Document, nil] The cached document for `query_str` and `max_tokens`, lexed with the current `GraphQL.reject_numbers_followed_by_names`
+      def [](query_str, max_tokens)
+        reject_numbers_followed_by_names = GraphQL.respond_to?(:reject_numbers_followed_by_names) && GraphQL.reject_numbers_followed_by_names
+        c_lookup(query_str, max_tokens, reject_numbers_followed_by_names)
+      end
+
+      private
+
+      # Nodes are reachable from more than one list (like `selections` and `children`), so each object is counted once
+      def memsize(value, seen)
+        case value
+        when GraphQL::Language::Nodes::AbstractNode, Array, String
+          if seen.key?(value)
+            return 0
+          end
+          seen[value] = true
+          size = ObjectSpace.memsize_of(value)
+          if value.is_a?(Array)
+            size += value.sum { |v| memsize(v, seen) }
+          elsif !value.is_a?(String)
+            size += value.instance_variables.sum { |ivar| memsize(value.instance_variable_get(ivar), seen) }
+          end
+          size
+        else
+          0
+        end
+      end
+    end
+
+    # Query fingerprints made in C, with SipHash-2-4 (128-bit output) and a fixed key.
+    # Choose it with `GraphQL::Query::Fingerprint.algorithm = :siphash`.
+    #
+    # `.generate` hashes a string's bytes where they are. `.generate_for_variables` hashes the JSON for a Hash as it walks it,
+    # without making a JSON string. For JSON-like values, it matches `generate(JSON.generate(variables))`.
+    module Fingerprint
+    end
+
+    GraphQL::Query::Fingerprint.register_algorithm(:siphash, Fingerprint)
+
+    # A binary format for parsed documents, which `GraphQL::Language::Cache` uses instead of `Marshal`.
+    #
+    # `.dump` writes each node's `marshal_dump` into tables of strings, nodes and values. `.load` reads those tables
+    # in one pass and makes nodes without calling any Ruby methods. `.load_file` reads a file in place, with `mmap`.
+    # Invalid data raises `ArgumentError`, and values which can't be written (besides nodes, only `nil`, booleans,
+    # numbers, symbols, strings and arrays can be) raise `TypeError`.
+    module BinaryAST
+    end
+
+    # Prints `GraphQL::Language::Nodes` in C, for `GraphQL::Language::Printer#print` (see `Printer.native_print?`).
+    #
+    # `.print(node, indent, truncate_size)` makes the same string as the Ruby printer, in one buffer. It returns `nil`
+    # for anything it leaves to Ruby, like objects which are printed with `#to_s` or strings which aren't UTF-8.
+    #
+    # `.sanitize(node, sanitized_printer, query, inline_variables)` prints like `GraphQL::Language::SanitizedPrinter`
+    # (see `SanitizedPrinter.native_sanitize?`). It calls Ruby to look up fields, arguments and types,
+    # and for the printer's `redact_argument_value?`, `redacted_argument_value` and `value_to_ast`.
+    module Printer
+    end
+
+    # Subclasses of `GraphQL::Language::Nodes` made by `parse(..., lazy: true)`.
+    #
+    # Their lists of children stay in the parser's native arena (a {Document})
+    # until they're first read. After that, they behave like the node classes they inherit from.
+    module LazyNodes
+      module LazyNode
+        # Equal to eagerly-built nodes, too
+        def ==(other)
+          return true if equal?(other)
+          other.kind_of?(self.class.superclass) &&
+            other.scalars == self.scalars &&
+            other.children == self.children
+        end
+
+        def children
+          materialize_children
+          super
+        end
+
+        def marshal_dump
+          materialize_children
+          super
+        end
+
+        # Share children with `other`, like a copy of an eagerly-built node would
+        def initialize_copy(other)
+          super
+          if @c_node_id
+            @c_node_id = nil
+            @c_document = nil
+            copy_children_from(other)
+          end
+        end
+
+        private
+
+        def materialize_children
+          if @c_node_id
+            @c_document.materialize_children(self, @c_node_id)
+            @c_node_id = nil
+            @c_document = nil
+          end
+        end
+      end
+
+      GraphQL::Language::Nodes.constants.each do |const_name|
+        node_class = GraphQL::Language::Nodes.const_get(const_name)
+        if !(node_class.is_a?(Class) && node_class < GraphQL::Language::Nodes::AbstractNode)
+          next
+        end
+        children_methods = node_class.ancestors.each do |ancestor|
+          if ancestor.respond_to?(:children_of_type) && (methods = ancestor.children_of_type)
+            break methods
+          end
+        end
+        if !children_methods.is_a?(Hash) || children_methods.empty?
+          # There's nothing to make lazily
+          next
+        end
+
+        # Define the class with a name, since `AbstractNode.inherited` needs one
+        module_eval <<-RUBY, __FILE__, __LINE__ + 1
+          class #{const_name} < GraphQL::Language::Nodes::#{const_name}
+            include LazyNode
+            self.children_method_name = superclass.children_method_name
+          end
+        RUBY
+        lazy_class = const_get(const_name)
+        children_methods.each_key do |method_name|
+          lazy_class.class_eval <<-RUBY, __FILE__, __LINE__ + 1
+            def #{method_name}
+              materialize_children
+              @#{method_name}
+            end
+          RUBY
+        end
+        lazy_class.class_eval <<-RUBY, __FILE__, __LINE__ + 1
+          private
+
+          def copy_children_from(other)
+            #{children_methods.each_key.map { |m| "@#{m} = other.#{m}" }.join("; ")}
+          end
+        RUBY
+        register_lazy_node_class(node_class, lazy_class, children_methods.keys.map { |m| :"@#{m}" })
+      end
+    end
+  end
+
   def self.scan_with_c(graphql_string)
     GraphQL::CParser::Lexer.tokenize(graphql_string)
   end
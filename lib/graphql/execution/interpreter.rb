@@ -40,6 +40,7 @@ module GraphQL
           trace = multiplex.current_trace
           Fiber[:__graphql_current_multiplex] = multiplex
           trace.execute_multiplex(multiplex: multiplex) do
+            multiplex.parse_queries
             schema = multiplex.schema
             queries = multiplex.queries
             multiplex_analyzers = schema.multiplex_analyzers
@@ -42,6 +42,30 @@ module GraphQL
       def logger
         @logger ||= @schema.logger_for(context)
       end
+
+      # If the parser can parse a batch of strings at once (like `GraphQL::CParser.parse_many`),
+      # and {Schema.multiplex_parse_many_min_bytes} is set, parse every query string up front, instead of one at a time.
+      # Parse errors are kept for each query, which handles them like it would have.
+      #
+      # Queries are batched by their `current_trace`, so that each one's `lex` and `parse` events
+      # go to the same trace as they would in {Query#prepare_ast}. A query with its own trace is parsed by itself, later.
+      def parse_queries
+        min_bytes = @schema.multiplex_parse_many_min_bytes
+        return if min_bytes.nil?
+        parser = GraphQL.default_parser
+        return unless parser.respond_to?(:parse_many)
+        # Cached documents are cheaper than a batch parse, see `Schema.parser_cache_size`
+        return if @schema.parser_cache
+        unparsed_queries = @queries.select { |q| q.is_a?(GraphQL::Query) && q.needs_parse? }
+        return if unparsed_queries.size < 2
+        unparsed_queries.group_by(&:current_trace).each do |trace, trace_queries|
+          next if trace_queries.size < 2 || trace_queries.sum { |q| q.query_string.bytesize } < min_bytes
+          documents = parser.parse_many(trace_queries.map(&:query_string), trace: trace, max_tokens: @schema.max_query_string_tokens)
+          trace_queries.each_with_index do |query, idx|
+            query.parsed_document = documents[idx]
+          end
+        end
+      end
     end
   end
 end
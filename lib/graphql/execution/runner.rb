@@ -82,6 +82,7 @@ module GraphQL
         end
 
         trace.execute_multiplex(multiplex: @multiplex) do
+          @multiplex.parse_queries
           trace.begin_analyze_multiplex(@multiplex, multiplex_analyzers)
           @schema.analysis_engine.analyze_multiplex(@multiplex, multiplex_analyzers)
           trace.end_analyze_multiplex(@multiplex, multiplex_analyzers)
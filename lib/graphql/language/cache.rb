@@ -19,6 +19,9 @@ module GraphQL
     # signing. This should only be used when the cache directory is trusted.
     # This will create a directory (`tmp/cache/graphql` by default) that stores a cache of parsed files.
     #
+    # When `graphql-c_parser` is loaded, documents are stored in its binary format (see `GraphQL::CParser::BinaryAST`),
+    # which loads faster than `Marshal`. Other payloads, and all payloads without it, are stored with `Marshal`.
+    #
     # Much like [bootsnap](https://github.com/Shopify/bootsnap), the parser cache needs to be cleaned up manually.
     # You will need to clear the cache directory for each new deployment of your application.
     # Also note that the parser cache will grow as your schema is loaded, so the cache directory must be writable.
@@ -35,6 +38,7 @@ module GraphQL
 
       DIGEST = Digest::SHA256.new << GraphQL::VERSION
       HMAC_SIZE = OpenSSL::Digest::SHA256.new.digest_length
+      MARSHAL_HEADER = Marshal.dump(nil).byteslice(0, 2)
       InvalidCache = Class.new(StandardError)
       private_constant :InvalidCache
 
@@ -69,8 +73,18 @@ module GraphQL
       end
 
       def load_cache(cache_path, cache_key)
+        if !@secret
+          if cache_path.binread(MARSHAL_HEADER.bytesize) == MARSHAL_HEADER
+            return Marshal.load(cache_path.binread)
+          elsif (binary_ast = self.binary_ast)
+            # Without a signature to check, the file can be read in place instead of copied to a string first
+            return load_binary_ast { binary_ast.load_file(cache_path.to_s) }
+          else
+            raise InvalidCache
+          end
+        end
+
         cache_data = cache_path.binread
-        return Marshal.load(cache_data) unless @secret
 
         signature = cache_data.byteslice(0, HMAC_SIZE)
         payload = cache_data.byteslice(HMAC_SIZE..-1)
@@ -80,12 +94,12 @@ module GraphQL
         unless secure_compare(signature, expected_signature)
           raise InvalidCache
         end
-        Marshal.load(payload)
+        deserialize(payload)
       end
 
       def write_cache(cache_path, cache_key, payload)
         @path.mkpath
-        serialized_payload = Marshal.dump(payload)
+        serialized_payload = serialize(payload)
         cache_data = if @secret
           signature_for(cache_key, serialized_payload) + serialized_payload
         else
@@ -102,6 +116,39 @@ module GraphQL
         end
       end
 
+      def serialize(payload)
+        if (binary_ast = self.binary_ast)
+          begin
+            return binary_ast.dump(payload)
+          rescue TypeError
+            # It isn't a document, or it has something the binary format can't hold
+          end
+        end
+        Marshal.dump(payload)
+      end
+
+      def deserialize(serialized_payload)
+        if serialized_payload.start_with?(MARSHAL_HEADER)
+          Marshal.load(serialized_payload)
+        elsif (binary_ast = self.binary_ast)
+          load_binary_ast { binary_ast.load(serialized_payload) }
+        else
+          # It was written with graphql-c_parser, which isn't loaded now
+          raise InvalidCache
+        end
+      end
+
+      def load_binary_ast
+        yield
+      rescue ArgumentError
+        # It was written by a different version, or it refers to a class that isn't loaded
+        raise InvalidCache
+      end
+
+      def binary_ast
+        defined?(GraphQL::CParser::BinaryAST) ? GraphQL::CParser::BinaryAST : nil
+      end
+
       def signature_for(cache_key, payload)
         OpenSSL::HMAC.digest('SHA256', @secret, cache_key + payload)
       end
@@ -33,16 +33,18 @@ module GraphQL
 
         attr_reader :filename
 
+        # These are only memoized when there's a source, so that they work on frozen nodes, too.
+        # Nodes which were frozen with their source (for example, by `Ractor.make_shareable`) compute them each time.
         def line
-          @line ||= @source&.line_at(@pos)
+          @line || (@source && (frozen? ? @source.line_at(@pos) : (@line = @source.line_at(@pos))))
         end
 
         def col
-          @col ||= @source&.column_at(@pos)
+          @col || (@source && (frozen? ? @source.column_at(@pos) : (@col = @source.column_at(@pos))))
         end
 
         def definition_line
-          @definition_line ||= (@source && @definition_pos) ? @source.line_at(@definition_pos) : nil
+          @definition_line || ((@source && @definition_pos) ? (frozen? ? @source.line_at(@definition_pos) : (@definition_line = @source.line_at(@definition_pos))) : nil)
         end
 
         # Value equality
@@ -93,6 +95,24 @@ module GraphQL
           end
         end
 
+        # Calculate this node's memoized values, then freeze it and everything in it,
+        # so that it can be shared between queries and threads (see `GraphQL::CParser::DocumentCache`).
+        # @return [self]
+        def deep_freeze
+          return self if frozen?
+          if @source
+            line
+            col
+            @definition_pos && definition_line
+            # Positions were calculated from the source, so it isn't needed anymore
+            @source = nil
+          end
+          children
+          scalars
+          instance_variables.each { |ivar| deep_freeze_value(instance_variable_get(ivar)) }
+          freeze
+        end
+
         # This creates a copy of `self`, with `new_options` applied.
         # @param new_options [Hash]
         # @return [AbstractNode] a shallow copy of `self`
@@ -144,6 +164,20 @@ module GraphQL
           self
         end
 
+        private
+
+        def deep_freeze_value(value)
+          case value
+          when AbstractNode
+            value.deep_freeze
+          when Array
+            value.each { |v| deep_freeze_value(v) }
+            value.freeze
+          else
+            value.freeze
+          end
+        end
+
         class << self
           # rubocop:disable Development/NoEvalCop This eval takes static inputs at load-time
 
@@ -219,8 +253,8 @@ module GraphQL
               else
                 module_eval <<-RUBY, __FILE__, __LINE__
                   def children
-                    @children ||= begin
-                      if #{children_of_type.keys.map { |k| "@#{k}.any?" }.join(" || ")}
+                    @children || begin
+                      new_children = if #{children_of_type.keys.map { |k| "@#{k}.any?" }.join(" || ")}
                         new_children = []
                         #{children_of_type.keys.map { |k| "new_children.concat(@#{k})" }.join("; ")}
                         new_children.freeze
@@ -228,6 +262,7 @@ module GraphQL
                       else
                         NO_CHILDREN
                       end
+                      frozen? ? new_children : (@children = new_children)
                     end
                   end
                 RUBY
@@ -265,7 +300,10 @@ module GraphQL
                 attr_reader #{method_names.map { |m| ":#{m}"}.join(", ")}
 
                 def scalars
-                  @scalars ||= [#{method_names.map { |k| "@#{k}" }.join(", ")}].freeze
+                  @scalars || begin
+                    new_scalars = [#{method_names.map { |k| "@#{k}" }.join(", ")}].freeze
+                    frozen? ? new_scalars : (@scalars = new_scalars)
+                  end
                 end
               RUBY
             end
@@ -313,6 +351,11 @@ module GraphQL
                 assignments << "@definition_pos = definition_pos"
               end
 
+              if name.end_with?("::Document")
+                # Only set by `GraphQL::CParser`, but assigned here too so that documents have the same instance variables
+                assignments << "@parse_stats = nil"
+              end
+
               keywords = scalar_method_names.map { |m| "#{m}: #{m}"} +
                 children_method_names.map { |m| "#{m}: #{m}" }
 
@@ -378,7 +421,10 @@ module GraphQL
         #   @return [String, Float, Integer, Boolean, Array, InputObject, VariableIdentifier] The value passed for this key
 
         def children
-          @children ||= Array(value).flatten.tap { _1.select! { |v| v.is_a?(AbstractNode) } }
+          @children || begin
+            new_children = Array(value).flatten.tap { _1.select! { |v| v.is_a?(AbstractNode) } }
+            frozen? ? new_children : (@children = new_children)
+          end
         end
       end
 
@@ -620,6 +666,11 @@ module GraphQL
         # @!attribute definitions
         #   @return [Array<OperationDefinition, FragmentDefinition>] top-level GraphQL units: operations or fragments
 
+        # @return [Hash{Symbol => Integer}, nil] Counted by `GraphQL::CParser` while it parsed this document (otherwise, `nil`):
+        #   `:max_depth` (the deepest nesting of selection sets), `:fields`, `:aliases`, `:directives`, `:fragment_spreads`
+        #   and `:max_list_size` (the most items in one list value). Copies made with {#merge} keep the original's stats.
+        attr_reader :parse_stats
+
         def slice_definition(name)
           GraphQL::Language::DefinitionSlice.slice(self, name)
         end
@@ -53,6 +53,9 @@ module GraphQL
       # @return [String] Valid GraphQL for `node`
       def print(node, indent: "", truncate_size: nil)
         truncate_size = truncate_size ? [truncate_size - OMISSION.size, 0].max : nil
+        if self.class.native_print? && (printed = GraphQL::CParser::Printer.print(node, indent, truncate_size))
+          return printed
+        end
         @out = TruncatableBuffer.new(truncate_size: truncate_size)
         print_node(node, indent: indent)
         @out.to_string
@@ -60,6 +63,21 @@ module GraphQL
         @out.to_string << OMISSION
       end
 
+      # When `graphql-c_parser` is loaded, {#print} uses `GraphQL::CParser::Printer`, which makes the same string in C.
+      # Printers which override any of {PRINT_METHODS} print in Ruby instead.
+      # @return [Boolean]
+      def self.native_print?
+        return false unless defined?(GraphQL::CParser::Printer)
+        return true if self == Printer
+        ancestors.each do |ancestor|
+          return true if ancestor == Printer
+          if PRINT_METHODS.any? { |m| ancestor.method_defined?(m, false) || ancestor.private_method_defined?(m, false) }
+            return false
+          end
+        end
+        false
+      end
+
       protected
 
       def print_string(str)
@@ -568,6 +586,10 @@ module GraphQL
           print_string(GraphQL::Language.serialize(node.to_s))
         end
       end
+
+      PRINT_METHODS = (public_instance_methods(false) + protected_instance_methods(false) + private_instance_methods(false))
+        .select { |m| m.start_with?("print_") }
+        .freeze
     end
   end
 end
@@ -30,12 +30,31 @@ module GraphQL
       # @return [String, nil] A scrubbed query string, if the query was valid.
       def sanitized_query_string
         if query.valid?
+          if self.class.native_sanitize? && (printed = GraphQL::CParser::Printer.sanitize(query.document, self, query, @inline_variables))
+            return printed
+          end
           print(query.document)
         else
           nil
         end
       end
 
+      # When `graphql-c_parser` is loaded, {#sanitized_query_string} prints in C with `GraphQL::CParser::Printer.sanitize`,
+      # which calls this printer's {#redact_argument_value?}, {#redacted_argument_value} and `value_to_ast`,
+      # and looks up types with the same methods as the Ruby printer.
+      # Printers which override any of {NATIVE_SANITIZE_METHODS} print in Ruby instead.
+      # @return [Boolean]
+      def self.native_sanitize?
+        return false unless defined?(GraphQL::CParser::Printer)
+        ancestors.each do |ancestor|
+          return true if ancestor == SanitizedPrinter
+          if NATIVE_SANITIZE_METHODS.any? { |m| ancestor.method_defined?(m, false) || ancestor.private_method_defined?(m, false) }
+            return false
+          end
+        end
+        false
+      end
+
       def print_node(node, indent: "")
         case node
         when FalseClass, Float, Integer, String, TrueClass
@@ -215,6 +234,8 @@ module GraphQL
       end
 
       attr_reader :query
+
+      NATIVE_SANITIZE_METHODS = (PRINT_METHODS + [:coerce_argument_value_to_list?]).freeze
     end
   end
 end
@@ -98,6 +98,16 @@ module GraphQL
 
     attr_writer :query_string
 
+    # @api private
+    # @return [Boolean] true if this query has a string which hasn't been parsed yet
+    def needs_parse?
+      !@prepared_ast && @document.nil? && !@query_string.nil? && @parsed_document.nil?
+    end
+
+    # @api private
+    # @param document_or_error [GraphQL::Language::Nodes::Document, GraphQL::ParseError] The result of parsing {#query_string}, see {Execution::Multiplex#parse_queries}
+    attr_writer :parsed_document
+
     # @return [GraphQL::Language::Nodes::Document]
     def document
       # It's ok if this hasn't been assigned yet
@@ -178,6 +188,7 @@ module GraphQL
 
       @query_string = query_string || query
       @document = document
+      @parsed_document = nil
 
       if @query_string && @document
         raise ArgumentError, "Query should only be provided a query string or a document, not both."
@@ -358,7 +369,7 @@ module GraphQL
 
     # @return [String] An opaque hash for identifying this query's given a variable values (not including defaults)
     def variables_fingerprint
-      @variables_fingerprint ||= "#{provided_variables.size}/#{Fingerprint.generate(provided_variables.to_json)}"
+      @variables_fingerprint ||= "#{provided_variables.size}/#{Fingerprint.generate_for_variables(provided_variables)}"
     end
 
     def validation_pipeline
@@ -457,7 +468,13 @@ module GraphQL
       @warden ||= @schema.warden_class.new(schema: @schema, context: @context)
       parse_error = nil
       @document ||= begin
-        if query_string
+        if @parsed_document.is_a?(GraphQL::ParseError)
+          raise @parsed_document
+        elsif @parsed_document
+          @parsed_document
+        elsif query_string && (parser_cache = @schema.parser_cache)
+          parser_cache.parse(query_string, trace: self.current_trace, max_tokens: @schema.max_query_string_tokens)
+        elsif query_string
           GraphQL.parse(query_string, trace: self.current_trace, max_tokens: @schema.max_query_string_tokens)
         end
       rescue GraphQL::ParseError => err
@@ -1,5 +1,6 @@
 # frozen_string_literal: true
 
+require 'base64'
 require 'digest/sha2'
 
 module GraphQL
@@ -9,6 +10,47 @@ module GraphQL
     # @see Query#variables_fingerprint
     # @see Query#fingerprint
     module Fingerprint
+      # The default algorithm: a SHA256 digest, encoded with URL-safe Base64.
+      module SHA256
+        def self.generate(input_str)
+          bytes = Digest::SHA256.digest(input_str)
+          Base64.urlsafe_encode64(bytes)
+        end
+
+        def self.generate_for_variables(variables)
+          generate(variables.to_json)
+        end
+      end
+
+      @algorithms = { sha256: SHA256 }
+      @algorithm = SHA256
+
+      class << self
+        # Add an algorithm which can be chosen with {.algorithm=}.
+        # `graphql-c_parser` adds `:siphash`, which is implemented in C.
+        # @param name [Symbol]
+        # @param implementation [#generate, #generate_for_variables]
+        # @return [void]
+        def register_algorithm(name, implementation)
+          @algorithms[name] = implementation
+        end
+
+        # @return [#generate, #generate_for_variables] The algorithm used by {.generate} and {.generate_for_variables}
+        attr_reader :algorithm
+
+        # Changing the algorithm changes every fingerprint, so choose it before running queries.
+        # @param new_algorithm [Symbol, #generate] The name of a registered algorithm (like `:sha256` or `:siphash`), or an implementation
+        def algorithm=(new_algorithm)
+          @algorithm = if new_algorithm.is_a?(Symbol)
+            @algorithms.fetch(new_algorithm) {
+              raise ArgumentError, "Unknown fingerprint algorithm: #{new_algorithm.inspect} (registered: #{@algorithms.keys.map(&:inspect).join(", ")})"
+            }
+          else
+            new_algorithm
+          end
+        end
+      end
+
       # Make an obfuscated hash of the given string (either a query string or variables JSON)
       # @param string [String]
       # @return [String] A normalized, opaque hash
@@ -18,8 +60,19 @@ module GraphQL
         # - Stable
         # - Irreversibly Opaque (don't want to leak variable values)
         # - URL-friendly
-        bytes = Digest::SHA256.digest(input_str)
-        Base64.urlsafe_encode64(bytes)
+        @algorithm.generate(input_str)
+      end
+
+      # Make an obfuscated hash of the given variables, like {.generate} does for their JSON.
+      # Some algorithms hash them without making a JSON string.
+      # @param variables [Hash]
+      # @return [String] A normalized, opaque hash
+      def self.generate_for_variables(variables)
+        if @algorithm.respond_to?(:generate_for_variables)
+          @algorithm.generate_for_variables(variables)
+        else
+          @algorithm.generate(variables.to_json)
+        end
       end
     end
   end
@@ -799,6 +799,57 @@ module GraphQL
         end
       end
 
+      # Keep up to `new_size` parsed documents in memory, and reuse them when the same query string is run again.
+      # Cached documents are frozen and shared by all queries. Traces still get `lex` and `parse` events when a document comes from the cache.
+      # This requires a parser which supports it (`GraphQL::CParser`); otherwise, each query string is parsed as usual.
+      # @param new_size [nil, Integer] How many documents to cache, or `nil` to not cache them
+      # @param max_bytes [nil, Integer] A limit on the memory used by cached documents (see `GraphQL::CParser::DocumentCache`)
+      # @return [nil, Integer]
+      def parser_cache_size(new_size = NOT_CONFIGURED, max_bytes: nil)
+        if NOT_CONFIGURED.equal?(new_size)
+          defined?(@parser_cache_size) ? @parser_cache_size : find_inherited_value(:parser_cache_size)
+        else
+          @parser_cache_max_bytes = max_bytes
+          remove_instance_variable(:@parser_cache) if defined?(@parser_cache)
+          @parser_cache_size = new_size
+        end
+      end
+
+      # Parse the query strings in a multiplex together before running them, when `GraphQL.default_parser` supports it (`GraphQL::CParser.parse_many`).
+      # Each batch starts native threads and joins them when it's done (there's no pool), so it's only worth it for big batches.
+      # Their `lex` and `parse` trace events come before `analyze_multiplex`, instead of during each query's analysis.
+      # @param min_bytes [nil, Integer] Batches whose query strings add up to fewer bytes are parsed one at a time, as usual. `nil` turns this off (the default).
+      # @return [nil, Integer]
+      def multiplex_parse_many_min_bytes(min_bytes = NOT_CONFIGURED)
+        if NOT_CONFIGURED.equal?(min_bytes)
+          defined?(@multiplex_parse_many_min_bytes) ? @multiplex_parse_many_min_bytes : find_inherited_value(:multiplex_parse_many_min_bytes)
+        else
+          @multiplex_parse_many_min_bytes = min_bytes
+        end
+      end
+
+      # @api private
+      # @return [nil, Object] The cache that {Query} gets documents from, see {.parser_cache_size}
+      def parser_cache
+        parser = GraphQL.default_parser
+        # Make a new cache if `GraphQL.default_parser` was changed.
+        # This isn't synchronized, since a race only makes an extra cache.
+        if !defined?(@parser_cache) || !parser.equal?(@parser_cache_parser)
+          size = parser_cache_size
+          @parser_cache = if size && parser.respond_to?(:new_document_cache)
+            max_bytes = parser_cache_max_bytes
+            max_bytes ? parser.new_document_cache(size, max_bytes: max_bytes) : parser.new_document_cache(size)
+          end
+          @parser_cache_parser = parser
+        end
+        @parser_cache
+      end
+
+      # @api private
+      def parser_cache_max_bytes
+        defined?(@parser_cache_max_bytes) ? @parser_cache_max_bytes : find_inherited_value(:parser_cache_max_bytes)
+      end
+
       def default_page_size(new_default_page_size = nil)
         if new_default_page_size
           @default_page_size = new_default_page_size
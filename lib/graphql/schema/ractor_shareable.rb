@@ -23,6 +23,8 @@ module GraphQL
           default_execution_strategy
           GraphQL.default_parser
           default_logger
+          # Other Ractors can't build and cache this, see `GraphQL::CParser::AtomTable.for_schema`
+          @frozen_parser_atom_table = defined?(GraphQL::CParser::AtomTable) ? GraphQL::CParser::AtomTable.for_schema(self) : nil
           freeze_error_handlers(error_handlers)
           # TODO: this freezes errors of parent classes which could cause trouble
           parent_class = superclass
@@ -67,6 +69,9 @@ module GraphQL
           def query_analyzers; @frozen_query_analyzers; end
           def plugins; @frozen_plugins; end
           def directives; @frozen_directives; end
+          # Documents are parsed each time, since the cache can't be shared by Ractors
+          def parser_cache; nil; end
+          def parser_atom_table; @frozen_parser_atom_table; end
 
           # This actually accumulates info during execution...
           # How to support it?
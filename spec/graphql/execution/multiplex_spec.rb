@@ -142,6 +142,104 @@ describe GraphQL::Execution::Multiplex do
     end
   end
 
+  describe "with a parser which can parse many strings at once" do
+    module ParseManyParser
+      class << self
+        attr_accessor :batches, :batch_traces
+      end
+
+      def self.parse(*args, **kwargs)
+        GraphQL::Language::Parser.parse(*args, **kwargs)
+      end
+
+      def self.parse_many(query_strs, **kwargs)
+        self.batches << query_strs
+        self.batch_traces << kwargs[:trace]
+        query_strs.map do |str|
+          parse(str, **kwargs)
+        rescue GraphQL::ParseError => err
+          err
+        end
+      end
+    end
+
+    class ParseManySchema < GraphQL::Schema
+      class Query < GraphQL::Schema::Object
+        field :echo, String do
+          argument :str, String
+        end
+
+        def echo(str:)
+          str
+        end
+      end
+
+      query(Query)
+      multiplex_parse_many_min_bytes(0)
+    end
+
+    before do
+      @prev_parser = GraphQL.default_parser
+      GraphQL.default_parser = ParseManyParser
+      ParseManyParser.batches = []
+      ParseManyParser.batch_traces = []
+    end
+
+    after do
+      GraphQL.default_parser = @prev_parser
+    end
+
+    it "parses them all before running and keeps parse errors with each query" do
+      bad_query_str = "{ echo(str: \"b\") "
+      res = ParseManySchema.multiplex([
+        {query: "{ echo(str: \"a\") }"},
+        {query: bad_query_str},
+        {document: GraphQL.parse("{ echo(str: \"c\") }")},
+        {query: "{ echo(str: \"d\") }"},
+      ])
+      assert_equal [["{ echo(str: \"a\") }", bad_query_str, "{ echo(str: \"d\") }"]], ParseManyParser.batches
+      expected_err = assert_raises(GraphQL::ParseError) { GraphQL::Language::Parser.parse(bad_query_str) }
+      assert_equal [expected_err.message], res[1]["errors"].map { |e| e["message"] }
+      assert_equal ["a", nil, "c", "d"], res.map { |r| r["data"] && r["data"]["echo"] }
+    end
+
+    it "batches queries by their trace" do
+      query_trace = ParseManySchema.new_trace
+      res = ParseManySchema.multiplex([
+        {query: "{ echo(str: \"a\") }", context: { trace: query_trace }},
+        {query: "{ echo(str: \"b\") }"},
+        {query: "{ echo(str: \"c\") }", context: { trace: query_trace }},
+        {query: "{ echo(str: \"d\") }", context: { trace: ParseManySchema.new_trace }},
+      ])
+      assert_equal [["{ echo(str: \"a\") }", "{ echo(str: \"c\") }"]], ParseManyParser.batches
+      assert_equal [query_trace], ParseManyParser.batch_traces
+      assert_equal ["a", "b", "c", "d"], res.map { |r| r["data"]["echo"] }
+    end
+
+    it "parses a single query string like before" do
+      res = ParseManySchema.multiplex([{query: "{ echo(str: \"a\") }"}])
+      assert_equal [], ParseManyParser.batches
+      assert_equal "a", res[0]["data"]["echo"]
+    end
+
+    it "parses query strings one at a time unless configured, or when they're smaller than the minimum" do
+      queries = [{query: "{ echo(str: \"a\") }"}, {query: "{ echo(str: \"b\") }"}]
+      default_schema = Class.new(GraphQL::Schema) { query(ParseManySchema::Query) }
+      assert_nil default_schema.multiplex_parse_many_min_bytes
+      res = default_schema.multiplex(queries)
+      assert_equal ["a", "b"], res.map { |r| r["data"]["echo"] }
+
+      big_min_schema = Class.new(ParseManySchema) { multiplex_parse_many_min_bytes(1_000) }
+      res = big_min_schema.multiplex(queries)
+      assert_equal ["a", "b"], res.map { |r| r["data"]["echo"] }
+      assert_equal [], ParseManyParser.batches
+
+      res = Class.new(big_min_schema) { multiplex_parse_many_min_bytes(nil) }.multiplex(queries)
+      assert_equal ["a", "b"], res.map { |r| r["data"]["echo"] }
+      assert_equal [], ParseManyParser.batches
+    end
+  end
+
   describe "context shared by a multiplex run" do
     it "is provided as context:" do
       checks = []
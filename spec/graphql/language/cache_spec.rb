@@ -54,11 +54,58 @@ describe GraphQL::Language::Cache do
       cache.fetch(source.to_s) { :parsed }
 
       cache_file = cache_path.children.first
-      assert_equal :parsed, Marshal.load(cache_file.binread)
+      if defined?(GraphQL::CParser::BinaryAST)
+        assert_equal :parsed, GraphQL::CParser::BinaryAST.load(cache_file.binread)
+      else
+        assert_equal :parsed, Marshal.load(cache_file.binread)
+      end
       assert_equal :parsed, GraphQL::Language::Cache.new(cache_path, secret: nil).fetch(source.to_s) { flunk("cache was not reused") }
     end
   end
 
+  it "reuses parsed documents" do
+    [nil, "secret"].each do |secret|
+      with_cache do |source, cache_path, _cache|
+        cache = GraphQL::Language::Cache.new(cache_path, secret: secret)
+        document = cache.fetch(source.to_s) { GraphQL.parse(source.read, filename: source.to_s) }
+        cached_document = cache.fetch(source.to_s) { flunk("cache was not reused") }
+
+        assert_equal document, cached_document
+        field = cached_document.definitions.first.fields.first
+        assert_equal "hello", field.name
+        assert_equal [1, 14], field.position
+        assert_equal source.to_s, field.filename
+        assert_equal document.to_query_string, cached_document.to_query_string
+      end
+    end
+  end
+
+  it "stores payloads which the binary format can't hold with Marshal" do
+    with_cache do |source, cache_path, cache|
+      payload = { "not" => "a document" }
+      cache.fetch(source.to_s) { payload }
+      assert_equal payload, cache.fetch(source.to_s) { flunk("cache was not reused") }
+
+      unsigned_cache = GraphQL::Language::Cache.new(cache_path.join("unsigned"), secret: nil)
+      unsigned_cache.fetch(source.to_s) { payload }
+      assert_equal payload, Marshal.load(cache_path.join("unsigned").children.first.binread)
+      assert_equal payload, unsigned_cache.fetch(source.to_s) { flunk("cache was not reused") }
+    end
+  end
+
+  if defined?(GraphQL::CParser::BinaryAST)
+    it "rebuilds binary entries which can't be read" do
+      with_cache do |source, cache_path, _cache|
+        cache = GraphQL::Language::Cache.new(cache_path, secret: nil)
+        cache.fetch(source.to_s) { GraphQL.parse(source.read) }
+        cache_file = cache_path.children.first
+        cache_file.binwrite(cache_file.binread.byteslice(0, 50))
+
+        assert_equal :reparsed, cache.fetch(source.to_s) { :reparsed }
+      end
+    end
+  end
+
   it "doesn't reuse a cache entry with a different secret" do
     with_cache do |source, cache_path, _cache|
       GraphQL::Language::Cache.new(cache_path, secret: "first-secret").fetch(source.to_s) { :parsed }
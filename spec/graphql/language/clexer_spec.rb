@@ -1,5 +1,6 @@
 # frozen_string_literal: true
 require "spec_helper"
+require "objspace"
 require_relative "./lexer_examples"
 
 if defined?(GraphQL::CParser::Lexer)
@@ -54,6 +55,693 @@ if defined?(GraphQL::CParser::Lexer)
       refute default_ast.definitions.first.name.frozen?
     end
 
+    it "makes each name once per document, or takes it from an AtomTable" do
+      str = "{ a: node { id } b: node { id __typename } }"
+      ast = GraphQL::CParser.parse(str, atoms: true)
+      a_field, b_field = ast.definitions.first.selections
+      assert_equal ["node", "node"], [a_field.name, b_field.name]
+      assert_same a_field.name, b_field.name
+      assert_same a_field.selections.first.name, b_field.selections.first.name
+      assert a_field.name.frozen?
+      assert_equal Encoding::UTF_8, a_field.name.encoding
+
+      other_ast = GraphQL::CParser.parse(str, atoms: true)
+      refute_same a_field.name, other_ast.definitions.first.selections.first.name
+
+      atoms = GraphQL::CParser::AtomTable.new(["node", "id"])
+      assert_equal 2, atoms.size
+      seeded_asts = 2.times.map { GraphQL::CParser.parse(str, atoms: atoms) }
+      seeded_names = seeded_asts.map { |doc| doc.definitions.first.selections.first.name }
+      assert_same atoms["node"], seeded_names[0]
+      assert_same atoms["node"], seeded_names[1]
+      # Names which aren't in the table are still shared in each document:
+      b_fields = seeded_asts.map { |doc| doc.definitions.first.selections.last }
+      assert_equal "__typename", b_fields[0].selections.last.name
+      assert_nil atoms["__typename"]
+      refute_same b_fields[0].selections.last.name, b_fields[1].selections.last.name
+
+      schema_atoms = GraphQL::CParser::AtomTable.for_schema(Jazz::Schema)
+      assert_same schema_atoms, GraphQL::CParser::AtomTable.for_schema(Jazz::Schema)
+      assert_equal "Query", schema_atoms["Query"]
+      assert_equal "instruments", schema_atoms["instruments"]
+      assert_equal "include", schema_atoms["include"]
+
+      assert_raises(TypeError) { GraphQL::CParser.parse(str, atoms: ["node"]) }
+    end
+
+    it "keeps tokens in a native buffer until they're requested" do
+      str = "{ f1(a: 1.5) }"
+      buffer = GraphQL::CParser::Lexer.tokenize_to_buffer(str)
+      assert_instance_of GraphQL::CParser::TokenBuffer, buffer
+      assert_equal 8, buffer.length
+      assert_equal [:FLOAT, 1, 9, "1.5", 210], buffer[5]
+      assert_equal [:RCURLY, 1, 14, "}", 226], buffer[-1]
+      assert_nil buffer[8]
+      assert_equal GraphQL::CParser::Lexer.tokenize(str), buffer.to_a
+    end
+
+    it "lexes one token at a time for the parser" do
+      stream = GraphQL::CParser::Lexer.token_stream("{ f1 }")
+      assert_instance_of GraphQL::CParser::TokenStream, stream
+      assert_nil stream.current_token
+      assert_equal 0, stream.tokens_count
+
+      parser = GraphQL::CParser::Parser.new("{ f1(a: 1.5) } } { f2 }", nil, GraphQL::Tracing::NullTrace, nil)
+      err = assert_raises(GraphQL::ParseError) { parser.result }
+      assert_equal "syntax error, unexpected RCURLY (\"}\") at [1, 16]", err.message
+      # The parser stopped at the unexpected token; the rest of the string wasn't lexed
+      assert_equal [:RCURLY, 1, 16, "}", 226], parser.token_stream.current_token
+      assert_equal 9, parser.token_stream.tokens_count
+    end
+
+    it "builds nodes with the same instance variables as Ruby" do
+      str = <<~GRAPHQL
+        query Q($v: [Int!] = [1]) @dir { a: f(x: {y: [1.5, "s", ENUM, null, $v]}) { ... on T { g } ...F } }
+        fragment F on T { g }
+        "Desc" type T implements I @dir { g(a: Int = 1): String }
+        directive @dir(b: Boolean) repeatable on QUERY | OBJECT
+        union U = T | S
+        extend schema { query: T }
+      GRAPHQL
+      ivars = ->(node) {
+        case node
+        when GraphQL::Language::Nodes::AbstractNode
+          [node.class, node.instance_variables, *node.instance_variables.map { |iv| ivars.(node.instance_variable_get(iv)) }]
+        when Array
+          node.map { |n| ivars.(n) }
+        end
+      }
+      c_document = GraphQL::CParser.parse(str)
+      ruby_document = GraphQL::Language::Parser.parse(str)
+      assert_equal ivars.(ruby_document), ivars.(c_document)
+      assert_equal ruby_document, c_document
+      assert c_document.definitions[2].description.frozen?
+    end
+
+    it "makes children lazily from a native arena" do
+      str = "query Q($v: Int = 5) { a: f(x: [1, 2.5, \"s\", ENUM, null, {y: $v}]) @skip(if: false) { ... on T { g } ...F } } fragment F on T { h }"
+      eager_document = GraphQL::CParser.parse(str)
+      lazy_document = GraphQL::CParser.parse(str, lazy: true)
+      assert_instance_of GraphQL::CParser::LazyNodes::Document, lazy_document
+      assert_kind_of GraphQL::Language::Nodes::Document, lazy_document
+      c_document = lazy_document.instance_variable_get(:@c_document)
+      assert_instance_of GraphQL::CParser::Document, c_document
+      assert_operator ObjectSpace.memsize_of(c_document), :>, 0
+
+      operation = lazy_document.definitions.first
+      assert_same operation, lazy_document.definitions.first
+      assert_nil operation.instance_variable_get(:@selections)
+      field = operation.selections.first
+      assert_same field, operation.selections.first
+      assert_equal [1, 2.5, "s"], field.arguments.first.value[0, 3]
+      copy = field.merge(alias: "b")
+      assert_same field.arguments, copy.arguments
+
+      assert_equal eager_document, lazy_document
+      assert_equal eager_document.to_query_string, lazy_document.to_query_string
+      assert_equal eager_document, Marshal.load(Marshal.dump(GraphQL::CParser.parse(str, lazy: true)))
+    end
+
+    it "makes shareable documents like deep_freeze does" do
+      str = "query Q($v: Int = 5) { a: f(x: [1, 2.5, \"s\", ENUM, null, {y: $v}]) @skip(if: false) { ... on T { g } ...F } }\nfragment F on T { h }\n\"Desc\" type T implements I @dir { g(a: Int = 1): String }"
+      filename = +"query.graphql"
+      shareable_document = GraphQL::CParser.parse(str, filename: filename, shareable: true)
+      assert Ractor.shareable?(shareable_document)
+      refute filename.frozen?
+      frozen_document = GraphQL::CParser.parse(str, filename: filename).deep_freeze
+      assert_equal frozen_document, shareable_document
+      walk = ->(a, b) {
+        assert_equal a.instance_variables, b.instance_variables
+        assert_equal [a.line, a.col, a.definition_line], [b.line, b.col, b.definition_line] if a.is_a?(GraphQL::Language::Nodes::AbstractNode)
+        a.children.zip(b.children) { |x, y| walk.(x, y) }
+      }
+      walk.(frozen_document, shareable_document)
+      assert_equal [[1, 1], [2, 1], [3, 8]], shareable_document.definitions.map(&:position)
+      assert_nil shareable_document.definitions.first.instance_variable_get(:@source)
+
+      err = assert_raises(ArgumentError) { GraphQL::CParser.parse(str, lazy: true, shareable: true) }
+      assert_equal "Lazy nodes can't be shareable, pass `lazy: false` with `shareable: true`", err.message
+      assert GraphQL::CParser.parse_many([str], shareable: true).all? { |doc| Ractor.shareable?(doc) }
+      assert Ractor.shareable?(GraphQL::CParser::AtomTable.new(["f"]))
+
+      # Documents which keep their source can be made shareable, too
+      document = Ractor.make_shareable(GraphQL::CParser.parse(str))
+      assert_equal [[1, 1], [2, 1], [3, 8]], document.definitions.map(&:position)
+      assert_equal 2, document.definitions.first.children.size
+      assert_equal shareable_document, document
+    end
+
+    it "counts parse stats and stops parsing at max_depth:, max_aliases: and max_fields:" do
+      str = "query Q($v: [Int] = [1, 2, 3]) @a { x: f(l: [[1, 2], [3, 4, 5, 6]]) @b @c { ... on T { g h: i } ...F } y: z }\nfragment F on T { k { l { m } } }"
+      expected_stats = { max_depth: 3, fields: 7, aliases: 3, directives: 3, fragment_spreads: 1, max_list_size: 4 }
+      assert_equal expected_stats, GraphQL::CParser.parse(str).parse_stats
+      assert_equal expected_stats, GraphQL::CParser.parse(str, lazy: true).parse_stats
+      assert_equal expected_stats, GraphQL::CParser.parse(str, shareable: true).parse_stats
+      assert GraphQL::CParser.parse(str).parse_stats.frozen?
+      assert_nil GraphQL::Language::Parser.parse(str).parse_stats
+
+      assert_equal expected_stats, GraphQL::CParser.parse(str, max_depth: 3, max_aliases: 3, max_fields: 7).parse_stats
+      [
+        [{ max_depth: 2 }, "Query has depth of 3, which exceeds max depth of 2 at [1, 86]", 1, 86],
+        [{ max_aliases: 2 }, "Query has 3 aliases, which exceeds max aliases of 2 at [1, 104]", 1, 104],
+        [{ max_fields: 4 }, "Query has 5 fields, which exceeds max fields of 4 at [2, 27]", 2, 27],
+      ].each do |limits, message, line, col|
+        [false, true].each do |release_gvl|
+          err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(str, release_gvl: release_gvl, **limits) }
+          assert_equal [message, line, col], [err.message, err.line, err.col]
+        end
+        assert_equal [message, 1], GraphQL::CParser.parse_many([str, "{ a }"], **limits).map { |result| result.is_a?(GraphQL::ParseError) ? result.message : result.parse_stats[:fields] }
+      end
+
+      # Depth is checked as each selection set opens, so the rest of the string isn't parsed
+      err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse("{ a { b { c } } } }", max_depth: 2) }
+      assert_equal "Query has depth of 3, which exceeds max depth of 2 at [1, 9]", err.message
+      err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse("{ a }", max_depth: 0) }
+      assert_equal "Query has depth of 1, which exceeds max depth of 0 at [1, 1]", err.message
+    end
+
+    it "stops at the bracket which goes over max_nesting:" do
+      assert_equal 10_000, GraphQL::CParser.max_nesting
+      depth = 100_000
+      {
+        "{ f(a: #{"[" * depth}1#{"]" * depth}) }" => [1, 10006],
+        "{ f(a: #{"{a: " * depth}1#{"}" * depth}) }" => [1, 40000],
+        "{ #{"a { " * depth}b#{" }" * depth} }" => [1, 40001],
+      }.each do |query_str, (line, col)|
+        [false, true].each do |release_gvl|
+          err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(query_str, release_gvl: release_gvl) }
+          assert_equal ["This query is too large to execute.", line, col], [err.message, err.line, err.col]
+        end
+      end
+
+      str = "{ a(b: [[1]]) }\n{ c(d: {e: {f: 1}}) }"
+      assert_equal 2, GraphQL::CParser.parse(str, max_nesting: 4).definitions.size
+      err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(str, max_nesting: 3) }
+      assert_equal [1, 9], [err.line, err.col]
+      results = GraphQL::CParser.parse_many([str, "{ a { b } }"], max_nesting: 3)
+      assert_equal [[1, 9], 1], results.map { |result| result.is_a?(GraphQL::ParseError) ? [result.line, result.col] : result.definitions.size }
+
+      # These are the deepest documents which fit in Bison's old `YYMAXDEPTH`, and they still parse by default
+      [
+        "{ a(b: #{"[" * 9_991}1#{"]" * 9_991}) }",
+        "{ a(b: #{"{c: " * 3_330}1#{"}" * 3_330}) }",
+        "#{"{a " * 2_499}#{"}" * 2_499}",
+      ].each do |query_str|
+        assert_instance_of GraphQL::Language::Nodes::Document, GraphQL::CParser.parse(query_str)
+        assert_instance_of GraphQL::Language::Nodes::Document, GraphQL::CParser.parse_many([query_str]).first
+      end
+
+      # Without a limit, deep documents are parsed on the heap, and can be made into nodes
+      deep_str = "{ #{"a { " * 2_000}b#{" }" * 2_000} }"
+      document = GraphQL::CParser.parse(deep_str, max_nesting: nil)
+      assert_equal 2_001, document.parse_stats[:max_depth]
+      assert_equal 2_001, GraphQL::CParser.parse_many([deep_str], max_nesting: nil).first.parse_stats[:max_depth]
+    end
+
+    it "unescapes strings like the Ruby lexer" do
+      [
+        "plain", "", "tab\\tnew\\nline\\r\\b\\f", "\\\"quoted\\\" \\\\ \\/", "\\\\u0041",
+        "\\u0041\\u0042", "\\u{0041}\\u0042", "\\u{0001F600}", "\\uD83D\\uDE00", "\\u{D83D}\\uDE00",
+        "é \\u00e9 \\u{10FFFF}", "before \\u2603 after", "\\uD83D", "\\u{110000}", "a\\uDE00\\uD83D",
+        "\\u00XY \\n", "\\u{00ZZ} \\n",
+      ].each do |string_content|
+        expected_value = string_content.dup
+        expected_valid = expected_value.match?(GraphQL::Language::Lexer::VALID_STRING)
+        if expected_valid
+          GraphQL::Language::Lexer.replace_escaped_characters_in_place(expected_value)
+          expected_valid = expected_value.valid_encoding?
+        end
+        token = GraphQL.scan_with_c("\"#{string_content}\"").first
+        assert_equal (expected_valid ? :STRING : :BAD_UNICODE_ESCAPE), token[0], "#{string_content} has the right token"
+        assert_equal expected_value.b, token[3].b, "#{string_content} is unescaped"
+        assert_equal Encoding::UTF_8, token[3].encoding
+      end
+    end
+
+    it "trims block strings like BlockString.trim_whitespace" do
+      [
+        "", "single line", "  leading space", "   ", "\n", "\n\n  \n",
+        "\n    Hello,\n      World!\n\n    Yours,\n      GraphQL.\n  ",
+        "first line\n    indented\n  less\n\n", "\t\n  tab\n\ttab\n", "é\n   ü\n   ö \r\n  \r",
+        "\\\"\"\" escaped\n  quotes",
+      ].each do |string_content|
+        tokens = GraphQL.scan_with_c("\"\"\"#{string_content}\"\"\" next")
+        assert_equal GraphQL::Language::BlockString.trim_whitespace(string_content.dup), tokens[0][3], "#{string_content.inspect} is trimmed"
+        assert_equal Encoding::UTF_8, tokens[0][3].encoding
+        assert_equal [:IDENTIFIER, 1 + string_content.count("\n")], tokens[1].first(2)
+      end
+    end
+
+    it "makes the same tokens with each scan kernel" do
+      str = "{\n#{" " * 40}f1(a: \"#{"plain " * 10}\", b: \"esc\\n\") ,,\t# #{"comment " * 10}\n  f2 #\n\"\" }"
+      expected_tokens = GraphQL.scan_with_ruby(str)
+      kernels = GraphQL::CParser::Lexer.available_scan_kernels
+      assert_includes kernels, "scalar"
+      original_kernel = GraphQL::CParser::Lexer.scan_kernel
+      kernels.each do |kernel|
+        GraphQL::CParser::Lexer.scan_kernel = kernel
+        assert_equal kernel, GraphQL::CParser::Lexer.scan_kernel
+        assert_equal expected_tokens, GraphQL::CParser::Lexer.tokenize(str).map { |t| t.first(4) }, "#{kernel} makes the same tokens"
+        assert_equal [:UNKNOWN_CHAR, 1, 4, "\""], GraphQL::CParser::Lexer.tokenize("{  \"#{"unterminated " * 10}\n}")[1].first(4)
+      end
+      assert_raises(ArgumentError) { GraphQL::CParser::Lexer.scan_kernel = "nonsense" }
+    ensure
+      GraphQL::CParser::Lexer.scan_kernel = original_kernel
+    end
+
+    it "finds lines and columns from byte offsets when they're read" do
+      str = "query Q {\n  a\r\n  b { c }\r  d\n  e(x: \"\"\"\n  multi\n  line\n  \"\"\") f\n}"
+      operation = GraphQL::CParser.parse(str).definitions.first
+      assert_nil operation.instance_variable_get(:@line)
+      assert_nil operation.instance_variable_get(:@col)
+      source = operation.instance_variable_get(:@source)
+      assert_instance_of GraphQL::CParser::Document, source
+      assert_equal [1, 1], operation.position
+      # Only `\n` ends a line, like in the Ruby parser
+      expected_positions = [["a", 2, 3], ["b", 3, 3], ["d", 3, 13], ["e", 4, 3], ["f", 7, 8]]
+      assert_equal expected_positions, operation.selections.map { |f| [f.name, f.line, f.col] }
+      assert_equal expected_positions, GraphQL::Language::Parser.parse(str).definitions.first.selections.map { |f| [f.name, f.line, f.col] }
+      assert_equal [1, 1, 2, 2], [0, 9, 10, 12].map { |pos| source.line_at(pos) }
+      assert_equal [1, 10, 1, 3], [0, 9, 10, 12].map { |pos| source.column_at(pos) }
+      assert_equal [2, 3, 3, 4, 7], Marshal.load(Marshal.dump(operation)).selections.map(&:line)
+    end
+
+    it "finds parse errors' lines and columns like nodes'" do
+      [
+        "{\r\n  a\r\n  b\r  c\r\n  d(\r\n}",
+        "{\r\n  a(b: \"\"\"\r\n\r\n\"\"\") c(d: 1e)\r\n}",
+        "{\r\n  a(b: \"\\u{110000}\")\r\n}",
+        "{\r\n  a(b: 1x)\r\n}",
+      ].each do |query_str|
+        expected_err = assert_raises(GraphQL::ParseError) { GraphQL::Language::Parser.parse(query_str) }
+        [false, true].each do |release_gvl|
+          err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(query_str, release_gvl: release_gvl) }
+          assert_equal [expected_err.line, expected_err.col], [err.line, err.col], "#{query_str.inspect} fails at the same place"
+        end
+      end
+
+      query_str = "{\r\n  a {\r\n    b(c: [[1]])\r\n  }\r\n}"
+      err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(query_str, max_depth: 1) }
+      assert_equal ["Query has depth of 2, which exceeds max depth of 1 at [2, 5]", 2, 5], [err.message, err.line, err.col]
+      err = GraphQL::CParser.parse_many([query_str], max_nesting: 4).first
+      assert_instance_of GraphQL::ParseError, err
+      assert_equal ["This query is too large to execute.", 3, 11], [err.message, err.line, err.col]
+      err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse("{\r\n  a b c\r\n}", max_tokens: 3) }
+      assert_equal [2, 7], [err.line, err.col]
+    end
+
+    it "converts numbers like String#to_i and #to_f" do
+      [
+        "0", "-0", "7", "-42", "999999999999999999", "-9223372036854775808", "9223372036854775808",
+        "1#{"0" * 40}", "0.5", "-0.0", "1.5e3", "2.5E-3", "1.0e+400", "3.14159265358979323846264338327950288",
+      ].each do |number|
+        value = GraphQL::CParser.parse("{ f(a: #{number}) }").definitions.first.selections.first.arguments.first.value
+        expected_value = number.include?(".") ? number.to_f : number.to_i
+        assert_equal expected_value, value, "#{number} is converted"
+        assert_instance_of expected_value.class, value
+      end
+    end
+
+    it "skips comments without allocating, unless they're kept" do
+      query_str = "{\n  a\n  b\n}\n"
+      commented_query_str = "# header\n" * 50 + "{\n  a # trailing\n  # b\n  b\n}\n"
+      allocations = [query_str, commented_query_str, query_str, commented_query_str].map do |str|
+        before = GC.stat(:total_allocated_objects)
+        GraphQL::CParser.parse(str)
+        GC.stat(:total_allocated_objects) - before
+      end
+      # The first two runs warm up caches
+      allocations.shift(2)
+      assert_equal allocations[0], allocations[1]
+
+      str = <<~GRAPHQL
+        # Not attached
+
+        # The query root
+        #   indented
+        type Query {
+          "Description"
+          # About f
+          f(
+            # About a
+            a: Int
+          ): String # trailing
+          g: E
+        }
+        # An enum
+        enum E {
+          #first
+          A
+          B
+        }
+      GRAPHQL
+      assert_nil GraphQL::CParser.parse(str).definitions.first.comment
+      [false, true].each do |lazy|
+        doc = GraphQL::CParser.parse(str, comments: true, lazy: lazy)
+        query_type, enum_type = doc.definitions
+        assert_equal "The query root\n  indented", query_type.comment
+        assert_equal ["About f", nil], query_type.fields.map(&:comment)
+        assert_equal "Description", query_type.fields.first.description
+        assert_equal "About a", query_type.fields.first.arguments.first.comment
+        assert_equal "An enum", enum_type.comment
+        assert_equal ["first", nil], enum_type.values.map(&:comment)
+        assert_includes doc.to_query_string, "# The query root\n#   indented\ntype Query {\n"
+      end
+    end
+
+    it "parses without the GVL like it does with it" do
+      str = <<~GRAPHQL
+        # The query root
+        type Query {
+          f(a: String = "tab\\t \\u00e9 \\uD83D\\uDE00", b: Float = -1.5e3): [Int!]
+          "Described"
+          g: Int
+          """
+            Block
+          """
+          h: Int
+        }
+        schema { query: Query }
+        query Q($v: Int = 10) @d(s: """ x """) { f(a: "plain") ... on Query { g } }
+      GRAPHQL
+      with_gvl = GraphQL::CParser.parse(str, release_gvl: false, comments: true)
+      without_gvl = GraphQL::CParser.parse(str, release_gvl: true, comments: true)
+      assert_equal with_gvl, without_gvl
+      assert_equal with_gvl.to_query_string, without_gvl.to_query_string
+      assert_equal with_gvl.definitions.map(&:line), without_gvl.definitions.map(&:line)
+      assert_equal with_gvl, GraphQL::CParser.parse(str, release_gvl: true, lazy: true)
+
+      # The original string can still be changed afterward
+      unfrozen_str = str.dup
+      GraphQL::CParser.parse(unfrozen_str, release_gvl: true)
+      unfrozen_str << " "
+
+      prev_reject_numbers_followed_by_names = GraphQL.reject_numbers_followed_by_names
+      GraphQL.reject_numbers_followed_by_names = true
+      [
+        "{ f(a: 1 }",
+        "{ f(a: \"\\uD83D\") }",
+        "{ f(a: \"\\u{110000}\") }",
+        "{ f(a: \"\\u{FFFFFFFFFF}\") }",
+        "{ f(a: 1two: 2) }",
+        "{ f(a: 1, b: 2, c: 3) }",
+        "{ f(a: \"\xff\") }",
+        "# only a comment",
+      ].each do |bad_str|
+        errors = [false, true].map do |release_gvl|
+          err = assert_raises(GraphQL::ParseError, RangeError) { GraphQL::CParser.parse(bad_str, release_gvl: release_gvl, max_tokens: 12) }
+          [err.class, err.message]
+        end
+        assert_equal errors[0], errors[1], "#{bad_str.inspect} raises the same error"
+      end
+    ensure
+      GraphQL.reject_numbers_followed_by_names = prev_reject_numbers_followed_by_names
+    end
+
+    it "makes parse errors without copying the query string" do
+      {
+        "{ f(a: ) }" => ["syntax error, unexpected RPAREN (\")\") at [1, 8] (q.graphql)", 1, 8],
+        "{ f(a: \"é\" b: ) }" => ["syntax error, unexpected RPAREN (\")\") at [1, 16] (q.graphql)", 1, 16],
+        "{ f(a: \"\\uD800\") }" => ["Parse error on bad Unicode escape sequence: \"\\xED\\xA0\\x80\" (error) at [1, 8] (q.graphql)", 1, 8],
+        "{ f }\n{ g h i j k l m }" => ["This query is too large to execute.", 2, 15],
+        "# only a comment" => ["syntax error, unexpected end of file (q.graphql)", nil, nil],
+      }.each do |query_str, (message, line, col)|
+        err = assert_raises(GraphQL::ParseError) { GraphQL::CParser.parse(query_str, filename: "q.graphql", max_tokens: 10) }
+        assert_equal [message, line, col], [err.message, err.line, err.col]
+        assert_same query_str, err.query
+      end
+    end
+
+    it "releases the GVL for big strings" do
+      prev_threshold = GraphQL::CParser.release_gvl_threshold
+      GraphQL::CParser.release_gvl_threshold = 10
+      assert GraphQL::CParser::Parser.new("{ f1 f2 f3 }", nil, GraphQL::Tracing::NullTrace, nil).instance_variable_get(:@release_gvl)
+      refute GraphQL::CParser::Parser.new("{ f1 }", nil, GraphQL::Tracing::NullTrace, nil).instance_variable_get(:@release_gvl)
+      refute GraphQL::CParser::Parser.new("{ f1 f2 f3 }", nil, GraphQL::Tracing::NullTrace, nil, release_gvl: false).instance_variable_get(:@release_gvl)
+    ensure
+      GraphQL::CParser.release_gvl_threshold = prev_threshold
+    end
+
+    it "parses many documents at once, returning errors in place" do
+      strs = ["{ f1 }", "query Q($a: Int = 1) { f2(a: $a) { ... on T { f3 } } }", "{ f1(", nil, "type Query { f1: Int }"]
+      results = GraphQL::CParser.parse_many(strs, threads: 2)
+      assert_equal 5, results.size
+      [0, 1, 4].each do |idx|
+        assert_equal GraphQL::CParser.parse(strs[idx]), results[idx]
+      end
+      assert_instance_of GraphQL::ParseError, results[2]
+      assert_equal "syntax error, unexpected end of file at [1, 5]", results[2].message
+      assert_instance_of GraphQL::ParseError, results[3]
+      assert_equal "No query string was present", results[3].message
+      assert_equal [], GraphQL::CParser.parse_many([])
+
+      too_many_tokens = GraphQL::CParser.parse_many(["{ a b c d e }", "{ a }"], max_tokens: 4, threads: 1)
+      assert_instance_of GraphQL::ParseError, too_many_tokens[0]
+      assert_equal GraphQL::CParser.parse("{ a }"), too_many_tokens[1]
+    end
+
+    describe GraphQL::CParser::DocumentCache do
+      it "returns the same frozen document for the same string and max_tokens" do
+        cache = GraphQL::CParser::DocumentCache.new(10)
+        query_str = "query Q($a: Int = 1) { f1(a: $a) { ... on T { f2 } } }"
+        doc = cache.parse(query_str)
+        assert doc.frozen?
+        assert_equal GraphQL::CParser.parse(query_str), doc
+        assert_same doc, cache.parse(query_str.dup)
+        assert_same doc, cache[+query_str, nil]
+        refute_same doc, cache.parse(query_str, max_tokens: 100)
+        assert_nil cache["{ f1 }", nil]
+
+        assert_raises(GraphQL::ParseError) { cache.parse("{ f1(") }
+        assert_raises(GraphQL::ParseError) { cache.parse(query_str, max_tokens: 2) }
+
+        stats = cache.stats
+        assert_equal 2, stats[:size]
+        assert_equal 2, stats[:hits]
+        assert_equal 5, stats[:misses]
+        assert_equal 0, stats[:evictions]
+        assert_operator stats[:bytesize], :>, 0
+
+        cache.clear
+        assert_equal 0, cache.size
+        assert_equal 0, cache.stats[:bytesize]
+      end
+
+      it "runs lex and parse trace events for hits" do
+        events = []
+        trace_class = Class.new(GraphQL::Tracing::Trace) do
+          define_method(:lex) { |query_string:, &block| block.call.tap { |result| events << [:lex, query_string, result.nil?] } }
+          define_method(:parse) { |query_string:, &block| block.call.tap { |result| events << [:parse, query_string, result.class] } }
+        end
+        cache = GraphQL::CParser::DocumentCache.new(10)
+        2.times { cache.parse("{ a }", trace: trace_class.new) }
+        document_class = GraphQL::Language::Nodes::Document
+        assert_equal [[:lex, "{ a }", false], [:parse, "{ a }", document_class], [:lex, "{ a }", true], [:parse, "{ a }", document_class]], events
+        assert_equal 1, cache.stats[:hits]
+      end
+
+      it "doesn't share documents lexed with a different reject_numbers_followed_by_names" do
+        prev_reject_numbers_followed_by_names = GraphQL.reject_numbers_followed_by_names
+        GraphQL.reject_numbers_followed_by_names = false
+        cache = GraphQL::CParser::DocumentCache.new(10)
+        query_str = "{ f(a: 1b: 2) }"
+        assert_equal 2, cache.parse(query_str).definitions.first.selections.first.arguments.size
+        GraphQL.reject_numbers_followed_by_names = true
+        assert_nil cache[query_str, nil]
+        assert_raises(GraphQL::ParseError) { cache.parse(query_str) }
+      ensure
+        GraphQL.reject_numbers_followed_by_names = prev_reject_numbers_followed_by_names
+      end
+
+      it "evicts the least recently used documents" do
+        cache = GraphQL::CParser::DocumentCache.new(2)
+        doc_a = cache.parse("{ a }")
+        cache.parse("{ b }")
+        cache.parse("{ a }")
+        cache.parse("{ c }")
+        assert_same doc_a, cache["{ a }", nil]
+        assert_nil cache["{ b }", nil]
+        assert_equal 1, cache.stats[:evictions]
+
+        one_doc_size = cache.stats[:bytesize] / 2
+        small_cache = GraphQL::CParser::DocumentCache.new(100, max_bytes: one_doc_size * 3)
+        5.times { |i| small_cache.parse("{ f#{i} }") }
+        assert_operator small_cache.size, :<=, 3
+        assert_operator small_cache.stats[:bytesize], :<=, one_doc_size * 3
+
+        tiny_cache = GraphQL::CParser::DocumentCache.new(100, max_bytes: 10)
+        assert tiny_cache.parse("{ a }").frozen?
+        assert_equal 0, tiny_cache.size
+      end
+
+      it "can be shared by threads" do
+        cache = GraphQL::CParser::DocumentCache.new(3)
+        query_strs = 5.times.map { |i| "{ f#{i} }" }
+        threads = 4.times.map do
+          Thread.new do
+            200.times.map { |i| cache.parse(query_strs[i % 5]).definitions.first.selections.first.name }
+          end
+        end
+        threads.each do |thread|
+          assert_equal 40.times.flat_map { %w[f0 f1 f2 f3 f4] }, thread.value
+        end
+        assert_equal 3, cache.size
+      end
+    end
+
+    describe GraphQL::CParser::Fingerprint do
+      it "matches SipHash-2-4-128's reference vectors" do
+        key = (0..15).map(&:chr).join.b
+        assert_equal "a3817f04ba25a8e66df67214c7550293", GraphQL::CParser::Fingerprint.siphash128(key, "").unpack1("H*")
+        assert_equal "5493e99933b0a8117e08ec0f97cfc3d9", GraphQL::CParser::Fingerprint.siphash128(key, (0..14).map(&:chr).join.b).unpack1("H*")
+      end
+
+      it "hashes variables like their JSON" do
+        variables = {
+          "a" => [1, -2.5, nil, true, false, 2**70],
+          "b" => "Quotes \", backslashes \\, newlines \n, controls \u0001 and \u00e9" * 20,
+          c: { d: :e, 1 => {} },
+        }
+        assert_equal GraphQL::CParser::Fingerprint.generate(JSON.generate(variables)), GraphQL::CParser::Fingerprint.generate_for_variables(variables)
+        assert_equal GraphQL::CParser::Fingerprint.generate("{}"), GraphQL::CParser::Fingerprint.generate_for_variables({})
+
+        deep = []
+        101.times { deep = [deep] }
+        assert_raises(ArgumentError) { GraphQL::CParser::Fingerprint.generate_for_variables({ "a" => deep }) }
+      end
+    end
+
+    describe GraphQL::CParser::BinaryAST do
+      def round_trip(value)
+        GraphQL::CParser::BinaryAST.load(GraphQL::CParser::BinaryAST.dump(value))
+      end
+
+      def positions(node)
+        [[node.class, node.line, node.col, node.filename]] + node.children.flat_map { |child| positions(child) }
+      end
+
+      it "loads documents like Marshal does" do
+        query_str = "query Q($v: [Int!] = [1, 99999999999, 123456789012345678901234567890]) {
+  f1(arg: {input: $v, nullInput: null, f: -1.5e3}) @stuff { ...F2 }
+}
+
+fragment F2 on T { ... { a: b(c: \"é\", d: \"\"\"block\"\"\") } }"
+        [
+          GraphQL::CParser.parse(query_str, filename: "query.graphql"),
+          GraphQL::CParser.parse(query_str, lazy: true),
+          GraphQL::Language::Parser.parse(query_str),
+          GraphQL::CParser.parse(Dummy::Schema.to_definition),
+        ].each do |doc|
+          marshalled_doc = Marshal.load(Marshal.dump(doc))
+          loaded_doc = round_trip(doc)
+          assert_equal doc, loaded_doc
+          assert_equal doc.to_query_string, loaded_doc.to_query_string
+          assert_equal positions(marshalled_doc), positions(loaded_doc)
+        end
+      end
+
+      it "keeps shared objects shared" do
+        doc = GraphQL::CParser.parse("{ a }")
+        loaded = round_trip([doc, doc, "s", "s".b, :sym, 2**80, -2.5, nil, true, false, [].freeze])
+        assert_same loaded[0], loaded[1]
+        assert_equal ["s", "s".b, :sym, 2**80, -2.5, nil, true, false], loaded[2..-2]
+        assert_equal Encoding::BINARY, loaded[3].encoding
+        assert_same GraphQL::Language::Nodes::NONE, loaded.last
+        assert loaded[0].definitions.frozen?
+      end
+
+      it "raises TypeError for values it can't hold" do
+        assert_raises(TypeError) { GraphQL::CParser::BinaryAST.dump({ "a" => 1 }) }
+        assert_raises(TypeError) { GraphQL::CParser::BinaryAST.dump(GraphQL::Language::Nodes::Field.new(name: Object.new)) }
+        assert_raises(TypeError) { GraphQL::CParser::BinaryAST.dump("é".encode("ISO-8859-1")) }
+      end
+
+      it "raises ArgumentError for invalid data" do
+        data = GraphQL::CParser::BinaryAST.dump(GraphQL::CParser.parse("{ a(b: 1) { c } }"))
+        data.bytesize.times do |length|
+          assert_raises(ArgumentError) { GraphQL::CParser::BinaryAST.load(data.byteslice(0, length)) }
+        end
+        # Class names are replaced with names of the same length
+        undefined_class = data.sub("GraphQL::Language::Nodes::Document", "GraphQL::Language::Nodes::Documenx")
+        err = assert_raises(ArgumentError) { GraphQL::CParser::BinaryAST.load(undefined_class) }
+        assert_includes err.message, "Documenx"
+        not_a_node = data.sub("GraphQL::Language::Nodes::Document", "GraphQL::Query::ValidationPipeline")
+        err = assert_raises(ArgumentError) { GraphQL::CParser::BinaryAST.load(not_a_node) }
+        assert_equal "Invalid binary AST: GraphQL::Query::ValidationPipeline isn't a subclass of GraphQL::Language::Nodes::AbstractNode", err.message
+      end
+
+      it "loads files" do
+        doc = GraphQL::CParser.parse("type Query { a: Int }")
+        Tempfile.create("binary_ast") do |file|
+          file.binmode
+          file.write(GraphQL::CParser::BinaryAST.dump(doc))
+          file.close
+          assert_equal doc, GraphQL::CParser::BinaryAST.load_file(file.path)
+        end
+        assert_raises(Errno::ENOENT) { GraphQL::CParser::BinaryAST.load_file("/nonexistent/binary_ast") }
+      end
+    end
+
+    describe ".signature" do
+      def signature(str)
+        GraphQL::CParser.signature(str)
+      end
+
+      it "ignores whitespace, commas, comments and literal values" do
+        sig = signature("query GetUser { user(id: 1, name: \"A\") { name } }")
+        assert_match(/\A[0-9a-f]{16}\z/, sig)
+        assert_equal sig, signature("query GetUser{user(id:2 name:\"\"\"B\"\"\"),{name}} # comment")
+        assert_equal signature("{ f(a: true) }"), signature("{ f(a: false) }")
+
+        refute_equal sig, signature("query GetUser { user(id: 1.5, name: \"A\") { name } }")
+        refute_equal sig, signature("query GetUser { user(id: 1, name: \"A\") { names } }")
+        refute_equal sig, signature("query GetUsers { user(id: 1, name: \"A\") { name } }")
+        refute_equal signature("{ f(a: RED) }"), signature("{ f(a: BLUE) }")
+        refute_equal signature("{ ab c }"), signature("{ a bc }")
+        refute_equal signature(""), signature("\xFF")
+      end
+
+      it "comes from a parser, too" do
+        query_str = "{ user(id: 1) { name } }"
+        parser = GraphQL::CParser::Parser.new(query_str, nil, GraphQL::Tracing::NullTrace, nil)
+        assert_equal signature(query_str), parser.signature
+      end
+    end
+
+    describe ".minify" do
+      def minify(str)
+        GraphQL::CParser.minify(str)
+      end
+
+      it "removes whitespace, commas and comments" do
+        assert_equal "query Q{user(id:1 active:true){name}}", minify("query Q {\n  user(id: 1, active: true) { name } # comment\n}")
+        assert_equal "{f(a:[1-2 3.5 -1\"\" \"a\" \"\"\" b \"\"\"]$v:E)...F ...on T{x}}", minify("{ f(a: [1, -2, 3.5, -1, \"\", \"a\", \"\"\" b \"\"\"] $v: E) ...F ... on T { x } }")
+        assert_equal "", minify(" , # nothing")
+        assert_equal Encoding::UTF_8, minify("{ f(a: \"caf\u00e9\") }").encoding
+      end
+
+      it "parses to the same document" do
+        Dir.glob("{benchmark,spec}/**/*.graphql").each do |filename|
+          query_str = File.read(filename)
+          document = begin
+            GraphQL.parse(query_str)
+          rescue GraphQL::ParseError
+            next
+          end
+          minified = minify(query_str)
+          assert_operator minified.bytesize, :<=, query_str.bytesize
+          assert_equal document, GraphQL.parse(minified), "#{filename} is the same after minifying"
+          assert_equal minified, minify(minified)
+        end
+      end
+
+      it "copies everything after an invalid character" do
+        assert_equal "{f} % a  ,b", minify("{ f } % a  ,b")
+        assert_equal "{f(a: \" 1\n\"b\") }", minify("{ f(a: \" 1\n\"b\") }")
+        assert_equal "\xFF { a }".b, minify("\xFF { a }").b
+      end
+    end
+
     it "exposes tokens_count" do
       str = "type Query { f1: Int }"
       parser = GraphQL::CParser::Parser.new(str, nil, GraphQL::Tracing::NullTrace, nil)
@@ -225,6 +225,33 @@ type Query {
     end
   end
 
+  describe "#deep_freeze" do
+    it "freezes every node and value, keeping positions" do
+      query_str = "query Q($v: [Int] = [1, 2]) {\n  f1(a: {b: \"c\"}) @skip(if: $v) {\n    ... on T { f2 }\n  }\n}"
+      doc = GraphQL.parse(query_str)
+      frozen_doc = GraphQL.parse(query_str).deep_freeze
+      assert_equal doc, frozen_doc
+      assert_equal doc.to_query_string, frozen_doc.to_query_string
+
+      nodes = []
+      visit = ->(n) { nodes << n; n.children.each(&visit) }
+      visit.call(frozen_doc)
+      assert nodes.all?(&:frozen?)
+      field = frozen_doc.definitions.first.selections.first
+      assert_equal [2, 3], field.position
+      assert field.arguments.frozen?
+      assert field.arguments.first.value.arguments.first.value.frozen?
+      assert frozen_doc.definitions.first.variables.first.default_value.frozen?
+    end
+
+    it "works on manually-created nodes" do
+      node = GraphQL::Language::Nodes::Field.new(name: "f1").deep_freeze
+      assert node.frozen?
+      assert_nil node.line
+      assert_nil node.col
+    end
+  end
+
   describe "description interning" do
     SDL = <<~GRAPHQL
       """
@@ -682,7 +682,7 @@ GRAPHQL
     if USING_C_PARSER
       assert_equal "{ t: __typename }", lex_trace[:query_string]
       assert_equal "lex", lex_trace[:key]
-      assert_instance_of Array, lex_trace[:result]
+      assert_instance_of GraphQL::CParser::TokenStream, lex_trace[:result]
     else
       parse_trace = lex_trace
     end
@@ -455,4 +455,86 @@ describe GraphQL::Language::Printer do
     expected_err = "Argument 'number' on Field 'issue' has an invalid value. Expected type 'Int!'."
     assert_equal [expected_err], result["errors"].map { |e| e["message"] }
   end
+
+  if USING_C_PARSER
+    describe "with GraphQL::CParser::Printer" do
+      ruby_printer_class = Class.new(GraphQL::Language::Printer) do
+        def print_string(str)
+          super
+        end
+      end
+
+      def assert_same_output(ruby_printer_class, node, **kwargs)
+        expected = ruby_printer_class.new.print(node, **kwargs)
+        printed = GraphQL::Language::Printer.new.print(node, **kwargs)
+        assert_equal expected, printed
+        assert_equal expected.encoding, printed.encoding
+      end
+
+      it "is used by printers which don't override print methods" do
+        assert GraphQL::Language::Printer.native_print?
+        assert GraphQL::Schema::Printer.native_print?
+        refute ruby_printer_class.native_print?
+        refute GraphQL::Language::SanitizedPrinter.native_print?
+        refute GraphQL::Schema::Printer::IntrospectionPrinter.native_print?
+      end
+
+      it "prints documents like the Ruby printer" do
+        big_schema_string = File.read("./benchmark/big_schema.graphql")
+        documents = [
+          document,
+          GraphQL::CParser.parse(query_string, lazy: true),
+          GraphQL::CParser.parse(big_schema_string, comments: true),
+          GraphQL::CParser.parse(big_schema_string, lazy: true),
+          Dummy::Schema.to_document,
+          GraphQL.parse('{ f(s: "caf\u00e9 \\\\ \\" \\u0001", l: [1, -2.5, null, ENUM, {a: $v}]) @d }'),
+        ]
+        documents.each do |doc|
+          length = ruby_printer_class.new.print(doc).size
+          [nil, 0, 14, 15, 16, 40, length / 2, length + 14, length + 15].each do |truncate_size|
+            assert_same_output(ruby_printer_class, doc, truncate_size: truncate_size)
+          end
+          doc.definitions.each do |definition|
+            assert_same_output(ruby_printer_class, definition, indent: "    ")
+          end
+        end
+      end
+
+      it "prints descriptions and comments like the Ruby printer" do
+        words = ["a", "bb", "cafés", "eeeeeeeeeeeeeeeeeeeeeeeeeeeeeeeee", "  ", "\t", "\n", "\n\n"]
+        rng = Random.new(1)
+        100.times do
+          text = Array.new(rng.rand(1..80)) { words.sample(random: rng) }.join(" ")
+          type_name = GraphQL::Language::Nodes::TypeName.new(name: "String")
+          doc = GraphQL::Language::Nodes::Document.new(definitions: [
+            GraphQL::Language::Nodes::ObjectTypeDefinition.new(name: "Thing", description: text, comment: text, interfaces: [], directives: [], fields: [
+              GraphQL::Language::Nodes::FieldDefinition.new(name: "f", description: text, type: type_name, arguments: [
+                GraphQL::Language::Nodes::InputValueDefinition.new(name: "a", comment: text, type: type_name, default_value: text),
+              ]),
+            ]),
+            GraphQL::Language::Nodes::EnumTypeDefinition.new(name: "E", values: [
+              GraphQL::Language::Nodes::EnumValueDefinition.new(name: "A", description: text),
+              GraphQL::Language::Nodes::EnumValueDefinition.new(name: "B", comment: text),
+            ]),
+          ])
+          assert_same_output(ruby_printer_class, doc)
+          assert_same_output(ruby_printer_class, doc, truncate_size: rng.rand(300))
+        end
+      end
+
+      it "leaves values it can't print to the Ruby printer" do
+        unsupported_value = Object.new
+        def unsupported_value.to_s
+          "custom"
+        end
+        argument = GraphQL::Language::Nodes::Argument.new(name: "a", value: unsupported_value)
+        assert_nil GraphQL::CParser::Printer.print(argument, "", nil)
+        assert_equal 'a: "custom"', printer.print(argument)
+
+        latin1_argument = GraphQL::Language::Nodes::Argument.new(name: "caf\xE9".dup.force_encoding("ISO-8859-1"), value: 1)
+        assert_nil GraphQL::CParser::Printer.print(latin1_argument, "", nil)
+        assert_equal ruby_printer_class.new.print(latin1_argument), printer.print(latin1_argument)
+      end
+    end
+  end
 end
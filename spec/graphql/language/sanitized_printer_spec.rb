@@ -377,4 +377,51 @@ describe GraphQL::Language::SanitizedPrinter do
     expected_query_string = "query {\n  things(group: DAY)\n}"
     assert_equal expected_query_string, query.sanitized_query_string
   end
+
+  if USING_C_PARSER
+    describe "with GraphQL::CParser::Printer.sanitize" do
+      def ruby_sanitized_printer_class(sanitized_printer_class = GraphQL::Language::SanitizedPrinter)
+        Class.new(sanitized_printer_class) do
+          # Overriding this opts out of `GraphQL::CParser::Printer.sanitize`
+          def coerce_argument_value_to_list?(type, value)
+            super
+          end
+        end
+      end
+
+      it "is used by printers which only override redaction hooks" do
+        assert GraphQL::Language::SanitizedPrinter.native_sanitize?
+        assert SanitizeTest::CustomSanitizedPrinter.native_sanitize?
+        refute ruby_sanitized_printer_class.native_sanitize?
+        refute Class.new(GraphQL::Language::SanitizedPrinter) { def print_field(field, indent: ""); super; end }.native_sanitize?
+      end
+
+      it "prints like the Ruby sanitizer" do
+        query_strings = [
+          '{ inputs(string: "s", id: "id", int: 1, float: 2.0, url: "u", enum: RED, inputObject: {string: "s", id: "id", int: 1, float: 2.0, url: "u", enum: RED}) }',
+          'query Q($s: String!, $i: ExampleInput!, $b: Boolean = true) { inputs(string: $s, id: "id", int: 1, float: 1.0, url: "u", enum: RED, inputObject: $i) @include(if: $b) ...F }
+          fragment F on Query { strings(strings: "s") ... on Query @skip(if: false) { colors(colors: RED) } ... { nestedArrayInputs(inputs: [{string: "s"}]) } }',
+          'query($strings: [String!]!, $colors: [Color!]!, $s: String!) { strings(strings: $strings) colors(colors: $colors) a: strings(strings: ["caf\u00e9", $s]) }',
+          '{ s1: customScalar(scalar: "s1") s2: customScalar(scalar: 1) s3: customScalar(scalar: {string: "s2", list: [1, "s3", null]}) __typename }',
+          'query($json: JSON!) { customScalar(scalar: $json) }',
+        ]
+        variables = {
+          "s" => "str", "b" => false, "strings" => ["s1", "s2"], "colors" => ["RED"],
+          "i" => { "string" => "s", "id" => "id", "int" => 3, "float" => 3.3, "url" => "u", "enum" => "BLUE" },
+          "json" => { "string" => "s", "list" => [1, 2.5, "s", nil] },
+        }
+        query_strings.each do |query_string|
+          [SanitizeTest::Schema, SanitizeTest::CustomSanitizedPrinterSchema].each do |schema|
+            query = GraphQL::Query.new(schema, query_string, variables: variables)
+            [true, false].each do |inline_variables|
+              expected = ruby_sanitized_printer_class(schema.sanitized_printer).new(query, inline_variables: inline_variables).sanitized_query_string
+              refute_nil expected
+              assert_equal expected, GraphQL::CParser::Printer.sanitize(query.document, schema.sanitized_printer.new(query), query, inline_variables)
+              assert_equal expected, query.sanitized_query_string(inline_variables: inline_variables)
+            end
+          end
+        end
+      end
+    end
+  end
 end
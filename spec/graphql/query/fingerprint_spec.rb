@@ -75,4 +75,38 @@ describe GraphQL::Query::Fingerprint do
     example_query = build_query(str2, var1b)
     assert_equal example_query.fingerprint, "#{example_query.operation_fingerprint}/#{example_query.variables_fingerprint}"
   end
+
+  describe ".algorithm=" do
+    after do
+      GraphQL::Query::Fingerprint.algorithm = :sha256
+    end
+
+    module ReverseFingerprint
+      def self.generate(str)
+        str.reverse
+      end
+    end
+
+    it "uses the given implementation" do
+      GraphQL::Query::Fingerprint.algorithm = ReverseFingerprint
+      query = build_query("{ __typename }", { "a" => 1 })
+      assert_equal "anonymous/} emanepyt__ {/1/}1:\"a\"{", query.fingerprint
+    end
+
+    it "raises on unknown algorithms" do
+      err = assert_raises(ArgumentError) { GraphQL::Query::Fingerprint.algorithm = :md4 }
+      assert_includes err.message, "Unknown fingerprint algorithm: :md4"
+      assert_equal GraphQL::Query::Fingerprint::SHA256, GraphQL::Query::Fingerprint.algorithm
+    end
+
+    if defined?(GraphQL::CParser::Fingerprint)
+      it "makes stable, shorter fingerprints with :siphash" do
+        GraphQL::Query::Fingerprint.algorithm = :siphash
+        query = build_query("{ __typename }", { "a" => 1, "b" => [2, "three", nil, { "four" => 4.5 }] })
+        assert_equal "anonymous/RFT35Aeqlj1ZJBBWjB-myg==", query.operation_fingerprint
+        assert_equal "2/#{GraphQL::CParser::Fingerprint.generate(JSON.generate(query.provided_variables))}", query.variables_fingerprint
+        refute_equal query.variables_fingerprint, build_query("{ __typename }", { "b" => [2, "three", nil, { "four" => 4.5 }], "a" => 1 }).variables_fingerprint
+      end
+    end
+  end
 end
@@ -138,6 +138,56 @@ if RUN_RACTOR_TESTS
       assert_equal schema_str.chomp, parsed_schema_ast.to_query_string
     end
 
+    if USING_C_PARSER
+      it "can parse shareable documents with the C parser, then validate them in another Ractor" do
+        ractor = Ractor.new do
+          parent = Ractor.receive
+          parent.send(["{ i }", "{ i nope }"].map { |query_str| GraphQL::CParser.parse(query_str, shareable: true) })
+        rescue StandardError => err
+          puts err.message
+          puts err.backtrace
+          parent.send(err)
+        end
+        ractor.send(Ractor.current)
+        documents = Ractor.receive
+        assert_equal [true, true], documents.map { |doc| Ractor.shareable?(doc) }
+
+        ractor = Ractor.new do
+          parent = Ractor.receive
+          shared_documents = Ractor.receive
+          parent.send(shared_documents.map { |doc| RactorExampleSchema.validate(doc).map(&:message) })
+        rescue StandardError => err
+          puts err.message
+          puts err.backtrace
+          parent.send(err)
+        end
+        ractor.send(Ractor.current)
+        ractor.send(documents)
+        assert_equal [[], ["Field 'nope' doesn't exist on type 'Query'"]], Ractor.receive
+      end
+
+      it "gets the schema's AtomTable in other Ractors" do
+        table = GraphQL::CParser::AtomTable.for_schema(RactorExampleSchema)
+        assert Ractor.shareable?(table)
+        ractor = Ractor.new do
+          parent = Ractor.receive
+          atoms = GraphQL::CParser::AtomTable.for_schema(RactorExampleSchema)
+          document = GraphQL::CParser.parse("{ i e }", atoms: atoms)
+          parent.send([atoms, document.definitions.first.selections.first.name.equal?(atoms["i"])])
+          GraphQL::CParser::AtomTable.for_schema(Dummy::Schema)
+        rescue StandardError => err
+          parent.send([err.class, err.message])
+        end
+        ractor.send(Ractor.current)
+        other_table, same_name = Ractor.receive
+        assert_same table, other_table
+        assert same_name
+        err_class, err_message = Ractor.receive
+        assert_equal GraphQL::Error, err_class
+        assert_includes err_message, "can only be called in the main Ractor"
+      end
+    end
+
     it "doesn't poison other schemas" do
       new_schema = Class.new(GraphQL::Schema) do
         q = Class.new(GraphQL::Schema::Object) {
@@ -49,6 +49,7 @@ describe GraphQL::Schema do
         multiplex_analyzer Object.new
         validate_timeout 100
         max_query_string_tokens 500
+        parser_cache_size 50
         rescue_from(StandardError) { }
         use GraphQL::Backtrace
         use GraphQL::Subscriptions::ActionCableSubscriptions, action_cable: nil, action_cable_coder: JSON
@@ -71,6 +72,7 @@ describe GraphQL::Schema do
       assert_equal base_schema.context_class, schema.context_class
       assert_equal base_schema.directives, schema.directives
       assert_equal base_schema.max_query_string_tokens, schema.max_query_string_tokens
+      assert_equal base_schema.parser_cache_size, schema.parser_cache_size
       assert_equal base_schema.query_analyzers, schema.query_analyzers
       assert_equal base_schema.multiplex_analyzers, schema.multiplex_analyzers
       assert_equal base_schema.disable_introspection_entry_points?, schema.disable_introspection_entry_points?
@@ -101,6 +103,7 @@ describe GraphQL::Schema do
         query_class(custom_query_class)
         extra_types [extra_type_2]
         max_query_string_tokens nil
+        parser_cache_size nil
       end
 
       query = Class.new(GraphQL::Schema::Object) do
@@ -144,6 +147,8 @@ describe GraphQL::Schema do
       assert_equal introspection, schema.introspection
       assert_equal cursor_encoder, schema.cursor_encoder
       assert_nil schema.max_query_string_tokens
+      assert_nil schema.parser_cache_size
+      assert_nil schema.parser_cache
 
       assert_equal context_class, schema.context_class
       assert_equal 10, schema.validate_timeout
@@ -456,6 +461,44 @@ To add other types to your schema, you might want `extra_types`: https://graphql
     end
   end
 
+  describe ".parser_cache_size" do
+    class ParserCacheSchema < GraphQL::Schema
+      class Query < GraphQL::Schema::Object
+        field :greeting, String do
+          argument :name, String
+        end
+
+        def greeting(name:)
+          "Hi, #{name}"
+        end
+      end
+      query(Query)
+      parser_cache_size 10
+    end
+
+    it "reuses frozen documents when the parser supports it" do
+      query_str = "{ greeting(name: \"Hal\") }"
+      res1 = ParserCacheSchema.execute(query_str)
+      res2 = ParserCacheSchema.execute(query_str.dup)
+      assert_equal({ "greeting" => "Hi, Hal" }, res1["data"])
+      assert_equal({ "greeting" => "Hi, Hal" }, res2["data"])
+      parse_error = ParserCacheSchema.execute("{ greeting(")
+      assert_equal 1, parse_error["errors"].size
+
+      if USING_C_PARSER
+        assert res1.query.document.frozen?
+        assert res1.query.document.equal?(res2.query.document)
+        stats = ParserCacheSchema.parser_cache.stats
+        assert_equal 1, stats[:size]
+        assert_equal 1, stats[:hits]
+        assert_equal 2, stats[:misses]
+      else
+        assert_nil ParserCacheSchema.parser_cache
+        refute res1.query.document.equal?(res2.query.document)
+      end
+    end
+  end
+
   describe "requiring query" do
     class QueryRequiredSchema < GraphQL::Schema
     end